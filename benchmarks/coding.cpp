@@ -3,6 +3,8 @@
 #include <sserialize/stats/statfuncs.h>
 #include <sserialize/utility/checks.h>
 #include <sserialize/storage/pack_unpack_functions.h>
+#include <sserialize/utility/Bitpacking.h>
+#include <sserialize/storage/varint_functions.h>
 #include <iostream>
 #include <set>
 #include <limits>
@@ -337,14 +339,142 @@ std::vector<long int> test64VecChecked(const std::vector<uint64_t> & nums, std::
 }
 
 
+std::vector<long int> testBitpacking(const std::vector<uint32_t> & nums, uint32_t bpn, sserialize::BitpackingInterface::InstructionLevel il, std::size_t testCount) {
+	std::vector<long int> res;
+	sserialize::TimeMeasurer tm;
+	auto packer = sserialize::BitpackingInterface::instance(bpn, il);
+	std::vector<uint8_t> data(nums.size()*bpn/8);
+	{
+		const uint32_t * sit = nums.data();
+		uint8_t * dit = data.data();
+		uint32_t count = sserialize::narrow_check<uint32_t>(nums.size());
+		packer->pack_blocks(sit, dit, count);
+	}
+	uint32_t sum = 0;
+	for(uint32_t x : nums) {
+		sum += x & sserialize::createMask(bpn);
+	}
+	std::vector<uint32_t> dest(nums.size());
+	for(std::size_t testNum = 0; testNum < testCount; ++testNum) {
+		const uint8_t * sit = data.data();
+		uint32_t * dit = dest.data();
+		uint32_t count = sserialize::narrow_check<uint32_t>(nums.size());
+		tm.begin();
+		packer->unpack_blocks(sit, dit, count);
+		tm.end();
+		res.push_back( tm.elapsedTime() );
+		uint32_t num = std::accumulate(dest.begin(), dest.end(), uint32_t(0));
+		ASSERT_SUM_NUM;
+	}
+	return res;
+}
+
+int benchBitpacking(int argc, char ** argv) {
+	if (argc < 4) {
+		std::cout << "bitpacking testLength testCount" << std::endl;
+		return -1;
+	}
+	using IL = sserialize::BitpackingInterface::InstructionLevel;
+	std::size_t testLength = atoi(argv[2]);
+	std::size_t testCount = atoi(argv[3]);
+	testLength = (testLength/64)*64;
+	IL supported = sserialize::detail::bitpacking::supportedInstructionLevel();
+	
+	std::cout << "#TestLength: " << testLength << std::endl;
+	std::cout << "#Test Count: " << testCount << std::endl;
+	std::cout << "#Supported instruction level: " << supported << std::endl;
+	std::cout << "#Entries are in M/s" << std::endl;
+	std::cout << "bpn;scalar;sse42;avx2" << std::endl;
+	std::vector<uint32_t> nums = createNumbersSet<uint32_t>(testLength);
+	for(uint32_t bpn(1); bpn <= 32; ++bpn) {
+		std::cout << bpn;
+		for(IL il : {sserialize::detail::bitpacking::IL_SCALAR, sserialize::detail::bitpacking::IL_SSE42, sserialize::detail::bitpacking::IL_AVX2}) {
+			std::cout << ";";
+			if (il > supported) {
+				std::cout << "-";
+				continue;
+			}
+			std::vector<long int> t = testBitpacking(nums, bpn, il, testCount);
+			std::cout << double(testLength)/sserialize::statistics::mean(t.begin(), t.end(), int64_t(0));
+		}
+		std::cout << std::endl;
+	}
+	return 0;
+}
+
+std::vector<long int> testVarint(const std::vector<uint32_t> & nums, uint32_t bits, bool bulk, std::size_t testCount) {
+	std::vector<long int> res;
+	sserialize::TimeMeasurer tm;
+	sserialize::UByteArrayAdapter uba(new std::vector<uint8_t>(), true);
+	uint32_t sum = 0;
+	for(uint32_t x : nums) {
+		x &= sserialize::createMask(bits);
+		uba.putVlPackedUint32(x);
+		sum += x;
+	}
+	std::vector<uint32_t> dest(nums.size());
+	for(std::size_t testNum = 0; testNum < testCount; ++testNum) {
+		tm.begin();
+		if (bulk) {
+			uba.getVlPackedUint32Array(0, dest.data(), dest.size());
+		}
+		else {
+			int len = 0;
+			sserialize::UByteArrayAdapter::OffsetType p = 0;
+			for(uint32_t & x : dest) {
+				x = uba.getVlPackedUint32(p, &len);
+				p += len;
+			}
+		}
+		tm.end();
+		res.push_back( tm.elapsedTime() );
+		uint32_t num = std::accumulate(dest.begin(), dest.end(), uint32_t(0));
+		ASSERT_SUM_NUM;
+	}
+	return res;
+}
+
+int benchVarint(int argc, char ** argv) {
+	if (argc < 4) {
+		std::cout << "varint testLength testCount" << std::endl;
+		return -1;
+	}
+	std::size_t testLength = atoi(argv[2]);
+	std::size_t testCount = atoi(argv[3]);
+	
+	std::cout << "#TestLength: " << testLength << std::endl;
+	std::cout << "#Test Count: " << testCount << std::endl;
+	std::cout << "#Simd support: " << sserialize::varint::hasSimdSupport() << std::endl;
+	std::cout << "#Entries are in M/s" << std::endl;
+	std::cout << "bits;single;bulk" << std::endl;
+	std::vector<uint32_t> nums = createNumbersSet<uint32_t>(testLength);
+	for(uint32_t bits : {4, 7, 10, 14, 21, 28, 32}) {
+		std::cout << bits;
+		for(bool bulk : {false, true}) {
+			std::vector<long int> t = testVarint(nums, bits, bulk, testCount);
+			std::cout << ";" << double(testLength)/sserialize::statistics::mean(t.begin(), t.end(), int64_t(0));
+		}
+		std::cout << std::endl;
+	}
+	return 0;
+}
+
 void printTimeVector(const std::vector<long int> & v) {
 	for(std::vector<long int>::const_iterator it(v.begin()); it != v.end(); ++it)
 		std::cout << *it << " ";
 }
 
 int main(int argc, char ** argv) {
+	if (argc > 1 && std::string(argv[1]) == "bitpacking") {
+		return benchBitpacking(argc, argv);
+	}
+	if (argc > 1 && std::string(argv[1]) == "varint") {
+		return benchVarint(argc, argv);
+	}
 	if (argc < 6) {
 		std::cout << "testLengthBegin testLengthEnd testLengthMul testCount (random|range)" << std::endl;
+		std::cout << "bitpacking testLength testCount" << std::endl;
+		std::cout << "varint testLength testCount" << std::endl;
 		return -1;
 		
 	}
@@ -124,6 +124,42 @@ int main(int argc, char ** argv) {
 		delete[] mBitSet64;
 		std::cout << "Conversion to ManualBitSet64 took " << tm.elapsedMilliSeconds() << " msec" << std::endl;
 	}
+	{
+		sserialize::DynamicBitSet a, b;
+		std::size_t half = values.size()/2;
+		a.set(values.begin(), values.begin()+half);
+		b.set(values.begin()+half, values.end());
+		
+		tm.begin();
+		sserialize::DynamicBitSet c(a & b);
+		tm.end();
+		std::cout << "DynamicBitSet::operator& took " << tm.elapsedMilliSeconds() << " msec" << std::endl;
+		
+		tm.begin();
+		sserialize::DynamicBitSet d(a | b);
+		tm.end();
+		std::cout << "DynamicBitSet::operator| took " << tm.elapsedMilliSeconds() << " msec" << std::endl;
+		
+		tm.begin();
+		sserialize::SizeType count = d.count();
+		tm.end();
+		std::cout << "DynamicBitSet::count took " << tm.elapsedMilliSeconds() << " msec for " << count << " bits" << std::endl;
+		
+		std::vector<uint32_t> ids;
+		ids.reserve(count);
+		tm.begin();
+		d.putInto(std::back_inserter(ids));
+		tm.end();
+		std::cout << "DynamicBitSet::putInto took " << tm.elapsedMilliSeconds() << " msec" << std::endl;
+		
+		tm.begin();
+		uint64_t sum = 0;
+		for(sserialize::DynamicBitSet::const_iterator it(d.cbegin()), end(d.cend()); it != end; ++it) {
+			sum += *it;
+		}
+		tm.end();
+		std::cout << "Iterating over DynamicBitSet took " << tm.elapsedMilliSeconds() << " msec (checksum " << sum << ")" << std::endl;
+	}
 	
 	return 0;
 }
\ No newline at end of file
@@ -0,0 +1,105 @@
+#include <sserialize/spatial/GeoPolygon.h>
+#include <sserialize/spatial/GeoPolygonEdgeIndex.h>
+#include <sserialize/Static/GeoPolygon.h>
+#include <sserialize/stats/TimeMeasuerer.h>
+
+#include <cmath>
+#include <iostream>
+#include <random>
+#include <vector>
+
+void help() {
+	std::cout << "prg\n"
+		"-p <point count>                     Number of vertices of the polygon\n"
+		"-n <query count>                     Number of query points\n"
+		"-r <rounds>                          Number of rounds\n"
+	<< std::endl;
+}
+
+struct State {
+	uint32_t pointCount = 10000;
+	uint32_t queryCount = 100000;
+	uint32_t rounds = 3;
+};
+
+template<typename T_WORKER>
+void bench(const std::string & name, const State & state, T_WORKER worker) {
+	uint64_t sum = 0;
+	sserialize::TimeMeasurer tm;
+	tm.begin();
+	for(uint32_t r(0); r < state.rounds; ++r) {
+		sum += worker();
+	}
+	tm.end();
+	std::cout << name << ": " << tm.elapsedMilliSeconds()/state.rounds << " ms per round (inside=" << sum/state.rounds << ")" << std::endl;
+}
+
+int main(int argc, char ** argv) {
+	State state;
+	for(int i(1); i < argc; ++i) {
+		std::string token(argv[i]);
+		if (token == "-p" && i+1 < argc) {
+			state.pointCount = atoi(argv[i+1]);
+			++i;
+		}
+		else if (token == "-n" && i+1 < argc) {
+			state.queryCount = atoi(argv[i+1]);
+			++i;
+		}
+		else if (token == "-r" && i+1 < argc) {
+			state.rounds = atoi(argv[i+1]);
+			++i;
+		}
+		else {
+			help();
+			return -1;
+		}
+	}
+	std::mt19937 gen(0);
+	std::uniform_real_distribution<double> radius(1.0, 5.0);
+	std::vector<sserialize::spatial::GeoPoint> points;
+	for(uint32_t i(0); i < state.pointCount; ++i) {
+		double angle = 2*M_PI*i/state.pointCount;
+		double r = radius(gen);
+		points.emplace_back(10.0 + r*std::sin(angle), 20.0 + r*std::cos(angle));
+	}
+	sserialize::spatial::GeoPolygon poly(points);
+	sserialize::UByteArrayAdapter d(sserialize::UByteArrayAdapter::createCache(0, sserialize::MM_PROGRAM_MEMORY));
+	d << poly;
+	sserialize::Static::spatial::GeoPolygon spoly(d);
+	
+	std::uniform_real_distribution<double> latDist(poly.boundary().minLat(), poly.boundary().maxLat());
+	std::uniform_real_distribution<double> lonDist(poly.boundary().minLon(), poly.boundary().maxLon());
+	std::vector<sserialize::spatial::GeoPoint> queries;
+	for(uint32_t i(0); i < state.queryCount; ++i) {
+		queries.emplace_back(latDist(gen), lonDist(gen));
+	}
+	
+	sserialize::TimeMeasurer tm;
+	tm.begin();
+	sserialize::spatial::GeoPolygonEdgeIndex idx(spoly);
+	tm.end();
+	std::cout << "index creation: " << tm.elapsedMilliSeconds() << " ms, " << idx.getSizeInBytes() << " Bytes, "
+		<< idx.boundaryCellCount() << " of " << idx.latCells()*idx.lonCells() << " cells on the boundary" << std::endl;
+	
+	bench("Static::spatial::GeoPolygon::contains", state, [&]() {
+		uint64_t sum = 0;
+		for(const auto & p : queries) {
+			sum += spoly.contains(p);
+		}
+		return sum;
+	});
+	bench("GeoPolygonEdgeIndex::contains", state, [&]() {
+		uint64_t sum = 0;
+		for(const auto & p : queries) {
+			sum += idx.contains(p);
+		}
+		return sum;
+	});
+	bench("Static::spatial::GeoPolygon batch contains", state, [&]() {
+		std::vector<char> result(queries.size());
+		spoly.contains(queries.cbegin(), queries.cend(), result.begin());
+		return (uint64_t) std::count(result.begin(), result.end(), 1);
+	});
+	return 0;
+}
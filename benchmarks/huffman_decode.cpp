@@ -0,0 +1,148 @@
+#include <sserialize/containers/HuffmanTree.h>
+#include <sserialize/containers/ItemIndexFactory.h>
+#include <sserialize/Static/HuffmanDecoder.h>
+#include <sserialize/Static/ItemIndexStore.h>
+#include <sserialize/iterator/MultiBitBackInserter.h>
+#include <sserialize/iterator/MultiBitIterator.h>
+#include <sserialize/iterator/UDWIterator.h>
+#include <sserialize/iterator/UDWIteratorPrivateHD.h>
+#include <sserialize/stats/TimeMeasuerer.h>
+
+#include <iostream>
+#include <random>
+#include <unordered_map>
+
+void help() {
+	std::cout << "prg\n"
+		"-f <file>                            ItemIndexStore with WAH or RLE-DE indexes, compressed with huffman if it is not yet\n"
+		"-n <symbol count>                    Number of symbols of the synthetic stream\n"
+		"-r <rounds>                          Number of rounds\n"
+	<< std::endl;
+}
+
+struct State {
+	std::string fileName;
+	uint32_t symbolCount = 10000000;
+	uint32_t rounds = 3;
+};
+
+void putWrapper(sserialize::UByteArrayAdapter & dest, const uint32_t & src) {
+	dest.putUint32(src);
+}
+
+///Compares decoding code by code walking the decoder nodes with the lookup table used by UDWIteratorPrivateHD
+void benchSynthetic(const State & state) {
+	std::mt19937 gen(0);
+	std::geometric_distribution<uint32_t> dist(0.05);
+	std::vector<uint32_t> data;
+	std::unordered_map<uint32_t, uint32_t> alphabet;
+	for(uint32_t i(0); i < state.symbolCount; ++i) {
+		data.push_back(dist(gen));
+		alphabet[data.back()] += 1;
+	}
+	sserialize::HuffmanTree<uint32_t> ht;
+	ht.create(alphabet.begin(), alphabet.end(), (uint32_t) data.size());
+	std::unordered_map<uint32_t, sserialize::HuffmanCodePoint> codes(ht.codePointMap());
+
+	sserialize::UByteArrayAdapter dataAdap(sserialize::UByteArrayAdapter::createCache(1, sserialize::MM_PROGRAM_MEMORY));
+	sserialize::MultiBitBackInserter backInserter(dataAdap);
+	for(uint32_t x : data) {
+		const sserialize::HuffmanCodePoint & cp = codes.at(x);
+		backInserter.push_back(cp.code(), cp.codeLength());
+	}
+	backInserter.flush();
+	dataAdap = backInserter.data();
+	dataAdap.resetPtrs();
+
+	sserialize::UByteArrayAdapter decoderAdap(sserialize::UByteArrayAdapter::createCache(1, sserialize::MM_PROGRAM_MEMORY));
+	sserialize::HuffmanTree<uint32_t>::ValueSerializer sfn = &putWrapper;
+	ht.serialize(decoderAdap, sfn, std::vector<uint8_t>({8, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4, 4}));
+	decoderAdap.resetPtrs();
+	sserialize::RCPtrWrapper<sserialize::Static::HuffmanDecoder> decoder(new sserialize::Static::HuffmanDecoder(decoderAdap));
+
+	std::cout << "Synthetic stream of " << data.size() << " symbols with " << alphabet.size() << " distinct values" << std::endl;
+	{
+		sserialize::TimeMeasurer tm;
+		uint64_t sum = 0;
+		tm.begin();
+		for(uint32_t r(0); r < state.rounds; ++r) {
+			sserialize::MultiBitIterator it(dataAdap);
+			for(uint32_t i(0), s((uint32_t) data.size()); i < s; ++i) {
+				uint32_t v = it.get32();
+				int len = decoder->decode(v, v);
+				it += (uint32_t) len;
+				sum += v;
+			}
+		}
+		tm.end();
+		std::cout << "node walk: " << tm.elapsedMilliSeconds()/state.rounds << " ms per round (checksum=" << sum << ")" << std::endl;
+	}
+	{
+		sserialize::TimeMeasurer tm;
+		uint64_t sum = 0;
+		tm.begin();
+		for(uint32_t r(0); r < state.rounds; ++r) {
+			sserialize::UDWIterator it(new sserialize::UDWIteratorPrivateHD(sserialize::MultiBitIterator(dataAdap), decoder), true);
+			for(uint32_t i(0), s((uint32_t) data.size()); i < s; ++i) {
+				sum += it.next();
+			}
+		}
+		tm.end();
+		std::cout << "lookup table: " << tm.elapsedMilliSeconds()/state.rounds << " ms per round (checksum=" << sum << ")" << std::endl;
+	}
+}
+
+void benchStore(const State & state) {
+	sserialize::Static::ItemIndexStore store(sserialize::UByteArrayAdapter::openRo(state.fileName, false));
+	if (!(store.compressionType() & sserialize::Static::ItemIndexStore::IC_HUFFMAN)) {
+		std::cout << "Compressing store with huffman" << std::endl;
+		sserialize::UByteArrayAdapter dest(sserialize::UByteArrayAdapter::createCache(1, sserialize::MM_PROGRAM_MEMORY));
+		sserialize::ItemIndexFactory::compressWithHuffman(store, dest);
+		dest.resetPtrs();
+		store = sserialize::Static::ItemIndexStore(dest);
+	}
+	std::cout << "Store with " << store.size() << " indexes" << std::endl;
+	sserialize::TimeMeasurer tm;
+	uint64_t sum = 0;
+	uint64_t count = 0;
+	tm.begin();
+	for(uint32_t r(0); r < state.rounds; ++r) {
+		for(uint32_t i(0), s(store.size()); i < s; ++i) {
+			sserialize::ItemIndex idx = store.at(i);
+			for(uint32_t x : idx) {
+				sum += x;
+			}
+			count += idx.size();
+		}
+	}
+	tm.end();
+	std::cout << "decoding all indexes: " << tm.elapsedMilliSeconds()/state.rounds << " ms per round, " << count/state.rounds << " ids (checksum=" << sum << ")" << std::endl;
+}
+
+int main(int argc, char ** argv) {
+	State state;
+	for(int i(1); i < argc; ++i) {
+		std::string token(argv[i]);
+		if (token == "-f" && i+1 < argc) {
+			state.fileName = std::string(argv[i+1]);
+			++i;
+		}
+		else if (token == "-n" && i+1 < argc) {
+			state.symbolCount = atoi(argv[i+1]);
+			++i;
+		}
+		else if (token == "-r" && i+1 < argc) {
+			state.rounds = atoi(argv[i+1]);
+			++i;
+		}
+		else {
+			help();
+			return -1;
+		}
+	}
+	benchSynthetic(state);
+	if (state.fileName.size()) {
+		benchStore(state);
+	}
+	return 0;
+}
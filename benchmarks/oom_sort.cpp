@@ -20,6 +20,7 @@ void help() {
 		"--u[niquify]                         Uniquify result\n"
 		"--no-fetch-lock                      Don't use a fetch lock\n"
 		"--no-flush-lock                      Don't use a flush lock\n"
+		"--no-prefetch                        Don't prefetch merge input asynchronously\n"
 		"--random-data                        Use random test data\n"
 	<< std::endl;
 }
@@ -39,6 +40,7 @@ struct State {
 	bool uniquify = false;
 	bool fetchLock{true};
 	bool flushLock{true};
+	bool prefetch{true};
 	bool random{false};
 };
 
@@ -58,6 +60,7 @@ void worker(T_SRC_CONTAINER_TYPE & data, State & state) {
 		.maxWait(state.maxWait)
 		.ioFetchLock(state.fetchLock)
 		.ioFlushLock(state.flushLock)
+		.prefetch(state.prefetch)
 		.makeUnique(state.uniquify);
 	
 	if (state.uniquify) {
@@ -220,6 +223,9 @@ int main(int argc, char ** argv) {
 		else if (token == "--no-flush-lock") {
 			state.flushLock = false;
 		}
+		else if (token == "--no-prefetch") {
+			state.prefetch = false;
+		}
 		else if (token == "--random-data") {
 			state.random = true;
 		}
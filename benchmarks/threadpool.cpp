@@ -0,0 +1,177 @@
+#include <sserialize/mt/ThreadPool.h>
+#include <sserialize/mt/GuardedVariable.h>
+#include <sserialize/stats/TimeMeasuerer.h>
+
+#include <iostream>
+#include <queue>
+#include <vector>
+#include <cmath>
+
+void help() {
+	std::cout << "prg\n"
+		"-t <thread count>                    Number of worker threads\n"
+		"-n <task count>                      Number of tasks\n"
+		"-w <work per task>                   Number of iterations per task\n"
+		"-g <grain size>                      Grain size of parallel_for\n"
+		"-r <rounds>                          Number of rounds\n"
+	<< std::endl;
+}
+
+///The single queue thread pool sserialize used before the work-stealing pool
+class SingleQueueThreadPool {
+private:
+	typedef std::function<void()> QueuedTaskFunction;
+	struct QueueInfo {
+		std::queue<QueuedTaskFunction> q;
+		uint32_t runningTasks{0};
+	};
+private:
+	std::vector<std::thread> m_threads;
+	sserialize::GuardedVariable<QueueInfo> m_qi;
+	std::atomic<bool> m_online{true};
+public:
+	SingleQueueThreadPool(uint32_t numThreads) {
+		for(uint32_t i(0); i < numThreads; ++i) {
+			m_threads.emplace_back([this]() {
+				while(m_online.load()) {
+					QueuedTaskFunction t;
+					{
+						auto qlck(m_qi.uniqueLock());
+						if (m_online.load() && m_qi.unsyncedValue().q.empty()) {
+							m_qi.wait(qlck);
+						}
+						if (!m_online.load() || m_qi.unsyncedValue().q.empty()) {
+							continue;
+						}
+						m_qi.unsyncedValue().runningTasks += 1;
+						t = std::move(m_qi.unsyncedValue().q.front());
+						m_qi.unsyncedValue().q.pop();
+					}
+					t();
+					m_qi.syncedWithNotifyAll([](QueueInfo & v) { v.runningTasks -= 1;});
+				}
+			});
+		}
+	}
+	~SingleQueueThreadPool() {
+		m_online = false;
+		m_qi.syncedWithNotifyAll([](QueueInfo &) {});
+		for(std::thread & t : m_threads) {
+			t.join();
+		}
+	}
+	void sheduleTask(QueuedTaskFunction t) {
+		m_qi.syncedWithNotifyOne([&t](QueueInfo & v) { v.q.push(std::move(t)); });
+	}
+	void flushQueue() {
+		auto qlck(m_qi.uniqueLock());
+		while(m_qi.unsyncedValue().q.size() || m_qi.unsyncedValue().runningTasks > 0) {
+			m_qi.wait(qlck);
+		}
+	}
+};
+
+struct State {
+	uint32_t threadCount = 4;
+	uint32_t taskCount = 1000000;
+	uint32_t work = 100;
+	uint32_t grainSize = 1024;
+	uint32_t rounds = 3;
+};
+
+inline double work(uint32_t seed, uint32_t iterations) {
+	double v = seed;
+	for(uint32_t i(0); i < iterations; ++i) {
+		v = std::sqrt(v + i);
+	}
+	return v;
+}
+
+template<typename T_POOL>
+void benchTasks(const std::string & name, T_POOL & pool, const State & state) {
+	sserialize::TimeMeasurer tm;
+	std::atomic<uint64_t> sum(0);
+	tm.begin();
+	for(uint32_t r(0); r < state.rounds; ++r) {
+		for(uint32_t i(0); i < state.taskCount; ++i) {
+			pool.sheduleTask([&sum, &state, i]() {
+				sum.fetch_add(uint64_t(work(i, state.work)), std::memory_order_relaxed);
+			});
+		}
+		pool.flushQueue();
+	}
+	tm.end();
+	std::cout << name << ": " << tm.elapsedMilliSeconds()/state.rounds << " ms per round (checksum=" << sum.load() << ")" << std::endl;
+}
+
+int main(int argc, char ** argv) {
+	State state;
+	for(int i(1); i < argc; ++i) {
+		std::string token(argv[i]);
+		if (token == "-t" && i+1 < argc) {
+			state.threadCount = atoi(argv[i+1]);
+			++i;
+		}
+		else if (token == "-n" && i+1 < argc) {
+			state.taskCount = atoi(argv[i+1]);
+			++i;
+		}
+		else if (token == "-w" && i+1 < argc) {
+			state.work = atoi(argv[i+1]);
+			++i;
+		}
+		else if (token == "-g" && i+1 < argc) {
+			state.grainSize = atoi(argv[i+1]);
+			++i;
+		}
+		else if (token == "-r" && i+1 < argc) {
+			state.rounds = atoi(argv[i+1]);
+			++i;
+		}
+		else {
+			help();
+			return -1;
+		}
+	}
+	std::cout << "Threads: " << state.threadCount << ", tasks: " << state.taskCount << ", work per task: " << state.work << std::endl;
+	{
+		SingleQueueThreadPool pool(state.threadCount);
+		benchTasks("single queue: sheduleTask", pool, state);
+	}
+	{
+		sserialize::ThreadPool pool(state.threadCount);
+		benchTasks("work stealing: sheduleTask", pool, state);
+	}
+	{
+		sserialize::ThreadPool pool(state.threadCount);
+		sserialize::TimeMeasurer tm;
+		std::atomic<uint64_t> sum(0);
+		tm.begin();
+		for(uint32_t r(0); r < state.rounds; ++r) {
+			pool.parallel_for(0, state.taskCount, state.grainSize, [&sum, &state](std::size_t i) {
+				sum.fetch_add(uint64_t(work(uint32_t(i), state.work)), std::memory_order_relaxed);
+			});
+		}
+		tm.end();
+		std::cout << "work stealing: parallel_for: " << tm.elapsedMilliSeconds()/state.rounds << " ms per round (checksum=" << sum.load() << ")" << std::endl;
+	}
+	{
+		std::vector<uint32_t> ids(state.taskCount);
+		for(uint32_t i(0); i < ids.size(); ++i) {
+			ids[i] = i;
+		}
+		for(std::size_t chunkSize : {std::size_t(1), std::size_t(0)}) {
+			sserialize::TimeMeasurer tm;
+			std::atomic<uint64_t> sum(0);
+			tm.begin();
+			for(uint32_t r(0); r < state.rounds; ++r) {
+				sserialize::ThreadPool::map([&sum, &state](uint32_t i) {
+					sum.fetch_add(uint64_t(work(i, state.work)), std::memory_order_relaxed);
+				}, ids.begin(), ids.end(), state.threadCount, chunkSize);
+			}
+			tm.end();
+			std::cout << "map with chunk size " << (chunkSize ? "1" : "auto") << ": " << tm.elapsedMilliSeconds()/state.rounds << " ms per round (checksum=" << sum.load() << ")" << std::endl;
+		}
+	}
+	return 0;
+}
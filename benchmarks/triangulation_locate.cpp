@@ -0,0 +1,104 @@
+#include <sserialize/Static/TriangulationGeoHierarchyArrangement.h>
+#include <sserialize/stats/TimeMeasuerer.h>
+
+#include <iostream>
+#include <random>
+#include <vector>
+
+void help() {
+	std::cout << "prg\n"
+		"-f <file>                            Serialized sserialize::Static::spatial::TriangulationGeoHierarchyArrangement\n"
+		"-n <point count>                     Number of random points within the grid\n"
+		"-t <thread count>                    Number of worker threads for the batch location\n"
+		"-r <rounds>                          Number of rounds\n"
+	<< std::endl;
+}
+
+struct State {
+	std::string fileName;
+	uint32_t pointCount = 1000000;
+	uint32_t threadCount = 4;
+	uint32_t rounds = 3;
+};
+
+using Arrangement = sserialize::Static::spatial::TriangulationGeoHierarchyArrangement;
+
+void printResult(const std::string & name, const sserialize::TimeMeasurer & tm, const State & state, const std::vector<uint32_t> & result, const std::vector<uint32_t> & ref) {
+	std::size_t diff = 0;
+	for(std::size_t i(0); i < ref.size(); ++i) {
+		diff += (result.at(i) != ref[i]);
+	}
+	double ms = double(tm.elapsedMilliSeconds())/state.rounds;
+	std::cout << name << ": " << ms << " ms per round, " << (ms > 0 ? state.pointCount/ms*1000 : 0) << " points/s";
+	//points on cell boundaries may be located in either cell depending on the start face of the walk
+	std::cout << " (" << diff << " differ from the per-point loop)" << std::endl;
+}
+
+int main(int argc, char ** argv) {
+	State state;
+	for(int i(1); i < argc; ++i) {
+		std::string token(argv[i]);
+		if (token == "-f" && i+1 < argc) {
+			state.fileName = std::string(argv[i+1]);
+			++i;
+		}
+		else if (token == "-n" && i+1 < argc) {
+			state.pointCount = atoi(argv[i+1]);
+			++i;
+		}
+		else if (token == "-t" && i+1 < argc) {
+			state.threadCount = atoi(argv[i+1]);
+			++i;
+		}
+		else if (token == "-r" && i+1 < argc) {
+			state.rounds = atoi(argv[i+1]);
+			++i;
+		}
+		else {
+			help();
+			return -1;
+		}
+	}
+	if (state.fileName.empty()) {
+		help();
+		return -1;
+	}
+	Arrangement ra(sserialize::UByteArrayAdapter::openRo(state.fileName, false));
+	const sserialize::spatial::GeoRect & rect = ra.grid().grid().rect();
+
+	std::mt19937 gen(0);
+	std::uniform_real_distribution<double> latDist(rect.minLat(), rect.maxLat());
+	std::uniform_real_distribution<double> lonDist(rect.minLon(), rect.maxLon());
+	std::vector<Arrangement::Point> points;
+	points.reserve(state.pointCount);
+	for(uint32_t i(0); i < state.pointCount; ++i) {
+		points.emplace_back(latDist(gen), lonDist(gen));
+	}
+	std::cout << "Points: " << state.pointCount << ", threads: " << state.threadCount << std::endl;
+
+	std::vector<uint32_t> ref;
+	{
+		sserialize::TimeMeasurer tm;
+		tm.begin();
+		for(uint32_t r(0); r < state.rounds; ++r) {
+			ref.clear();
+			ref.reserve(points.size());
+			for(const Arrangement::Point & p : points) {
+				ref.push_back(ra.cellId(p));
+			}
+		}
+		tm.end();
+		printResult("per-point loop", tm, state, ref, ref);
+	}
+	for(uint32_t threadCount : {uint32_t(1), state.threadCount}) {
+		std::vector<uint32_t> result;
+		sserialize::TimeMeasurer tm;
+		tm.begin();
+		for(uint32_t r(0); r < state.rounds; ++r) {
+			result = ra.cellId(points, threadCount);
+		}
+		tm.end();
+		printResult("batch with " + std::to_string(threadCount) + " threads", tm, state, result, ref);
+	}
+	return 0;
+}
@@ -0,0 +1,164 @@
+#include <sserialize/storage/UByteArrayAdapter.h>
+#include <sserialize/containers/ItemIndexFactory.h>
+#include <sserialize/containers/ItemIndexPrivates/ItemIndexPrivateFoR.h>
+#include <sserialize/containers/CompactUintArray.h>
+#include <sserialize/utility/Bitpacking.h>
+#include <sserialize/mt/ThreadPool.h>
+#include <sserialize/stats/TimeMeasuerer.h>
+
+#include <atomic>
+#include <iostream>
+#include <random>
+#include <vector>
+
+void help() {
+	std::cout << "prg\n"
+		"-t <thread count>                    Maximum number of threads, the benchmark runs with 1, 2, 4, ... threads\n"
+		"-n <access count>                    Number of accesses per thread\n"
+		"-s <index size>                      Number of ids in the FoR index\n"
+		"-r <rounds>                          Number of rounds\n"
+	<< std::endl;
+}
+
+struct State {
+	uint32_t threadCount = 8;
+	uint32_t accessCount = 10000000;
+	uint32_t indexSize = 1000000;
+	uint32_t rounds = 3;
+};
+
+///Runs worker with threadCount threads, all of them reading the same storage
+template<typename T_WORKER>
+void bench(const std::string & name, const State & state, uint32_t threadCount, T_WORKER worker) {
+	std::atomic<uint64_t> sum(0);
+	sserialize::TimeMeasurer tm;
+	tm.begin();
+	for(uint32_t r(0); r < state.rounds; ++r) {
+		std::atomic<uint32_t> threadId(0);
+		sserialize::ThreadPool::execute([&]() {
+			sum.fetch_add(worker(threadId.fetch_add(1)), std::memory_order_relaxed);
+		}, threadCount, sserialize::ThreadPool::CopyTaskTag());
+	}
+	tm.end();
+	std::cout << name << " with " << threadCount << " threads: " << tm.elapsedMilliSeconds()/state.rounds << " ms per round (checksum=" << sum.load() << ")" << std::endl;
+}
+
+int main(int argc, char ** argv) {
+	State state;
+	for(int i(1); i < argc; ++i) {
+		std::string token(argv[i]);
+		if (token == "-t" && i+1 < argc) {
+			state.threadCount = atoi(argv[i+1]);
+			++i;
+		}
+		else if (token == "-n" && i+1 < argc) {
+			state.accessCount = atoi(argv[i+1]);
+			++i;
+		}
+		else if (token == "-s" && i+1 < argc) {
+			state.indexSize = atoi(argv[i+1]);
+			++i;
+		}
+		else if (token == "-r" && i+1 < argc) {
+			state.rounds = atoi(argv[i+1]);
+			++i;
+		}
+		else {
+			help();
+			return -1;
+		}
+	}
+	std::mt19937 gen(0);
+	sserialize::UByteArrayAdapter data(sserialize::UByteArrayAdapter::createCache(1, sserialize::MM_PROGRAM_MEMORY));
+	for(uint32_t i(0); i < (1 << 20); ++i) {
+		data.putUint32(gen());
+	}
+	std::vector<uint32_t> offsets(4096);
+	for(uint32_t & x : offsets) {
+		x = gen() % (data.size()-8);
+	}
+
+	std::vector<uint32_t> ids;
+	for(uint32_t i(0), id(0); i < state.indexSize; ++i) {
+		id += 1 + gen() % 64;
+		ids.push_back(id);
+	}
+	sserialize::UByteArrayAdapter forData(sserialize::UByteArrayAdapter::createCache(1, sserialize::MM_PROGRAM_MEMORY));
+	sserialize::ItemIndexFactory::create(ids, forData, sserialize::ItemIndex::T_FOR);
+	forData.resetPtrs();
+	
+	//the deltas of ids as bit packed blocks, this is what FoRBlock::decodeBlock reads
+	const uint32_t blockSize = 128;
+	uint32_t blockBits = 0;
+	std::vector<uint32_t> deltas(ids.size());
+	for(std::size_t i(0); i < ids.size(); ++i) {
+		deltas[i] = ids[i] - (i ? ids[i-1] : 0);
+		blockBits = std::max<uint32_t>(blockBits, sserialize::CompactUintArray::minStorageBits(deltas[i]));
+	}
+	const uint32_t blockCount = uint32_t(deltas.size()/blockSize);
+	const sserialize::UByteArrayAdapter::SizeType blockStorageSize = sserialize::CompactUintArray::minStorageBytes(blockBits, blockSize);
+	sserialize::UByteArrayAdapter blockData(sserialize::UByteArrayAdapter::createCache(1, sserialize::MM_PROGRAM_MEMORY));
+	for(uint32_t i(0); i < blockCount; ++i) {
+		sserialize::detail::ItemIndexImpl::FoRCreator::encodeBlock(blockData, deltas.begin()+i*blockSize, deltas.begin()+(i+1)*blockSize, blockBits);
+	}
+	blockData.resetPtrs();
+	///decodes all blocks of blockData, dataAccess(offset, size, unpack) calls unpack with the contiguous data of a block
+	auto decodeBlocks = [&](auto dataAccess) {
+		uint64_t sum = 0;
+		std::vector<uint32_t> dest(blockSize);
+		for(uint32_t r(0); r < 10; ++r) {
+			for(uint32_t i(0); i < blockCount; ++i) {
+				dataAccess(i*blockStorageSize, blockStorageSize, [&](const uint8_t * data) {
+					uint32_t * vit = dest.data();
+					uint32_t count = blockSize;
+					sserialize::BitpackingInterface::shared(blockBits).unpack_blocks(data, vit, count);
+				});
+				sum += dest.back();
+			}
+		}
+		return sum;
+	};
+
+	for(uint32_t threadCount(1); threadCount <= state.threadCount; threadCount *= 2) {
+		//each access creates and destroys an adapter, this changes the reference count of the shared storage twice
+		bench("sub adapter", state, threadCount, [&](uint32_t threadId) {
+			uint64_t sum = 0;
+			for(uint32_t i(0); i < state.accessCount; ++i) {
+				sum += sserialize::UByteArrayAdapter(data, offsets[(i+threadId) % offsets.size()], 8).getUint32(4);
+			}
+			return sum;
+		});
+		bench("borrowed view", state, threadCount, [&](uint32_t threadId) {
+			uint64_t sum = 0;
+			for(uint32_t i(0); i < state.accessCount; ++i) {
+				sum += data.getBorrowedView(offsets[(i+threadId) % offsets.size()], 8).getUint32(4);
+			}
+			return sum;
+		});
+		//FoR blocks used to be decoded through a memory view, it allocates and changes the reference count for every block
+		bench("FoR block decoding (memory view)", state, threadCount, [&](uint32_t) {
+			return decodeBlocks([&](sserialize::UByteArrayAdapter::OffsetType offset, sserialize::UByteArrayAdapter::SizeType size, auto unpack) {
+				sserialize::UByteArrayAdapter::MemoryView mv(blockData.getMemView(offset, size));
+				unpack(mv.data());
+			});
+		});
+		//FoR blocks are now decoded through a borrowed view
+		bench("FoR block decoding (borrowed view)", state, threadCount, [&](uint32_t) {
+			return decodeBlocks([&](sserialize::UByteArrayAdapter::OffsetType offset, sserialize::UByteArrayAdapter::SizeType size, auto unpack) {
+				sserialize::UByteArrayAdapter::BorrowedView bv(blockData.getBorrowedView(offset, size));
+				unpack(bv.data());
+			});
+		});
+		bench("FoR decoding", state, threadCount, [&](uint32_t) {
+			uint64_t sum = 0;
+			std::vector<uint32_t> dest(ids.size());
+			for(uint32_t i(0); i < 10; ++i) {
+				sserialize::ItemIndex idx(forData, sserialize::ItemIndex::T_FOR);
+				idx.putInto(dest.data());
+				sum += dest.back();
+			}
+			return sum;
+		});
+	}
+	return 0;
+}
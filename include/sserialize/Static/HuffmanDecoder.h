@@ -3,6 +3,8 @@
 #include <sserialize/storage/UByteArrayAdapter.h>
 #include <sserialize/Static/Array.h>
 #include <sserialize/storage/SerializationInfo.h>
+#include <array>
+#include <vector>
 
 /** This is a tablebased huffman decoder.
   * Essentialy its a tree with branching factor B and different child nodes
@@ -20,6 +22,9 @@
   *--------------------------------------------------------------
   *      uint8    | vl32       |(uint32:uint32)
   *
+  * Upon construction a flat lookup table indexed by the next LookupBits bits of the input is created.
+  * Every entry holds up to MaxLookupSymbols codes that are completely contained in these bits.
+  * Only codes longer than LookupBits need to walk the nodes.
   *
   */
 
@@ -49,6 +54,16 @@ public:
 		inline uint32_t childPtrDiff() const { return m_childPtrBitLen >> 5; }
 		inline bool hasChild() { return !(m_childPtrBitLen & 0x1F); }
 	};
+	static constexpr uint8_t LookupBits = 10;
+	static constexpr uint32_t MaxLookupSymbols = 3;
+	///Codes decoded from the upper LookupBits of the input
+	struct LookupEntry {
+		std::array<uint32_t, MaxLookupSymbols> values;
+		///bit length of each code
+		std::array<uint8_t, MaxLookupSymbols> lengths;
+		///number of valid codes, 0 if the first code is longer than LookupBits
+		uint8_t count;
+	};
 private:
 	class StaticNode {
 	public:
@@ -71,7 +86,9 @@ private:
 	
 	Static::Array<StaticNode> m_nodes;
 	StaticNode m_root;
+	std::vector<LookupEntry> m_lookup;
 private:
+	void buildLookupTable();
 
 	///selects the @length upper bits
 	template<typename T_UINT_TYPE>
@@ -120,6 +137,12 @@ public:
 	void readInCache();
 	UByteArrayAdapter::OffsetType getSizeInBytes() const { return m_nodes.getSizeInBytes(); }
 	
+	///@param src the next 32 bits of the input, the first bit is the most significant one
+	///@return the codes within the upper LookupBits of src, use decode() if there are none
+	inline const LookupEntry & lookup(uint32_t src) const {
+		return m_lookup[src >> (32-LookupBits)];
+	}
+	
 	///@return on success  the bit length, on error -1
 	inline int decode(uint16_t src, uint32_t & decodedValue) const {
 		return decodeImp<uint16_t>(src, decodedValue);
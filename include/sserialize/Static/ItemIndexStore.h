@@ -2,8 +2,11 @@
 #define SSERIALIZE_STATIC_ITEM_INDEX_STORE
 #include <sserialize/containers/SortedOffsetIndex.h>
 #include <sserialize/containers/ItemIndex.h>
+#include <sserialize/containers/ConcurrentCache.h>
+#include <sserialize/storage/BufferPool.h>
 #include "HuffmanDecoder.h"
 #include <unordered_set>
+#include <memory>
 #define SSERIALIZE_STATIC_ITEM_INDEX_STORE_VERSION 6
 
 /*Version 6
@@ -36,6 +39,8 @@ namespace Static {
 namespace interfaces {
 
 class ItemIndexStore: public RefCountObject {
+public:
+	typedef ConcurrentCache<uint32_t, ItemIndex>::Stats CacheStats;
 public:
 	ItemIndexStore() {}
 	virtual ~ItemIndexStore() {}
@@ -55,6 +60,9 @@ public:
 	virtual const UByteArrayAdapter & getData() const = 0;
 	virtual RCPtrWrapper<HuffmanDecoder> getHuffmanTree() const = 0;
 	virtual UByteArrayAdapter getHuffmanTreeData() const = 0;
+	///Stores without a cache ignore this
+	virtual void setCacheCapacity(uint32_t /*maxEntries*/, std::size_t /*maxBytes*/, uint32_t /*minIndexSize*/) {}
+	virtual CacheStats cacheStats() const { return CacheStats(); }
 };
 
 }//end namespace interfaces
@@ -130,6 +138,15 @@ public:
 	inline const UByteArrayAdapter & getData() const { return priv()->getData(); }
 	inline RCPtrWrapper<HuffmanDecoder> getHuffmanTree() const { return priv()->getHuffmanTree(); }
 	inline UByteArrayAdapter getHuffmanTreeData() const { return priv()->getHuffmanTreeData();}
+	/** Cache decoded indexes, the cache is thread-safe.
+	  * Cached indexes are stored fully decoded (as T_STL_VECTOR with 4 Bytes per entry) and can be shared between threads.
+	  * Only indexes with at least minIndexSize entries are admitted, smaller ones are cheaper to decode than to look up.
+	  * maxBytes bounds the memory used by the cached indexes, maxEntries == 0 disables the cache.
+	  * Both limits are split among the shards of the cache (at most maxEntries of them), indexes larger than maxBytes/shards are not cached.
+	  * Enabling or disabling the cache is not thread-safe, changing the capacity of an enabled cache is.
+	  */
+	inline void setCacheCapacity(uint32_t maxEntries, std::size_t maxBytes, uint32_t minIndexSize = 16) { priv()->setCacheCapacity(maxEntries, maxBytes, minIndexSize); }
+	inline interfaces::ItemIndexStore::CacheStats cacheStats() const { return priv()->cacheStats(); }
 };
 
 namespace detail {
@@ -148,7 +165,10 @@ private:
 		UByteArrayAdapter decompress(uint32_t id, const sserialize::UByteArrayAdapter & src) const;
 	private:
 		BoundedCompactUintArray m_data;
+		///output buffers of decompress, they return to the pool once the decompressed index is destroyed
+		mutable RCPtrWrapper<BufferPool> m_pool;
 	};
+	typedef ConcurrentCache<uint32_t, ItemIndex> IndexCache;
 private:
 	uint8_t m_version;
 	int m_type;
@@ -159,6 +179,10 @@ private:
 	RCPtrWrapper<HuffmanDecoder> m_hd;
 	RCPtrWrapper<LZODecompressor> m_lzod;
 	CompactUintArray m_idxTypeInfo;
+	std::unique_ptr<IndexCache> m_cache;
+	uint32_t m_cacheMinIndexSize;
+private:
+	ItemIndex decode(uint32_t pos) const;
 public:
 	ItemIndexStore();
 	ItemIndexStore(sserialize::UByteArrayAdapter data);
@@ -180,6 +204,8 @@ public:
 	virtual inline const UByteArrayAdapter & getData() const override { return m_data; }
 	virtual inline RCPtrWrapper<HuffmanDecoder> getHuffmanTree() const override { return m_hd; }
 	virtual UByteArrayAdapter getHuffmanTreeData() const override;
+	virtual void setCacheCapacity(uint32_t maxEntries, std::size_t maxBytes, uint32_t minIndexSize) override;
+	virtual CacheStats cacheStats() const override;
 };
 
 }//end namespace detail
@@ -52,6 +52,9 @@ public:
 	inline const Triangulation & tds() const { return m_grid.tds(); }
 	cellid_type cellId(double lat, double lon) const;
 	cellid_type cellId(const Point & p) const;
+	///Locate many points at once, see TriangulationGridLocator::faceIds
+	///@return cell ids in the order of points
+	std::vector<cellid_type> cellId(std::span<const Point> points, uint32_t threadCount = 1) const;
 	std::set<cellid_type> cellIds(double lat, double lon) const;
 	std::set<cellid_type> cellIds(const Point & p) const;
 	cellid_type cellIdFromFaceId(FaceId faceId) const;
@@ -2,6 +2,7 @@
 #define SSERIALIZE_STATIC_SPATIAL_TRIANGULATION_GRID_LOCATOR_H
 #include <sserialize/Static/Triangulation.h>
 #include <sserialize/Static/RGeoGrid.h>
+#include <span>
 
 #define SSERIALIZE_STATIC_SPATIAL_TRIANGULATION_GRID_LOCATOR_VERSION 2
 
@@ -30,6 +31,8 @@ public:
 	using SizeType = Triangulation::SizeType;
 	using Grid = sserialize::Static::spatial::RGeoGrid<sserialize::Static::spatial::Triangulation::FaceId>;
 	static constexpr FaceId NullFace = Triangulation::NullFace;
+	///number of consecutive points (in curve order) processed by a single task of faceIds
+	static constexpr std::size_t BatchChunkSize = 4096;
 private:
 	Triangulation m_trs;
 	Grid m_grid;
@@ -50,6 +53,14 @@ public:
 	FaceId faceId(const Point & p) const;
 	Face face(double lat, double lon) const;
 	Face face(const Point & p) const;
+	///Locate many points at once, result[i] is equal to faceId(points[i])
+	///Points are processed in the order of a hilbert curve over the grid.
+	///The face of the previous point is used as hint for the next one if both are in the same grid cell.
+	///@param threadCount number of threads, 0 uses the hardware concurrency
+	std::vector<FaceId> faceIds(std::span<const Point> points, uint32_t threadCount = 1) const;
+private:
+	///locate the points order[begin, end) which are sorted in curve order
+	void faceIds(std::span<const Point> points, const std::vector<uint64_t> & order, std::size_t begin, std::size_t end, std::vector<FaceId> & result) const;
 };
 
 }}}//end namespace
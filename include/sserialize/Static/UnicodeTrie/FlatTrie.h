@@ -6,7 +6,7 @@
 #include <sserialize/containers/UnicodeStringMap.h>
 #include <sserialize/vendor/utf8.h>
 #include <sserialize/iterator/Iterator.h>
-#define SSERIALIZE_STATIC_UNICODE_TRIE_FLAT_TRIE_BASE_VERSION 1
+#define SSERIALIZE_STATIC_UNICODE_TRIE_FLAT_TRIE_BASE_VERSION 2
 #define SSERIALIZE_STATIC_UNICODE_TRIE_FLAT_TRIE_VERSION 1
 
 namespace sserialize {
@@ -124,17 +124,25 @@ public:
 
 /** Layout:
   *
-  *-------------------------------------------------------------------
-  *VERSION|StringDataSize|    StringData   |StaticStrings(offset, len)|
-  *--------------------------------------------------------------------
-  *uin8t  |OffsetType    |UByteArrayAdapter|MultiVarBitArray         
+  *-----------------------------------------------------------------------------------------
+  *VERSION|FLAGS|StringDataSize|    StringData   |StaticStrings(offset, len)|*SearchIndex
+  *-----------------------------------------------------------------------------------------
+  *uin8t  |uint8|OffsetType    |UByteArrayAdapter|MultiVarBitArray          |
   *
+  * SearchIndex is only present if FLAGS contains F_SEARCH_INDEX:
+  *
+  *-----------------------------------------
+  *Stride  |Samples
+  *-----------------------------------------
+  *uint32_t|Array<UByteArrayAdapter>
+  *
+  * Sample i is a copy of the string at position i*Stride.
   *
   */
   
-class FlatTrieBase: sserialize::Static::SimpleVersion<1, FlatTrieBase> {
+class FlatTrieBase: sserialize::Static::SimpleVersion<2, FlatTrieBase> {
 public:
-	using Version = sserialize::Static::SimpleVersion<1, FlatTrieBase>;
+	using Version = sserialize::Static::SimpleVersion<2, FlatTrieBase>;
 	using SizeType = sserialize::MultiVarBitArray::SizeType;
 	typedef enum {TA_STR_OFFSET=0, TA_STR_LEN=1} TrieAccessors;
 	static constexpr SizeType npos = std::numeric_limits<SizeType>::max();
@@ -156,10 +164,18 @@ public:
 		inline StaticStringsIterator operator+(SizeType o) { return StaticStringsIterator(m_pos+o, m_trie); }
 		inline bool operator!=(const StaticStringsIterator & other) const { return m_pos != other.m_pos || m_trie != other.m_trie; }
 	};
+	typedef enum {F_NONE=0x0, F_SEARCH_INDEX=0x1} Flags;
+	static constexpr SizeType DefaultSearchIndexStride = 64;
+private:
+	using SearchIndexSamples = sserialize::Static::Array<sserialize::UByteArrayAdapter>;
 private:
 	sserialize::UByteArrayAdapter m_strData;
 	sserialize::MultiVarBitArray m_trie;
+	SizeType m_searchIndexStride;
+	SearchIndexSamples m_searchIndex;
 private:
+	///find str in the range [left, right]
+	SizeType find(const std::string & str, bool prefixMatch, SizeType left, SizeType right) const;
 	template<typename TVISITOR>
 	void visitDF(const Node & node, TVISITOR & visitor) {
 		visitor(node);
@@ -184,7 +200,12 @@ public:
 	UByteArrayAdapter strData(uint32_t pos) const;
 	inline StringSizeType strSize(const StaticString & str) const { return str.size(); }
 	inline StringSizeType strSize(SizeType pos) const { return strSize(sstr(pos)); }
+	///If the trie has a search index, then find() first searches its contiguous samples
+	///and only touches the strings between two samples instead of log2(size()) strings spread over the whole string data.
 	SizeType find(const std::string & str, bool prefixMatch) const;
+	inline bool hasSearchIndex() const { return m_searchIndexStride; }
+	///every searchIndexStride()-th string is sampled in the search index, 0 if there is none
+	inline SizeType searchIndexStride() const { return m_searchIndexStride; }
 	Node root() const;
 	std::ostream & printStats(std::ostream & out) const;
 	///visit all nodes in depth-first search
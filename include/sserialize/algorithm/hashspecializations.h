@@ -5,6 +5,7 @@
 #include <string>
 #include <vector>
 #include <functional>
+#include <cstring>
 #include <cryptopp/sha3.h>
 
 namespace CryptoPP {
@@ -111,6 +112,93 @@ public:
 		return data;
 	}
 };
+
+namespace detail {
+namespace FastHasher128 {
+
+constexpr uint64_t P0 = 0xa0761d6478bd642full;
+constexpr uint64_t P1 = 0xe7037ed1a0b428dbull;
+constexpr uint64_t P2 = 0x8ebc6af09c88c6e3ull;
+constexpr uint64_t P3 = 0x589965cc75374cc3ull;
+
+///64x64->128 bit multiplication folded to 64 bits
+inline uint64_t mum(uint64_t a, uint64_t b) {
+	__uint128_t r = static_cast<__uint128_t>(a)*b;
+	return static_cast<uint64_t>(r) ^ static_cast<uint64_t>(r >> 64);
+}
+
+inline uint64_t read64(const uint8_t * p) {
+	uint64_t v;
+	::memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+}} //end namespace detail::FastHasher128
+
+///Non-cryptographic 128 bit hash in the spirit of wyhash.
+///About an order of magnitude faster than ShaHasher and suitable for deduplication of trusted data.
+///The digest is not stable across platforms with different endianess.
+template<typename T>
+class FastHasher128;
+
+template<>
+class FastHasher128<sserialize::UByteArrayAdapter::MemoryView> {
+public:
+	static constexpr uint32_t DigestSize = 16;
+	using DigestData = ShaHasherDigestData;
+	using value_type = sserialize::UByteArrayAdapter::MemoryView;
+public:
+	FastHasher128(uint64_t seed = 0) : m_seed(seed) {}
+	inline DigestData operator()(const value_type & value) const {
+		return hash(value.begin(), value.size());
+	}
+	DigestData hash(const uint8_t * data, std::size_t size) const {
+		using namespace detail::FastHasher128;
+		//every input word is mixed into both lanes, otherwise half of the digest would not depend on short inputs
+		uint64_t s0 = m_seed ^ P0;
+		uint64_t s1 = m_seed ^ P1 ^ static_cast<uint64_t>(size);
+		const uint8_t * it = data;
+		std::size_t remaining = size;
+		for(; remaining >= 16; remaining -= 16, it += 16) {
+			uint64_t a = read64(it);
+			uint64_t b = read64(it+8);
+			s0 = mum(a ^ P1, b ^ s0);
+			s1 = mum(b ^ P3, a ^ s1);
+		}
+		if (remaining) {
+			uint8_t tail[16] = {0};
+			::memcpy(tail, it, remaining);
+			uint64_t a = read64(tail);
+			uint64_t b = read64(tail+8) ^ (static_cast<uint64_t>(remaining) << 56);
+			s0 = mum(a ^ P1, b ^ s0);
+			s1 = mum(b ^ P3, a ^ s1);
+		}
+		uint64_t h0 = mum(s0 ^ P3, s1 ^ P0);
+		uint64_t h1 = mum(s1 ^ P2, h0 ^ P3 ^ static_cast<uint64_t>(size));
+		h0 = mum(h0 ^ P1, h1 ^ P2);
+		DigestData result;
+		::memcpy(result.begin(), &h0, sizeof(h0));
+		::memcpy(result.begin()+sizeof(h0), &h1, sizeof(h1));
+		return result;
+	}
+private:
+	uint64_t m_seed;
+};
+
+template<>
+class FastHasher128<std::vector<uint8_t>> {
+public:
+	static constexpr uint32_t DigestSize = 16;
+	using DigestData = ShaHasherDigestData;
+	using value_type = std::vector<uint8_t>;
+public:
+	FastHasher128(uint64_t seed = 0) : m_h(seed) {}
+	inline DigestData operator()(const value_type & value) const {
+		return m_h.hash(value.data(), value.size());
+	}
+private:
+	FastHasher128<sserialize::UByteArrayAdapter::MemoryView> m_h;
+};
 	
 } //end namespace sserialize
 
@@ -7,7 +7,10 @@
 #include <queue>
 #include <mutex>
 #include <condition_variable>
+#include <future>
+#include <memory>
 #include <sserialize/containers/OOMArray.h>
+#include <sserialize/mt/ThreadPool.h>
 #include <sserialize/algorithm/utilcontainerfuncs.h>
 #include <sserialize/stats/ProgressInfo.h>
 #include <sserialize/stats/TimeMeasuerer.h>
@@ -18,65 +21,122 @@ namespace sserialize {
 namespace detail {
 namespace oom {
 
+///Buffered sequential reader of a source range
+///If a prefetcher is given, then the next buffer is filled asynchronously by the prefetcher while the current one is consumed.
+///In this case the InputBuffer holds two buffers of bufferSize bytes each.
 template<typename TSourceIterator, typename TValue = typename std::iterator_traits<TSourceIterator>::value_type>
 class InputBuffer {
 public:
 	typedef typename std::vector<TValue>::iterator iterator;
 	typedef TValue value_type;
 private:
-	TSourceIterator m_srcIt;
-	SizeType m_srcPos;
-	SizeType m_srcSize;
-	//in number of entries
-	SizeType m_bufferSize;
+	///The prefetch task only accesses this, hence it has to have a stable address
+	struct Source {
+		TSourceIterator it;
+		SizeType pos;
+		SizeType size;
+		//in number of entries
+		SizeType bufferSize;
+		//locked during reads if set
+		std::mutex * ioLock;
+		//filled by the prefetch task
+		std::vector<TValue> backBuffer;
+		Source(const TSourceIterator & it, SizeType size, SizeType bufferSize, std::mutex * ioLock) :
+		it(it), pos(0), size(size), bufferSize(bufferSize), ioLock(ioLock)
+		{}
+		bool eof() const { return pos >= size; }
+		void fill(std::vector<TValue> & buffer) {
+			buffer.clear();
+			std::unique_lock<std::mutex> lck;
+			if (ioLock) {
+				lck = std::unique_lock<std::mutex>(*ioLock);
+			}
+			for(SizeType copyAmount(0); copyAmount < bufferSize && pos < size; ++copyAmount, ++pos, ++it) {
+				buffer.push_back(*it);
+			}
+		}
+	};
+private:
+	std::unique_ptr<Source> m_src;
+	sserialize::ThreadPool * m_prefetcher{0};
+	std::future<void> m_prefetch;
 	std::vector<TValue> m_buffer;
 	iterator m_bufferIt;
 private:
 	void fillBuffer() {
-		m_buffer.clear();
-		SizeType copyAmount(0);
-		for(; copyAmount < m_bufferSize && m_srcPos < m_srcSize; ++copyAmount, ++m_srcPos, ++m_srcIt) {
-			m_buffer.push_back(*m_srcIt);
+		if (m_prefetch.valid()) {
+			m_prefetch.get();
+			std::swap(m_buffer, m_src->backBuffer);
+		}
+		else {
+			m_src->fill(m_buffer);
 		}
 		m_bufferIt = m_buffer.begin();
+		if (m_prefetcher && !m_src->eof()) {
+			prefetch();
+		}
+	}
+	void prefetch() {
+		auto promise = std::make_shared< std::promise<void> >();
+		m_prefetch = promise->get_future();
+		Source * src = m_src.get();
+		std::function<void()> task = [src, promise]() {
+			try {
+				src->fill(src->backBuffer);
+				promise->set_value();
+			}
+			catch (...) {
+				promise->set_exception(std::current_exception());
+			}
+		};
+		if (!m_prefetcher->sheduleTask(task)) {
+			task();
+		}
+	}
+	void waitForPrefetch() {
+		if (m_prefetch.valid()) {
+			m_prefetch.wait();
+		}
 	}
 public:
-	InputBuffer() : m_bufferSize(0), m_bufferIt(m_buffer.begin()) {}
+	InputBuffer() : m_bufferIt(m_buffer.begin()) {}
 	InputBuffer(const TSourceIterator & srcBegin, const TSourceIterator & srcEnd, SizeType bufferSize) :
 	InputBuffer(srcBegin, std::distance(srcBegin, srcEnd), bufferSize)
 	{
 		SSERIALIZE_CHEAP_ASSERT_SMALLER_OR_EQUAL(0, std::distance(srcBegin, srcEnd));
 	}
 	///@param bufferSize bufferSize in bytes
-	InputBuffer(const TSourceIterator & srcBegin, SizeType srcSize, SizeType bufferSize) :
-	m_srcIt(srcBegin),
-	m_srcPos(0),
-	m_srcSize(srcSize),
-	m_bufferSize(bufferSize/sizeof(value_type))
+	///@param prefetcher fills the next buffer asynchronously if set, it has to outlive this InputBuffer
+	///@param ioLock is locked during reads from the source if set
+	InputBuffer(const TSourceIterator & srcBegin, SizeType srcSize, SizeType bufferSize, sserialize::ThreadPool * prefetcher = 0, std::mutex * ioLock = 0) :
+	m_src(new Source(srcBegin, srcSize, std::max<SizeType>(1, bufferSize/sizeof(value_type)), ioLock)),
+	m_prefetcher(prefetcher)
 	{
-		m_buffer.reserve(m_bufferSize);
+		m_buffer.reserve(m_src->bufferSize);
 		fillBuffer();
 	}
 	InputBuffer(InputBuffer && other) :
-	m_srcIt(std::move(other.m_srcIt)),
-	m_srcPos(other.m_srcPos),
-	m_srcSize(other.m_srcSize),
-	m_bufferSize(other.m_bufferSize)
+	m_src(std::move(other.m_src)),
+	m_prefetcher(other.m_prefetcher),
+	m_prefetch(std::move(other.m_prefetch))
 	{
 		std::size_t bufferItOffset = other.m_bufferIt - other.m_buffer.begin();
 		m_buffer = std::move(other.m_buffer);
 		m_bufferIt = m_buffer.begin()+bufferItOffset;
 	}
 	InputBuffer & operator=(InputBuffer && other) {
-		m_srcIt = std::move(other.m_srcIt);
-		m_srcPos = other.m_srcPos;
-		m_srcSize = other.m_srcSize;
-		m_bufferSize = other.m_bufferSize;
+		waitForPrefetch();
+		m_src = std::move(other.m_src);
+		m_prefetcher = other.m_prefetcher;
+		m_prefetch = std::move(other.m_prefetch);
 		std::size_t bufferItOffset = other.m_bufferIt - other.m_buffer.begin();
 		m_buffer = std::move(other.m_buffer);
 		m_bufferIt = m_buffer.begin()+bufferItOffset;
 		return *this;
 	}
+	~InputBuffer() {
+		waitForPrefetch();
+	}
 	TValue & get() { return *m_bufferIt; }
 	const TValue & get() const { return *m_bufferIt; }
 	///return true if has next
@@ -92,11 +152,95 @@ public:
 	}
 };
 
+///Tree of losers for k-way merging.
+///Leaf i holds the current head of source i, every inner node holds the source that lost the match played at this node.
+///Replacing the head of the winning source only replays the matches on the path from its leaf to the root.
+///This needs log2(k) comparisons per element compared to about 2*log2(k) of a binary heap.
+///Ties are won by the source with the smaller index.
+template<typename TValue, typename TCompare>
+class LoserTree {
+public:
+	LoserTree(uint32_t k, const TCompare & compare) :
+	m_compare(compare),
+	m_k(k),
+	m_tree(std::max<uint32_t>(k, 1), 0),
+	m_values(k),
+	m_exhausted(k, 1)
+	{}
+	///Sets the head of source i, call build() after setting all heads
+	void set(uint32_t i, TValue && v) {
+		m_values.at(i) = std::move(v);
+		m_exhausted.at(i) = 0;
+	}
+	void build() {
+		if (!m_k) {
+			return;
+		}
+		//winners of the subtrees, leaves are at [k, 2k)
+		std::vector<uint32_t> winners(2*m_k);
+		for(uint32_t i(0); i < m_k; ++i) {
+			winners[m_k+i] = i;
+		}
+		for(uint32_t p(m_k-1); p > 0; --p) {
+			uint32_t a = winners[2*p];
+			uint32_t b = winners[2*p+1];
+			if (beats(a, b)) {
+				winners[p] = a;
+				m_tree[p] = b;
+			}
+			else {
+				winners[p] = b;
+				m_tree[p] = a;
+			}
+		}
+		m_tree[0] = winners[1];
+	}
+	bool empty() const { return !m_k || m_exhausted[m_tree[0]]; }
+	///source of the smallest head
+	uint32_t top() const { return m_tree[0]; }
+	TValue & topValue() { return m_values[m_tree[0]]; }
+	///The winning source has a new head
+	void replaceTop(TValue && v) {
+		m_values[m_tree[0]] = std::move(v);
+		replay();
+	}
+	///The winning source has no elements left
+	void popTop() {
+		m_exhausted[m_tree[0]] = 1;
+		replay();
+	}
+private:
+	bool beats(uint32_t a, uint32_t b) const {
+		if (m_exhausted[a] || m_exhausted[b]) {
+			return !m_exhausted[a] || (m_exhausted[b] && a < b);
+		}
+		if (m_compare(m_values[a], m_values[b])) {
+			return true;
+		}
+		return !m_compare(m_values[b], m_values[a]) && a < b;
+	}
+	void replay() {
+		uint32_t winner = m_tree[0];
+		for(uint32_t p((m_k+winner)/2); p > 0; p /= 2) {
+			if (beats(m_tree[p], winner)) {
+				std::swap(m_tree[p], winner);
+			}
+		}
+		m_tree[0] = winner;
+	}
+private:
+	TCompare m_compare;
+	uint32_t m_k;
+	std::vector<uint32_t> m_tree;
+	std::vector<TValue> m_values;
+	std::vector<uint8_t> m_exhausted;
+};
+
 template<typename TIterator, typename TIteratorCategory = typename std::iterator_traits<TIterator>::iterator_category>
 struct InMemorySort {
 	static constexpr bool canSort = false;
 	template<typename TCompare>
-	inline static void sort(const TIterator &/*begin*/, const TIterator &/*end*/, const TCompare &/*compare*/) {}
+	inline static void sort(const TIterator &/*begin*/, const TIterator &/*end*/, const TCompare &/*compare*/, uint32_t /*numThreads*/) {}
 	template<typename TEqual>
 	inline static void uniqe(const TIterator &/*begin*/, const TIterator &/*end*/, const TEqual &/*equal*/) {}
 };
@@ -105,8 +249,8 @@ template<typename TIterator>
 struct InMemorySort<TIterator, std::random_access_iterator_tag> {
 	static constexpr bool canSort = true;
 	template<typename TCompare>
-	inline static void sort(const TIterator & begin, const TIterator & end, const TCompare & compare) {
-		std::sort(begin, end, compare);
+	inline static void sort(const TIterator & begin, const TIterator & end, const TCompare & compare, uint32_t numThreads) {
+		sserialize::mt_sort(begin, end, compare, numThreads);
 	}
 	template<typename TEqual>
 	inline static TIterator unique(const TIterator & begin, const TIterator & end, const TEqual & equal) {
@@ -188,6 +332,7 @@ private: //need to come first in order to access them with decltype
 	sserialize::MmappedMemoryType m_mmt{sserialize::MM_FILEBASED};
 	uint32_t m_queueDepth{64};
 	uint32_t m_maxWait{10};
+	bool m_prefetch{true};
 public:
 	SortTraits(Compare c = Compare(), Equal e = Equal()) : m_compare(c), m_equal(e) {}
 	~SortTraits() {}
@@ -205,6 +350,8 @@ public:
 	SSERIALIZE_OOM_SORT_TRAITS_GET_SET(queueDepth)
 	//maximum time a thread waits before it (temporarily) removes itself from processing
 	SSERIALIZE_OOM_SORT_TRAITS_GET_SET(maxWait)
+	//fill the input buffers of parallel merges asynchronously while the current buffers are merged
+	SSERIALIZE_OOM_SORT_TRAITS_GET_SET(prefetch)
 #undef SSERIALIZE_OOM_SORT_TRAITS_GET_SET
 public:
 	Compare compare() const { return m_compare; }
@@ -217,15 +364,17 @@ public:
 
 ///A standard out-of-memory sorting algorithm. It first sorts the input in chunks of size maxMemoryUsage/threadCount
 ///These chunks are then merged together in possibly multiple phases. In a single phase up to queueDepth chunks are merged together.
+///If threadCount > 1 then the chunks of a phase are split into threadCount ranges of the key space which are merged in parallel.
+///Chunks are merged with a loser tree. Parallel merges read their input asynchronously if prefetch is enabled.
+///Inputs that fit into memory are sorted with mt_sort using threadCount threads.
 ///@param maxMemoryUsage default is 4 GB
-///@param threadCount should be no larger than about 4, 2 should be sufficient for standard io-speeds, used fo the initial chunk sorting, a single chunk then has a size of maxMemoryUsage/threadCount
+///@param threadCount used for the initial chunk sorting and the merge phases, a single chunk then has a size of maxMemoryUsage/threadCount
 ///@param queueDepth the maximum number of chunks to merge in a single round, this directly influences the number of merge rounds
 ///@param comp comparisson operator. This functions needs to be thread-safe <=> threadCount > 1
 ///@param equal equality operator, only used if TUniquify is true. This functions needs to be thread-safe <=> threadCount > 1
 ///@return points to the last element of the sorted sequence
 ///In general: Larger chunks result in a smaller number of rounds and can be processed with a smaller queue depth reducing random access
 ///Thus for very large data sizes it may be better to use only one thread to create the largest chunks possible
-///TODO: use mt_sort for large chunks if threadCount == 1 or add ability to define a sort operator
 template<
 	typename TInputOutputIterator,
 	typename Traits =
@@ -240,6 +389,7 @@ TInputOutputIterator oom_sort(TInputOutputIterator begin, TInputOutputIterator e
 	typedef TInputOutputIterator SrcIterator;
 	typedef typename std::iterator_traits<SrcIterator>::value_type value_type;
 	typedef detail::oom::InputBuffer<SrcIterator> InputBuffer;
+	typedef detail::oom::LoserTree<value_type, typename Traits::Compare> LoserTree;
 // 	using std::next;
 	
 	
@@ -274,8 +424,6 @@ TInputOutputIterator oom_sort(TInputOutputIterator begin, TInputOutputIterator e
 		uint64_t initialChunkSize;
 		//tmp buffer size in bytes
 		uint64_t tmpBuffferSize;
-		//merge buffer size in number of entries
-		uint64_t mergeBufferEntries;
 		Config(Traits & traits) :
 			traits(traits),
 			initialChunkSize(this->traits.maxMemoryUsage()/(traits.maxThreadCount()*sizeof(value_type)))
@@ -302,8 +450,7 @@ TInputOutputIterator oom_sort(TInputOutputIterator begin, TInputOutputIterator e
 
 		//if TUniquify is true, then these are NOT necessarily contiguous, BUT they are always sorted in ascending order
 		std::vector< ChunkDescription > pendingChunks;
-		std::vector<InputBuffer> activeChunkBuffers;
-		std::vector<value_type> activeChunkBufferValues;
+		std::atomic<uint64_t> mergeCompleted;
 	};
 	
 	Config cfg(traits);
@@ -321,7 +468,7 @@ TInputOutputIterator oom_sort(TInputOutputIterator begin, TInputOutputIterator e
 		if (Traits::withProgressInfo) {
 			std::cout << "Using in-memory sorting..." << std::flush;
 		}
-		detail::oom::InMemorySort<TInputOutputIterator>::sort(begin, end, traits.compare());
+		detail::oom::InMemorySort<TInputOutputIterator>::sort(begin, end, traits.compare(), traits.maxThreadCount());
 		if (traits.makeUnique()) {
 			using std::unique;
 			return unique(begin, end, traits.equal());
@@ -484,381 +631,285 @@ TInputOutputIterator oom_sort(TInputOutputIterator begin, TInputOutputIterator e
 	//now merge the chunks, use at most 1/4 or 1 GiB  of memory for the temporary storage
 	//Using more than 1 GiB will likely reduce the write performance since then we are writing very large chunks while the queue is full
 	cfg.tmpBuffferSize = std::min<uint64_t>(1024*1024*1024, cfg.traits.maxMemoryUsage()/4);
-	if (traits.maxThreadCount() > 1) {
-		cfg.mergeBufferEntries = std::max<uint64_t>(128, cfg.traits.maxMemoryUsage()/(4*sizeof(value_type)*(traits.maxThreadCount()-1)));
-	}
 	sserialize::OOMArray<value_type> tmp(traits.mmt());
 	
-	for(uint32_t queueRound(0); state.pendingChunks.size() > 1; ++queueRound) {
-		state.pinfo.begin(state.resultSize, std::string("Merging sorted chunks round ") + std::to_string(queueRound));
-		
-		std::vector<ChunkDescription> nextRoundPendingChunks;
-		
-		detail::oom::IteratorSyncer<TInputOutputIterator>::sync(begin);
-		
-		//setup temporary store
-		tmp.clear();
-		
-		for(uint32_t cbi(0), cbs((uint32_t)state.pendingChunks.size()); cbi < cbs;) {
-			{//fill the activeChunkBuffers
-				SSERIALIZE_CHEAP_ASSERT(!state.activeChunkBuffers.size());
-				SSERIALIZE_CHEAP_ASSERT(!state.activeChunkBufferValues.size());
-				uint64_t chunkBufferSize = traits.maxMemoryUsage();
-				chunkBufferSize -= cfg.tmpBuffferSize;
-				chunkBufferSize -= sizeof(value_type)*cfg.mergeBufferEntries*(traits.maxThreadCount()-1);
-				chunkBufferSize /= std::min<uint32_t>(traits.queueDepth(), cbs-cbi);
-				for(; cbi < cbs && state.activeChunkBuffers.size() < traits.queueDepth(); ++cbi) {
-					const ChunkDescription & pendingChunk = state.pendingChunks.at(cbi);
-					if (!traits.makeUnique() || pendingChunk.size()) {
-						state.activeChunkBuffers.emplace_back(begin+pendingChunk.first, pendingChunk.size(), chunkBufferSize);
-						state.activeChunkBufferValues.emplace_back(state.activeChunkBuffers.back().get());
-					}
+	///Merges a group of chunks with multiple threads.
+	///The key space is split into maxThreadCount ranges by splitters sampled from the chunks.
+	///Every range is merged by its own thread into its own region of tmp, hence the threads need no synchronization.
+	///Equal elements always end up in the same range which keeps makeUnique local to a range.
+	class RangeMerger final {
+	public:
+		RangeMerger(Config * cfg, State * state, const SrcIterator & srcBegin, sserialize::OOMArray<value_type> * dest, const std::vector<ChunkDescription> & chunks) :
+		m_cfg(cfg),
+		m_state(state),
+		m_srcBegin(srcBegin),
+		m_dest(dest),
+		m_chunks(chunks),
+		m_rangeCount(cfg->traits.maxThreadCount()),
+		m_bounds(chunks.size()*(m_rangeCount+1))
+		{}
+		///@return the number of elements written to dest
+		uint64_t operator()() {
+			split();
+			uint64_t destBegin = m_dest->size();
+			uint64_t groupSize = 0;
+			std::vector<uint64_t> rangeOffsets(m_rangeCount);
+			for(uint32_t r(0); r < m_rangeCount; ++r) {
+				rangeOffsets[r] = destBegin+groupSize;
+				for(std::size_t c(0); c < m_chunks.size(); ++c) {
+					groupSize += bound(c, r+1)-bound(c, r);
 				}
 			}
+			//resize dest to the maximum target size to facilitate parallel io
+			m_dest->truncate(destBegin+groupSize);
 			
-			//add our result chunk to the queue (we don't know the size yet, just the beginning)
-			nextRoundPendingChunks.emplace_back(tmp.size());
-			
-			struct PrioComp {
-				typename Traits::Compare comp;
-				std::vector<value_type> * chunkBufferValues;
-				bool operator()(uint32_t a, uint32_t b) {
-					const value_type & av = (*chunkBufferValues)[a];
-					const value_type & bv = (*chunkBufferValues)[b];
-					return !( comp(av, bv) );
-				}
-				PrioComp(typename Traits::Compare comp, std::vector<value_type> * chunkBufferValues) : comp(comp), chunkBufferValues(chunkBufferValues) {}
-				PrioComp(const PrioComp & other) : comp(other.comp), chunkBufferValues(other.chunkBufferValues) {}
-			};
-			
-			typedef std::priority_queue<uint32_t, std::vector<uint32_t>, PrioComp> MyPrioQ;
-			
-			if (traits.maxThreadCount() > 1) {
-				//use 1/4 of max memory for all buffers, but at least 128 entries per buffer
-				//We have a single fetch and multiple push threads
-				class PreQueue final {
-				public:
-					PreQueue(Config * cfg, State * state, uint32_t chunkBegin, uint32_t chunkEnd) : 
-					m_cfg(cfg),
-					m_state(state),
-					m_queue(PrioComp(m_cfg->traits.compare(), &(m_state->activeChunkBufferValues))),
-					m_bufferSize(std::max<std::size_t>(m_cfg->mergeBufferEntries/2, 1))
-					{
-						for(; chunkBegin != chunkEnd; ++chunkBegin) {
-							m_queue.push(chunkBegin);
-						}
-					}
-					PreQueue(PreQueue const &) = delete;
-					PreQueue(PreQueue && other) :
-					m_cfg(other.m_cfg),
-					m_state(other.m_state),
-					m_queue(std::move(other.m_queue)),
-					m_bufferSize(other.m_bufferSize),
-					m_frontBuffer(std::move(other.m_frontBuffer)),
-					m_frontBufferPos(other.m_frontBufferPos),
-					m_backBuffer(std::move(other.m_backBuffer)),
-					m_eof(other.m_eof)
-					{}
-					PreQueue & operator=(PreQueue &&) = delete;
-					PreQueue & operator=(PreQueue const &) = delete;
-					~PreQueue() {}
-				public:
-					///Since we don't use locking only a single consumer is allowed
-					///if this returns true, then result holds a new value
-					///Otherwise no new value is available anymore
-					bool pop(value_type & result) {
-						if (m_frontBufferPos >= m_frontBuffer.size()) {
-							std::unique_lock<std::mutex> lck(m_lock);
-							if (m_backBuffer.size()) {
-								std::swap(m_frontBuffer, m_backBuffer);
-								m_frontBufferPos = 0;
-								m_backBuffer.clear();
-								m_prod_cv.notify_one();
-							}
-							else if (!m_eof) {
-								m_prod_cv.notify_one();
-								m_con_cv.wait(lck, [&]() { return m_backBuffer.size() || m_eof; });
-								if (m_backBuffer.size()) {
-									std::swap(m_backBuffer, m_frontBuffer);
-									m_frontBufferPos = 0;
-									m_backBuffer.clear();
-									m_prod_cv.notify_one();
-								}
-								else {
-									SSERIALIZE_CHEAP_ASSERT(m_eof);
-									return false;
-								}
-							}
-							else {
-								return false;
-							}
-						}
-						result = std::move(m_frontBuffer[m_frontBufferPos]);
-						m_frontBufferPos += 1;
-						return true;
-					}
-					void run() {
-						while (!m_eof) {
-							std::unique_lock<std::mutex> lck(m_lock);
-							if (m_backBuffer.size()) {
-								m_prod_cv.wait(lck, [&](){ return !m_backBuffer.size(); });
-							}
-							fillBackBuffer();
-							m_eof = !m_queue.size();
-							m_con_cv.notify_one();
-						}
+			std::unique_ptr<sserialize::ThreadPool> prefetcher;
+			if (m_cfg->traits.prefetch()) {
+				prefetcher.reset(new sserialize::ThreadPool(m_rangeCount));
+			}
+			std::vector<uint64_t> rangeSizes(m_rangeCount, 0);
+			std::vector<std::thread> workers;
+			std::vector<std::exception_ptr> errors(m_rangeCount);
+			for(uint32_t r(0); r < m_rangeCount; ++r) {
+				workers.emplace_back([&, r]() {
+					try {
+						rangeSizes[r] = merge(r, rangeOffsets[r], prefetcher.get());
 					}
-					void init() {
-						std::lock_guard<std::mutex> lck(m_lock);
-						fillBackBuffer();
-						std::swap(m_backBuffer, m_frontBuffer);
-						fillBackBuffer();
+					catch (...) {
+						errors[r] = std::current_exception();
 					}
-				private:
-					///m_lock has to be locked
-					void fillBackBuffer() {
-						SSERIALIZE_CHEAP_ASSERT(!m_backBuffer.size());
-						while (m_queue.size() && m_backBuffer.size() < m_bufferSize) {
-							uint32_t pqMin = m_queue.top();
-							m_queue.pop();
-							InputBuffer & chunkBuffer = m_state->activeChunkBuffers[pqMin];
-							value_type & v = m_state->activeChunkBufferValues[pqMin];
-							m_backBuffer.emplace_back(std::move(v));
-							if (chunkBuffer.next()) {
-								m_state->activeChunkBufferValues[pqMin] = chunkBuffer.get();
-								m_queue.push(pqMin);
-							}
+				});
+			}
+			for(std::thread & t : workers) {
+				t.join();
+			}
+			for(std::exception_ptr & e : errors) {
+				if (e) {
+					std::rethrow_exception(e);
+				}
+			}
+			//ranges with duplicates have gaps in between them
+			uint64_t destEnd = rangeOffsets[0]+rangeSizes[0];
+			for(uint32_t r(1); r < m_rangeCount; ++r) {
+				moveLeft(rangeOffsets[r], rangeSizes[r], destEnd);
+				destEnd += rangeSizes[r];
+			}
+			if (destEnd != destBegin+groupSize) {
+				m_dest->resize(destEnd);
+			}
+			return destEnd-destBegin;
+		}
+	private:
+		uint64_t & bound(std::size_t chunk, uint32_t range) { return m_bounds[chunk*(m_rangeCount+1)+range]; }
+		///computes the begin of every range in every chunk
+		void split() {
+			auto comp = m_cfg->traits.compare();
+			//number of samples per range taken from each chunk
+			constexpr uint32_t SampleFactor = 8;
+			uint32_t samplesPerChunk = m_rangeCount*SampleFactor;
+			auto samplePos = [&](std::size_t c, uint32_t j) -> uint64_t {
+				return m_chunks[c].first + m_chunks[c].size()*j/samplesPerChunk;
+			};
+			std::vector<value_type> samples;
+			samples.reserve(m_chunks.size()*samplesPerChunk);
+			for(std::size_t c(0); c < m_chunks.size(); ++c) {
+				for(uint32_t j(0); j < samplesPerChunk; ++j) {
+					samples.push_back(*(m_srcBegin+samplePos(c, j)));
+				}
+			}
+			std::vector<value_type> splitters(samples);
+			std::sort(splitters.begin(), splitters.end(), comp);
+			for(uint32_t r(1); r < m_rangeCount; ++r) {
+				splitters[r-1] = splitters[splitters.size()*r/m_rangeCount];
+			}
+			for(std::size_t c(0); c < m_chunks.size(); ++c) {
+				bound(c, 0) = m_chunks[c].first;
+				bound(c, m_rangeCount) = m_chunks[c].second;
+				for(uint32_t r(1); r < m_rangeCount; ++r) {
+					const value_type & splitter = splitters[r-1];
+					//narrow the search window with the samples of this chunk
+					uint64_t lo = bound(c, r-1);
+					uint64_t hi = m_chunks[c].second;
+					for(uint32_t j(0); j < samplesPerChunk; ++j) {
+						uint64_t p = samplePos(c, j);
+						if (p < lo) {
+							continue;
 						}
-					}
-				private:
-					Config * m_cfg;
-					State * m_state;
-					MyPrioQ m_queue;
-					std::size_t m_bufferSize{0};
-					std::vector<value_type> m_frontBuffer; //only touched by the consumer thread
-					std::size_t m_frontBufferPos{0};
-					std::vector<value_type> m_backBuffer;
-					std::mutex m_lock; //locks access to the backBuffer
-					std::condition_variable m_prod_cv;
-					std::condition_variable m_con_cv;
-					bool m_eof{false};
-				};
-				
-				class FlushQueue final {
-				public:
-					FlushQueue(Config * cfg, State * state, sserialize::OOMArray<value_type> * dest) :
-					m_cfg(cfg),
-					m_state(state),
-					m_dest(dest),
-					m_offset(m_dest->size())
-					{
-						SSERIALIZE_CHEAP_ASSERT_SMALLER(m_dest->size(), state->resultSize);
-						//resize dest to maximum target size to facilitate parallel io
-						m_dest->truncate(state->resultSize);
-
-						uint32_t numWorkers;
-						if (cfg->traits.mmt() == MM_SLOW_FILEBASED || cfg->traits.ioFlushLock()) {
-							numWorkers = 1;
+						if (comp(samples[c*samplesPerChunk+j], splitter)) {
+							lo = p+1;
 						}
 						else {
-							numWorkers = std::max<uint32_t>(2, (cfg->traits.maxThreadCount()-2)/2);
-						}
-						for(uint32_t i(0); i < numWorkers; ++i) {
-							m_workers.emplace_back([this](){ this->run();});
+							hi = p;
+							break;
 						}
-						m_bufferSize = std::max<std::size_t>(128, cfg->tmpBuffferSize/(m_workers.size()*sizeof(value_type)));
 					}
-					~FlushQueue() {
-						flush();
-						m_running = false;
-						m_cv.notify_all();
-						for(auto & x : m_workers) {
-							x.join();
-						}
-						//flush last entry
-						m_dest->replace(m_offset, m_data.begin(), m_data.end());
-						//resize dest to correct size
-						m_dest->resize(size());
-					}
-					uint64_t size() const {
-						return m_offset+m_data.size();
-					}
-					value_type const & back() const {
-						return m_data.back();
-					}
-					void emplace_back(value_type && value) {
-						m_data.emplace_back(std::move(value));
-						if (m_data.size() >= m_bufferSize) {
-							flush();
+					//lower bound of splitter in [lo, hi)
+					while (lo < hi) {
+						uint64_t mid = lo + (hi-lo)/2;
+						if (comp(*(m_srcBegin+mid), splitter)) {
+							lo = mid+1;
 						}
-					}
-				public:
-					//Flush data
-					void flush() {
-						//Check if we can flush data without exceeding our memory constraints
-						{
-							std::unique_lock<std::mutex> lck(m_submitLock);
-							if (m_pendingFlushSize >= m_bufferSize*m_workers.size()) {
-								m_submitCv.wait(lck, [&]{ return m_pendingFlushSize < m_bufferSize*m_workers.size(); });
-							}
-						}
-						
-						//we move the last entry to our next buffer to implement the back() function
-						std::vector<value_type> oldData;
-						oldData.reserve(m_bufferSize);
-						
-						std::lock_guard<std::mutex> lck(m_lock);
-						std::swap(oldData, m_data);
-						m_data.emplace_back(std::move(oldData.back()));
-						
-						oldData.pop_back();
-						std::size_t dataSize = oldData.size();
-						m_entries.emplace(m_offset, std::move(oldData));
-						
-						m_offset += dataSize;
-						m_pendingFlushSize += dataSize;
-						
-						m_cv.notify_one();
-					}
-				private:
-					struct Entry {
-						uint64_t offset;
-						std::vector<value_type> data;
-						Entry(uint64_t offset, std::vector<value_type> && data) :
-						offset(offset),
-						data(std::move(data))
-						{}
-						Entry(Entry &&) = default;
-						Entry & operator=(Entry &&) = default;
-					};
-				private:
-					///function run by the worker threads
-					void run() {
-						std::unique_lock<std::mutex> lck(m_lock, std::defer_lock);
-						while (true) {
-							lck.lock();
-							if (!m_entries.size()) {
-								if (m_running.load(std::memory_order_relaxed)) {
-									m_cv.wait(lck, [&](){ return m_entries.size() || !m_running.load(std::memory_order_relaxed);});
-								}
-							}
-							if (!m_entries.size()) {
-								SSERIALIZE_CHEAP_ASSERT(!m_running.load(std::memory_order_relaxed));
-								break;
-							}
-							Entry e = std::move(m_entries.front());
-							m_entries.pop();
-							lck.unlock();
-							SSERIALIZE_CHEAP_ASSERT_SMALLER_OR_EQUAL(e.offset+e.data.size(), m_dest->size());
-							m_dest->replace(e.offset, e.data.begin(), e.data.end());
-							//notify submit thread that it can continue issuing new data
-							std::lock_guard<std::mutex> submitLck(m_submitLock);
-							m_pendingFlushSize -= e.data.size();
-							m_submitCv.notify_one();
+						else {
+							hi = mid;
 						}
 					}
-				private:
-					Config * m_cfg;
-					State * m_state;
-					sserialize::OOMArray<value_type> * m_dest;
-					std::size_t m_bufferSize;
-					uint64_t m_offset;
-					std::vector<value_type> m_data; //This is only touched by the single producer thread
-					std::vector<std::thread> m_workers;
-					std::queue<Entry> m_entries;
-					std::mutex m_lock;
-					std::condition_variable m_cv;
-					std::atomic_bool m_running{true};
-					std::mutex m_submitLock;
-					std::condition_variable m_submitCv;
-					std::size_t m_pendingFlushSize{0};
-				};
-				
-				std::vector<PreQueue> queues;
-				std::vector<value_type> queueValues;
-				std::vector<std::thread> queueWorkers;
-				{
-					std::size_t chunksPerQueue = state.activeChunkBuffers.size()/(traits.maxThreadCount()-1)+std::size_t(state.activeChunkBuffers.size()%(traits.maxThreadCount()-1) > 0);
-					for(std::size_t i(0); i < state.activeChunkBuffers.size(); i += chunksPerQueue) {
-						queues.emplace_back(
-								&cfg,
-								&state,
-								uint32_t(i),
-								std::min<uint32_t>(state.activeChunkBuffers.size(), i+chunksPerQueue)
-						);
-					}
+					bound(c, r) = lo;
 				}
-
-				for(std::size_t i(0), s(queues.size()); i < s; ++i) {
-					queueWorkers.emplace_back([&](std::size_t mainQueueId) {
-						queues[mainQueueId].init();
-					}, i);
+			}
+		}
+		///@return number of elements written
+		uint64_t merge(uint32_t range, uint64_t destOffset, sserialize::ThreadPool * prefetcher) {
+			Traits & traits = m_cfg->traits;
+			std::mutex * fetchLock = traits.ioFetchLock() ? &(m_state->ioLock) : 0;
+			std::size_t inputCount = 0;
+			for(std::size_t c(0); c < m_chunks.size(); ++c) {
+				inputCount += bound(c, range) < bound(c, range+1);
+			}
+			if (!inputCount) {
+				return 0;
+			}
+			uint64_t bufferSize = (traits.maxMemoryUsage()-m_cfg->tmpBuffferSize)/(m_rangeCount*inputCount);
+			if (prefetcher) {
+				bufferSize /= 2;
+			}
+			std::size_t outBufferEntries = std::max<uint64_t>(128, m_cfg->tmpBuffferSize/(m_rangeCount*sizeof(value_type)));
+			
+			std::vector<InputBuffer> inputs;
+			inputs.reserve(inputCount);
+			LoserTree tree(inputCount, traits.compare());
+			for(std::size_t c(0); c < m_chunks.size(); ++c) {
+				if (bound(c, range) < bound(c, range+1)) {
+					inputs.emplace_back(m_srcBegin+bound(c, range), bound(c, range+1)-bound(c, range), bufferSize, prefetcher, fetchLock);
+					tree.set(inputs.size()-1, std::move(inputs.back().get()));
 				}
-				
-				for(std::size_t i(0), s(queueWorkers.size()); i < s; ++i) {
-					queueWorkers[i].join();
+			}
+			tree.build();
+			
+			std::vector<value_type> out;
+			out.reserve(outBufferEntries);
+			value_type last;
+			uint64_t written = 0;
+			auto flush = [&]() {
+				std::unique_lock<std::mutex> lck(m_state->ioLock, std::defer_lock);
+				if (traits.ioFlushLock()) {
+					lck.lock();
 				}
-				queueWorkers.clear();
-				
-				for(std::size_t i(0), s(queues.size()); i < s; ++i) {
-					queueWorkers.emplace_back([&](std::size_t mainQueueId) {
-						queues[mainQueueId].run();
-					}, i);
+				m_dest->replace(destOffset+written, out.data(), out.data()+out.size());
+				if (lck.owns_lock()) {
+					lck.unlock();
 				}
-				
-				MyPrioQ pq(PrioComp(traits.compare(), &queueValues));
-				queueValues.resize(queues.size());
-				
-				for(std::size_t i(0); i < queues.size(); ++i) {
-					if (queues[i].pop(queueValues[i])) { 
-						pq.push(i);
-					}
+				written += out.size();
+				m_state->mergeCompleted += out.size();
+				last = std::move(out.back());
+				out.clear();
+				if (range == 0) {
+					m_state->pinfo(m_state->mergeCompleted);
 				}
-				
-				FlushQueue flushQueue(&cfg, &state, &tmp);
-
-				while(pq.size()) {
-					uint32_t pqMin = pq.top();
-					pq.pop();
-					value_type & v = queueValues[pqMin];
-					if (!traits.makeUnique() || !flushQueue.size() || !traits.equal()(flushQueue.back(), v)) {
-						flushQueue.emplace_back(std::move(v));
-					}
-					//get our next element
-					if (queues[pqMin].pop(v)) {
-						pq.push(pqMin);
-					}
-					if (flushQueue.size() % 1000 == 0) {
-						state.pinfo(flushQueue.size());
+			};
+			while (!tree.empty()) {
+				uint32_t i = tree.top();
+				value_type & v = tree.topValue();
+				if (!traits.makeUnique() || !(out.size() || written) || !traits.equal()(out.size() ? out.back() : last, v)) {
+					out.emplace_back(std::move(v));
+					if (out.size() >= outBufferEntries) {
+						flush();
 					}
-					SSERIALIZE_CHEAP_ASSERT_SMALLER_OR_EQUAL(flushQueue.size(), state.resultSize);
 				}
-				for(std::size_t i(0), s(queueWorkers.size()); i < s; ++i) {
-					queueWorkers[i].join();
+				if (inputs[i].next()) {
+					tree.replaceTop(std::move(inputs[i].get()));
+				}
+				else {
+					tree.popTop();
+				}
+			}
+			if (out.size()) {
+				flush();
+			}
+			return written;
+		}
+		///moves [src, src+count) to dest <= src
+		void moveLeft(uint64_t src, uint64_t count, uint64_t dest) {
+			SSERIALIZE_CHEAP_ASSERT_SMALLER_OR_EQUAL(dest, src);
+			if (src == dest || !count) {
+				return;
+			}
+			uint64_t blockSize = std::max<uint64_t>(1, m_cfg->tmpBuffferSize/sizeof(value_type));
+			std::vector<value_type> block;
+			for(uint64_t i(0); i < count; i += blockSize) {
+				uint64_t blockCount = std::min<uint64_t>(blockSize, count-i);
+				block.clear();
+				auto it = m_dest->begin()+(src+i);
+				for(uint64_t j(0); j < blockCount; ++j, ++it) {
+					block.push_back(*it);
+				}
+				m_dest->replace(dest+i, block.data(), block.data()+block.size());
+			}
+		}
+	private:
+		Config * m_cfg;
+		State * m_state;
+		SrcIterator m_srcBegin;
+		sserialize::OOMArray<value_type> * m_dest;
+		const std::vector<ChunkDescription> & m_chunks;
+		uint32_t m_rangeCount;
+		std::vector<uint64_t> m_bounds;
+	};
+	
+	for(uint32_t queueRound(0); state.pendingChunks.size() > 1; ++queueRound) {
+		state.pinfo.begin(state.resultSize, std::string("Merging sorted chunks round ") + std::to_string(queueRound));
+		state.mergeCompleted = 0;
+		
+		std::vector<ChunkDescription> nextRoundPendingChunks;
+		
+		detail::oom::IteratorSyncer<TInputOutputIterator>::sync(begin);
+		
+		//setup temporary store
+		tmp.clear();
+		
+		for(uint32_t cbi(0), cbs((uint32_t)state.pendingChunks.size()); cbi < cbs;) {
+			std::vector<ChunkDescription> chunks;
+			for(; cbi < cbs && chunks.size() < traits.queueDepth(); ++cbi) {
+				const ChunkDescription & pendingChunk = state.pendingChunks.at(cbi);
+				if (!traits.makeUnique() || pendingChunk.size()) {
+					chunks.push_back(pendingChunk);
 				}
 			}
+			
+			//add our result chunk to the queue (we don't know the size yet, just the beginning)
+			nextRoundPendingChunks.emplace_back(tmp.size());
+			
+			if (traits.maxThreadCount() > 1) {
+				tmp.flush();
+				tmp.backBufferSize(0);
+				tmp.readBufferSize(cfg.tmpBuffferSize);
+				RangeMerger(&cfg, &state, begin, &tmp, chunks)();
+			}
 			else {
 				tmp.reserve(state.resultSize);
 				tmp.backBufferSize(cfg.tmpBuffferSize);
 				tmp.readBufferSize(sizeof(value_type));
 				
-				MyPrioQ pq(PrioComp(traits.compare(), &(state.activeChunkBufferValues)));
-			
-				for(std::size_t i(0); i < state.activeChunkBuffers.size(); ++i) {
-					pq.push(i);
+				uint64_t chunkBufferSize = (traits.maxMemoryUsage()-cfg.tmpBuffferSize)/std::max<std::size_t>(1, chunks.size());
+				std::vector<InputBuffer> chunkBuffers;
+				chunkBuffers.reserve(chunks.size());
+				LoserTree tree(chunks.size(), traits.compare());
+				for(std::size_t i(0); i < chunks.size(); ++i) {
+					chunkBuffers.emplace_back(begin+chunks[i].first, chunks[i].size(), chunkBufferSize);
+					tree.set(i, std::move(chunkBuffers.back().get()));
 				}
+				tree.build();
 			
-				while (pq.size()) {
-					uint32_t pqMin = pq.top();
-					pq.pop();
-					InputBuffer & chunkBuffer = state.activeChunkBuffers[pqMin];
-					value_type & v = state.activeChunkBufferValues[pqMin];
+				while (!tree.empty()) {
+					uint32_t i = tree.top();
+					value_type & v = tree.topValue();
 					if (!traits.makeUnique() || !tmp.size() || !traits.equal()(tmp.back(), v)) {
 						tmp.emplace_back(std::move(v));
 					}
-					if (chunkBuffer.next()) {
-						state.activeChunkBufferValues[pqMin] = chunkBuffer.get();
-						pq.push(pqMin);
+					if (chunkBuffers[i].next()) {
+						tree.replaceTop(std::move(chunkBuffers[i].get()));
+					}
+					else {
+						tree.popTop();
 					}
 					if (tmp.size() % 1000 == 0) {
 						state.pinfo(tmp.size());
@@ -877,8 +928,6 @@ TInputOutputIterator oom_sort(TInputOutputIterator begin, TInputOutputIterator e
 				//since then all elements of the chunks are appended to tmp
 				nextRoundPendingChunks.pop_back();
 			}
-			state.activeChunkBuffers.clear();
-			state.activeChunkBufferValues.clear();
 		}
 		
 		if (traits.makeUnique()) {
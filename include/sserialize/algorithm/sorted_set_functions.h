@@ -0,0 +1,39 @@
+#ifndef SSERIALIZE_SORTED_SET_FUNCTIONS_H
+#define SSERIALIZE_SORTED_SET_FUNCTIONS_H
+#include <cstdint>
+#include <cstddef>
+
+/**
+  * Set operations on decoded, strictly increasing uint32_t arrays.
+  * These are the kernels used by the ItemIndex set operations.
+  * Inputs of similar size are processed by a simd block merge (if the cpu supports SSE4.2),
+  * inputs whose sizes differ by more than SkewThreshold use galloping search in the larger input.
+  *
+  * dest has to provide space for maxSize elements of the respective operation and must not alias the inputs.
+  * All functions return the number of elements written to dest.
+  */
+
+namespace sserialize {
+namespace sortedset {
+
+///Use galloping if one input is at least SkewThreshold times larger than the other
+constexpr std::size_t SkewThreshold = 32;
+
+///maxSize = min(aSize, bSize)
+std::size_t intersect(const uint32_t * a, std::size_t aSize, const uint32_t * b, std::size_t bSize, uint32_t * dest);
+///maxSize = aSize + bSize
+std::size_t unite(const uint32_t * a, std::size_t aSize, const uint32_t * b, std::size_t bSize, uint32_t * dest);
+///maxSize = aSize
+std::size_t difference(const uint32_t * a, std::size_t aSize, const uint32_t * b, std::size_t bSize, uint32_t * dest);
+///maxSize = aSize + bSize
+std::size_t symmetricDifference(const uint32_t * a, std::size_t aSize, const uint32_t * b, std::size_t bSize, uint32_t * dest);
+
+///@return first element in [begin, end) that is not smaller than v, search starts with exponentially growing steps at begin
+const uint32_t * gallop(const uint32_t * begin, const uint32_t * end, uint32_t v);
+
+///@return true if the simd kernels are used on this cpu
+bool hasSimdSupport();
+
+}}//end namespace sserialize::sortedset
+
+#endif
@@ -0,0 +1,276 @@
+#ifndef SSERIALIZE_CONCURRENT_CACHE_H
+#define SSERIALIZE_CONCURRENT_CACHE_H
+#include <sserialize/algorithm/hashspecializations.h>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+#include <shared_mutex>
+#include <limits>
+#include <memory>
+
+namespace sserialize {
+
+/**
+  * Thread-safe cache.
+  * Keys are distributed onto shards by their hash, every shard has its own lock.
+  * Each shard evicts entries using CLOCK with a small usage counter per entry.
+  * This approximates LFU with amortized O(1) eviction.
+  *
+  * The capacity is given by a maximum number of entries and a maximum total cost (i.e. the size in bytes).
+  * Both limits are split evenly among the shards, hence the effective capacity is rounded up to a multiple of the shard count.
+  * Small caches use fewer shards: there are never more shards in use than maxEntries.
+  * Entries whose cost exceeds the cost limit of a shard are not cached at all.
+  * A limit of 0 disables the cache.
+  * setCapacity() may be called concurrently with all other operations, it waits for running operations to finish.
+  */
+template<typename TKey, typename TValue, typename THash = std::hash<TKey>, typename TKeyEqual = std::equal_to<TKey>>
+class ConcurrentCache final {
+public:
+	struct Stats {
+		uint64_t hits{0};
+		uint64_t misses{0};
+		uint64_t insertions{0};
+		uint64_t evictions{0};
+		std::size_t size{0};
+		std::size_t cost{0};
+	};
+	static constexpr std::size_t Unlimited = std::numeric_limits<std::size_t>::max();
+	static constexpr uint32_t DefaultShardCount = 16;
+private:
+	static constexpr uint8_t MaxUsage = 3;
+	struct Node {
+		TValue value;
+		std::size_t cost;
+		std::size_t slot;
+		uint8_t usage;
+		Node(TValue const & value, std::size_t cost) : value(value), cost(cost), slot(0), usage(1) {}
+	};
+	using Map = std::unordered_map<TKey, Node, THash, TKeyEqual>;
+	using MapEntry = typename Map::value_type;
+	//aligned to not share cache lines between the locks of different shards
+	struct alignas(64) Shard {
+		std::mutex lock;
+		Map entries;
+		///the clock, pointers to entries are stable
+		std::vector<MapEntry*> clock;
+		std::vector<std::size_t> freeSlots;
+		std::size_t hand{0};
+		std::size_t cost{0};
+		Stats stats;
+	};
+private:
+	THash m_hash;
+	std::unique_ptr<Shard[]> m_shards;
+	uint32_t m_shardCount;
+	///guards the configuration below, operations take it shared, setCapacity() exclusively
+	mutable std::shared_mutex m_configLock;
+	///number of shards in use, 0 if the cache is disabled
+	uint32_t m_activeShards;
+	std::size_t m_maxEntries;
+	std::size_t m_maxCost;
+private:
+	///activeShards has to be larger than 0
+	Shard & shard(TKey const & key, uint32_t activeShards) const {
+		std::size_t h = m_hash(key);
+		return m_shards[(h ^ (h >> 29)) % activeShards];
+	}
+	uint32_t activeShards(std::size_t maxEntries, std::size_t maxCost) const {
+		if (!maxEntries || !maxCost) {
+			return 0;
+		}
+		return (uint32_t) std::min<std::size_t>(m_shardCount, maxEntries);
+	}
+	std::size_t perShard(std::size_t limit, uint32_t activeShards) const {
+		return limit == Unlimited ? Unlimited : std::max<std::size_t>(1, (limit + activeShards - 1)/activeShards);
+	}
+	///evict one entry of a non-empty shard, shard needs to be locked
+	void evict(Shard & s) const {
+		while (true) {
+			if (s.hand >= s.clock.size()) {
+				s.hand = 0;
+			}
+			MapEntry * e = s.clock[s.hand];
+			if (e && e->second.usage) {
+				e->second.usage -= 1;
+			}
+			else if (e) {
+				s.cost -= e->second.cost;
+				s.clock[s.hand] = nullptr;
+				s.freeSlots.push_back(s.hand);
+				s.entries.erase(e->first);
+				s.stats.evictions += 1;
+				s.hand += 1;
+				return;
+			}
+			s.hand += 1;
+		}
+	}
+	///shard needs to be locked
+	void shrink(Shard & s, std::size_t maxEntries, std::size_t maxCost) const {
+		while (s.entries.size() && (s.entries.size() > maxEntries || s.cost > maxCost)) {
+			evict(s);
+		}
+	}
+public:
+	ConcurrentCache(std::size_t maxEntries = Unlimited, std::size_t maxCost = Unlimited, uint32_t shardCount = DefaultShardCount) :
+	m_shards(new Shard[std::max<uint32_t>(shardCount, 1)]),
+	m_shardCount(std::max<uint32_t>(shardCount, 1)),
+	m_activeShards(activeShards(maxEntries, maxCost)),
+	m_maxEntries(maxEntries),
+	m_maxCost(maxCost)
+	{}
+	ConcurrentCache(ConcurrentCache const &) = delete;
+	ConcurrentCache & operator=(ConcurrentCache const &) = delete;
+	~ConcurrentCache() {}
+	void setCapacity(std::size_t maxEntries, std::size_t maxCost = Unlimited) {
+		std::unique_lock<std::shared_mutex> configLck(m_configLock);
+		m_maxEntries = maxEntries;
+		m_maxCost = maxCost;
+		uint32_t active = activeShards(maxEntries, maxCost);
+		if (active != m_activeShards) {
+			m_activeShards = active;
+			//keys map to different shards now
+			clear();
+			return;
+		}
+		for(uint32_t i(0); i < active; ++i) {
+			std::lock_guard<std::mutex> lck(m_shards[i].lock);
+			shrink(m_shards[i], perShard(m_maxEntries, active), perShard(m_maxCost, active));
+		}
+	}
+	std::size_t maxEntries() const {
+		std::shared_lock<std::shared_mutex> configLck(m_configLock);
+		return m_maxEntries;
+	}
+	std::size_t maxCost() const {
+		std::shared_lock<std::shared_mutex> configLck(m_configLock);
+		return m_maxCost;
+	}
+	///number of shards in use
+	uint32_t shardCount() const {
+		std::shared_lock<std::shared_mutex> configLck(m_configLock);
+		return m_activeShards;
+	}
+	///@return true if key was found, value is only set in this case
+	bool find(TKey const & key, TValue & value) const {
+		std::shared_lock<std::shared_mutex> configLck(m_configLock);
+		uint32_t active = m_activeShards;
+		if (!active) {
+			return false;
+		}
+		Shard & s = shard(key, active);
+		std::lock_guard<std::mutex> lck(s.lock);
+		auto it = s.entries.find(key);
+		if (it == s.entries.end()) {
+			s.stats.misses += 1;
+			return false;
+		}
+		s.stats.hits += 1;
+		it->second.usage = std::min<uint8_t>(it->second.usage+1, MaxUsage);
+		value = it->second.value;
+		return true;
+	}
+	bool contains(TKey const & key) const {
+		std::shared_lock<std::shared_mutex> configLck(m_configLock);
+		uint32_t active = m_activeShards;
+		if (!active) {
+			return false;
+		}
+		Shard & s = shard(key, active);
+		std::lock_guard<std::mutex> lck(s.lock);
+		return s.entries.count(key);
+	}
+	///Inserts or replaces the value of key
+	///Values are computed outside of the cache, two threads missing the same key may insert the same key concurrently
+	void insert(TKey const & key, TValue const & value, std::size_t cost = 1) const {
+		std::shared_lock<std::shared_mutex> configLck(m_configLock);
+		uint32_t active = m_activeShards;
+		if (!active) {
+			return;
+		}
+		Shard & s = shard(key, active);
+		std::size_t maxEntries = perShard(m_maxEntries, active);
+		std::size_t maxCost = perShard(m_maxCost, active);
+		std::lock_guard<std::mutex> lck(s.lock);
+		auto it = s.entries.find(key);
+		if (it != s.entries.end()) {
+			s.cost -= it->second.cost;
+			s.clock[it->second.slot] = nullptr;
+			s.freeSlots.push_back(it->second.slot);
+			s.entries.erase(it);
+		}
+		if (cost > maxCost) {
+			return;
+		}
+		shrink(s, maxEntries-1, maxCost-cost);
+		it = s.entries.emplace(key, Node(value, cost)).first;
+		if (s.freeSlots.size()) {
+			it->second.slot = s.freeSlots.back();
+			s.freeSlots.pop_back();
+			s.clock[it->second.slot] = &(*it);
+		}
+		else {
+			it->second.slot = s.clock.size();
+			s.clock.push_back(&(*it));
+		}
+		s.cost += cost;
+		s.stats.insertions += 1;
+	}
+	void erase(TKey const & key) const {
+		std::shared_lock<std::shared_mutex> configLck(m_configLock);
+		uint32_t active = m_activeShards;
+		if (!active) {
+			return;
+		}
+		Shard & s = shard(key, active);
+		std::lock_guard<std::mutex> lck(s.lock);
+		auto it = s.entries.find(key);
+		if (it != s.entries.end()) {
+			s.cost -= it->second.cost;
+			s.clock[it->second.slot] = nullptr;
+			s.freeSlots.push_back(it->second.slot);
+			s.entries.erase(it);
+		}
+	}
+	void clear() {
+		for(uint32_t i(0); i < m_shardCount; ++i) {
+			Shard & s = m_shards[i];
+			std::lock_guard<std::mutex> lck(s.lock);
+			s.entries.clear();
+			s.clock.clear();
+			s.freeSlots.clear();
+			s.hand = 0;
+			s.cost = 0;
+		}
+	}
+	///number of cached entries
+	std::size_t size() const {
+		return stats().size;
+	}
+	///Accumulated statistics of all shards
+	Stats stats() const {
+		Stats result;
+		for(uint32_t i(0); i < m_shardCount; ++i) {
+			Shard & s = m_shards[i];
+			std::lock_guard<std::mutex> lck(s.lock);
+			result.hits += s.stats.hits;
+			result.misses += s.stats.misses;
+			result.insertions += s.stats.insertions;
+			result.evictions += s.stats.evictions;
+			result.size += s.entries.size();
+			result.cost += s.cost;
+		}
+		return result;
+	}
+	void resetStats() {
+		for(uint32_t i(0); i < m_shardCount; ++i) {
+			Shard & s = m_shards[i];
+			std::lock_guard<std::mutex> lck(s.lock);
+			s.stats = Stats();
+		}
+	}
+};
+
+}//end namespace sserialize
+
+#endif
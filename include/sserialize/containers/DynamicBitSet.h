@@ -3,6 +3,7 @@
 #include <sserialize/storage/UByteArrayAdapter.h>
 #include <sserialize/containers/AbstractArray.h>
 #include <sserialize/containers/ItemIndex.h>
+#include <string.h>
 
 namespace sserialize {
 
@@ -11,6 +12,17 @@ class DynamicBitSet;
 namespace detail {
 namespace DynamicBitSet {
 
+///Bits are stored lsb first, hence bit i of the set is bit i%64 of the (i/64)-th little-endian 64 bit word
+///@param avail number of valid bytes at src, missing bytes are zero
+inline uint64_t loadWord(const uint8_t * src, std::size_t avail = 8) {
+	uint64_t v = 0;
+	::memcpy(&v, src, std::min<std::size_t>(avail, 8));
+#if defined(__BYTE_ORDER__) && __BYTE_ORDER__ == __ORDER_BIG_ENDIAN__
+	v = __builtin_bswap64(v);
+#endif
+	return v;
+}
+
 class DynamicBitSetIdIterator: public sserialize::detail::AbstractArrayIterator<SizeType> {
 public:
 	DynamicBitSetIdIterator();
@@ -28,19 +40,32 @@ private:
 	void moveToNextSetBit();
 private:
 	const sserialize::DynamicBitSet * m_p;
+	///only valid if the data of m_p is contiguous
+	UByteArrayAdapter::MemoryView m_mem;
+	UByteArrayAdapter::OffsetType m_size;
+	///byte offset of the next word
 	UByteArrayAdapter::OffsetType m_off;
-	SizeType m_curId; 
-	uint8_t m_d;
-	uint8_t m_remainingBits;
+	SizeType m_curId;
+	///id of the first bit of the current word
+	SizeType m_wordId;
+	///remaining set bits of the current word, the lowest is the current one
+	uint64_t m_w;
 };
 
 
 }}
 
+/**
+  * A bit set stored in an UByteArrayAdapter, bit i is bit i%8 of byte i/8.
+  * All operations work on 64 bit words of the underlying memory (with AVX2 if the cpu supports it).
+  * This is fastest for contiguous storage like the default in-memory storage.
+  * Storage that is not contiguous is copied once per operation.
+  */
 class DynamicBitSet final {
 public:
 	///An iterator that iterates over the set ids
 	typedef AbstractArrayIterator<SizeType> const_iterator;
+	static constexpr SizeType npos = std::numeric_limits<SizeType>::max();
 private:
 	UByteArrayAdapter m_data;
 public:
@@ -57,7 +82,9 @@ public:
 	///@param shift: number of bytes to align to expressed as a power of two. i.e. 0 => 1 byte, 1 => 2 bytes, 2 => 4 bytes, 3 => 8 bytes
 	bool align(uint8_t shift);
 	
+	///@return smallest set id or 8*data().size() if no bit is set
 	IdType smallestEntry() const;
+	///@return largest set id or 0 if no bit is set
 	IdType largestEntry() const;
 	//a good upper bound for the largest Entry
 	IdType upperBound() const;
@@ -93,21 +120,28 @@ public:
 	template<typename T_OUTPUT_ITERATOR>
 	void putInto(T_OUTPUT_ITERATOR out) const {
 		UByteArrayAdapter::OffsetType s = m_data.size();
-		UByteArrayAdapter::OffsetType i = 0;
+		if (!s) {
+			return;
+		}
+		const UByteArrayAdapter::MemoryView mv(m_data.asMemView());
+		const uint8_t * d = mv.data();
 		SizeType id = 0;
-		for(; i < s; ++i) {
-			uint8_t d = m_data.getUint8(i);
-			for(SizeType curId(id); d; ++curId, d >>= 1) {
-				if (d & 0x1) {
-					*out = curId;
-					++out;
-				}
+		for(UByteArrayAdapter::OffsetType i(0); i < s; i += 8, id += 64) {
+			for(uint64_t w(detail::DynamicBitSet::loadWord(d+i, s-i)); w; w &= w-1) {
+				*out = id + SizeType(__builtin_ctzll(w));
+				++out;
 			}
-			id += 8;
 		}
 	}
 	
+	///number of set bits, same as count()
 	SizeType size() const;
+	///number of set bits
+	SizeType count() const;
+	///@return number of set bits in [0, pos)
+	SizeType rank(SizeType pos) const;
+	///@return position of the set bit with rank n or npos if count() <= n
+	SizeType select(SizeType n) const;
 	
 	const_iterator cbegin() const;
 	const_iterator cend() const;
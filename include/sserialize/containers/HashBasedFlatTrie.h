@@ -241,6 +241,8 @@ public:
 		m_strHandler.strStorage = &m_stringData;
 		const StringHandler * strHandlerPtr = &m_strHandler;
 		m_ht = HashTable(HashFunc1(strHandlerPtr), HashFunc2(strHandlerPtr), StringEq(strHandlerPtr), 0.8, HTValueStorage(hashMMT), HTStorage(hashMMT));
+		//string comparisons are expensive, the control bytes reject most of them
+		m_ht.probingMode(HashTable::PM_GROUPED);
 	}
 	HashBasedFlatTrie(HashBasedFlatTrie const&) = delete;
 	~HashBasedFlatTrie() {}
@@ -293,6 +295,11 @@ public:
 	TValue & at(std::string const & str);
 	TValue const & at(std::string const & str) const;
 	TValue & operator[](const StaticString & str);
+	///Move all strings of other into this trie, other is empty afterwards.
+	///Strings already in this trie keep their value, new strings get the value from other.
+	///Only the string data of new strings is copied. Overlapping strings of other (i.e. a string and its suffixes) share their data afterwards as well.
+	///This allows to fill a trie per thread and merge them afterwards. You have to call finalize() again.
+	void merge(HashBasedFlatTrie && other);
 	///You have to call finalize() before using this @param prefixMatch strIt->strEnd can be a prefix of the path
 	template<typename T_OCTET_ITERATOR>
 	NodePtr findNode(T_OCTET_ITERATOR strIt, const T_OCTET_ITERATOR& strEnd, bool prefixMatch);
@@ -309,11 +316,12 @@ public:
 	}
 	
 	///append just the trie, no payload
-	bool append(UByteArrayAdapter & dest);
+	///@param searchIndexStride sample every searchIndexStride-th string into the search index of the static trie, 0 omits the search index
+	bool append(UByteArrayAdapter & dest, SizeType searchIndexStride = sserialize::Static::UnicodeTrie::FlatTrieBase::DefaultSearchIndexStride);
 	
 	///you can only call this after finalize(), calls payloadHandler in in-order
 	template<typename T_PH, typename T_STATIC_PAYLOAD = typename std::result_of<T_PH(NodePtr)>::type>
-	bool append(UByteArrayAdapter & dest, T_PH payloadHandler, std::size_t threadCount = 1);
+	bool append(UByteArrayAdapter & dest, T_PH payloadHandler, std::size_t threadCount = 1, SizeType searchIndexStride = sserialize::Static::UnicodeTrie::FlatTrieBase::DefaultSearchIndexStride);
 	
 	static NodePtr make_nodeptr(Node & node) { return NodePtr(node); }
 	static NodePtr make_nodeptr(const Node & node) { return NodePtr(node); }
@@ -594,6 +602,53 @@ HashBasedFlatTrie<TValue>::insert(T_OCTET_ITERATOR begin, const T_OCTET_ITERATOR
 	return insert(std::string(begin, end));
 }
 
+template<typename TValue>
+void
+HashBasedFlatTrie<TValue>::merge(HashBasedFlatTrie && other) {
+	if (&other == this || !other.size()) {
+		return;
+	}
+	if (!size()) {
+		m_ht.reserve(other.size());
+	}
+	//collect the strings that are new to this trie
+	std::vector<const typename HashTable::value_type*> newStrings;
+	{
+		std::lock_guard<std::mutex> lck(m_specStrLock);
+		for(const auto & x : other.m_ht) {
+			m_strHandler.specialString = other.m_strHandler.strBegin(x.first);
+			bool known = (m_ht.find(StaticString::make_special(x.first.size())) != m_ht.end());
+			m_strHandler.specialString = 0;
+			if (!known) {
+				newStrings.push_back(&x);
+			}
+		}
+	}
+	//copy the string data of overlapping strings (i.e. a string and its suffixes) only once
+	std::sort(newStrings.begin(), newStrings.end(), [](const typename HashTable::value_type * a, const typename HashTable::value_type * b) {
+		return a->first.offset() < b->first.offset();
+	});
+	for(auto it(newStrings.begin()), end(newStrings.end()); it != end;) {
+		typename StaticString::OffsetType rangeBegin = (*it)->first.offset();
+		typename StaticString::OffsetType rangeEnd = rangeBegin + (*it)->first.size();
+		auto rangeIt = it;
+		for(++rangeIt; rangeIt != end && (*rangeIt)->first.offset() < rangeEnd; ++rangeIt) {
+			rangeEnd = std::max<typename StaticString::OffsetType>(rangeEnd, (*rangeIt)->first.offset() + (*rangeIt)->first.size());
+		}
+		if (rangeEnd - rangeBegin > StaticString::noff - m_stringData.size()) {
+			throw sserialize::OutOfBoundsException("HashBasedFlatTrie::merge: string data is too large");
+		}
+		typename StaticString::OffsetType baseOff;
+		narrow_check_assign(baseOff) = m_stringData.size();
+		m_stringData.push_back(other.m_stringData.cbegin()+rangeBegin, other.m_stringData.cbegin()+rangeEnd);
+		for(; it != rangeIt; ++it) {
+			m_ht[StaticString(baseOff + ((*it)->first.offset() - rangeBegin), (*it)->first.size())] = (*it)->second;
+		}
+	}
+	other.m_ht.clear();
+	other.m_stringData.clear();
+}
+
 template<typename TValue>
 void HashBasedFlatTrie<TValue>::finalize(uint64_t nodeBeginOff, uint64_t nodeEndOff, StaticString::SizeType posInStr) {
 	if (nodeBeginOff != nodeEndOff) {
@@ -703,14 +758,18 @@ bool HashBasedFlatTrie<TValue>::checkTrieEquality(const Static::UnicodeTrie::Fla
 }
 
 template<typename TValue>
-bool HashBasedFlatTrie<TValue>::append(UByteArrayAdapter & dest) {
+bool HashBasedFlatTrie<TValue>::append(UByteArrayAdapter & dest, SizeType searchIndexStride) {
 	sserialize::ProgressInfo pinfo;
 	sserialize::TimeMeasurer tm;
 
 #if defined(SSERIALIZE_EXPENSIVE_ASSERT_ENABLED)
 	UByteArrayAdapter::OffsetType flatTrieBaseBeginOffset = dest.tellPutPtr();
 #endif
-	dest.putUint8(1); //version of FlatTrieBase
+	if (searchIndexStride > std::numeric_limits<uint32_t>::max()) {
+		throw sserialize::OutOfBoundsException("Search index stride is too large");
+	}
+	dest.putUint8(2); //version of FlatTrieBase
+	dest.putUint8(searchIndexStride ? sserialize::Static::UnicodeTrie::FlatTrieBase::F_SEARCH_INDEX : sserialize::Static::UnicodeTrie::FlatTrieBase::F_NONE);
 	dest.putOffset(m_stringData.size());
 	
 	std::cout << "Copying string data(" << sserialize::prettyFormatSize(m_stringData.size()) << ")..." << std::flush;
@@ -750,6 +809,21 @@ bool HashBasedFlatTrie<TValue>::append(UByteArrayAdapter & dest) {
 	}
 	tsCreator.flush();
 	pinfo.end();
+	
+	if (searchIndexStride) {
+		dest.putUint32(searchIndexStride);
+		sserialize::Static::ArrayCreator<UByteArrayAdapter> samplesCreator(dest);
+		SizeType pos = 0;
+		for(const auto & x : m_ht) {
+			if (pos % searchIndexStride == 0) {
+				samplesCreator.beginRawPut();
+				samplesCreator.rawPut().putData(reinterpret_cast<const uint8_t*>(m_strHandler.strBegin(x.first)), x.first.size());
+				samplesCreator.endRawPut();
+			}
+			++pos;
+		}
+		samplesCreator.flush();
+	}
 #if defined(SSERIALIZE_EXPENSIVE_ASSERT_ENABLED)
 	{
 		UByteArrayAdapter tmp(dest);
@@ -765,12 +839,12 @@ bool HashBasedFlatTrie<TValue>::append(UByteArrayAdapter & dest) {
 
 template<typename TValue>
 template<typename T_PH, typename T_STATIC_PAYLOAD>
-bool HashBasedFlatTrie<TValue>::append(UByteArrayAdapter & dest, T_PH payloadHandler, std::size_t threadCount) {
+bool HashBasedFlatTrie<TValue>::append(UByteArrayAdapter & dest, T_PH payloadHandler, std::size_t threadCount, SizeType searchIndexStride) {
 	if (size() > std::numeric_limits<SizeType>::max()) {
 		throw sserialize::CreationException("HashBasedFlatTrie: unable to serialize. Too many nodes.");
 	}
 
-	if (!append(dest)) {
+	if (!append(dest, searchIndexStride)) {
 		return false;
 	}
 	sserialize::ProgressInfo pinfo;
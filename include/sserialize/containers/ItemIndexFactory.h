@@ -7,6 +7,8 @@
 #include <iostream>
 #include <mutex>
 #include <shared_mutex>
+#include <array>
+#include <exception>
 #include <sserialize/storage/UByteArrayAdapter.h>
 #include <sserialize/algorithm/utilcontainerfuncs.h>
 #include <sserialize/containers/ItemIndex.h>
@@ -16,8 +18,63 @@
 #include <sserialize/storage/pack_unpack_functions.h>
 #include <sserialize/containers/MMVector.h>
 #include <sserialize/algorithm/hashspecializations.h>
+#include <sserialize/mt/ThreadPool.h>
 
 namespace sserialize {
+namespace detail {
+
+///Computes the exact storage size of the index types whose size only depends on the gaps between the ids.
+///Feed it all ids in ascending order, all supported types are handled in the same scan.
+class ItemIndexSizeEstimator final {
+public:
+	using SizeType = UByteArrayAdapter::SizeType;
+	static constexpr int SupportedTypes = ItemIndex::T_NATIVE | ItemIndex::T_DE | ItemIndex::T_RLE_DE | ItemIndex::T_ELIAS_FANO;
+public:
+	ItemIndexSizeEstimator() {}
+	template<typename T_ITERATOR>
+	ItemIndexSizeEstimator(T_ITERATOR begin, const T_ITERATOR & end) {
+		for(; begin != end; ++begin) {
+			push_back(*begin);
+		}
+	}
+	inline void push_back(uint32_t id) {
+		uint32_t diff = id - m_prev;
+		m_deDataSize += psize_vu32(diff);
+		if (diff == m_rleDiff) {
+			++m_rle;
+		}
+		else {
+			m_rleDeDataSize += rleSize();
+			m_rle = 1;
+			m_rleDiff = diff;
+		}
+		m_prev = id;
+		++m_count;
+	}
+	static inline bool supports(int type) { return (type & SupportedTypes) == type; }
+	///@return size in bytes of the index created with ItemIndexFactory::create, type has to be supported
+	SizeType size(int type) const;
+private:
+	///size of the current run as encoded by ItemIndexPrivateRleDECreator
+	inline SizeType rleSize() const {
+		if (m_rle == 1) {
+			return psize_vu32(m_rleDiff << 1);
+		}
+		else if (m_rle) {
+			return psize_vu32((m_rle << 1) | 0x1) + psize_vu32(m_rleDiff << 1);
+		}
+		return 0;
+	}
+private:
+	uint32_t m_count{0};
+	uint32_t m_prev{0};
+	uint32_t m_rle{0};
+	uint32_t m_rleDiff{0};
+	SizeType m_deDataSize{0};
+	SizeType m_rleDeDataSize{0};
+};
+
+}//end namespace detail
 
 /** This class is a storage for multiple ItemIndex. It can create a file suitable for the Static::IndexStore.
 	Live-Compression is currenty only available for VARUINT.
@@ -60,8 +117,17 @@ public:
 	private:
 		uint32_t m_v{INVALID};
 	};
+	///DH_SHA3 uses ShaHasher, DH_FAST uses the much faster non-cryptographic FastHasher128
+	enum DeduplicationHash { DH_SHA3=0, DH_FAST=1 };
 	typedef ShaHasherDigestData DataHashKey;
-	typedef std::unordered_map<DataHashKey, IndexId> DataHashType; //Hash->id
+	struct DataHashValue {
+		IndexId id;
+		UByteArrayAdapter::OffsetType dataOffset;
+		UByteArrayAdapter::SizeType dataSize;
+	};
+	typedef std::unordered_map<DataHashKey, DataHashValue> DataHashType; //Hash->id
+	///The deduplication map is split into shards with their own lock to reduce contention of concurrent addIndex calls
+	static constexpr std::size_t DataHashShardCount = 64;
 	typedef sserialize::MMVector<uint64_t > IdToOffsetsType;
 	typedef sserialize::MMVector<uint32_t> ItemIndexSizesContainer;
 	typedef sserialize::MMVector<uint8_t> ItemIndexTypesContainer;
@@ -79,6 +145,7 @@ public:
 	Static::ItemIndexStore::IndexCompressionType compressionType() const { return m_compressionType; }
 	UByteArrayAdapter at(OffsetType offset) const;
 	///Sets the type of the indexes. If T_MULTIPLE is set, then the index with the smallest size is chosen to be stored
+	///The sizes of NATIVE, DE, RLE_DE and ELIAS_FANO are computed without encoding the index, only the chosen type is created
 	void setType(int type);
 	///create the ItemIndexStore at the beginning of data
 	void setIndexFile(UByteArrayAdapter data);
@@ -88,6 +155,11 @@ public:
 	void setCheckIndex(bool checkIndex) { m_checkIndex = checkIndex;}
 	//default is on
 	void setDeduplication(bool dedup) { m_useDeduplication  = dedup; }
+	///Changing the hash function recalculates the deduplication data, default is DH_FAST
+	void setDeduplicationHash(DeduplicationHash dh);
+	DeduplicationHash deduplicationHash() const { return m_dedupHash; }
+	///Compare the index data byte by byte on a hash hit, default is off
+	void setDeduplicationVerification(bool verify) { m_verifyDeduplication = verify; }
 	
 	void setGrowSize(UByteArrayAdapter::SizeType v) { m_growSize = v; }
 	
@@ -124,6 +196,8 @@ public:
 	static UByteArrayAdapter::OffsetType compressWithVarUint(sserialize::Static::ItemIndexStore & store, UByteArrayAdapter & dest);
 	static UByteArrayAdapter::OffsetType compressWithLZO(sserialize::Static::ItemIndexStore & store, UByteArrayAdapter & dest);
 	
+	///Indexes with at least this many ids are trial-encoded in parallel if type & ItemIndex::T_MULTIPLE
+	static constexpr std::size_t ParallelCreationThreshold = 1 << 20;
 	///@return the type created if type & ItemIndex::T_MULTIPLE, ItemIndex::T_NULL if creation failed
 	template<typename TSortedContainer>
 	static ItemIndex::Types create(const TSortedContainer& idx, sserialize::UByteArrayAdapter& dest, int type, ItemIndex::CompressionLevel cl = ItemIndex::CL_DEFAULT);
@@ -137,6 +211,15 @@ private:
 	DataHashKey hashFunc(const std::vector< uint8_t >& v);
 	///returns the id of the index or -1 if none was found @thread-safety: yes
 	int64_t getIndex(const std::vector< uint8_t >& v, DataHashKey & hv);
+	inline std::size_t dataHashShard(const DataHashKey & hv) const { return hv.data[DataHashKey::DigestSize-1] % DataHashShardCount; }
+	///@thread-safety: yes
+	bool dataEqual(const DataHashValue & v, const std::vector<uint8_t> & idx);
+	///@return id of the index data, calls pushIndex for new data
+	uint32_t addDeduplicatedIndex(const std::vector<uint8_t> & idx, uint32_t idxSize, ItemIndex::Types type);
+	///writes the index data and its aux data at the position reserved by reserveIndex @thread-safety: true
+	void pushIndex(const std::vector<uint8_t> & idx, uint32_t idxSize, ItemIndex::Types type, IndexId indexId, UByteArrayAdapter::OffsetType dataOffset);
+	void reserveIndex(const std::vector<uint8_t> & idx, IndexId & indexId, UByteArrayAdapter::OffsetType & dataOffset);
+	void clearDeduplicationData();
 	///adds the data of an index to store @thread-safety: true
 	uint32_t addIndex(const std::vector<uint8_t> & idx, uint32_t idxSize, ItemIndex::Types type);
 private:
@@ -146,7 +229,11 @@ private:
 	//meta data
 	UByteArrayAdapter::SizeType m_dataOffset;
 	uint64_t m_idCounter;
-	DataHashType m_hash;
+	struct DataHashShard {
+		std::mutex lock;
+		DataHashType hash;
+	};
+	std::array<DataHashShard, DataHashShardCount> m_hash;
 	
 	//aux data
 	IdToOffsetsType m_idToOffsets;
@@ -159,6 +246,8 @@ private:
 	//config
 	bool m_checkIndex;
 	bool m_useDeduplication;
+	bool m_verifyDeduplication;
+	DeduplicationHash m_dedupHash;
 	int m_type;
 	Static::ItemIndexStore::IndexCompressionType m_compressionType;
 	UByteArrayAdapter::SizeType m_growSize;
@@ -236,27 +325,77 @@ ItemIndex::Types ItemIndexFactory::create(const TSortedContainer & idx, UByteArr
 		}
 		return ok;
 	};
+	bool created = false;
 	if (type & ItemIndex::T_MULTIPLE) {
 		type &= ~ItemIndex::T_MULTIPLE;
-		int ct = 1; //T_SIMPLE
-		int bestType = ItemIndex::T_NULL;
-		sserialize::UByteArrayAdapter::SizeType bestSize = std::numeric_limits<sserialize::UByteArrayAdapter::SizeType>::max();
-		sserialize::UByteArrayAdapter tmp(new std::vector<uint8_t>(), true);
-		while(type) {
+		struct Candidate {
+			int type;
+			bool ok;
+			bool encoded;
+			sserialize::UByteArrayAdapter::SizeType size;
+			sserialize::UByteArrayAdapter data;
+		};
+		std::vector<Candidate> candidates;
+		for(int ct = 1; type; type >>= 1, ct <<= 1) { //ct=1 is T_SIMPLE
 			if (type & 0x1) {
-				bool ok = c(tmp, ItemIndex::Types(ct));
-				if (ok && tmp.size() < bestSize) {
-					bestSize = tmp.size();
-					bestType = ct;
+				candidates.push_back(Candidate{ct, false, false, 0, sserialize::UByteArrayAdapter()});
+			}
+		}
+		//exact sizes from a single scan
+		std::vector<std::size_t> trials;
+		detail::ItemIndexSizeEstimator estimator(idx.cbegin(), idx.cend());
+		for(std::size_t i(0); i < candidates.size(); ++i) {
+			if (detail::ItemIndexSizeEstimator::supports(candidates[i].type)) {
+				candidates[i].ok = true;
+				candidates[i].size = estimator.size(candidates[i].type);
+			}
+			else {
+				trials.push_back(i);
+			}
+		}
+		//the others have to be encoded
+		auto trial = [&candidates, &c](std::size_t i) {
+			Candidate & cd = candidates[i];
+			cd.data = sserialize::UByteArrayAdapter(new std::vector<uint8_t>(), true);
+			cd.ok = c(cd.data, cd.type);
+			cd.encoded = true;
+			cd.size = cd.data.size();
+		};
+		if (trials.size() > 1 && idx.size() >= ParallelCreationThreshold) {
+			std::vector<std::exception_ptr> errors(candidates.size());
+			sserialize::ThreadPool::map([&trial, &errors](std::size_t i) {
+				try {
+					trial(i);
 				}
-				tmp.resize(0);
+				catch (...) {
+					errors[i] = std::current_exception();
+				}
+			}, trials.begin(), trials.end(), narrow_check<uint32_t>(trials.size()), 1);
+			for(const std::exception_ptr & e : errors) {
+				if (e) {
+					std::rethrow_exception(e);
+				}
+			}
+		}
+		else {
+			for(std::size_t i : trials) {
+				trial(i);
 			}
-			type >>= 1;
-			ct <<= 1;
 		}
-		type = bestType;
+		//the first one with the smallest size wins
+		const Candidate * best = 0;
+		for(const Candidate & cd : candidates) {
+			if (cd.ok && (!best || cd.size < best->size)) {
+				best = &cd;
+			}
+		}
+		type = best ? best->type : int(ItemIndex::T_NULL);
+		if (best && best->encoded) {
+			dest.putData(best->data);
+			created = true;
+		}
 	}
-	bool ok = c(dest, type);
+	bool ok = created || c(dest, type);
 	type = ok ? type : ItemIndex::T_NULL;
 #if defined(SSERIALIZE_EXPENSIVE_ASSERT_ENABLED)
 	if (type != ItemIndex::T_NULL) {
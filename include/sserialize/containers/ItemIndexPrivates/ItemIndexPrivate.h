@@ -4,6 +4,8 @@
 #include <sserialize/containers/ItemIndex.h>
 #include <sserialize/containers/DynamicBitSet.h>
 #include <sserialize/iterator/AtStlInputIterator.h>
+#include <sserialize/algorithm/sorted_set_functions.h>
+#include <vector>
 
 namespace sserialize {
 
@@ -109,6 +111,9 @@ struct IntersectOp {
 	static inline uint32_t maxSize(const sserialize::ItemIndexPrivate* first, const sserialize::ItemIndexPrivate* second) {
 		return std::min<uint32_t>(first->size(), second->size());
 	}
+	static inline std::size_t apply(const uint32_t * first, std::size_t firstSize, const uint32_t * second, std::size_t secondSize, uint32_t * dest) {
+		return sserialize::sortedset::intersect(first, firstSize, second, secondSize, dest);
+	}
 };
 
 struct UniteOp {
@@ -120,6 +125,9 @@ struct UniteOp {
 	static inline uint32_t maxSize(const sserialize::ItemIndexPrivate* first, const sserialize::ItemIndexPrivate* second) {
 		return first->size() + second->size();
 	}
+	static inline std::size_t apply(const uint32_t * first, std::size_t firstSize, const uint32_t * second, std::size_t secondSize, uint32_t * dest) {
+		return sserialize::sortedset::unite(first, firstSize, second, secondSize, dest);
+	}
 };
 
 struct DifferenceOp {
@@ -131,6 +139,9 @@ struct DifferenceOp {
 	static inline uint32_t maxSize(const sserialize::ItemIndexPrivate* first, const sserialize::ItemIndexPrivate* /*second*/) {
 		return first->size();
 	}
+	static inline std::size_t apply(const uint32_t * first, std::size_t firstSize, const uint32_t * second, std::size_t secondSize, uint32_t * dest) {
+		return sserialize::sortedset::difference(first, firstSize, second, secondSize, dest);
+	}
 };
 
 
@@ -143,6 +154,9 @@ struct SymmetricDifferenceOp {
 	static inline uint32_t maxSize(const sserialize::ItemIndexPrivate* first, const sserialize::ItemIndexPrivate* second) {
 		return first->size() + second->size();
 	}
+	static inline std::size_t apply(const uint32_t * first, std::size_t firstSize, const uint32_t * second, std::size_t secondSize, uint32_t * dest) {
+		return sserialize::sortedset::symmetricDifference(first, firstSize, second, secondSize, dest);
+	}
 };
 
 template<typename TPositionIterator>
@@ -188,46 +202,21 @@ public:
 		return Init::init(first, second);
 	}
 
+	///Decodes both indexes and computes the result with the kernels from sorted_set_functions.h
 	static sserialize::ItemIndexPrivate* execute(const sserialize::ItemIndexPrivate * first, const sserialize::ItemIndexPrivate * second) {
 		TCreator creator( init(first, second) );
 		
-		PositionIterator fIt( begin(first) );
-		PositionIterator fEnd( end(first) );
-		PositionIterator sIt( begin(second) );
-		PositionIterator sEnd( end(second) );
+		std::vector<uint32_t> firstIds(first->size());
+		std::vector<uint32_t> secondIds(second->size());
+		first->putInto(firstIds.data());
+		second->putInto(secondIds.data());
 		
-		for( ;unequal(fIt, fEnd) && unequal(sIt, sEnd); ) {
-			uint32_t fId = get(first, fIt);
-			uint32_t sId = get(second, sIt);
-			if (fId < sId) {
-				if (TFunc::pushFirstSmaller) {
-					creator.push_back(fId);
-				}
-				next(fIt);
-			}
-			else if (sId < fId) {
-				if (TFunc::pushSecondSmaller) {
-					creator.push_back(sId);
-				}
-				next(sIt);
-			}
-			else {
-				if (TFunc::pushEqual) {
-					creator.push_back(fId);
-				}
-				next(fIt);
-				next(sIt);
-			}
-		}
-		if (TFunc::pushFirstRemainder) {
-			for(; unequal(fIt, fEnd); next(fIt)) {
-				creator.push_back(get(first, fIt));
-			}
-		}
-		if (TFunc::pushSecondRemainder) {
-			for(; unequal(sIt, sEnd); next(sIt)) {
-				creator.push_back(get(second, sIt));
-			}
+		std::vector<uint32_t> result(TFunc::maxSize(first, second));
+		std::size_t resultSize = TFunc::apply(firstIds.data(), firstIds.size(), secondIds.data(), secondIds.size(), result.data());
+		SSERIALIZE_CHEAP_ASSERT_SMALLER_OR_EQUAL(resultSize, result.size());
+		
+		for(std::size_t i(0); i < resultSize; ++i) {
+			creator.push_back(result[i]);
 		}
 		
 		creator.flush();
@@ -141,6 +141,8 @@ public:
 	static bool create(const TSortedContainer & src, UByteArrayAdapter & dest);
 	static uint8_t numLowerBits(uint32_t count, uint32_t upperBound);
 	static uint32_t upperBound(uint32_t count, uint32_t largestElement);
+	///@return the number of bytes create() needs for a strongly monotone sequence of count elements ending with largestElement
+	static UByteArrayAdapter::SizeType storageSize(uint32_t count, uint32_t largestElement);
 private:
 	static uint32_t upperBoundStorage(uint32_t upperBound);
 private:
@@ -54,19 +54,27 @@ public:
 	virtual bool notEq(const MyBaseClass * other) const override;
 	virtual bool eq(const MyBaseClass * other) const override;
 	virtual MyBaseClass * copy() const override;
+public:
+	///Moves the iterator forward to the first element not smaller than id or to the end
+	///Uses the skip table of the index if there is one
+	void advanceTo(uint32_t id);
+	///position of the iterator in the index
+	uint32_t indexPosition() const;
 private:
 	friend class sserialize::ItemIndexPrivateFoR;
 private:
 	///begin iterator
-	explicit FoRIterator (uint32_t idxSize, const sserialize::CompactUintArray & bits, const sserialize::UByteArrayAdapter & data);
+	explicit FoRIterator (uint32_t idxSize, const sserialize::CompactUintArray & bits, const sserialize::UByteArrayAdapter & data, const BlockSkipTable & skipTable);
 	///end iterator
 	explicit FoRIterator (uint32_t idxSize);
 	
 	bool fetchBlock(const sserialize::UByteArrayAdapter& d, uint32_t prev);
 	uint32_t blockCount() const;
 private:
+	sserialize::UByteArrayAdapter m_blockData;
 	sserialize::UByteArrayAdapter m_data;
 	sserialize::CompactUintArray m_bits;
+	BlockSkipTable m_skipTable;
 	uint32_t m_indexPos;
 	uint32_t m_indexSize;
 	uint32_t m_blockPos;
@@ -88,6 +96,7 @@ public:
 	FoRCreator();
 	FoRCreator(uint32_t blockSizeOffset);
 	FoRCreator(UByteArrayAdapter & data, uint32_t blockSizeOffset);
+	FoRCreator(UByteArrayAdapter & data, uint32_t blockSizeOffset, const BlockSkipTableCreator & skipTable);
 	FoRCreator(FoRCreator && other);
 	virtual ~FoRCreator();
 public:
@@ -110,8 +119,9 @@ public:
 	static uint32_t optBlockSize(T_ITERATOR begin, T_ITERATOR end);	
 
 	///begin->end are absolute values
+	///skipTableInterval > 0 adds a skip table with an entry every skipTableInterval blocks
 	template<typename T_ITERATOR, int T_OPTIMIZATION_OPTIONS = OO_BLOCK_SIZE>
-	static bool create(T_ITERATOR begin, T_ITERATOR end, sserialize::UByteArrayAdapter& dest);
+	static bool create(T_ITERATOR begin, T_ITERATOR end, sserialize::UByteArrayAdapter& dest, uint32_t skipTableInterval = 0);
 private:
 	UByteArrayAdapter & data();
 	const UByteArrayAdapter & data() const;
@@ -126,6 +136,7 @@ private:
 	uint32_t m_vor; //all values of m_values "ored"
 	//stuff for flush
 	std::vector<uint8_t> m_blockBits;
+	BlockSkipTableCreator m_skipTable;
 	UByteArrayAdapter m_data;
 	UByteArrayAdapter * m_dest;
 	sserialize::UByteArrayAdapter::OffsetType m_putPtr;
@@ -148,6 +159,7 @@ public:
 	///load all data into memory (only usefull if the underlying storage is not contigous)
 	virtual void loadIntoMemory() override;
 
+	virtual uint32_t find(uint32_t id) const override;
 	virtual uint32_t at(uint32_t pos) const override;
 	virtual uint32_t first() const override;
 	virtual uint32_t last() const override;
@@ -174,23 +186,31 @@ public:
 public:
 	static ItemIndexPrivate * fromBitSet(const DynamicBitSet & bitSet, sserialize::ItemIndex::CompressionLevel cl = sserialize::ItemIndex::CL_DEFAULT);
 	///create new index beginning at dest.tellPutPtr()
+	///skipTableInterval > 0 adds a skip table with an entry every skipTableInterval blocks
 	template<typename T_ITERATOR>
-	static bool create(T_ITERATOR begin, const T_ITERATOR&  end, sserialize::UByteArrayAdapter& dest, sserialize::ItemIndex::CompressionLevel cl = sserialize::ItemIndex::CL_DEFAULT);
+	static bool create(T_ITERATOR begin, const T_ITERATOR&  end, sserialize::UByteArrayAdapter& dest, sserialize::ItemIndex::CompressionLevel cl = sserialize::ItemIndex::CL_DEFAULT, uint32_t skipTableInterval = 0);
 	///create new index beginning at dest.tellPutPtr()
 	template<typename TSortedContainer>
-	static bool create(const TSortedContainer & src, UByteArrayAdapter & dest, sserialize::ItemIndex::CompressionLevel cl = sserialize::ItemIndex::CL_DEFAULT);
+	static bool create(const TSortedContainer & src, UByteArrayAdapter & dest, sserialize::ItemIndex::CompressionLevel cl = sserialize::ItemIndex::CL_DEFAULT, uint32_t skipTableInterval = 0);
 public:
 	uint32_t blockSizeOffset() const;
 	uint32_t blockSize() const;
 	uint32_t blockCount() const;
+	bool hasSkipTable() const;
+	const detail::ItemIndexImpl::BlockSkipTable & skipTable() const;
+	///@return position of the first element not smaller than id, size() if there is none
+	uint32_t lowerBound(uint32_t id) const;
 private:
 	template<typename TFunc>
 	sserialize::ItemIndexPrivate * genericSetOp(const ItemIndexPrivateFoR * cother) const;
+	///intersection of a small index with this index using the skip table
+	ItemIndexPrivate * skipIntersect(const sserialize::ItemIndexPrivate * small) const;
 private:
 	UByteArrayAdapter m_d;
 	uint32_t m_size;
 	UByteArrayAdapter m_blocks;
 	CompactUintArray m_bits;
+	detail::ItemIndexImpl::BlockSkipTable m_skipTable;
 	mutable AbstractArrayIterator<uint32_t> m_it;
 	mutable std::vector<uint32_t> m_cache;
 };
@@ -214,7 +234,7 @@ void FoRCreator::encodeBlock(UByteArrayAdapter& dest, T_ITERATOR it, T_ITERATOR
 		auto dit = memv.data();
 		uint32_t count = dist;
 		const uint32_t * sit = &(*it);
-		sserialize::BitpackingInterface::instance(bits)->pack_blocks(sit, dit, count);
+		sserialize::BitpackingInterface::shared(bits).pack_blocks(sit, dit, count);
 		uint32_t consumed = dist-count;
 		memv.flush();
 		dest.incPutPtr(dit - memv.data());
@@ -232,7 +252,7 @@ void FoRCreator::encodeBlock(UByteArrayAdapter& dest, T_ITERATOR it, T_ITERATOR
 }
 
 template<typename T_ITERATOR, int T_OPTIMIZATION_OPTIONS>
-bool FoRCreator::create(T_ITERATOR begin, T_ITERATOR end, sserialize::UByteArrayAdapter & dest) {
+bool FoRCreator::create(T_ITERATOR begin, T_ITERATOR end, sserialize::UByteArrayAdapter & dest, uint32_t skipTableInterval) {
 	if (begin == end) {
 		dest.putVlPackedUint32(0);
 		dest.putVlPackedUint32(0);
@@ -274,16 +294,24 @@ bool FoRCreator::create(T_ITERATOR begin, T_ITERATOR end, sserialize::UByteArray
 	uint32_t blockSize = ItemIndexPrivatePFoR::BlockSizes[blockSizeOffset];
 	std::vector<uint8_t> metadata(dv.size()/blockSize + uint32_t(dv.size()%blockSize>0) + 1);
 	metadata.front() = blockSizeOffset;
+	//the id in front of the current block
+	uint32_t prevId = 0;
+	BlockSkipTableCreator skipTable(skipTableInterval);
 	dest.putVlPackedUint32(dv.size());
+	if (skipTable.enabled()) {
+		dest.putVlPackedUint32(0); //skip table marker
+	}
 	
 	if (T_OPTIMIZATION_OPTIONS == int(OO_BLOCK_SIZE)) {
 		dest.putVlPackedUint32(blockDataStorageSize);
 		{
-			SSERIALIZE_CHEAP_ASSERT_EXEC(auto blockDataBegin = dest.tellPutPtr());
+			auto blockDataBegin = dest.tellPutPtr();
 			auto mdit = metadata.begin()+1;
 			for(auto dvit(dv.begin()), dvend(dv.end()); dvit < dvend; dvit += blockSize, ++mdit) {
 				uint32_t cbs = std::min<uint32_t>(blockSize, dvend-dvit);
 				auto blockEnd = dvit+cbs;
+				skipTable.addBlock(mdit - (metadata.begin()+1), prevId, dest.tellPutPtr() - blockDataBegin);
+				prevId = std::accumulate(dvit, blockEnd, prevId);
 				uint32_t blockBits = CompactUintArray::minStorageBits(std::accumulate(dvit, blockEnd, uint32_t(0), std::bit_or<uint32_t>()));
 				encodeBlock(dest, dvit, blockEnd, blockBits);
 				*mdit = blockBits;
@@ -298,6 +326,8 @@ bool FoRCreator::create(T_ITERATOR begin, T_ITERATOR end, sserialize::UByteArray
 			for(auto dvit(dv.begin()), dvend(dv.end()); dvit < dvend; dvit += blockSize, ++mdit) {
 				uint32_t cbs = std::min<uint32_t>(blockSize, dvend-dvit);
 				auto blockEnd = dvit+cbs;
+				skipTable.addBlock(mdit - (metadata.begin()+1), prevId, tmp.tellPutPtr());
+				prevId = std::accumulate(dvit, blockEnd, prevId);
 				uint32_t blockBits;
 				if (T_OPTIMIZATION_OPTIONS == int(OO_BLOCK_BITS)) {
 					blockBits = CompactUintArray::minStorageBits(std::accumulate(dvit, blockEnd, uint32_t(0), std::bit_or<uint32_t>()));
@@ -316,31 +346,32 @@ bool FoRCreator::create(T_ITERATOR begin, T_ITERATOR end, sserialize::UByteArray
 	}
 	//and the block bits
 	sserialize::CompactUintArray::create(metadata, dest, ItemIndexPrivatePFoR::BlockDescBitWidth);
+	skipTable.flush(dest);
 	return true;
 }
 
 }} //end namespace detail::ItemIndexImpl
 
 template<typename T_ITERATOR>
-bool ItemIndexPrivateFoR::create(T_ITERATOR begin, const T_ITERATOR & end, UByteArrayAdapter & dest, sserialize::ItemIndex::CompressionLevel cl) {
+bool ItemIndexPrivateFoR::create(T_ITERATOR begin, const T_ITERATOR & end, UByteArrayAdapter & dest, sserialize::ItemIndex::CompressionLevel cl, uint32_t skipTableInterval) {
 	using Creator = detail::ItemIndexImpl::FoRCreator;
 	switch(cl) {
 	case sserialize::ItemIndex::CL_NONE:
-		return Creator::create<T_ITERATOR, Creator::OO_NONE>(begin, end, dest);
+		return Creator::create<T_ITERATOR, Creator::OO_NONE>(begin, end, dest, skipTableInterval);
 	case sserialize::ItemIndex::CL_LOW:
-		return Creator::create<T_ITERATOR, Creator::OO_BLOCK_BITS>(begin, end, dest);
+		return Creator::create<T_ITERATOR, Creator::OO_BLOCK_BITS>(begin, end, dest, skipTableInterval);
 	case sserialize::ItemIndex::CL_MID:
 	case sserialize::ItemIndex::CL_HIGH:
 	default:
-		return Creator::create<T_ITERATOR, Creator::OO_BLOCK_SIZE>(begin, end, dest);
+		return Creator::create<T_ITERATOR, Creator::OO_BLOCK_SIZE>(begin, end, dest, skipTableInterval);
 	}
 	return detail::ItemIndexImpl::FoRCreator::create(begin, end, dest);
 }
 
 template<typename TSortedContainer>
 bool
-ItemIndexPrivateFoR::create(const TSortedContainer & src, UByteArrayAdapter & dest, sserialize::ItemIndex::CompressionLevel cl) {
-	return create(src.begin(), src.end(), dest, cl);
+ItemIndexPrivateFoR::create(const TSortedContainer & src, UByteArrayAdapter & dest, sserialize::ItemIndex::CompressionLevel cl, uint32_t skipTableInterval) {
+	return create(src.begin(), src.end(), dest, cl, skipTableInterval);
 }
 
 template<typename TFunc>
@@ -19,6 +19,62 @@ namespace ItemIndexImpl {
 
 class PForCreator;
 
+/** Optional skip table of FoR and PFoR indexes
+  * Every interval-th block has an entry storing the id preceding the block (the base of its delta coding)
+  * and the offset of the block in the block data section.
+  * This allows to start decoding at these blocks without decoding the blocks in front of them.
+  * 
+  * struct {
+  *   v_unsigned<32> interval;
+  *   BoundedCompactUintArray prev;
+  *   BoundedCompactUintArray offset;
+  * }
+  * 
+  */
+
+class BlockSkipTable final {
+public:
+	BlockSkipTable();
+	explicit BlockSkipTable(const sserialize::UByteArrayAdapter & d);
+	BlockSkipTable(const BlockSkipTable&) = default;
+	~BlockSkipTable() = default;
+	BlockSkipTable & operator=(const BlockSkipTable &) = default;
+	///number of entries
+	uint32_t size() const;
+	uint32_t interval() const;
+	sserialize::UByteArrayAdapter::SizeType getSizeInBytes() const;
+	///the block the entry points to
+	uint32_t blockNum(uint32_t entry) const;
+	///the id preceding the first id of the block
+	uint32_t prev(uint32_t entry) const;
+	///offset of the block in the block data section
+	uint32_t offset(uint32_t entry) const;
+	///@return the last entry whose prev is smaller than id, 0 if there is no such entry
+	uint32_t entryFor(uint32_t id) const;
+private:
+	uint32_t m_interval;
+	sserialize::BoundedCompactUintArray m_prev;
+	sserialize::BoundedCompactUintArray m_offset;
+	sserialize::UByteArrayAdapter::SizeType m_dataSize;
+};
+
+class BlockSkipTableCreator final {
+public:
+	///interval == 0 disables the skip table
+	BlockSkipTableCreator(uint32_t interval = 0);
+	~BlockSkipTableCreator() = default;
+	bool enabled() const;
+	///has to be called for every block before it is written
+	///@param prev the id preceding the first id of the block
+	///@param offset the offset of the block in the block data section
+	void addBlock(uint32_t blockNum, uint32_t prev, sserialize::UByteArrayAdapter::SizeType offset);
+	void flush(sserialize::UByteArrayAdapter & dest) const;
+private:
+	uint32_t m_interval;
+	std::vector<uint32_t> m_prev;
+	std::vector<uint32_t> m_offset;
+};
+
 /** A single frame of reference block
   * Data format is as follows:
   * 
@@ -54,7 +110,7 @@ public:
 	const_iterator end() const;
 	const_iterator cend() const;
 private:
-	SizeType decodeBlock(sserialize::UByteArrayAdapter d, uint32_t prev, uint32_t size, uint32_t bpn);
+	SizeType decodeBlock(const sserialize::UByteArrayAdapter & d, uint32_t prev, uint32_t size, uint32_t bpn);
 private:
 	std::vector<uint32_t> m_values;
 	sserialize::UByteArrayAdapter::SizeType m_dataSize;
@@ -73,11 +129,17 @@ public:
 	virtual bool notEq(const MyBaseClass * other) const override;
 	virtual bool eq(const MyBaseClass * other) const override;
 	virtual MyBaseClass * copy() const override;
+public:
+	///Moves the iterator forward to the first element not smaller than id or to the end
+	///Uses the skip table of the index if there is one
+	void advanceTo(uint32_t id);
+	///position of the iterator in the index
+	uint32_t indexPosition() const;
 private:
 	friend class sserialize::ItemIndexPrivatePFoR;
 private:
 	///begin iterator
-	explicit PFoRIterator(uint32_t idxSize, const sserialize::CompactUintArray & bits, const sserialize::UByteArrayAdapter & data);
+	explicit PFoRIterator(uint32_t idxSize, const sserialize::CompactUintArray & bits, const sserialize::UByteArrayAdapter & data, const BlockSkipTable & skipTable);
 	///end iterator
 	explicit PFoRIterator(uint32_t idxSize);
 	
@@ -85,8 +147,10 @@ private:
 	uint32_t blockCount() const;
 	const PFoRBlock & block() const;
 private:
+	sserialize::UByteArrayAdapter m_blockData;
 	sserialize::UByteArrayAdapter m_data;
 	sserialize::CompactUintArray m_bits;
+	BlockSkipTable m_skipTable;
 	uint32_t m_indexPos;
 	uint32_t m_indexSize;
 	uint32_t m_blockPos;
@@ -142,6 +206,7 @@ public:
 	PFoRCreator(uint32_t blockSizeOffset);
 	PFoRCreator(UByteArrayAdapter & data, uint32_t blockSizeOffset);
 	PFoRCreator(UByteArrayAdapter & data, uint32_t finalSize, uint32_t blockSizeOffset);
+	PFoRCreator(UByteArrayAdapter & data, uint32_t blockSizeOffset, const BlockSkipTableCreator & skipTable);
 	PFoRCreator(PFoRCreator && other);
 	~PFoRCreator();
 	uint32_t size() const;
@@ -180,8 +245,9 @@ public:
 	static void optBitsDist(std::array< uint32_t, int(33) >& storageSizes, std::size_t inputSize, uint32_t& optBits, uint32_t& optStorageSize);
 	
 	///begin->end are absolute values
+	///skipTableInterval > 0 adds a skip table with an entry every skipTableInterval blocks
 	template<typename T_ITERATOR, int T_OPTIMIZATION_OPTIONS = OO_BLOCK_SIZE>
-	static bool create(T_ITERATOR begin, T_ITERATOR end, sserialize::UByteArrayAdapter& dest);
+	static bool create(T_ITERATOR begin, T_ITERATOR end, sserialize::UByteArrayAdapter& dest, uint32_t skipTableInterval = 0);
 	
 	static void optBlockCfg(const OptimizerData & od, uint32_t & optBlockSizeOffset, uint32_t & optBlockStorageSize);
 	
@@ -200,6 +266,7 @@ private:
 	std::vector<OptimizerData::Entry> m_od;
 	uint32_t m_prev;
 	std::vector<uint8_t> m_blockBits;
+	BlockSkipTableCreator m_skipTable;
 	UByteArrayAdapter m_data;
 	UByteArrayAdapter * m_dest;
 	sserialize::UByteArrayAdapter::OffsetType m_putPtr;
@@ -213,13 +280,18 @@ private:
   * 
   * struct {
   *     v_unsigned<32> size; //number of entries
+  *     v_unsigned<32> skipTableMarker; //only present if there is a skip table, always 0
   *     v_unsigned<32> dataSize; //size of the blockData section
   *     List<PFoRBlock> blocks; //pfor blocks
   *     //first entry is the size of a block given as offset into ItemIndexPrivatePFoR::BlockSizes
   *     //following entries encode the bit size of a block
   *     CompactUintArray<5> blockDesc;
+  *     BlockSkipTable skipTable; //only present if there is a skip table
   * }
   * 
+  * Every block occupies at least one Byte, hence dataSize of a non-empty index is never 0.
+  * Indexes without skip table therefore never start with a size > 0 followed by a 0.
+  * 
   **/
 
 class ItemIndexPrivatePFoR: public ItemIndexPrivate {
@@ -240,6 +312,7 @@ public:
 	///load all data into memory (only usefull if the underlying storage is not contigous)
 	virtual void loadIntoMemory() override;
 
+	virtual uint32_t find(uint32_t id) const override;
 	virtual uint32_t at(uint32_t pos) const override;
 	virtual uint32_t first() const override;
 	virtual uint32_t last() const override;
@@ -266,20 +339,29 @@ public:
 public:
 	static ItemIndexPrivate * fromBitSet(const DynamicBitSet & bitSet, sserialize::ItemIndex::CompressionLevel cl);
 	///create new index beginning at dest.tellPutPtr()
+	///skipTableInterval > 0 adds a skip table with an entry every skipTableInterval blocks
 	template<typename T_ITERATOR>
-	static bool create(T_ITERATOR begin, const T_ITERATOR&  end, sserialize::UByteArrayAdapter& dest, sserialize::ItemIndex::CompressionLevel cl);
+	static bool create(T_ITERATOR begin, const T_ITERATOR&  end, sserialize::UByteArrayAdapter& dest, sserialize::ItemIndex::CompressionLevel cl, uint32_t skipTableInterval = 0);
 	///create new index beginning at dest.tellPutPtr()
 	template<typename TSortedContainer>
-	static bool create(const TSortedContainer & src, UByteArrayAdapter & dest, sserialize::ItemIndex::CompressionLevel cl);
+	static bool create(const TSortedContainer & src, UByteArrayAdapter & dest, sserialize::ItemIndex::CompressionLevel cl, uint32_t skipTableInterval = 0);
 public:
 	uint32_t blockSizeOffset() const;
 	uint32_t blockSize() const;
 	uint32_t blockCount() const;
+	bool hasSkipTable() const;
+	const detail::ItemIndexImpl::BlockSkipTable & skipTable() const;
+	///@return position of the first element not smaller than id, size() if there is none
+	uint32_t lowerBound(uint32_t id) const;
+private:
+	///intersection of a small index with this index using the skip table
+	ItemIndexPrivate * skipIntersect(const sserialize::ItemIndexPrivate * small) const;
 private:
 	UByteArrayAdapter m_d;
 	uint32_t m_size;
 	UByteArrayAdapter m_blocks;
 	CompactUintArray m_bits;
+	detail::ItemIndexImpl::BlockSkipTable m_skipTable;
 	mutable AbstractArrayIterator<uint32_t> m_it;
 	mutable std::vector<uint32_t> m_cache;
 };
@@ -420,7 +502,7 @@ void PFoRCreator::optBitsOD(T_IT begin, T_IT end, uint32_t & optBits, uint32_t &
 }
 
 template<typename T_ITERATOR, int T_OPTIMIZATION_OPTIONS>
-bool PFoRCreator::create(T_ITERATOR begin, T_ITERATOR end, sserialize::UByteArrayAdapter & dest) {
+bool PFoRCreator::create(T_ITERATOR begin, T_ITERATOR end, sserialize::UByteArrayAdapter & dest, uint32_t skipTableInterval) {
 	SSERIALIZE_NORMAL_ASSERT(sserialize::is_strong_monotone_ascending(begin, end));
 	std::vector<uint32_t> dv;
 	OptimizerData od;
@@ -455,19 +537,28 @@ bool PFoRCreator::create(T_ITERATOR begin, T_ITERATOR end, sserialize::UByteArra
 	
 	metadata.resize(blockCount+1);
 	metadata.front() = blockSizeOffset;
+	
+	//the id in front of the current block
+	uint32_t prevId = 0;
+	BlockSkipTableCreator skipTable(dv.size() ? skipTableInterval : 0);
 
 	dest.putVlPackedUint32(dv.size()); //idx size
+	if (skipTable.enabled()) {
+		dest.putVlPackedUint32(0); //skip table marker
+	}
 	
 	if (T_OPTIMIZATION_OPTIONS == int(OO_BLOCK_SIZE) ) {
 		dest.putVlPackedUint32(blockStorageSize); // block data size
 		
-		SSERIALIZE_CHEAP_ASSERT_EXEC(auto blockDataBegin = dest.tellPutPtr());
+		auto blockDataBegin = dest.tellPutPtr();
 		
 		if (dv.size()) { //now comes the block data
 			auto odit = od.begin();
 			auto mdit = metadata.begin()+1;
 			for(auto dvit(dv.begin()), dvend(dv.end()); dvit < dvend; dvit += blockSize, odit += blockSize, ++mdit) {
 				uint32_t myBlockSize = std::min<uint32_t>(blockSize, dvend-dvit);
+				skipTable.addBlock(mdit - (metadata.begin()+1), prevId, dest.tellPutPtr() - blockDataBegin);
+				prevId = std::accumulate(dvit, dvit+myBlockSize, prevId);
 				uint32_t blockBits = encodeBlock(dest, dvit, odit, odit+myBlockSize);
 				*mdit = blockBits;
 			}
@@ -483,6 +574,8 @@ bool PFoRCreator::create(T_ITERATOR begin, T_ITERATOR end, sserialize::UByteArra
 				auto odit = od.begin();
 				for(auto dvit(dv.begin()), dvend(dv.end()); dvit < dvend; dvit += blockSize, odit += blockSize, ++mdit) {
 					uint32_t myBlockSize = std::min<uint32_t>(blockSize, dvend-dvit);
+					skipTable.addBlock(mdit - (metadata.begin()+1), prevId, tmp.tellPutPtr());
+					prevId = std::accumulate(dvit, dvit+myBlockSize, prevId);
 					uint32_t blockBits = encodeBlock(tmp, dvit, odit, odit+myBlockSize);
 					SSERIALIZE_CHEAP_ASSERT_LARGER(blockBits, uint32_t(0));
 					*mdit = blockBits;
@@ -491,6 +584,8 @@ bool PFoRCreator::create(T_ITERATOR begin, T_ITERATOR end, sserialize::UByteArra
 			else {
 				for(auto dvit(dv.begin()), dvend(dv.end()); dvit < dvend; dvit += blockSize, ++mdit) {
 					uint32_t myBlockSize = std::min<uint32_t>(blockSize, dvend-dvit);
+					skipTable.addBlock(mdit - (metadata.begin()+1), prevId, tmp.tellPutPtr());
+					prevId = std::accumulate(dvit, dvit+myBlockSize, prevId);
 					uint32_t blockBits = 32;
 					if (T_OPTIMIZATION_OPTIONS == int(OO_FOR)) {
 						blockBits = CompactUintArray::minStorageBits( std::accumulate(dvit, dvit+myBlockSize, uint32_t(0), std::bit_or<uint32_t>()) );
@@ -507,31 +602,32 @@ bool PFoRCreator::create(T_ITERATOR begin, T_ITERATOR end, sserialize::UByteArra
 	}
 
 	sserialize::CompactUintArray::create(metadata, dest, ItemIndexPrivatePFoR::BlockDescBitWidth);
+	skipTable.flush(dest);
 	return true;
 }
 
 }} //end namespace detail::ItemIndexImpl
 
 template<typename T_ITERATOR>
-bool ItemIndexPrivatePFoR::create(T_ITERATOR begin, const T_ITERATOR & end, UByteArrayAdapter & dest, sserialize::ItemIndex::CompressionLevel cl) {
+bool ItemIndexPrivatePFoR::create(T_ITERATOR begin, const T_ITERATOR & end, UByteArrayAdapter & dest, sserialize::ItemIndex::CompressionLevel cl, uint32_t skipTableInterval) {
 	using Creator = detail::ItemIndexImpl::PFoRCreator;
 	switch(cl) {
 	case sserialize::ItemIndex::CL_NONE:
-		return Creator::create<T_ITERATOR, Creator::OO_NONE>(begin, end, dest);
+		return Creator::create<T_ITERATOR, Creator::OO_NONE>(begin, end, dest, skipTableInterval);
 	case sserialize::ItemIndex::CL_LOW:
-		return Creator::create<T_ITERATOR, Creator::OO_FOR>(begin, end, dest);
+		return Creator::create<T_ITERATOR, Creator::OO_FOR>(begin, end, dest, skipTableInterval);
 	case sserialize::ItemIndex::CL_MID:
-		return Creator::create<T_ITERATOR, Creator::OO_BLOCK_BITS>(begin, end, dest);
+		return Creator::create<T_ITERATOR, Creator::OO_BLOCK_BITS>(begin, end, dest, skipTableInterval);
 	case sserialize::ItemIndex::CL_HIGH:
 	default:
-		return Creator::create<T_ITERATOR, Creator::OO_BLOCK_SIZE>(begin, end, dest);
+		return Creator::create<T_ITERATOR, Creator::OO_BLOCK_SIZE>(begin, end, dest, skipTableInterval);
 	}
 }
 
 template<typename TSortedContainer>
 bool
-ItemIndexPrivatePFoR::create(const TSortedContainer & src, UByteArrayAdapter & dest, sserialize::ItemIndex::CompressionLevel cl) {
-	return create(src.begin(), src.end(), dest, cl);
+ItemIndexPrivatePFoR::create(const TSortedContainer & src, UByteArrayAdapter & dest, sserialize::ItemIndex::CompressionLevel cl, uint32_t skipTableInterval) {
+	return create(src.begin(), src.end(), dest, cl, skipTableInterval);
 }
 
 }
@@ -8,6 +8,10 @@
 #include <sserialize/utility/checks.h>
 #include <sserialize/utility/log.h>
 
+#if defined(__SSE2__)
+	#include <emmintrin.h>
+#endif
+
 namespace sserialize {
 namespace detail {
 namespace OADHashTable {
@@ -46,10 +50,47 @@ struct OADSizeTypeLimits<uint64_t> {
 	static constexpr uint64_t max = 0xFFFFFFFFFFFFFFFF;
 };
 
+///number of slots whose control bytes are compared at once in grouped probing
+constexpr uint32_t GroupSize = 16;
+///control byte of an empty slot, used slots have the high bit set
+constexpr uint8_t EmptyCtrl = 0;
+
+///finalizer of MurmurHash3, user supplied hashes may be weak (i.e. std::hash of integers is the identity)
+inline uint64_t mixHash(uint64_t h) {
+	h ^= h >> 33;
+	h *= 0xff51afd7ed558ccdULL;
+	h ^= h >> 33;
+	h *= 0xc4ceb9fe1a85ec53ULL;
+	h ^= h >> 33;
+	return h;
+}
+
+///@return mask whose bit i is set iff group[i] == v
+inline uint32_t matchGroup(const uint8_t * group, uint8_t v) {
+#if defined(__SSE2__)
+	__m128i g = _mm_loadu_si128(reinterpret_cast<const __m128i*>(group));
+	return uint32_t(_mm_movemask_epi8(_mm_cmpeq_epi8(g, _mm_set1_epi8(char(v)))));
+#else
+	uint32_t result = 0;
+	for(uint32_t i(0); i < GroupSize; ++i) {
+		result |= uint32_t(group[i] == v) << i;
+	}
+	return result;
+#endif
+}
+
 }}
 
 ///An Open addressing double hashed hash table with up to ValueStorageType::value_type::max-1 elements
 ///element order using the iterators is based on the insertion order
+///
+///Probing modes:
+///PM_DOUBLE_HASHING: probes the table using hash1 and hash2, every probe compares a key in the value storage
+///PM_GROUPED: Swiss-table like probing. The slots are divided into groups of 16.
+///  Every slot has an additional control byte holding 7 bits of the (mixed) hash1 of its key.
+///  The control bytes of a group are compared at once (SSE2), hence keys are only compared if their control byte matches.
+///  Groups are probed triangularly, hash2 and maxCollisions are not used.
+///  This needs one additional byte per slot in program memory but touches the value storage far less often at high load factors.
 //dev WARNING:do NOT add ability of deleting functions without looking at the code for maxCollision
 template<	typename TKey,
 			typename TValue,
@@ -68,6 +109,7 @@ public:
 	typedef typename ValueStorageType::iterator iterator;
 	typedef typename ValueStorageType::const_iterator const_iterator;
 	typedef typename TableStorageType::value_type SizeType;
+	enum ProbingMode { PM_DOUBLE_HASHING=0, PM_GROUPED=1 };
 private:
 	static constexpr uint64_t findend = detail::OADHashTable::OADSizeTypeLimits<uint64_t>::max;
 private:
@@ -79,9 +121,23 @@ private:
 	THash1 m_hash1;
 	THash2 m_hash2;
 	TKeyEq m_keyEq;
+	ProbingMode m_pm{PM_DOUBLE_HASHING};
+	///control bytes of the slots in grouped probing mode, empty otherwise
+	std::vector<uint8_t> m_ctrl;
 private:
 	uint64_t findBucket(const key_type & key) const;
+	///@param ctrl control byte of key if probing mode is PM_GROUPED
+	uint64_t findBucket(const key_type & key, uint8_t & ctrl) const;
+	uint64_t findGroupedBucket(const key_type & key, uint8_t & ctrl) const;
 	void rehash(uint64_t count);
+	///initialize an empty table with a size of 16
+	void resetTable() {
+		m_d.clear();
+		m_d.resize(16, 0);
+		if (m_pm == PM_GROUPED) {
+			m_ctrl.assign(16, detail::OADHashTable::EmptyCtrl);
+		}
+	}
 	
 	//pos == 0 is the null-value => real values start with > 0
 	inline value_type & value(SizeType ptr) {
@@ -127,8 +183,7 @@ public:
 	m_keyEq(keyEq)
 	{
 		m_valueStorage.clear();
-		m_d.clear();
-		m_d.resize(16, 0);
+		resetTable();
 	}
 	OADHashTable(const ValueStorageType & valueStorage, const TableStorageType & tableStorage) :
 	m_valueStorage(valueStorage),
@@ -138,8 +193,7 @@ public:
 	m_maxCollisions(100)
 	{
 		m_valueStorage.clear();
-		m_d.clear();
-		m_d.resize(16, 0);
+		resetTable();
 	}
 	OADHashTable(const OADHashTable & other) :
 	m_valueStorage(other.m_valueStorage),
@@ -149,7 +203,9 @@ public:
 	m_maxCollisions(other.m_maxCollisions),
 	m_hash1(other.m_hash1),
 	m_hash2(other.m_hash2),
-	m_keyEq(other.m_keyEq)
+	m_keyEq(other.m_keyEq),
+	m_pm(other.m_pm),
+	m_ctrl(other.m_ctrl)
 	{}
 	OADHashTable(OADHashTable && other) :
 	m_valueStorage(std::move(other.m_valueStorage)),
@@ -159,7 +215,9 @@ public:
 	m_maxCollisions(other.m_maxCollisions),
 	m_hash1(std::move(other.m_hash1)),
 	m_hash2(std::move(other.m_hash2)),
-	m_keyEq(std::move(other.m_keyEq))
+	m_keyEq(std::move(other.m_keyEq)),
+	m_pm(other.m_pm),
+	m_ctrl(std::move(other.m_ctrl))
 	{}
 	OADHashTable & operator=(const OADHashTable & other) {
 		m_valueStorage = other.m_valueStorage;
@@ -170,6 +228,8 @@ public:
 		m_hash1 = other.m_hash1;
 		m_hash2 = other.m_hash2;
 		m_keyEq = other.m_keyEq;
+		m_pm = other.m_pm;
+		m_ctrl = other.m_ctrl;
 		return *this;
 	}
 	OADHashTable & operator=(OADHashTable && other) {
@@ -181,6 +241,8 @@ public:
 		m_hash1 = std::move(other.m_hash1);
 		m_hash2 = std::move(other.m_hash2);
 		m_keyEq = std::move(other.m_keyEq);
+		m_pm = other.m_pm;
+		m_ctrl = std::move(other.m_ctrl);
 		return *this;
 	}
 	
@@ -188,14 +250,16 @@ public:
 	///calls clear on the table and value storage
 	void clear() {
 		m_valueStorage.clear();
-		m_d.clear();
-		m_d.resize(16, 0);
+		resetTable();
 	}
 	inline SizeType size() const { return (SizeType) m_valueStorage.size(); }
 	///Capacity of the storage table
 	inline SizeType storageCapacity()  const { return (SizeType) m_valueStorage.capacity();}
 	inline double rehashMultiplier() const { return m_rehashMult;}
 	inline void rehashMultiplier(double v) { m_rehashMult = v; }
+	inline ProbingMode probingMode() const { return m_pm; }
+	///Changing the probing mode rehashes the table
+	void probingMode(ProbingMode pm);
 	///Capacity of the hash table (not the storage table)
 	inline uint64_t capacity() const { return m_d.capacity();}
 	inline double load_factor() const { return (double)size()/m_d.size();}
@@ -251,6 +315,44 @@ public:
 template<typename TKey, typename TValue, typename THash1, typename THash2, typename TValueStorageType, typename TTableStorageType, typename TKeyEq>
 uint64_t
 OADHashTable<TKey, TValue, THash1, THash2, TValueStorageType, TTableStorageType, TKeyEq>::findBucket(const key_type & key) const {
+	uint8_t ctrl;
+	return findBucket(key, ctrl);
+}
+
+template<typename TKey, typename TValue, typename THash1, typename THash2, typename TValueStorageType, typename TTableStorageType, typename TKeyEq>
+uint64_t
+OADHashTable<TKey, TValue, THash1, THash2, TValueStorageType, TTableStorageType, TKeyEq>::findGroupedBucket(const key_type & key, uint8_t & ctrl) const {
+	using namespace detail::OADHashTable;
+	uint64_t h = mixHash(m_hash1(key));
+	ctrl = uint8_t(0x80 | (h & 0x7F));
+	//the number of groups is a power of 2, hence triangular probing visits every group
+	uint64_t groupMask = m_d.size()/GroupSize - 1;
+	uint64_t group = (h >> 7) & groupMask;
+	for(uint64_t i(0); i <= groupMask; ++i) {
+		uint64_t groupBegin = group*GroupSize;
+		const uint8_t * groupCtrl = m_ctrl.data() + groupBegin;
+		for(uint32_t m = matchGroup(groupCtrl, ctrl); m; m &= m-1) {
+			uint64_t pos = groupBegin + __builtin_ctz(m);
+			if (m_keyEq(value(m_d[pos]).first, key)) {
+				return pos;
+			}
+		}
+		//there are no deletions, an empty slot ends the probe sequence
+		uint32_t empty = matchGroup(groupCtrl, EmptyCtrl);
+		if (empty) {
+			return groupBegin + __builtin_ctz(empty);
+		}
+		group = (group + i + 1) & groupMask;
+	}
+	return findend;
+}
+
+template<typename TKey, typename TValue, typename THash1, typename THash2, typename TValueStorageType, typename TTableStorageType, typename TKeyEq>
+uint64_t
+OADHashTable<TKey, TValue, THash1, THash2, TValueStorageType, TTableStorageType, TKeyEq>::findBucket(const key_type & key, uint8_t & ctrl) const {
+	if (m_pm == PM_GROUPED) {
+		return findGroupedBucket(key, ctrl);
+	}
 	uint64_t s = m_d.size();
 	if (UNLIKELY_BRANCH(!s)) {
 		return findend;
@@ -275,7 +377,16 @@ OADHashTable<TKey, TValue, THash1, THash2, TValueStorageType, TTableStorageType,
 template<typename TKey, typename TValue, typename THash1, typename THash2, typename TValueStorageType, typename TTableStorageType, typename TKeyEq>
 void
 OADHashTable<TKey, TValue, THash1, THash2, TValueStorageType, TTableStorageType, TKeyEq>::rehash(uint64_t count) {
-	count = count | 0x1;
+	if (m_pm == PM_GROUPED) {
+		uint64_t groupCount = 1;
+		while (groupCount*detail::OADHashTable::GroupSize < count) {
+			groupCount *= 2;
+		}
+		count = groupCount*detail::OADHashTable::GroupSize;
+	}
+	else {
+		count = count | 0x1;
+	}
 #ifndef NDEBUG
 	if (!size() || count/size() > 10) {
 		sserialize::info("sserialize::OADHashTable::rehash", sserialize::toString("load_factor=", (double)size()/count, "; count=", count));
@@ -283,10 +394,20 @@ OADHashTable<TKey, TValue, THash1, THash2, TValueStorageType, TTableStorageType,
 #endif
 	m_d.clear();
 	m_d.resize(count, 0);
+	if (m_pm == PM_GROUPED) {
+		m_ctrl.assign(count, detail::OADHashTable::EmptyCtrl);
+	}
+	else {
+		m_ctrl = std::vector<uint8_t>();
+	}
 	for(SizeType i = 1, s = size(); i <= s; ++i) {
-		uint64_t pos = findBucket(value(i).first);
+		uint8_t ctrl;
+		uint64_t pos = findBucket(value(i).first, ctrl);
 		if (pos != findend) {
 			m_d[pos] = i;
+			if (m_pm == PM_GROUPED) {
+				m_ctrl[pos] = ctrl;
+			}
 		}
 		else {
 			rehash(count*m_rehashMult);
@@ -295,6 +416,21 @@ OADHashTable<TKey, TValue, THash1, THash2, TValueStorageType, TTableStorageType,
 	}
 }
 
+template<typename TKey, typename TValue, typename THash1, typename THash2, typename TValueStorageType, typename TTableStorageType, typename TKeyEq>
+void
+OADHashTable<TKey, TValue, THash1, THash2, TValueStorageType, TTableStorageType, TKeyEq>::probingMode(ProbingMode pm) {
+	if (pm == m_pm) {
+		return;
+	}
+	m_pm = pm;
+	if (size()) {
+		rehash(m_d.size());
+	}
+	else {
+		resetTable();
+	}
+}
+
 template<typename TKey, typename TValue, typename THash1, typename THash2, typename TValueStorageType, typename TTableStorageType, typename TKeyEq>
 void
 OADHashTable<TKey, TValue, THash1, THash2, TValueStorageType, TTableStorageType, TKeyEq>::max_load_factor(double f) {
@@ -321,7 +457,8 @@ OADHashTable<TKey, TValue, THash1, THash2, TValueStorageType, TTableStorageType,
 template<typename TKey, typename TValue, typename THash1, typename THash2, typename TValueStorageType, typename TTableStorageType, typename TKeyEq>
 TValue &
 OADHashTable<TKey, TValue, THash1, THash2, TValueStorageType, TTableStorageType, TKeyEq>::operator[](const key_type & key) {
-	uint64_t pos = findBucket(key);
+	uint8_t ctrl;
+	uint64_t pos = findBucket(key, ctrl);
 	if (pos != findend && m_d[pos]) {
 		return value(m_d[pos]).second;
 	}
@@ -338,6 +475,9 @@ OADHashTable<TKey, TValue, THash1, THash2, TValueStorageType, TTableStorageType,
 		if ( mySize != cp ) {//get optimized out if return_type(m_valueStorage.size()) == SizeType
 			throw std::out_of_range("OADHashTable: overflow in TableStorage pointer type. Too many elements in hash.");
 		}
+		if (m_pm == PM_GROUPED) {
+			m_ctrl[pos] = ctrl;
+		}
 		return value(cp).second;
 	}
 }
@@ -733,6 +733,7 @@ template<typename TValue, typename TEnable>
 template<typename TSourceIterator>
 typename OOMArray<TValue, TEnable>::SizeType
 OOMArray<TValue, TEnable>::replace(SizeType position, TSourceIterator srcBegin, const TSourceIterator & srcEnd) {
+	using std::distance;
 	SizeType offset = position;
 	SizeType count = distance(srcBegin, srcEnd);
 	
@@ -9,6 +9,10 @@ namespace sserialize {
 class UDWIteratorPrivateHD: public UDWIteratorPrivate {
 	MultiBitIterator m_bitIterator;
 	RCPtrWrapper<Static::HuffmanDecoder> m_decoder;
+	///lookup entry with codes that are decoded but not yet returned by next()
+	///m_bitIterator still points to the first of these, hence hasNext() and copy() are not affected
+	const Static::HuffmanDecoder::LookupEntry * m_pending;
+	uint32_t m_pendingPos;
 public:
 	UDWIteratorPrivateHD();
 	UDWIteratorPrivateHD(const MultiBitIterator & bitIterator, const RCPtrWrapper<Static::HuffmanDecoder> & decoder);
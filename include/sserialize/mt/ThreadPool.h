@@ -1,7 +1,11 @@
 #ifndef SSERIALIZE_THREAD_POOL_H
 #define SSERIALIZE_THREAD_POOL_H
 #include <sserialize/mt/GuardedVariable.h>
-#include <queue>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <iterator>
+#include <algorithm>
 #include <functional>
 #include <mutex>
 #include <condition_variable>
@@ -10,38 +14,92 @@
 
 namespace sserialize {
 
+/**
+  * Work-stealing thread pool.
+  * Every worker owns a deque of tasks. Workers pop tasks from the back of their own deque
+  * and steal from the front of the deques of the other workers if their own deque is empty.
+  * Tasks sheduled from within a task go to the deque of the executing worker,
+  * tasks sheduled from other threads are distributed round-robin.
+  */
 class ThreadPool final {
 public:
 	struct SingletonTaskTag {};
 	struct CopyTaskTag {};
 private:
 	typedef std::function< void(void) > QueuedTaskFunction;
-	typedef std::queue<QueuedTaskFunction> TaskQueue;
-	struct QueueInfo {
-		TaskQueue q;
-		uint32_t runningTasks;
-		QueueInfo() : runningTasks(0) {}
+	struct WorkerQueue {
+		std::mutex lck;
+		std::deque<QueuedTaskFunction> tasks;
+	};
+	struct ParallelForState {
+		std::size_t begin;
+		std::size_t end;
+		std::size_t grainSize;
+		std::size_t chunkCount;
+		std::atomic<std::size_t> nextChunk;
+		std::atomic<std::size_t> finishedChunks;
+		GuardedVariable<bool> done;
+		ParallelForState(std::size_t begin, std::size_t end, std::size_t grainSize);
 	};
 private:
 	std::vector<std::thread> m_threads;
-	GuardedVariable<QueueInfo> m_qi;
+	std::vector< std::unique_ptr<WorkerQueue> > m_queues;
 	std::atomic<bool> m_online; //is ThreadPool online
+	///tasks that are in a queue
+	std::atomic<std::size_t> m_queuedTasks;
+	///tasks that are in a queue or are currently executed
+	std::atomic<std::size_t> m_unfinishedTasks;
+	///queue for the next task sheduled from outside of the pool
+	std::atomic<uint32_t> m_nextQueue;
+	std::atomic<uint32_t> m_sleepingThreads;
+	std::mutex m_sleepLck;
+	std::condition_variable m_sleepCv;
+	std::mutex m_flushLck;
+	std::condition_variable m_flushCv;
 	GuardedVariable<uint32_t> m_runningThreads;//threads MUST notify this variable if they decrement/increment it
 private:
 	void stop();
 	void start(uint32_t count);
+	///@return number of the worker of this pool executing the current thread or numThreads()
+	uint32_t currentWorker() const;
+	///execute one task, prefer tasks of queue myQueue
+	///@return false if there was no task to execute
+	bool runPendingTask(uint32_t myQueue);
+	void wakeUp();
+	template<typename T_FUNC>
+	static void runChunks(ParallelForState & state, const T_FUNC & func) {
+		while (true) {
+			std::size_t chunk = state.nextChunk.fetch_add(1, std::memory_order_relaxed);
+			if (chunk >= state.chunkCount) {
+				return;
+			}
+			std::size_t chunkBegin = state.begin + chunk*state.grainSize;
+			std::size_t chunkEnd = std::min(chunkBegin + state.grainSize, state.end);
+			for(std::size_t i(chunkBegin); i < chunkEnd; ++i) {
+				func(i);
+			}
+			if (state.finishedChunks.fetch_add(1, std::memory_order_acq_rel)+1 == state.chunkCount) {
+				state.done.syncedWithNotifyAll([](bool & v) { v = true; });
+			}
+		}
+	}
+	///wait until all chunks of state are done, workers of this pool execute other tasks while waiting
+	void wait(ParallelForState & state);
 public:
-	void taskWorkerFunc(uint32_t /*myThreadNumber*/);
+	void taskWorkerFunc(uint32_t myThreadNumber);
 public:
 	ThreadPool(uint32_t numThreads = 1);
 	///Destroys the thread pool without doing any more work
 	///Call flushQueue() to flush the queue
 	~ThreadPool();
 	///Wait for empty queue
+	///If called from within a task of this pool then the calling thread executes queued tasks until no task is left in any queue
+	///It does not wait for tasks that are executed by other workers in this case
 	void flushQueue();
 	std::size_t queueSize() const;
 	void numThreads(uint32_t num);
 	uint32_t numThreads() const;
+	///Tasks may shedule further tasks
 	bool sheduleTask(QueuedTaskFunction t);
 	template<typename T_TASKFUNC, typename... Args>
 	bool sheduleTaskWithArgs(T_TASKFUNC t, Args&&...args) {
@@ -49,6 +107,26 @@ public:
 		return sheduleTask(tmp);
 	}
 	
+	///Calls func(i) for each i in [begin, end) exactly once and returns after all calls are done.
+	///The range is split into chunks of grainSize elements, the calling thread helps processing them.
+	///This may be called from within a task of this pool.
+	///func must not throw.
+	template<typename T_FUNC>
+	void parallel_for(std::size_t begin, std::size_t end, std::size_t grainSize, T_FUNC func) {
+		if (begin >= end) {
+			return;
+		}
+		//shared as helper tasks may start after we returned, they won't find any chunk left in this case
+		auto state = std::make_shared<ParallelForState>(begin, end, grainSize);
+		const T_FUNC * funcPtr = &func;
+		std::size_t helpers = std::min<std::size_t>(state->chunkCount-1, numThreads());
+		for(std::size_t i(0); i < helpers; ++i) {
+			sheduleTask([state, funcPtr]() { runChunks(*state, *funcPtr); });
+		}
+		runChunks(*state, func);
+		wait(*state);
+	}
+	
 	///execute task t with threadCount threads by spawning new threads
 	static void execute(QueuedTaskFunction t, uint32_t threadCount = 0);
 	
@@ -97,31 +175,63 @@ public:
 	
 	///execute task t with threadCount threads by spawning new threads
 	///Calls t for each element in the range exactly once
+	///Elements are handed out in chunks of chunkSize elements, chunkSize=0 chooses the chunk size based on the range size
 	template<typename T_TASKFUNC, typename T_ITERATOR>
-	static void map(T_TASKFUNC t, T_ITERATOR begin, T_ITERATOR end, uint32_t threadCount = 0) {
-		struct State {
-			T_ITERATOR b;
-			T_ITERATOR e;
-			std::mutex lck;
-			State(T_ITERATOR begin, T_ITERATOR end) : b(begin), e(end) {}
-		};
-		State state(begin, end);
-		execute([&state, t]() {
-			std::unique_lock<std::mutex> lck(state.lck);
-			lck.unlock();
-			while (true) {
-				lck.lock();
-				if (state.b != state.e) {
-					T_ITERATOR m = state.b;
-					++state.b;
-					lck.unlock();
-					t(*m);
-				}
-				else {
-					return;
+	static void map(T_TASKFUNC t, T_ITERATOR begin, T_ITERATOR end, uint32_t threadCount = 0, std::size_t chunkSize = 0) {
+		if (!threadCount) {
+			threadCount = hardware_concurrency();
+		}
+		using Category = typename std::iterator_traits<T_ITERATOR>::iterator_category;
+		if constexpr (std::is_base_of<std::random_access_iterator_tag, Category>::value) {
+			std::size_t size = std::distance(begin, end);
+			if (!chunkSize) {
+				chunkSize = std::max<std::size_t>(1, size/(std::size_t(threadCount)*16));
+			}
+			std::atomic<std::size_t> next(0);
+			execute([&next, begin, size, chunkSize, t]() {
+				while (true) {
+					std::size_t chunkBegin = next.fetch_add(chunkSize, std::memory_order_relaxed);
+					if (chunkBegin >= size) {
+						return;
+					}
+					std::size_t chunkEnd = std::min(chunkBegin+chunkSize, size);
+					for(T_ITERATOR it(begin+chunkBegin), itEnd(begin+chunkEnd); it != itEnd; ++it) {
+						t(*it);
+					}
 				}
+			}, threadCount);
+		}
+		else {
+			if (!chunkSize) {
+				chunkSize = 16;
 			}
-		}, threadCount);
+			struct State {
+				T_ITERATOR b;
+				T_ITERATOR e;
+				std::mutex lck;
+				State(T_ITERATOR begin, T_ITERATOR end) : b(begin), e(end) {}
+			};
+			State state(begin, end);
+			execute([&state, chunkSize, t]() {
+				std::vector<T_ITERATOR> chunk;
+				chunk.reserve(chunkSize);
+				while (true) {
+					chunk.clear();
+					{
+						std::lock_guard<std::mutex> lck(state.lck);
+						for(; state.b != state.e && chunk.size() < chunkSize; ++state.b) {
+							chunk.push_back(state.b);
+						}
+					}
+					if (chunk.empty()) {
+						return;
+					}
+					for(const T_ITERATOR & it : chunk) {
+						t(*it);
+					}
+				}
+			}, threadCount);
+		}
 	}
 public:
 	static inline uint32_t hardware_concurrency() { return std::thread::hardware_concurrency(); }
@@ -8,6 +8,8 @@
 #include <sserialize/containers/ItemIndexFactory.h>
 #include <sserialize/Static/CellTextCompleter.h>
 #include <unordered_set>
+#include <memory>
+#include <thread>
 
 /**
 
@@ -489,6 +491,8 @@ namespace TrieCreation {
 
 template<typename TIterator, typename TExactOutputIterator, typename TSuffixOutputIterator, bool TWithProgressInfo>
 struct State {
+	typedef TExactOutputIterator ExactOutputIterator;
+	typedef TSuffixOutputIterator SuffixOutputIterator;
 	TIterator it;
 	TIterator end;
 	std::mutex itemLock;
@@ -518,6 +522,8 @@ template<typename TState, typename TTraits>
 struct Worker {
 	typedef typename TTraits::ExactStrings ExactStrings;
 	typedef typename TTraits::SuffixStrings SuffixStrings;
+	typedef typename TState::ExactOutputIterator ExactOutputIterator;
+	typedef typename TState::SuffixOutputIterator SuffixOutputIterator;
 	TState * m_state;
 	std::unordered_set<std::string> m_exactStrings;
 	std::unordered_set<std::string> m_suffixStrings;
@@ -527,14 +533,21 @@ struct Worker {
 	ExactStrings m_es;
 	SuffixStrings m_ss;
 	sserialize::StringCompleter::SupportedQuerries m_sq;
+	ExactOutputIterator m_esi;
+	SuffixOutputIterator m_ssi;
+	///m_esi and m_ssi are shared with other workers
+	bool m_sharedOutput;
 	void flush() {
 		{
-			std::lock_guard<std::mutex> lck(m_state->flushLock);
+			std::unique_lock<std::mutex> lck(m_state->flushLock, std::defer_lock);
+			if (m_sharedOutput) {
+				lck.lock();
+			}
 			for(const std::string & x : m_exactStrings) {
-				*(m_state->esi) = x;
+				*m_esi = x;
 			}
 			for(const std::string & x : m_suffixStrings) {
-				*(m_state->ssi) = x;
+				*m_ssi = x;
 			}
 		}
 		m_exactStrings.clear(),
@@ -568,17 +581,29 @@ struct Worker {
 		}
 		flush();
 	}
+	///all workers write to the output iterators of state
 	Worker(TState * state, TTraits & traits) :
 	m_state(state),
 	m_eit(m_exactStrings, m_exactStrings.begin()), m_sit(m_suffixStrings, m_suffixStrings.begin()),
 	m_bufferSize(10000),
-	m_es(traits.exactStrings()), m_ss(traits.suffixStrings())  {}
+	m_es(traits.exactStrings()), m_ss(traits.suffixStrings()),
+	m_esi(state->esi), m_ssi(state->ssi), m_sharedOutput(true)
+	{}
+	///the worker exclusively writes to esi and ssi, hence flushing needs no synchronization
+	Worker(TState * state, TTraits & traits, ExactOutputIterator esi, SuffixOutputIterator ssi) :
+	m_state(state),
+	m_eit(m_exactStrings, m_exactStrings.begin()), m_sit(m_suffixStrings, m_suffixStrings.begin()),
+	m_bufferSize(10000),
+	m_es(traits.exactStrings()), m_ss(traits.suffixStrings()),
+	m_esi(esi), m_ssi(ssi), m_sharedOutput(false)
+	{}
 	Worker(Worker && other) :
 	m_state(other.m_state),
 	m_exactStrings(std::move(other.m_exactStrings)), m_suffixStrings(std::move(other.m_suffixStrings)),
 	m_eit(m_exactStrings, m_exactStrings.begin()), m_sit(m_suffixStrings, m_suffixStrings.begin()),
 	m_bufferSize(other.m_bufferSize),
-	m_es(std::move(other.m_es)), m_ss(std::move(other.m_ss))
+	m_es(std::move(other.m_es)), m_ss(std::move(other.m_ss)),
+	m_esi(other.m_esi), m_ssi(other.m_ssi), m_sharedOutput(other.m_sharedOutput)
 	{}
 	~Worker() {
 		flush();
@@ -676,11 +701,19 @@ void appendSACTC(TItemIterator itemsBegin, TItemIterator itemsEnd,
 
 		ItemState itemState(itemsBegin, itemsEnd, esi, ssi, sq);
 		RegionState regionState(regionsBegin, regionsEnd, esi, ssi, sq);
+		
+		//every worker fills its own trie, these are merged afterwards
+		//this way the insertion does not serialize on a single hash table
+		std::vector< std::unique_ptr<MyTrieType> > workerTries;
+		for(std::size_t i(0); i < insertionConcurrency; ++i) {
+			workerTries.emplace_back(new MyTrieType());
+		}
 
 		itemState.pinfo.begin("Inserting item strings");
 		std::vector<std::thread> threads;
 		for(std::size_t i(0); i < insertionConcurrency; ++i) {
-			threads.emplace_back(ItemWorker(&itemState, itemTraits));
+			MyTrieType * t = workerTries[i].get();
+			threads.emplace_back(ItemWorker(&itemState, itemTraits, ExactStringsInserter(t), SuffixStringsInserter(t)));
 		}
 		for(std::size_t i(0); i < insertionConcurrency; ++i) {
 			threads[i].join();
@@ -690,7 +723,8 @@ void appendSACTC(TItemIterator itemsBegin, TItemIterator itemsEnd,
 		
 		regionState.pinfo.begin("Inserting region strings");
 		for(std::size_t i(0); i < insertionConcurrency; ++i) {
-			threads.emplace_back(RegionWorker(&regionState, regionTraits));
+			MyTrieType * t = workerTries[i].get();
+			threads.emplace_back(RegionWorker(&regionState, regionTraits, ExactStringsInserter(t), SuffixStringsInserter(t)));
 		}
 		for(std::size_t i(0); i < insertionConcurrency; ++i) {
 			threads[i].join();
@@ -698,6 +732,25 @@ void appendSACTC(TItemIterator itemsBegin, TItemIterator itemsEnd,
 		threads.clear();
 		regionState.pinfo.end();
 		
+		//merge the worker tries pairwise in parallel, the result ends up in the first one which is then moved into myTrie
+		for(std::size_t step(1); step < workerTries.size(); step *= 2) {
+			for(std::size_t i(0); i+step < workerTries.size(); i += 2*step) {
+				MyTrieType * dest = workerTries[i].get();
+				MyTrieType * src = workerTries[i+step].get();
+				threads.emplace_back([dest, src]() {
+					dest->merge(std::move(*src));
+				});
+			}
+			for(std::thread & t : threads) {
+				t.join();
+			}
+			threads.clear();
+		}
+		if (workerTries.size()) {
+			myTrie = std::move(*workerTries.front());
+		}
+		workerTries.clear();
+		
 		myTrie.finalize(sortConcurrency);
 		myTrie.append(dest);
 	}
@@ -81,6 +81,8 @@ public:
 	///Tries to set an upper limit to the result set size to speed-up set operations (soft constraint)
 	void setMaxResultSetSize(uint32_t size);
 	void setMinStrLen(uint32_t size);
+	///Number of threads used to evaluate independent parts of the query, 0 for one thread per core
+	void setThreadCount(uint32_t threadCount);
 	
 	void buildTree(const std::string & queryString);
 	ItemIndexIterator asItemIndexIterator();
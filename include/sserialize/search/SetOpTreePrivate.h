@@ -23,6 +23,8 @@ public:
 	//sets the maximum result set size, no need to impement this
 	virtual void setMaxResultSetSize(uint32_t /*size*/) { }
 	virtual void setMinStrLen(uint32_t /*size*/) {}
+	//sets the number of threads used to evaluate independent subtrees, no need to implement this
+	virtual void setThreadCount(uint32_t /*threadCount*/) {}
 
 	virtual void buildTree(const std::string & queryString) = 0;
 	virtual ItemIndexIterator asItemIndexIterator() = 0;
@@ -19,6 +19,12 @@
  * $String{String}
  * $ExternalFunctoid{} can be registerd on runtime.
  * it will get the String in the surrounding brackets: If you need to use the closeing brace }, then you have to escape it
+ *
+ * Set operations are planned using the sizes of the completions:
+ * Chains of intersections and unions are flattened. Intersections are evaluated smallest operand first
+ * and stop as soon as the intermediate result is empty. Differences with an empty first operand skip the second operand.
+ * Repeated completion strings are completed only once.
+ * With setThreadCount() > 1 independent subtrees (no external functions, no shared completions) are evaluated in parallel.
  */
  
  //TODO:hard constraints: Set op node should ALWAYS have exactly 2 children
@@ -124,6 +130,7 @@ private:
 
 private:
 	enum TreeDiffTypes {UDT_SUBSET=1, UDT_SUPERSET=2, UDT_EQUAL=3, UDT_DIFFERENT=4};
+	typedef std::pair<std::string, uint8_t> CompletionKey;
 
 private:
 	StringCompleter m_strCompleter;
@@ -133,18 +140,29 @@ private:
 	std::map<std::string, RCPtrWrapper<SetOpTree::SelectableOpFilter> > m_externalFunctoids;
 	std::map< std::pair<std::string, uint8_t>, ItemIndex> m_completions;
 	Node * m_rootNode;
+	uint32_t m_threadCount;
 private://utility functions
 	TreeDiffTypes completionStringDifference(const std::string & newString, const std::string & oldString);
 	ItemIndexIterator createItemIndexIteratorTree(Node * node);
 
 private:
 	SetOpTreePrivateComplex & operator=(const SetOpTreePrivateComplex & other);
-	ItemIndex doSetOperationsRecurse(SetOpTreePrivateComplex::Node* node);
+	///@param parallel evaluate independent subtrees in parallel
+	ItemIndex doSetOperationsRecurse(SetOpTreePrivateComplex::Node* node, bool parallel = false);
 	ItemIndex doSetOperationsRecurse(SetOpTreePrivateComplex::Node* node, SetOpTreePrivateComplex::Node* refTree, TreeDiffTypes & diff);
 	bool charHintsCheckChanged(Node * node, Node * child, const ItemIndex & index); 
 	std::set<uint16_t> getCharHintsFromNode(Node * node);
 	bool parseQuery(const std::string& queryString, sserialize::SetOpTreePrivateComplex::Node*& treeRootNode, std::map< std::pair< std::string, uint8_t >, sserialize::ItemIndex >& cmpStrings);
 	void clearTree();
+private://planner
+	///Estimated result size of node, this is exact for completions and cached nodes
+	uint32_t estimateSize(Node * node) const;
+	///Collects the operands of a chain of op nodes of type opType that don't use external functions for opType
+	void collectOperands(Node * node, uint32_t opType, std::vector<Node*> & operands) const;
+	///@return false if the subtree contains external functions, these may not be thread-safe
+	bool collectCompletions(Node * node, std::vector<CompletionKey> & dest) const;
+	///Evaluates operands, operands[i] is evaluated by another thread if it is independent of all other operands
+	void calcOperands(const std::vector<Node*> & operands, std::vector<ItemIndex> & dest, bool parallel);
 public:
 	SetOpTreePrivateComplex();
 	SetOpTreePrivateComplex(const SetOpTreePrivateComplex & other);
@@ -152,6 +170,8 @@ public:
 	virtual SetOpTreePrivate * copy() const;
 
 
+	///@param threadCount 0 for one thread per core
+	virtual void setThreadCount(uint32_t threadCount);
 	virtual void buildTree(const std::string & queryString);
 	virtual ItemIndexIterator asItemIndexIterator();
 	virtual ItemIndex update(const std::string & queryString);
@@ -138,6 +138,12 @@ public:
 	CellQueryResult operator+(const CellQueryResult & other) const;
 	CellQueryResult operator-(const CellQueryResult & other) const;
 	CellQueryResult operator^(const CellQueryResult & other) const;
+	///The operators above with the cells split into ranges of cell ids which are processed by threadCount threads
+	///@param threadCount 0 for one thread per core
+	CellQueryResult intersect(const CellQueryResult & other, uint32_t threadCount) const;
+	CellQueryResult unite(const CellQueryResult & other, uint32_t threadCount) const;
+	CellQueryResult diff(const CellQueryResult & other, uint32_t threadCount) const;
+	CellQueryResult symDiff(const CellQueryResult & other, uint32_t threadCount) const;
 	CellQueryResult allToFull() const;
 	CellQueryResult removeEmpty() const;
 	
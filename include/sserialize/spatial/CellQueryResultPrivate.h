@@ -39,6 +39,22 @@ private:
 		ItemIndex idx;
 		uint32_t idxPtr;
 	};
+	
+	///A range of cells of this and of the other operand, both ranges contain the same cell ids
+	struct SetOpRange {
+		uint32_t myBegin;
+		uint32_t myEnd;
+		uint32_t oBegin;
+		uint32_t oEnd;
+		inline uint32_t mySize() const { return myEnd - myBegin; }
+		inline uint32_t oSize() const { return oEnd - oBegin; }
+	};
+	
+	///Computes the result of a set operation for the cells in range, r is empty
+	typedef void (CellQueryResult::*SetOpImp)(const CellQueryResult & o, const SetOpRange & range, CellQueryResult & r) const;
+public:
+	///Set operations with less cells per thread are done sequentially
+	static constexpr uint32_t MinCellsPerSetOpPart = 256;
 private:
 	CellInfo m_ci;
 	sserialize::Static::ItemIndexStore m_idxStore;
@@ -49,6 +65,13 @@ private:
 	void uncheckedSet(uint32_t pos, const sserialize::ItemIndex & idx);
 	void uncheckedSet(uint32_t pos, sserialize::ItemIndex && idx);
 	static bool flagCheck(int first, int second);
+	void intersectImp(const CellQueryResult & o, const SetOpRange & range, CellQueryResult & r) const;
+	void uniteImp(const CellQueryResult & o, const SetOpRange & range, CellQueryResult & r) const;
+	void diffImp(const CellQueryResult & o, const SetOpRange & range, CellQueryResult & r) const;
+	void symDiffImp(const CellQueryResult & o, const SetOpRange & range, CellQueryResult & r) const;
+	///Partitions the cell ids into ranges which are processed by op in parallel.
+	///The partial results are concatenated by relocating their indexes
+	CellQueryResult * setOp(const CellQueryResult & o, SetOpImp op, uint32_t threadCount) const;
 public:
 	CellQueryResult();
 	CellQueryResult(const CellInfo & ci, const ItemIndexStore & idxStore, int flags);
@@ -79,10 +102,11 @@ public:
 	uint32_t maxItems() const;
 	inline bool fetched(uint32_t pos) const { return m_desc[pos].fetched; }
 	inline uint32_t rawDesc(uint32_t pos) const { return m_desc[pos].raw(); }
-	CellQueryResult * intersect(const CellQueryResult * other) const;
-	CellQueryResult * unite(const CellQueryResult * other) const;
-	CellQueryResult * diff(const CellQueryResult * other) const;
-	CellQueryResult * symDiff(const CellQueryResult * other) const;
+	///@param threadCount number of threads, 0 for one thread per core
+	CellQueryResult * intersect(const CellQueryResult * other, uint32_t threadCount = 1) const;
+	CellQueryResult * unite(const CellQueryResult * other, uint32_t threadCount = 1) const;
+	CellQueryResult * diff(const CellQueryResult * other, uint32_t threadCount = 1) const;
+	CellQueryResult * symDiff(const CellQueryResult * other, uint32_t threadCount = 1) const;
 	CellQueryResult * allToFull() const;
 	CellQueryResult * removeEmpty(uint32_t emptyCellCount = 0) const;
 	CellQueryResult * toGlobalItemIds(uint32_t threadCount) const;
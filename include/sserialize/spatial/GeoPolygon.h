@@ -3,6 +3,7 @@
 #include <sserialize/algorithm/utilfuncs.h>
 #include <sserialize/utility/types.h>
 #include <sserialize/spatial/GeoWay.h>
+#include <sserialize/spatial/GeoPolygonEdgeIndex.h>
 #include <sserialize/containers/AbstractArray.h>
 #include <vector>
 #include <cmath>
@@ -56,6 +57,10 @@ public:
 	bool encloses(const MyGeoWay & other) const;
 	template<typename T_GEO_POINT_ITERATOR>
 	bool contains(T_GEO_POINT_ITERATOR begin, T_GEO_POINT_ITERATOR end) const;
+	///Tests every point in [begin, end) and writes the result as bool to out
+	///Large batches on large polygons are answered by a temporary GeoPolygonEdgeIndex
+	template<typename T_GEO_POINT_ITERATOR, typename T_OUTPUT_ITERATOR>
+	T_OUTPUT_ITERATOR contains(T_GEO_POINT_ITERATOR begin, T_GEO_POINT_ITERATOR end, T_OUTPUT_ITERATOR out) const;
 
 	///+1 for counter-clockwise orientation, -1 for clockwise orientation, 0 for no orientation
 	int orientation() const;
@@ -388,6 +393,19 @@ bool GeoPolygon<TPointsContainer>::contains(T_GEO_POINT_ITERATOR begin, T_GEO_PO
 	return false;
 }
 
+template<typename TPointsContainer>
+template<typename T_GEO_POINT_ITERATOR, typename T_OUTPUT_ITERATOR>
+T_OUTPUT_ITERATOR GeoPolygon<TPointsContainer>::contains(T_GEO_POINT_ITERATOR begin, T_GEO_POINT_ITERATOR end, T_OUTPUT_ITERATOR out) const {
+	//building the index costs about as much as a few plain tests
+	if (MyBaseClass::points().size() > 64 && std::distance(begin, end) > 32) {
+		return GeoPolygonEdgeIndex(MyBaseClass::myBoundary(), cbegin(), cend()).contains(begin, end, out);
+	}
+	for(; begin != end; ++begin, ++out) {
+		*out = contains(*begin);
+	}
+	return out;
+}
+
 ///serializes without type info
 template<typename TPointsContainer>
 sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & destination, const GeoPolygon<TPointsContainer> & p) {
@@ -0,0 +1,117 @@
+#ifndef SSERIALIZE_SPATIAL_GEO_POLYGON_EDGE_INDEX_H
+#define SSERIALIZE_SPATIAL_GEO_POLYGON_EDGE_INDEX_H
+#include <sserialize/spatial/GeoRect.h>
+#include <sserialize/spatial/GeoPoint.h>
+#include <sserialize/storage/UByteArrayAdapter.h>
+#include <vector>
+
+namespace sserialize {
+namespace spatial {
+
+/** Acceleration structure for point-in-polygon tests on a single polygon.
+  * contains() gives the same results as GeoPolygon::contains() of the polygon it was created from.
+  *
+  * The bounding box of the polygon is split along the longitude into slabs,
+  * each slab stores the edges whose longitude range overlaps it.
+  * Only these edges can change the result of the crossing test of a point within the slab.
+  * Additionally a raster over the bounding box stores for every cell if it lies completely inside,
+  * completely outside or on the boundary of the polygon. Only points in boundary cells need the slab.
+  *
+  * The index holds its own copy of the vertices, so decoding the vertices of a Static::spatial::GeoPolygon is only done once.
+  * It can be serialized next to the polygon and loaded with the UByteArrayAdapter constructor.
+  *
+  * Serialization format:
+  * ----------------------------------------------------------------------------------------------------------------
+  * VERSION|MINLAT|MAXLAT|MINLON|MAXLON|POINTCOUNT|SLABCOUNT|LATCELLS|LONCELLS|LAT|LON|SLABBEGIN|SLABEDGES|CELLS
+  * ----------------------------------------------------------------------------------------------------------------
+  *   u8   |double|double|double|double|   vu32   |   vu32  |  vu32  |  vu32  |double[]|double[]|vu32[]|vu32[]|u8[]
+  *
+  * SLABBEGIN has SLABCOUNT+1 entries, SLABEDGES holds the id of the second vertex of each edge
+  */
+class GeoPolygonEdgeIndex final {
+public:
+	typedef enum : uint8_t {CS_OUTSIDE=0, CS_INSIDE=1, CS_BOUNDARY=2} CellState;
+	static constexpr uint8_t Version = 1;
+public:
+	GeoPolygonEdgeIndex();
+	///@param boundary the boundary of the polygon
+	///@param begin, end the points of the closed polygon, the last point equals the first
+	///@param slabCount, rasterSize number of slabs and number of raster cells per dimension, 0 selects them based on the number of points
+	template<typename T_GEO_POINT_ITERATOR>
+	GeoPolygonEdgeIndex(const GeoRect & boundary, T_GEO_POINT_ITERATOR begin, T_GEO_POINT_ITERATOR end, uint32_t slabCount = 0, uint32_t rasterSize = 0);
+	///Creates the index for a polygon, works with any GeoPolygon<TPointsContainer>
+	template<typename T_GEO_POLYGON>
+	explicit GeoPolygonEdgeIndex(const T_GEO_POLYGON & poly, uint32_t slabCount = 0, uint32_t rasterSize = 0);
+	///Deserializes the index
+	explicit GeoPolygonEdgeIndex(const UByteArrayAdapter & d);
+	~GeoPolygonEdgeIndex();
+	///Number of vertices including the closing one
+	inline uint32_t size() const { return (uint32_t) m_lat.size(); }
+	inline const GeoRect & boundary() const { return m_boundary; }
+	inline uint32_t slabCount() const { return m_slabCount; }
+	inline uint32_t latCells() const { return m_latCells; }
+	inline uint32_t lonCells() const { return m_lonCells; }
+	CellState cellState(uint32_t latCell, uint32_t lonCell) const;
+	///Number of raster cells with state CS_BOUNDARY
+	uint32_t boundaryCellCount() const;
+	UByteArrayAdapter::OffsetType getSizeInBytes() const;
+public:
+	bool contains(const GeoPoint & p) const;
+	bool contains(double lat, double lon) const;
+	///Tests every point in [begin, end) and writes the result as bool to out
+	template<typename T_GEO_POINT_ITERATOR, typename T_OUTPUT_ITERATOR>
+	T_OUTPUT_ITERATOR contains(T_GEO_POINT_ITERATOR begin, T_GEO_POINT_ITERATOR end, T_OUTPUT_ITERATOR out) const;
+	UByteArrayAdapter & append(UByteArrayAdapter & dest) const;
+private:
+	void build(uint32_t slabCount, uint32_t rasterSize);
+	///crossing test of GeoPolygon::contains() restricted to the edges of the slab of lon
+	bool slabContains(double lat, double lon) const;
+	uint32_t slab(double lon) const;
+	uint32_t latCell(double lat) const;
+	uint32_t lonCell(double lon) const;
+private:
+	GeoRect m_boundary;
+	std::vector<double> m_lat;
+	std::vector<double> m_lon;
+	uint32_t m_slabCount;
+	uint32_t m_latCells;
+	uint32_t m_lonCells;
+	std::vector<uint32_t> m_slabBegin;
+	std::vector<uint32_t> m_slabEdges;
+	std::vector<uint8_t> m_cells;
+};
+
+template<typename T_GEO_POINT_ITERATOR>
+GeoPolygonEdgeIndex::GeoPolygonEdgeIndex(const GeoRect & boundary, T_GEO_POINT_ITERATOR begin, T_GEO_POINT_ITERATOR end, uint32_t slabCount, uint32_t rasterSize) :
+GeoPolygonEdgeIndex()
+{
+	m_boundary = boundary;
+	for(; begin != end; ++begin) {
+		const auto & p = *begin;
+		m_lat.push_back(p.lat());
+		m_lon.push_back(p.lon());
+	}
+	build(slabCount, rasterSize);
+}
+
+template<typename T_GEO_POLYGON>
+GeoPolygonEdgeIndex::GeoPolygonEdgeIndex(const T_GEO_POLYGON & poly, uint32_t slabCount, uint32_t rasterSize) :
+GeoPolygonEdgeIndex(poly.boundary(), poly.cbegin(), poly.cend(), slabCount, rasterSize)
+{}
+
+template<typename T_GEO_POINT_ITERATOR, typename T_OUTPUT_ITERATOR>
+T_OUTPUT_ITERATOR GeoPolygonEdgeIndex::contains(T_GEO_POINT_ITERATOR begin, T_GEO_POINT_ITERATOR end, T_OUTPUT_ITERATOR out) const {
+	for(; begin != end; ++begin, ++out) {
+		const auto & p = *begin;
+		*out = contains(p.lat(), p.lon());
+	}
+	return out;
+}
+
+inline sserialize::UByteArrayAdapter & operator<<(sserialize::UByteArrayAdapter & dest, const GeoPolygonEdgeIndex & idx) {
+	return idx.append(dest);
+}
+
+}}//end namespace sserialize::spatial
+
+#endif
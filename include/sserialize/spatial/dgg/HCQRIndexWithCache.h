@@ -1,6 +1,6 @@
 #pragma once
 
-#include <sserialize/containers/LFUCache.h>
+#include <sserialize/containers/ConcurrentCache.h>
 
 #include <sserialize/spatial/dgg/HCQRIndex.h>
 
@@ -40,15 +40,33 @@ struct hash<sserialize::spatial::dgg::detail::HCQRIndexWithCache::CacheKey> {
 
 namespace sserialize::spatial::dgg {
 
+///Caches query results of the base index.
+///The cache is thread-safe and sharded, hence concurrent queries only contend if they hit the same shard.
+///Queries that miss the cache are computed without holding a lock.
 class HCQRIndexWithCache: public sserialize::spatial::dgg::interface::HCQRIndex {
 public:
     using HCQRIndexPtr = sserialize::RCPtrWrapper<sserialize::spatial::dgg::interface::HCQRIndex>;
+private:
+    using CacheKey = sserialize::spatial::dgg::detail::HCQRIndexWithCache::CacheKey;
+    using Cache = sserialize::ConcurrentCache<CacheKey, HCQRPtr>;
 public:
-    HCQRIndexWithCache(HCQRIndexPtr const & base, uint32_t cacheSize = 10);
+    using CacheStats = Cache::Stats;
+    ///Approximate memory usage of a cached result with no nodes
+    static constexpr std::size_t ResultBaseSize = 128;
+    ///Approximate memory usage of a node of a cached result
+    static constexpr std::size_t NodeSize = 48;
+public:
+    HCQRIndexWithCache(HCQRIndexPtr const & base, uint32_t cacheSize = 10, std::size_t cacheByteSize = Cache::Unlimited);
     ~HCQRIndexWithCache() override;
-	static HCQRIndexPtr make(HCQRIndexPtr const & base, uint32_t cacheSize = 10);
+	static HCQRIndexPtr make(HCQRIndexPtr const & base, uint32_t cacheSize = 10, std::size_t cacheByteSize = Cache::Unlimited);
 public:
+    ///Maximum number of cached results
     void setCacheSize(uint32_t size);
+    ///Maximum approximate memory usage of the cached results, see ResultBaseSize and NodeSize
+    void setCacheByteSize(std::size_t size);
+    CacheStats cacheStats() const;
+    void resetCacheStats();
+    void clearCache();
 public:
     sserialize::StringCompleter::SupportedQuerries getSupportedQueries() const override;
 public:
@@ -62,11 +80,10 @@ public:
 	SpatialGridInfo const & sgi() const override;
 	SpatialGrid const & sg() const override;
 private:
-    using CacheKey = sserialize::spatial::dgg::detail::HCQRIndexWithCache::CacheKey;
-    using Cache = sserialize::LFUCache<CacheKey, HCQRPtr>;
+    template<typename T_FUNC>
+    HCQRPtr cached(CacheKey const & ck, T_FUNC func) const;
 private:
     HCQRIndexPtr m_base;
-    mutable std::mutex m_cacheLock;
     mutable Cache m_cache;
 };
 
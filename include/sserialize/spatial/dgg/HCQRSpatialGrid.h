@@ -11,6 +11,8 @@ namespace sserialize {
 
 namespace sserialize::spatial::dgg::impl::detail::HCQRSpatialGrid {
 
+class TreeNodeArena;
+
 /**
 	* We assume the following: 
 	* A Node is either an internal node and only has children OR a leaf node.
@@ -19,7 +21,7 @@ namespace sserialize::spatial::dgg::impl::detail::HCQRSpatialGrid {
 	*/
 class TreeNode final {
 public:
-	using Children = std::vector<std::unique_ptr<TreeNode>>;
+	using Children = std::vector<TreeNode*>;
 	using PixelId = sserialize::spatial::dgg::interface::SpatialGrid::PixelId;
 	enum : int {NONE=0x0, IS_INTERNAL=0x1, IS_PARTIAL_MATCH=0x2, IS_FULL_MATCH=0x4, IS_FETCHED=0x8} Flags;
 	static constexpr uint32_t npos = std::numeric_limits<uint32_t>::max();
@@ -28,13 +30,14 @@ public:
 	TreeNode(TreeNode const &) = delete;
 	~TreeNode() {}
 	//copies flags, pixelId and itemIndexId if IS_FETCHED is false 
-	std::unique_ptr<TreeNode> shallowCopy() const; 
+	TreeNode * shallowCopy(TreeNodeArena & arena) const; 
 	//copies flags, pixelId if IS_FETCHED is true and sets the new fetchedItemIndexId 
-	std::unique_ptr<TreeNode> shallowCopy(uint32_t fetchedItemIndexId) const;
+	TreeNode * shallowCopy(TreeNodeArena & arena, uint32_t fetchedItemIndexId) const;
 	//copies flags, pixelId if isInternal() is true
-	std::unique_ptr<TreeNode> shallowCopy(Children && newChildren) const; 
+	TreeNode * shallowCopy(TreeNodeArena & arena, Children && newChildren) const; 
 public:
-	static std::unique_ptr<TreeNode> make_unique(PixelId pixelId, int flags, uint32_t itemIndexId = npos);
+	///The node is owned by arena
+	static TreeNode * make(TreeNodeArena & arena, PixelId pixelId, int flags, uint32_t itemIndexId = npos);
 public:
 	inline PixelId pixelId() const { return m_pid; }
 	inline bool isInternal() const { return children().size(); }
@@ -55,6 +58,7 @@ public:
 public:
 	bool valid() const;
 private:
+	friend class TreeNodeArena;
 	TreeNode(PixelId pixelId, int flags, uint32_t itemIndexId);
 private:
 	PixelId m_pid;
@@ -62,6 +66,43 @@ private:
 	uint32_t m_itemIndexId;
 	Children m_children;
 };
+
+/**
+  * Owns the nodes of a tree. Nodes are allocated in blocks and are only freed when the arena is destroyed.
+  * Dropping a node from a tree therefore does not free it.
+  */
+class TreeNodeArena final {
+public:
+	using PixelId = TreeNode::PixelId;
+public:
+	TreeNodeArena() {}
+	TreeNodeArena(TreeNodeArena const &) = delete;
+	TreeNodeArena(TreeNodeArena && other) = default;
+	~TreeNodeArena();
+	TreeNodeArena & operator=(TreeNodeArena const &) = delete;
+	TreeNodeArena & operator=(TreeNodeArena && other);
+public:
+	TreeNode * make(PixelId pixelId, int flags, uint32_t itemIndexId);
+	///Takes ownership of the nodes of other
+	void splice(TreeNodeArena && other);
+	///number of allocated nodes
+	std::size_t size() const;
+	///destroys all nodes
+	void clear();
+private:
+	static constexpr std::size_t MinBlockSize = 64;
+	static constexpr std::size_t MaxBlockSize = 64*1024;
+	struct alignas(TreeNode) NodeStorage {
+		std::byte data[sizeof(TreeNode)];
+	};
+	struct Block {
+		std::unique_ptr<NodeStorage[]> nodes;
+		std::size_t capacity;
+		std::size_t size;
+	};
+private:
+	std::vector<Block> m_blocks;
+};
 	
 } //end namespace sserialize::spatial::dgg::impl::detail::HCQRSpatialGrid
 
@@ -73,7 +114,9 @@ public:
     using Parent = interface::HCQRSpatialGrid;
     using Self = sserialize::spatial::dgg::impl::HCQRSpatialGrid;
 	using TreeNode = detail::HCQRSpatialGrid::TreeNode;
-	using TreeNodePtr = std::unique_ptr<TreeNode>;
+	using TreeNodeArena = detail::HCQRSpatialGrid::TreeNodeArena;
+	///Nodes are owned by the arena of their HCQRSpatialGrid
+	using TreeNodePtr = TreeNode *;
 public:
     HCQRSpatialGrid(
         sserialize::Static::ItemIndexStore idxStore,
@@ -86,8 +129,10 @@ public:
         sserialize::RCPtrWrapper<sserialize::spatial::dgg::interface::SpatialGrid> sg,
         sserialize::RCPtrWrapper<sserialize::spatial::dgg::interface::SpatialGridInfo> sgi
     );
+    ///root has to be allocated in arena
     HCQRSpatialGrid(
-		TreeNodePtr && root,
+		TreeNodeArena && arena,
+		TreeNodePtr root,
         sserialize::Static::ItemIndexStore idxStore,
         sserialize::RCPtrWrapper<sserialize::spatial::dgg::interface::SpatialGrid> sg,
         sserialize::RCPtrWrapper<sserialize::spatial::dgg::interface::SpatialGridInfo> sgi
@@ -108,6 +153,10 @@ public:
     HCQRPtr allToFull() const override;
 public:
 	TreeNodePtr const & root() const;
+	///Number of threads used by operator/, operator+ and operator- to compute the subtrees below the root, 1 by default
+	///Results of these operations inherit this setting
+	void setThreadCount(uint32_t threadCount) { m_threadCount = threadCount; }
+	uint32_t threadCount() const { return m_threadCount; }
 public:
     sserialize::ItemIndex items(TreeNode const & node) const;
 	PixelLevel level(TreeNode const & node) const;
@@ -118,9 +167,15 @@ public:
 private:
     struct HCQRSpatialGridOpHelper;
 private:
-    TreeNodePtr m_root;
+	///empty grid with the same stores and settings
+	sserialize::RCPtrWrapper<Self> emptyResult() const;
+	TreeNodePtr makeNode(PixelId pixelId, int flags, uint32_t itemIndexId = TreeNode::npos);
+private:
+    TreeNodeArena m_arena;
+    TreeNodePtr m_root{nullptr};
     sserialize::Static::ItemIndexStore m_items;
     std::vector<sserialize::ItemIndex> m_fetchedItems;
+    uint32_t m_threadCount{1};
 };
 
 } //end namespace sserialize::spatial::dgg::impl
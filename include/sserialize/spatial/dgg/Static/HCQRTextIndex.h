@@ -95,7 +95,8 @@ public:
 	~CompactTree();
 public:
 	uint32_t nodeCount() const;
-	HCQRSpatialGrid::TreeNodePtr tree(SpatialGrid const & sg) const;
+	///nodes are allocated in arena
+	HCQRSpatialGrid::TreeNodePtr tree(SpatialGrid const & sg, HCQRSpatialGrid::TreeNodeArena & arena) const;
 private:
 	sserialize::UByteArrayAdapter m_d;
 };
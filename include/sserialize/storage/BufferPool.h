@@ -0,0 +1,44 @@
+#ifndef SSERIALIZE_BUFFER_POOL_H
+#define SSERIALIZE_BUFFER_POOL_H
+#include <sserialize/utility/refcounting.h>
+#include <vector>
+#include <mutex>
+#include <cstdint>
+
+namespace sserialize {
+
+/**
+  * Thread-safe pool of byte buffers to reuse the output buffers of decompressors.
+  * Pass a buffer together with its pool to UByteArrayAdapter(std::vector<uint8_t>*, const RCPtrWrapper<BufferPool>&)
+  * to hand it back to the pool once the last adapter referencing it is destroyed.
+  * The pool keeps at most maxBuffers buffers, buffers with a capacity larger than maxBufferCapacity are deleted on release.
+  */
+class BufferPool final: public RefCountObject {
+public:
+	struct Stats {
+		uint64_t acquired{0};
+		uint64_t reused{0};
+		std::size_t pooled{0};
+	};
+	static constexpr std::size_t DefaultMaxBuffers = 64;
+	static constexpr std::size_t DefaultMaxBufferCapacity = 1024*1024;
+public:
+	BufferPool(std::size_t maxBuffers = DefaultMaxBuffers, std::size_t maxBufferCapacity = DefaultMaxBufferCapacity);
+	BufferPool(const BufferPool & other) = delete;
+	BufferPool & operator=(const BufferPool & other) = delete;
+	virtual ~BufferPool();
+	///@return a buffer of size size with unspecified content, the caller owns it until it is passed to release()
+	std::vector<uint8_t> * acquire(std::size_t size);
+	void release(std::vector<uint8_t> * buffer);
+	Stats stats() const;
+private:
+	mutable std::mutex m_lock;
+	std::vector< std::vector<uint8_t>* > m_buffers;
+	std::size_t m_maxBuffers;
+	std::size_t m_maxBufferCapacity;
+	Stats m_stats;
+};
+
+}//end namespace sserialize
+
+#endif
@@ -1,10 +1,13 @@
 #ifndef SSERIALIZE_CHUNKED_MMAPPED_FILE_H
 #define SSERIALIZE_CHUNKED_MMAPPED_FILE_H
 #include <sserialize/utility/refcounting.h>
-#include <sserialize/containers/DirectRandomCache.h>
 #include <sserialize/storage/UByteArrayAdapter.h>
 #include <sserialize/utility/types.h>
 #include <limits>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include <vector>
 
 namespace sserialize {
 namespace detail {
@@ -25,19 +28,70 @@ public:
 	}
 };
 
+///Loads regions of a file into the page cache on a background thread
+class Prefetcher;
+
+struct ChunkSlot {
+	///set while the chunk is being unmapped, pins are only valid if this flag is not set
+	static constexpr uint32_t EvictionFlag = uint32_t(1) << 31;
+	std::atomic<uint8_t*> data{nullptr};
+	///number of leases
+	std::atomic<uint32_t> pins{0};
+	///second chance flag for eviction
+	std::atomic<bool> used{false};
+};
+
 }}//end namespace detail::ChunkedMmappedFile
 
 class ChunkedMmappedFilePrivate;
 
 /** This class implements a chunked mmapped file access. The minimum chunksize is 1 MebiByte and a default cache count of 16
   * 
-  * This class is NOT thread-safe (and never can: i.e. thread-one holds a refernce to a cacheLine by oeprator[] and thread 2 evicts that cacheLine. There's no way to lock the cacheline without user-interaction in thread 19
+  * With readahead enabled, sequential access (two consecutively mapped chunks) triggers loading the following chunks
+  * into the page cache on a background thread. prefetch() does the same for an explicit region.
+  * 
+  * Concurrent access is supported through read(), write() and lease().
+  * A ChunkLease pins its chunk: pinned chunks are never unmapped. Hence the cache count is a soft limit if many chunks are pinned.
+  * Looking up a mapped chunk is lock-free, mapping and unmapping chunks is serialized.
+  * Every access pins the chunk for its duration, direct pointers into the file are only available through a lease.
+  * open(), close(), resize() and setCacheCount() need exclusive access and no lease may exist during close() and resize(),
+  * otherwise they throw a PreconditionViolationException.
   * 
   */
 class ChunkedMmappedFile: public RCWrapper<ChunkedMmappedFilePrivate>  {
 public:
 	typedef OffsetType SizeType;
 	typedef SignedOffsetType NegativeSizeType;
+	
+	///Keeps a chunk mapped as long as the lease or one of its copies exists
+	class ChunkLease final {
+	public:
+		ChunkLease();
+		ChunkLease(const ChunkLease & other);
+		ChunkLease(ChunkLease && other);
+		~ChunkLease();
+		ChunkLease & operator=(const ChunkLease & other);
+		ChunkLease & operator=(ChunkLease && other);
+		inline bool valid() const { return m_slot; }
+		///begin of the chunk
+		inline uint8_t * data() const { return m_data; }
+		///global offset of the beginning of the chunk
+		inline SizeType offset() const { return m_offset; }
+		inline SizeType size() const { return m_size; }
+		inline bool contains(SizeType globalOffset) const { return globalOffset >= m_offset && globalOffset < m_offset+m_size; }
+		///@param globalOffset has to be within this chunk
+		inline uint8_t * at(SizeType globalOffset) const { return m_data + (globalOffset - m_offset); }
+	private:
+		friend class ChunkedMmappedFilePrivate;
+		///takes ownership of a pin of slot
+		ChunkLease(detail::ChunkedMmappedFile::ChunkSlot * slot, uint8_t * data, SizeType offset, SizeType size);
+		void release();
+	private:
+		detail::ChunkedMmappedFile::ChunkSlot * m_slot;
+		uint8_t * m_data;
+		SizeType m_offset;
+		SizeType m_size;
+	};
 protected:
 	typedef RCWrapper<ChunkedMmappedFilePrivate> MyParentClass;
 public:
@@ -54,9 +108,9 @@ public:
 	bool open();
 	bool close();
 
-	uint8_t & operator[](const SizeType offset);
-	const uint8_t & operator[](const SizeType offset) const;
-	uint8_t * data(const SizeType offset);
+	uint8_t operator[](const SizeType offset) const;
+	///pin the chunk containing offset
+	ChunkLease lease(const SizeType offset) const;
 	void read(const ChunkedMmappedFile::SizeType offset, uint8_t* dest, SizeType& len) const;
 	void write(const uint8_t * src, const SizeType destOffset, SizeType & len);
 	
@@ -67,6 +121,12 @@ public:
 	void setDeleteOnClose(bool deleteOnClose);
 	void setSyncOnClose(bool syncOnClose);
 	void setCacheCount(uint32_t count);
+	///number of currently mapped chunks
+	uint32_t mappedChunkCount() const;
+	/** Number of chunks to load ahead on sequential access, 0 disables readahead */
+	void setReadahead(uint32_t chunkCount);
+	/** Asynchronously load the region [offset, offset+len) into the page cache */
+	void prefetch(SizeType offset, SizeType len);
 
 	/** resizes the file to size bytes. All former data references are invalid after this */
 	bool resize(sserialize::ChunkedMmappedFile::SizeType size);
@@ -91,16 +151,45 @@ private:
 	uint32_t m_chunkMask;
 	
 	ChunkIndexType m_maxOccupyCount{16};
-	DirectRandomCache<uint8_t*> m_cache;
+	std::unique_ptr<detail::ChunkedMmappedFile::ChunkSlot[]> m_slots;
+	ChunkIndexType m_chunkCount{0};
+	
+	///guards everything below and mapping/unmapping of chunks
+	std::mutex m_mapLock;
+	///mapped chunks, this is the clock used for eviction
+	std::vector<ChunkIndexType> m_mapped;
+	std::size_t m_clockHand{0};
+	
+	uint32_t m_readaheadChunks{0};
+	ChunkIndexType m_lastMappedChunk{std::numeric_limits<ChunkIndexType>::max()};
+	///chunks before this one were already handed to the prefetcher
+	ChunkIndexType m_readaheadEnd{0};
+	std::unique_ptr<detail::ChunkedMmappedFile::Prefetcher> m_prefetcher;
 private:
 	uint8_t * do_map(const sserialize::ChunkedMmappedFilePrivate::ChunkIndexType chunk);
 	
 	/** unmaps a chunk but does not remove it from the cache */
-	bool do_unmap(const ChunkIndexType chunk);
+	bool do_unmap(const ChunkIndexType chunk, uint8_t * data);
 	/** Does an unchecked sync on @param chunk */
-	bool do_sync(const ChunkIndexType chunk);
-	inline ChunkSizeType chunkSize() { return static_cast<ChunkSizeType>(1) << m_chunkShift; }
-	ChunkSizeType sizeOfChunk(ChunkIndexType chunk);
+	bool do_sync(const ChunkIndexType chunk, uint8_t * data);
+	inline ChunkSizeType chunkSize() const { return static_cast<ChunkSizeType>(1) << m_chunkShift; }
+	ChunkSizeType sizeOfChunk(ChunkIndexType chunk) const;
+	/** Reset the chunk slots according to the file size, all chunks have to be unmapped */
+	void resetSlots();
+	/** Unmaps chunk if it is not pinned, m_mapLock has to be held
+	  * @return true if chunk was unmapped */
+	bool tryEvict(ChunkIndexType chunk, bool & unmapOk);
+	/** Unmaps one chunk that is not pinned, m_mapLock has to be held
+	  * @return false if all chunks are pinned */
+	bool evictOne();
+	/** Maps chunk and pins it, m_mapLock has to be held */
+	uint8_t * mapAndPin(ChunkIndexType chunk);
+	/** Called if chunk was mapped, issues readahead on sequential access, m_mapLock has to be held */
+	void readahead(ChunkIndexType chunk);
+	/** m_mapLock has to be held */
+	void do_prefetch(SizeType offset, SizeType len);
+	/** Stops the prefetcher, waits for running requests */
+	void stopPrefetcher();
 public:
 	ChunkedMmappedFilePrivate(uint8_t chunkSizeExponent);
 	virtual ~ChunkedMmappedFilePrivate();
@@ -109,6 +198,9 @@ public:
 	inline void setDeleteOnClose(bool deleteOnClose) { m_deleteOnClose = deleteOnClose; }
 	inline void setSyncOnClose(bool syncOnClose) { m_syncOnClose = syncOnClose; }
 	void setCacheCount(uint32_t count);
+	ChunkIndexType mappedChunkCount();
+	void setReadahead(uint32_t chunkCount);
+	void prefetch(SizeType offset, SizeType len);
 
 	inline SizeType size() const { return m_size; }
 	inline std::string fileName() const { return m_fileName;}
@@ -119,16 +211,11 @@ public:
 	/** Close all maps an the file */
 	bool do_close();
 	
-	/** unmaps all open mappings and removes them from the cache */
+	/** unmaps all open mappings and removes them from the cache, throws if a chunk is still leased */
 	bool do_unmap();
 	
 	bool resize(const SizeType size);
 
-	///This does not do any kind of correctnes checks! 
-	inline uint8_t & operator[](const SizeType pos) { return *data(pos); }
-	///This does not do any kind of correctnes checks! 
-	uint8_t * data(const SizeType offset);
-	
 	///copys at most len bytes starting from offset into dest, len contains the read bytes
 	void read(const ChunkedMmappedFilePrivate::SizeType offset, uint8_t* dest, SizeType& len);
 	
@@ -136,7 +223,7 @@ public:
 	void write(const uint8_t * src, const SizeType destOffset, SizeType & len);
 	
 	///This does not do any kind of correctnes checks! 
-	uint8_t * chunkData(const sserialize::ChunkedMmappedFilePrivate::ChunkIndexType chunk);
+	ChunkedMmappedFile::ChunkLease lease(const sserialize::ChunkedMmappedFilePrivate::ChunkIndexType chunk);
 	   ChunkIndexType chunk(const sserialize::ChunkedMmappedFilePrivate::SizeType offset) const;
 	   ChunkSizeType inChunkOffSet(const sserialize::ChunkedMmappedFilePrivate::SizeType offset) const;
 };
@@ -7,22 +7,35 @@
 #include <sserialize/storage/MmappedFile.h>
 #include <sserialize/containers/DynamicBitSet.h>
 #include <sserialize/utility/types.h>
+#include <sserialize/utility/Compressor.h>
 #include <limits>
 #include <stack>
+#include <memory>
+#include <mutex>
+#include <future>
+#include <unordered_map>
 
 //TODO: improve by only compresssing compressible tiles, uncompressible tiles should be mmapped into memory
 
 /** This class implements a compressed file with variable size chunks
   * It supports random access on the stored data
   * 
-  *-------------------------------------------------------------------------------------
-  *CompressedData|ChunkOffsets        |  ChunkType  |CHUNKEXP|DECSIZE |COMPSIZE|VERSION
-  *-------------------------------------------------------------------------------------
-  *       *      |  SortedOffsetIndex |DynamicBitSet|    1   |   5    |   5    |   1
+  *---------------------------------------------------------------------------------------------
+  *CompressedData|ChunkOffsets        |ChunkCodecs|CHUNKEXP|DECSIZE |COMPSIZE|CODEC|VERSION
+  *---------------------------------------------------------------------------------------------
+  *       *      |  SortedOffsetIndex |   u8*     |    1   |   5    |   5    |  1  |   2
   *
   * ChunkOffsets: Offset from the beginning of CompressedData to chunk i
-  * ChunkType: Bit set which selects if the data is in compressed form or not
+  * ChunkCodecs: Compressor::CompressionTypes of chunk i, CT_NONE if the chunk is stored uncompressed
+  * CODEC: the preferred codec of the creator of the file
   *
+  * Version 1 files store a DynamicBitSet instead of ChunkCodecs (set bits mark lzo compressed chunks)
+  * and have no CODEC field. They can still be opened.
+  *
+  * Decompressed chunks are stored in a cache shared by all CompressedMmappedFile with a global memory budget (see setSharedCacheSize).
+  * Every file additionally keeps references to its setCacheCount() most recently used chunks,
+  * pointers returned by data() and operator[] stay valid until that many other chunks of the file were accessed.
+  * On sequential access the following chunks are decompressed in parallel on a shared thread pool (see setDecodeAhead).
   *
   */
 
@@ -63,7 +76,18 @@ public:
 	#if defined(SSERIALIZE_UBA_NON_CONTIGUOUS) || defined(SSERIALIZE_UBA_ONLY_CONTIGUOUS_SOFT_FAIL)
 	UByteArrayAdapter dataAdapter();
 	#endif
+	///number of chunks this file keeps referenced
 	void setCacheCount(uint32_t count);
+	///number of chunks to decompress in the background during sequential access, 0 disables decode-ahead
+	void setDecodeAhead(uint32_t chunkCount);
+	
+	///set the maximum size in bytes of the decompressed chunks in the shared cache
+	static void setSharedCacheSize(std::size_t bytes);
+	static std::size_t sharedCacheSize();
+	///@return bytes currently used by the shared cache
+	static std::size_t sharedCacheUsage();
+	///set the number of threads used to decompress chunks in the background
+	static void setDecompressionThreadCount(uint32_t count);
 	
 	/** Creates a CompressedMmappedFile
 	  *
@@ -73,6 +97,20 @@ public:
 	  */
 	static bool create(const UByteArrayAdapter & src, UByteArrayAdapter & dest, uint8_t chunkSizeExponent, double compressionRatio);
 	
+	/** Creates a CompressedMmappedFile using the given codecs
+	  * Every chunk is compressed with every codec and stored with the one that produces the smallest output.
+	  * Chunks not reaching compressionRatio with any codec are stored uncompressed.
+	  * Hence passing both a fast codec (i.e. CT_LZ4) and a dense one (i.e. CT_LZ4HC) only uses the dense codec where it pays off.
+	  *
+	  * @param codecs: codecs to choose from, the first one is stored as the preferred codec of the file
+	  */
+	static bool create(const UByteArrayAdapter & src, UByteArrayAdapter & dest, uint8_t chunkSizeExponent, double compressionRatio, const std::vector<Compressor::CompressionTypes> & codecs);
+	
+	///@return the preferred codec of the file
+	Compressor::CompressionTypes codec() const;
+	///@return codec of the chunk containing offset, CT_NONE if it is stored uncompressed
+	Compressor::CompressionTypes codec(const SizeType offset) const;
+	
 };
 
 
@@ -83,6 +121,8 @@ public:
 	typedef DirectRandomCache<uint32_t> MyCacheType;
 	typedef uint32_t ChunkIndexType;
 	typedef SizeType ChunkSizeType;
+	///Data of a chunk, either decompressed to memory or mmapped if it is stored uncompressed
+	typedef std::shared_ptr<uint8_t> ChunkDataPtr;
 private:
 	std::string m_fileName;
 	SizeType m_size; //Total size of the decompressed file
@@ -91,8 +131,15 @@ private:
 	std::size_t m_compressedSize;
 	
 	uint8_t * m_chunkIndexData;
+	std::size_t m_chunkIndexMapLen;
 	Static::SortedOffsetIndex m_chunkIndex;
-	DynamicBitSet m_chunkTypeBitSet;
+	///codec of each chunk
+	std::vector<uint8_t> m_chunkCodecs;
+	Compressor::CompressionTypes m_codec;
+	///decompressors indexed by codec, only created for codecs used in the file
+	std::vector<Compressor> m_decompressors;
+	///id of this file in the shared cache
+	uint64_t m_fileId;
 	
 	/** 1 << m_chunkShift = chunkSize */
 	uint8_t m_chunkShift;
@@ -100,32 +147,39 @@ private:
 	
 	uint32_t m_maxOccupyCount;
 	MyCacheType m_cache; //cache which maps from File chunks to m_chunkStorage positions
-	MmappedFile m_decTileFile; //the file storage to store the decompressed data
-	std::vector<uint16_t> m_freeList; //list of free places in decTileFile
-	std::vector<uint8_t*> m_chunkStorage;
+	std::vector<ChunkDataPtr> m_chunkStorage;
+	
+	uint32_t m_decodeAhead;
+	ChunkIndexType m_lastChunk;
+	///chunks currently decompressed in the background
+	std::mutex m_inFlightLock;
+	std::unordered_map<ChunkIndexType, std::shared_future<ChunkDataPtr>> m_inFlight;
 private:
 	
-	void mmapChunkParameters(ChunkIndexType chunk, size_t & mapOverHead, off_t & beginOffset, size_t & mapLen);
+	void mmapChunkParameters(ChunkIndexType chunk, size_t & mapOverHead, off_t & beginOffset, size_t & mapLen) const;
 	
-	///@return ptr to the beginning of the chunk
-	uint8_t * mmapChunk(ChunkIndexType chunk);
-	///@param data: ptr to the beginning of the chunk
-	void ummapChunk(ChunkIndexType chunk, uint8_t * data);
+	///@return the mmapped chunk
+	ChunkDataPtr mmapChunk(ChunkIndexType chunk) const;
 
-	///This function uncompresses chunk number @chunk into @dest
-	bool do_unpack(ChunkIndexType chunk, uint8_t * dest);
+	///This function uncompresses chunk number @chunk, it is thread-safe
+	///@return decompressed data, empty on failure
+	ChunkDataPtr do_unpack(ChunkIndexType chunk) const;
 	
-	/** This functions populates the chunkStorage with chunk @chunk */
-	bool populate(ChunkIndexType chunk, uint8_t* & dest);
+	/** This function returns the data of chunk @chunk from the shared cache, the background decompression or decompresses it itself */
+	ChunkDataPtr populate(ChunkIndexType chunk);
+	
+	///Decompress the chunks following chunk in the background if chunk continues a sequential scan
+	void decodeAhead(ChunkIndexType chunk);
+	///wait for all background decompressions of this file
+	void waitForInFlight();
 	
 	/** This function evicts a chunk from the cache
-	  * it returns the chosen chunk, 0xFFFFFFFF on failure
-	  * It checks the type of the chosen chunk an removed mmapped locations or puts the freed decTileChunk back into the freeList
-	  *
+	  * @return false if the cache is empty
 	  */
 	bool evict(ChunkIndexType & evictedChunk, ChunkIndexType & associatedChunkStoragePostion);
 	
 	inline ChunkSizeType chunkSize() const { return 1 << m_chunkShift; }
+	ChunkSizeType sizeOfChunk(ChunkIndexType chunk) const;
 	ChunkIndexType chunkCount() const;
 public:
 	CompressedMmappedFilePrivate();
@@ -134,11 +188,14 @@ public:
 	
 	///sets the cache count, costly operation
 	void setCacheCount(ChunkIndexType count);
+	void setDecodeAhead(uint32_t chunkCount);
 
 	///@return Total size of the decompressed data
 	inline SizeType size() const { return m_size; }
 	inline std::string fileName() const { return m_fileName;}
 	bool valid() const;
+	inline Compressor::CompressionTypes codec() const { return m_codec; }
+	inline Compressor::CompressionTypes chunkCodec(const ChunkIndexType chunk) const { return Compressor::CompressionTypes(m_chunkCodecs.at(chunk)); }
 	
 	/** Open file */
 	bool do_open();
@@ -155,6 +212,8 @@ public:
 	
 	///This does not do any kind of correctnes checks! 
 	uint8_t * chunkData(const ChunkIndexType chunk);
+	///@return data of chunk, the data stays valid as long as the returned pointer exists
+	ChunkDataPtr chunkDataPtr(const ChunkIndexType chunk);
 	ChunkIndexType chunk(const SizeType offset) const;
 	ChunkSizeType inChunkOffSet(const SizeType offset) const;
 };
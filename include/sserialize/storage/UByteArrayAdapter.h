@@ -32,8 +32,11 @@
 #include <sserialize/utility/refcounting.h>
 #include <sserialize/storage/MmappedMemory.h>
 #include <sserialize/storage/SerializationInfo.h>
+#include <sserialize/storage/pack_unpack_functions.h>
+#include <sserialize/utility/constants.h>
 #include <stdint.h>
 #include <iterator>
+#include <algorithm>
 #include <deque>
 #include <vector>
 #include <string>
@@ -63,6 +66,7 @@ class MmappedFile;
 // class UByteArrayAdapterPrivate;
 class ChunkedMmappedFile;
 class CompressedMmappedFile;
+class BufferPool;
 class UByteArrayAdapter;
 
 SSERIALIZE_NAMESPACE_INLINE_UBA_ONLY_CONTIGUOUS
@@ -150,6 +154,8 @@ namespace __UByteArrayAdapter {
 		UByteArrayAdapter dataBase() const;
 	};
 	
+	class BorrowedView;
+	
 	struct ConsumeTag {};
 	struct NoConsumeTag {};
 	
@@ -222,6 +228,7 @@ public:
 	} AdviseType;
 	
 	typedef detail::__UByteArrayAdapter::MemoryView MemoryView;
+	typedef detail::__UByteArrayAdapter::BorrowedView BorrowedView;
 	
 	template<typename TValue>
 	using SerializationSupport = detail::__UByteArrayAdapter::SerializationSupport<TValue>;
@@ -278,6 +285,8 @@ public://constructors
 	UByteArrayAdapter(std::vector<uint8_t> * data, OffsetType offSet, OffsetType len);
 	UByteArrayAdapter(std::vector<uint8_t> * data);
 	UByteArrayAdapter(std::vector<uint8_t> * data, bool deleteOnClose);
+	///data is handed back to pool once the last adapter referencing it is destroyed
+	UByteArrayAdapter(std::vector<uint8_t> * data, const RCPtrWrapper<BufferPool> & pool);
 	UByteArrayAdapter(const sserialize::MmappedFile& file, OffsetType offSet, OffsetType len);
 	UByteArrayAdapter(const sserialize::MmappedFile& file);
 	UByteArrayAdapter(const sserialize::MmappedMemory<uint8_t> & mem);
@@ -397,6 +406,10 @@ public://conversion functions
 	const MemoryView getMemView(const OffsetType pos, OffsetType size) const;
 	inline MemoryView asMemView() { return getMemView(0, size());}
 	const MemoryView asMemView() const { return getMemView(0, size());}
+	///Returns a non-owning read-only view that does not touch the reference count of the storage
+	///The view is only valid as long as this adapter or a copy of it is alive and the storage is not resized
+	BorrowedView getBorrowedView(const OffsetType pos, OffsetType size) const;
+	BorrowedView asBorrowedView() const;
 	
 	std::string toString() const;
 	
@@ -427,6 +440,18 @@ public://get functions with offset
 	uint32_t getVlPackedUint32(const OffsetType pos, int* length = 0) const;
 	int32_t getVlPackedInt32(const OffsetType pos, int* length = 0) const;
 	
+	///Decode count consecutive vl-packed numbers starting at pos into dest
+	///The memory is resolved once, contiguous storage is decoded in place, other storage in chunks
+	///@return number of bytes consumed
+	///@throw OutOfBoundsException if the data ends before count numbers were decoded
+	OffsetType getVlPackedUint64Array(const OffsetType pos, uint64_t * dest, SizeType count) const;
+	OffsetType getVlPackedInt64Array(const OffsetType pos, int64_t * dest, SizeType count) const;
+	OffsetType getVlPackedUint32Array(const OffsetType pos, uint32_t * dest, SizeType count) const;
+	OffsetType getVlPackedInt32Array(const OffsetType pos, int32_t * dest, SizeType count) const;
+	///Decode count delta encoded numbers, dest[i] = start + v[0] + ... + v[i]
+	OffsetType getVlPackedDeltaUint64Array(const OffsetType pos, uint64_t * dest, SizeType count, uint64_t start = 0) const;
+	OffsetType getVlPackedDeltaUint32Array(const OffsetType pos, uint32_t * dest, SizeType count, uint32_t start = 0) const;
+	
 	//Offset storage
 	OffsetType getOffset(const OffsetType pos) const;
 	NegativeOffsetType getNegativeOffset(const OffsetType pos) const;
@@ -491,6 +516,14 @@ public://streaming get functions
 	uint32_t getVlPackedUint32();
 	int32_t getVlPackedInt32();
 	
+	///Streaming versions of the bulk decoding functions, advances the get pointer by the number of bytes consumed
+	void getVlPackedUint64Array(uint64_t * dest, SizeType count);
+	void getVlPackedInt64Array(int64_t * dest, SizeType count);
+	void getVlPackedUint32Array(uint32_t * dest, SizeType count);
+	void getVlPackedInt32Array(int32_t * dest, SizeType count);
+	void getVlPackedDeltaUint64Array(uint64_t * dest, SizeType count, uint64_t start = 0);
+	void getVlPackedDeltaUint32Array(uint32_t * dest, SizeType count, uint32_t start = 0);
+	
 	///@return number of uint8_t read, @param len: maxnumber of uint8_t to read
 	OffsetType getData(uint8_t * dest, OffsetType len);
 
@@ -533,6 +566,7 @@ public://debugging functions
 /*---------------PRIVATE PART---------------------------*/
 private:
 	friend class detail::__UByteArrayAdapter::MemoryView;
+	friend class detail::__UByteArrayAdapter::BorrowedView;
 private:
 	/** Data is at offset, not at base address **/
 	MyPrivatePtr m_priv;
@@ -644,6 +678,124 @@ inline void UByteArrayAdapter::put(UByteArrayAdapter::OffsetType pos, const sser
 namespace detail {
 namespace __UByteArrayAdapter {
 
+///Read-only view of a range of an UByteArrayAdapter without ownership of the storage.
+///Copying and slicing a view neither allocates nor changes the reference count of the storage.
+///Contiguous storage is read through a plain pointer, other storage through its backend.
+class BorrowedView final {
+public:
+	typedef sserialize::UByteArrayAdapter::MyPrivate MyPrivate;
+	typedef sserialize::OffsetType OffsetType;
+	typedef sserialize::OffsetType SizeType;
+public:
+	BorrowedView() {}
+	~BorrowedView() {}
+	///view of size bytes starting at pos
+	BorrowedView slice(OffsetType pos, OffsetType size) const;
+	///view of all bytes starting at pos
+	inline BorrowedView slice(OffsetType pos) const { return slice(pos, m_size-std::min(pos, m_size)); }
+	inline OffsetType size() const { return m_size; }
+	inline bool isEmpty() const { return !m_size; }
+	///If this is true, then data() points to the first byte of the view
+	inline bool isContiguous() const { return m_data || !m_size; }
+	///nullptr if the storage is not contiguous
+	inline const uint8_t * data() const { return m_data; }
+public:
+	inline uint8_t getUint8(OffsetType pos) const;
+	inline uint16_t getUint16(OffsetType pos) const;
+	inline uint32_t getUint24(OffsetType pos) const;
+	inline uint32_t getUint32(OffsetType pos) const;
+	inline uint64_t getUint64(OffsetType pos) const;
+	inline uint32_t getVlPackedUint32(OffsetType pos, int * length = 0) const;
+	inline uint64_t getVlPackedUint64(OffsetType pos, int * length = 0) const;
+	///@return number of bytes copied, at most len
+	OffsetType getData(OffsetType pos, uint8_t * dest, OffsetType len) const;
+	///Owning adapter of the same range, this increments the reference count of the storage
+	sserialize::UByteArrayAdapter adapter() const;
+private:
+	friend class sserialize::UByteArrayAdapter;
+	BorrowedView(const uint8_t * data, const MyPrivate * priv, OffsetType offset, OffsetType size);
+private:
+	inline void range_check(OffsetType pos, OffsetType length) const {
+		if (UNLIKELY_BRANCH(m_size < pos+length)) {
+			throwOutOfBounds(pos, length);
+		}
+	}
+	[[noreturn]] void throwOutOfBounds(OffsetType pos, OffsetType length) const;
+	uint8_t privGetUint8(OffsetType pos) const;
+	uint16_t privGetUint16(OffsetType pos) const;
+	uint32_t privGetUint24(OffsetType pos) const;
+	uint32_t privGetUint32(OffsetType pos) const;
+	uint64_t privGetUint64(OffsetType pos) const;
+	uint32_t privGetVlPackedUint32(OffsetType pos, int * length) const;
+	uint64_t privGetVlPackedUint64(OffsetType pos, int * length) const;
+private:
+	const uint8_t * m_data{nullptr};
+	const MyPrivate * m_priv{nullptr};
+	OffsetType m_offset{0};
+	OffsetType m_size{0};
+};
+
+#define UBA_BORROWED_VIEW_GET_FUNC(__TYPE, __NAME, __PRIVNAME, __LENGTH, __UNPACK) \
+__TYPE BorrowedView::__NAME(OffsetType pos) const { \
+	range_check(pos, __LENGTH); \
+	if (LIKELY_BRANCH(m_data)) { \
+		return __UNPACK(m_data+pos); \
+	} \
+	return __PRIVNAME(pos); \
+}
+
+UBA_BORROWED_VIEW_GET_FUNC(uint8_t, getUint8, privGetUint8, 1, up_u8)
+UBA_BORROWED_VIEW_GET_FUNC(uint16_t, getUint16, privGetUint16, 2, up_u16)
+UBA_BORROWED_VIEW_GET_FUNC(uint32_t, getUint24, privGetUint24, 3, up_u24)
+UBA_BORROWED_VIEW_GET_FUNC(uint32_t, getUint32, privGetUint32, 4, up_u32)
+UBA_BORROWED_VIEW_GET_FUNC(uint64_t, getUint64, privGetUint64, 8, up_u64)
+#undef UBA_BORROWED_VIEW_GET_FUNC
+
+uint32_t BorrowedView::getVlPackedUint32(OffsetType pos, int * length) const {
+	range_check(pos, 1);
+	int len = (int) std::min<SizeType>(5, m_size - pos);
+	uint32_t res;
+	if (LIKELY_BRANCH(m_data)) {
+		uint8_t * begin = const_cast<uint8_t*>(m_data+pos);
+		res = up_vu32(begin, begin+len, &len);
+	}
+	else {
+		res = privGetVlPackedUint32(pos, &len);
+	}
+	if (length) {
+		*length = len;
+	}
+	if (len < 0) {
+		throwOutOfBounds(pos, 1);
+	}
+	return res;
+}
+
+uint64_t BorrowedView::getVlPackedUint64(OffsetType pos, int * length) const {
+	range_check(pos, 1);
+	int len = (int) std::min<SizeType>(10, m_size - pos);
+	uint64_t res;
+	if (LIKELY_BRANCH(m_data)) {
+		uint8_t * begin = const_cast<uint8_t*>(m_data+pos);
+		res = up_vu64(begin, begin+len, &len);
+	}
+	else {
+		res = privGetVlPackedUint64(pos, &len);
+	}
+	if (length) {
+		*length = len;
+	}
+	if (len < 0) {
+		throwOutOfBounds(pos, 1);
+	}
+	return res;
+}
+
+}}//end namespace detail::__UByteArrayAdapter
+
+namespace detail {
+namespace __UByteArrayAdapter {
+
 #define UBA_SERIALIZATION_SUPPORT_SPECIALICATIONS(__TYPE) \
 template<> \
 struct SerializationSupport<__TYPE> { \
@@ -0,0 +1,44 @@
+#ifndef SSERIALIZE_VARINT_FUNCTIONS_H
+#define SSERIALIZE_VARINT_FUNCTIONS_H
+#include <cstdint>
+#include <cstddef>
+
+/**
+  * Bulk decoding of variable length packed integers as written by p_v/UByteArrayAdapter::putVlPacked*.
+  * A number is stored in little endian groups of 7 bits, the high bit of a byte signals that another byte follows.
+  * Numbers have at most 5 (uint32_t) or 10 (uint64_t) bytes.
+  *
+  * The uint32_t decoder uses a masked vbyte style simd kernel (if the cpu supports SSE4.1):
+  * The continuation bits of 8 bytes are gathered with a movemask. A table lookup on this mask yields
+  * a shuffle that moves all leading numbers with 1 or 2 bytes into 16 bit lanes.
+  * Runs of 16 single byte numbers are expanded directly.
+  * Longer numbers are decoded by the scalar code.
+  *
+  * These are the kernels used by UByteArrayAdapter::getVlPacked*Array.
+  */
+
+namespace sserialize {
+namespace varint {
+
+///Decode up to count numbers from [src, srcEnd).
+///Decoding stops early if the next number is not completely contained in [src, srcEnd).
+///@param bytes number of bytes consumed
+///@return number of decoded numbers
+std::size_t decode(const uint8_t * src, const uint8_t * srcEnd, uint32_t * dest, std::size_t count, std::size_t & bytes);
+std::size_t decode(const uint8_t * src, const uint8_t * srcEnd, uint64_t * dest, std::size_t count, std::size_t & bytes);
+
+///Convert decoded numbers to signed numbers in place (sign in the least significant bit as written by p_v<SignedType>)
+void toSigned(uint32_t * begin, uint32_t * end);
+void toSigned(uint64_t * begin, uint64_t * end);
+
+///In place inclusive prefix sum starting at prev, i.e. begin[i] = prev + begin[0] + ... + begin[i]
+///@return the last value or prev if the range is empty
+uint32_t prefixSum(uint32_t * begin, uint32_t * end, uint32_t prev);
+uint64_t prefixSum(uint64_t * begin, uint64_t * end, uint64_t prev);
+
+///@return true if the simd kernels are used on this cpu
+bool hasSimdSupport();
+
+}}//end namespace sserialize::varint
+
+#endif
@@ -25,6 +25,18 @@ inline uint32_t betoh(uint32_t v) { return be32toh(v); }
 inline uint16_t betoh(uint16_t v) { return be16toh(v); }
 inline uint8_t betoh(uint8_t v) { return v; }
 
+typedef enum {IL_SCALAR=0, IL_SSE42=1, IL_AVX2=2} InstructionLevel;
+
+///Unpacks count numbers with a fixed number of bits each from src to dest, count has to be a multiple of 8
+///@return pointer to the first byte after the unpacked data
+typedef const uint8_t * (*UnpackFunction)(const uint8_t * src, uint32_t * dest, uint32_t count);
+
+///@return the best instruction level supported by the cpu we are running on (determined once at runtime)
+InstructionLevel supportedInstructionLevel();
+
+///@return simd unpack function for numbers with bpn bits or nullptr if il does not provide one
+UnpackFunction simdUnpacker(uint32_t bpn, InstructionLevel il);
+
 template<uint32_t bpn>
 struct BitpackingBufferTypeSelector {
 	using type = uint64_t;
@@ -277,6 +289,8 @@ constexpr std::array<uint8_t, BitpackingImp<bpn>::BlockSize> BitpackingImp<bpn>:
 
 
 class BitpackingInterface {
+public:
+	using InstructionLevel = detail::bitpacking::InstructionLevel;
 public:
 	BitpackingInterface() {}
 	virtual ~BitpackingInterface() {}
@@ -287,7 +301,12 @@ public:
 	virtual void pack_blocks(const uint32_t* & src, uint8_t* & dest, uint32_t & count) const = 0;
 	virtual void pack_blocks(const uint64_t* & src, uint8_t* & dest, uint32_t & count) const = 0;
 public:
+	///Unpacking to uint32_t uses the best instruction level supported by the cpu
 	static std::unique_ptr<BitpackingInterface> instance(uint32_t bpn);
+	static std::unique_ptr<BitpackingInterface> instance(uint32_t bpn, InstructionLevel il);
+	///Process-wide instance for bpn using the best supported instruction level
+	///This does not allocate and is thread-safe
+	static const BitpackingInterface & shared(uint32_t bpn);
 };
 
 template<uint32_t bpn>
@@ -295,12 +314,18 @@ class Bitpacking: public BitpackingInterface {
 public:
 	using BitpackingImp = detail::bitpacking:: BitpackingImp<bpn>;
 public:
-	Bitpacking() {}
+	///@param simdUnpack optional accelerated unpacker for uint32_t destinations
+	Bitpacking(detail::bitpacking::UnpackFunction simdUnpack = nullptr) : m_simdUnpack(simdUnpack) {}
 	virtual ~Bitpacking() {}
 public:
 	virtual void unpack_blocks(const uint8_t* & src, uint32_t* & dest, uint32_t & count) const override {
 		uint32_t myCount = (count/BitpackingImp::BlockSize)*BitpackingImp::BlockSize;
-		src = m_p.unpack(src, dest, myCount);
+		if (m_simdUnpack) {
+			src = m_simdUnpack(src, dest, myCount);
+		}
+		else {
+			src = m_p.unpack(src, dest, myCount);
+		}
 		dest += myCount;
 		count -= myCount;
 	}
@@ -325,6 +350,7 @@ public:
 	}
 private:
 	BitpackingImp m_p;
+	detail::bitpacking::UnpackFunction m_simdUnpack;
 };
 
 }//end namespace sserialize
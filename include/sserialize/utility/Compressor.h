@@ -1,6 +1,9 @@
 #ifndef SSERIALIZE_COMPRESSOR_H
 #define SSERIALIZE_COMPRESSOR_H
 #include <sserialize/utility/refcounting.h>
+#include <string>
+#include <cstdint>
+#include <cstddef>
 
 namespace sserialize {
 class UByteArrayAdapter;
@@ -12,22 +15,46 @@ class Interface;
 
 }}//end namespace
 
+/** Block compressor with a selectable codec.
+  * The numeric value of a codec is stored in files (i.e. by CompressedMmappedFile), hence values must never change.
+  *
+  * CT_LZ4 uses the LZ4 block format with a greedy single-probe match finder, it is tuned for decompression speed.
+  * CT_LZ4HC produces the same format with a hash chain match finder and lazy matching.
+  * It compresses a lot slower but produces smaller output that decompresses as fast as CT_LZ4.
+  */
 class Compressor {
 public:
-	typedef enum {CT_NONE=0, CT_LZO=1} CompressionTypes;
+	typedef enum {CT_NONE=0, CT_LZO=1, CT_LZ4=2, CT_LZ4HC=3, CT__COUNT=4} CompressionTypes;
 private:
 	sserialize::RCPtrWrapper<detail::Compressor::Interface> m_priv;
+	CompressionTypes m_type;
 public:
 	Compressor(CompressionTypes ct = CT_NONE);
+	Compressor(const Compressor & other);
 	virtual ~Compressor();
+	Compressor & operator=(const Compressor & other);
+	CompressionTypes type() const { return m_type; }
 	///compress src to dest starting at dest[0]
 	///@return number of bytes written to dest
 	int64_t compress(const sserialize::UByteArrayAdapter & src, sserialize::UByteArrayAdapter & dest) const;
 	///decompress src to dest starting at dest[0]
 	///@return number of bytes written to dest
 	int64_t decompress(const sserialize::UByteArrayAdapter & src, sserialize::UByteArrayAdapter & dest) const;
+	///compress srcSize bytes of src to dest which has space for destCapacity bytes
+	///@return number of bytes written to dest or -1 if compression failed (i.e. dest is too small)
+	int64_t compress(const uint8_t * src, std::size_t srcSize, uint8_t * dest, std::size_t destCapacity) const;
+	///@return number of bytes written to dest or -1 if src is corrupt or dest is too small
+	int64_t decompress(const uint8_t * src, std::size_t srcSize, uint8_t * dest, std::size_t destCapacity) const;
+	///@return upper bound of the compressed size of srcSize bytes, dest buffers of this size never overflow
+	std::size_t maxCompressedSize(std::size_t srcSize) const;
+public:
+	///@return true if a codec is registered for ct
+	static bool supported(uint32_t ct);
+	static std::string name(CompressionTypes ct);
+	///@return codec with the given name, throws TypeMissMatchException if there is none
+	static CompressionTypes fromName(const std::string & name);
 };
 
 }//end namespace
 
-#endif
\ No newline at end of file
+#endif
@@ -25,13 +25,43 @@ void HuffmanDecoder::StaticNode::readInCache() const {
 	delete[] tmp;
 }
 
-HuffmanDecoder::HuffmanDecoder() {}
+HuffmanDecoder::HuffmanDecoder() :
+m_lookup(uint32_t(1) << LookupBits, LookupEntry{{}, {}, 0})
+{}
 
 HuffmanDecoder::HuffmanDecoder(const UByteArrayAdapter & data) :
 m_nodes(data),
 m_root(m_nodes.at(0))
 {
 	m_root.readInCache();
+	buildLookupTable();
+}
+
+void HuffmanDecoder::buildLookupTable() {
+	m_lookup.assign(uint32_t(1) << LookupBits, LookupEntry{{}, {}, 0});
+	for(uint32_t prefix(0), s(uint32_t(m_lookup.size())); prefix < s; ++prefix) {
+		LookupEntry & e = m_lookup[prefix];
+		uint32_t usedBits = 0;
+		while (e.count < MaxLookupSymbols && usedBits < LookupBits) {
+			//the remaining bits of prefix followed by zeros, codes that fit into the remaining bits are not affected by the zeros
+			uint32_t src = (prefix << (32-LookupBits)) << usedBits;
+			uint32_t value;
+			int len;
+			try {
+				len = decode(src, value);
+			}
+			catch (const sserialize::CorruptDataException &) {
+				len = -1;
+			}
+			if (len <= 0 || usedBits + len > LookupBits) {
+				break;
+			}
+			e.values[e.count] = value;
+			e.lengths[e.count] = uint8_t(len);
+			e.count += 1;
+			usedBits += len;
+		}
+	}
 }
 
 void HuffmanDecoder::readInCache() {
@@ -76,10 +76,13 @@ ItemIndexStore::ItemIndexStore(interfaces::ItemIndexStore * base) : m_priv(base)
 
 namespace detail {
 
-ItemIndexStore::LZODecompressor::LZODecompressor() {}
+ItemIndexStore::LZODecompressor::LZODecompressor() :
+m_pool(new BufferPool())
+{}
 
 ItemIndexStore::LZODecompressor::LZODecompressor(const sserialize::UByteArrayAdapter & data) :
-m_data(data)
+m_data(data),
+m_pool(new BufferPool())
 {}
 
 ItemIndexStore::LZODecompressor::~LZODecompressor() {}
@@ -93,17 +96,17 @@ UByteArrayAdapter ItemIndexStore::LZODecompressor::decompress(uint32_t id, const
 		uint32_t chunkLength = m_data.at(id);
 		//Get a memory view, but we don't write to it, so it's ok
 		const UByteArrayAdapter::MemoryView srcD = src.getMemView(0, src.size());
-		uint8_t * dest = new uint8_t[chunkLength];
+		std::vector<uint8_t> * dest = m_pool->acquire(chunkLength);
 
 		lzo_uint destLen = chunkLength;
-		int ok = ::lzo1x_decompress_safe(srcD.get(), src.size(), dest, &destLen, 0);
+		int ok = ::lzo1x_decompress_safe(srcD.get(), src.size(), dest->data(), &destLen, 0);
 		if (ok != LZO_E_OK) {
+			m_pool->release(dest);
 			return UByteArrayAdapter();
 		}
 		else {
-			UByteArrayAdapter ret(dest, 0, destLen);
-			ret.setDeleteOnClose(true);
-			return ret;
+			dest->resize(destLen);
+			return UByteArrayAdapter(dest, m_pool);
 		}
 	}
 	return UByteArrayAdapter();
@@ -111,11 +114,13 @@ UByteArrayAdapter ItemIndexStore::LZODecompressor::decompress(uint32_t id, const
 
 ItemIndexStore::ItemIndexStore() :
 m_type(ItemIndex::T_EMPTY),
-m_compression(sserialize::Static::ItemIndexStore::IC_NONE)
+m_compression(sserialize::Static::ItemIndexStore::IC_NONE),
+m_cacheMinIndexSize(0)
 {}
 
 ItemIndexStore::ItemIndexStore(UByteArrayAdapter data) :
-m_version(data.getUint8(0))
+m_version(data.getUint8(0)),
+m_cacheMinIndexSize(0)
 {
 	if (m_version == 5 || m_version == 6) {
 		m_type = data.getUint16(1);
@@ -246,7 +251,20 @@ ItemIndex ItemIndexStore::at(uint32_t pos) const {
 	if (pos >= size()) {
 		return ItemIndex();
 	}
-	
+	if (m_cache && idxSize(pos) >= m_cacheMinIndexSize) {
+		ItemIndex result;
+		if (m_cache->find(pos, result)) {
+			return result;
+		}
+		//Decoded indexes may lazily fill internal caches and are therefore not safe to share between threads
+		result = ItemIndex(decode(pos).toVector());
+		m_cache->insert(pos, result, result.size()*sizeof(uint32_t));
+		return result;
+	}
+	return decode(pos);
+}
+
+ItemIndex ItemIndexStore::decode(uint32_t pos) const {
 	ItemIndex::Types type = indexType(pos);
 	
 	UByteArrayAdapter idxData = rawDataAt(pos);
@@ -284,6 +302,26 @@ UByteArrayAdapter ItemIndexStore::getHuffmanTreeData() const {
 	return UByteArrayAdapter();
 }
 
+void ItemIndexStore::setCacheCapacity(uint32_t maxEntries, std::size_t maxBytes, uint32_t minIndexSize) {
+	m_cacheMinIndexSize = minIndexSize;
+	if (!maxEntries) {
+		m_cache.reset();
+	}
+	else if (m_cache) {
+		m_cache->setCapacity(maxEntries, maxBytes);
+	}
+	else {
+		m_cache.reset(new IndexCache(maxEntries, maxBytes));
+	}
+}
+
+ItemIndexStore::CacheStats ItemIndexStore::cacheStats() const {
+	if (m_cache) {
+		return m_cache->stats();
+	}
+	return CacheStats();
+}
+
 std::ostream& ItemIndexStore::printStats(std::ostream& out) const {
 	return printStats(out, [](uint32_t) { return true; });
 }
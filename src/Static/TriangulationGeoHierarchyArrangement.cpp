@@ -75,6 +75,17 @@ uint32_t TriangulationGeoHierarchyArrangement::cellId(double lat, double lon) co
 	return tmp;
 }
 
+std::vector<TriangulationGeoHierarchyArrangement::cellid_type>
+TriangulationGeoHierarchyArrangement::cellId(std::span<const Point> points, uint32_t threadCount) const {
+	std::vector<FaceId> faceIds = m_grid.faceIds(points, threadCount);
+	std::vector<cellid_type> result;
+	result.reserve(faceIds.size());
+	for(FaceId faceId : faceIds) {
+		result.push_back(cellIdFromFaceId(faceId));
+	}
+	return result;
+}
+
 
 std::set<TriangulationGeoHierarchyArrangement::cellid_type>
 TriangulationGeoHierarchyArrangement::cellIds(double lat, double lon) const {
@@ -1,11 +1,44 @@
 #include <sserialize/Static/TriangulationGridLocator.h>
 #include <sserialize/utility/exceptions.h>
+#include <sserialize/mt/ThreadPool.h>
+
+#include <algorithm>
+#include <atomic>
 
 #include <CGAL/Exact_predicates_inexact_constructions_kernel.h>
 
 namespace sserialize {
 namespace Static {
 namespace spatial {
+namespace {
+
+///position of (x, y) on a hilbert curve covering [0, 2^16)^2
+uint32_t hilbertIndex(uint32_t x, uint32_t y) {
+	uint32_t d = 0;
+	for(uint32_t s(uint32_t(1) << 15); s > 0; s >>= 1) {
+		uint32_t rx = (x & s) ? 1 : 0;
+		uint32_t ry = (y & s) ? 1 : 0;
+		d += s * s * ((3 * rx) ^ ry);
+		if (!ry) {
+			if (rx) {
+				x = 0xFFFF ^ x;
+				y = 0xFFFF ^ y;
+			}
+			std::swap(x, y);
+		}
+	}
+	return d;
+}
+
+uint32_t curveCoordinate(double v, double min, double max) {
+	if (max <= min) {
+		return 0;
+	}
+	double tmp = (v - min) / (max - min) * 0xFFFF;
+	return uint32_t( std::clamp<double>(tmp, 0, 0xFFFF) );
+}
+
+}//end anonymous namespace
 
 TriangulationGridLocator::TriangulationGridLocator() {}
 
@@ -79,4 +112,85 @@ TriangulationGridLocator::Face TriangulationGridLocator::face(double lat, double
 	return m_trs.face(fId);
 }
 
+std::vector<TriangulationGridLocator::FaceId>
+TriangulationGridLocator::faceIds(std::span<const Point> points, uint32_t threadCount) const {
+	if (points.size() > std::numeric_limits<uint32_t>::max()) {
+		throw sserialize::TypeOverflowException("TriangulationGridLocator::faceIds: too many points");
+	}
+	std::vector<FaceId> result(points.size(), NullFace);
+	
+	//sort the points along a hilbert curve, the lower 32 bits hold the position of the point in the input
+	//points outside of the grid are not located at all
+	std::vector<uint64_t> order;
+	order.reserve(points.size());
+	const sserialize::spatial::GeoRect & rect = m_grid.rect();
+	for(std::size_t i(0), s(points.size()); i < s; ++i) {
+		const Point & p = points[i];
+		if (!gridContains(p)) {
+			continue;
+		}
+		uint32_t x = curveCoordinate(p.lon(), rect.minLon(), rect.maxLon());
+		uint32_t y = curveCoordinate(p.lat(), rect.minLat(), rect.maxLat());
+		order.push_back( (uint64_t(hilbertIndex(x, y)) << 32) | i );
+	}
+	std::sort(order.begin(), order.end());
+	
+	if (threadCount == 0) {
+		threadCount = sserialize::ThreadPool::hardware_concurrency();
+	}
+	std::size_t chunkCount = (order.size() + BatchChunkSize - 1) / BatchChunkSize;
+	if (threadCount <= 1 || chunkCount <= 1) {
+		faceIds(points, order, 0, order.size(), result);
+		return result;
+	}
+	
+	struct State {
+		const TriangulationGridLocator * that;
+		std::span<const Point> points;
+		const std::vector<uint64_t> * order;
+		std::vector<FaceId> * result;
+		std::atomic<std::size_t> chunk{0};
+		std::size_t chunkCount;
+	};
+	struct Worker {
+		State * state;
+		Worker(State * state) : state(state) {}
+		Worker(const Worker & other) : state(other.state) {}
+		void operator()() {
+			while (true) {
+				std::size_t chunk = state->chunk.fetch_add(1, std::memory_order_relaxed);
+				if (chunk >= state->chunkCount) {
+					break;
+				}
+				std::size_t begin = chunk*BatchChunkSize;
+				std::size_t end = std::min(begin+BatchChunkSize, state->order->size());
+				state->that->faceIds(state->points, *(state->order), begin, end, *(state->result));
+			}
+		}
+	};
+	State state;
+	state.that = this;
+	state.points = points;
+	state.order = &order;
+	state.result = &result;
+	state.chunkCount = chunkCount;
+	sserialize::ThreadPool::execute(Worker(&state), (uint32_t) std::min<std::size_t>(threadCount, chunkCount), sserialize::ThreadPool::CopyTaskTag());
+	return result;
+}
+
+void TriangulationGridLocator::faceIds(std::span<const Point> points, const std::vector<uint64_t> & order, std::size_t begin, std::size_t end, std::vector<FaceId> & result) const {
+	//every thread writes to distinct entries of result
+	FaceId prevFace = NullFace;
+	uint32_t prevTile = std::numeric_limits<uint32_t>::max();
+	for(std::size_t i(begin); i < end; ++i) {
+		uint32_t pos = uint32_t(order[i]);
+		const Point & p = points[pos];
+		uint32_t tile = m_grid.select(p.lat(), p.lon()).tile;
+		FaceId hint = (tile == prevTile ? prevFace : m_grid.at(tile));
+		prevFace = m_trs.locate(p, hint, Triangulation::TT_STRAIGHT);
+		prevTile = (prevFace != NullFace ? tile : std::numeric_limits<uint32_t>::max());
+		result[pos] = prevFace;
+	}
+}
+
 }}}//end namespace
@@ -6,6 +6,7 @@ namespace Static {
 namespace UnicodeTrie {
 
 constexpr FlatTrieBase::SizeType FlatTrieBase::npos;
+constexpr FlatTrieBase::SizeType FlatTrieBase::DefaultSearchIndexStride;
 
 namespace detail {
 namespace FlatTrie {
@@ -98,21 +99,38 @@ Node::const_iterator Node::cend() const {
 
 }}//end namespace detail::FlatTrie
 
-FlatTrieBase::FlatTrieBase() {}
+FlatTrieBase::FlatTrieBase() :
+m_searchIndexStride(0)
+{}
 
 FlatTrieBase::FlatTrieBase(const sserialize::UByteArrayAdapter & src) :
 Version(src, Version::NoConsume()),
-m_strData(src, 1+UByteArrayAdapter::OffsetTypeSerializedLength(), src.getOffset(1)),
-m_trie(src+(1+UByteArrayAdapter::OffsetTypeSerializedLength()+m_strData.size()))
-{}
+m_strData(src, 2+UByteArrayAdapter::OffsetTypeSerializedLength(), src.getOffset(2)),
+m_trie(src+(2+UByteArrayAdapter::OffsetTypeSerializedLength()+m_strData.size())),
+m_searchIndexStride(0)
+{
+	if (src.getUint8(1) & F_SEARCH_INDEX) {
+		//only the header of the samples is parsed here, the samples themselves are read by find()
+		UByteArrayAdapter::OffsetType searchIndexBegin = 2+UByteArrayAdapter::OffsetTypeSerializedLength()+m_strData.size()+m_trie.getSizeInBytes();
+		m_searchIndexStride = src.getUint32(searchIndexBegin);
+		if (!m_searchIndexStride) {
+			throw sserialize::CorruptDataException("FlatTrieBase: search index stride is 0");
+		}
+		m_searchIndex = SearchIndexSamples(src+(searchIndexBegin+4));
+	}
+}
 
 UByteArrayAdapter::OffsetType FlatTrieBase::getSizeInBytes() const {
-	return 1+UByteArrayAdapter::OffsetTypeSerializedLength()+m_strData.size()+m_trie.getSizeInBytes();
+	UByteArrayAdapter::OffsetType result = 2+UByteArrayAdapter::OffsetTypeSerializedLength()+m_strData.size()+m_trie.getSizeInBytes();
+	if (hasSearchIndex()) {
+		result += 4+m_searchIndex.getSizeInBytes();
+	}
+	return result;
 }
 
 UByteArrayAdapter FlatTrieBase::data() const {
 	UByteArrayAdapter result(m_strData);
-	result -= 1+UByteArrayAdapter::OffsetTypeSerializedLength();
+	result -= 2+UByteArrayAdapter::OffsetTypeSerializedLength();
 	result.resetPtrs();
 	result.resize(getSizeInBytes());
 	return result;
@@ -123,14 +141,33 @@ FlatTrieBase::SizeType FlatTrieBase::find(const std::string & str, bool prefixMa
 	if (size() == SizeType(0)) {
 		return npos;
 	}
+	if (!hasSearchIndex()) {
+		return find(str, prefixMatch, 0, size()-1);
+	}
+	//find the first sample that is larger than str, str is then between this and the previous sample
+	SizeType sl = 0;
+	SizeType sr = m_searchIndex.size();
+	while (sl < sr) {
+		SizeType sm = sl + (sr-sl)/2;
+		std::string::size_type lcp = 0;
+		if (compare(m_searchIndex.at(sm), str, lcp) <= 0) {
+			sl = sm+1;
+		}
+		else {
+			sr = sm;
+		}
+	}
+	SizeType left = (sl ? (sl-1)*m_searchIndexStride : SizeType(0));
+	SizeType right = (sl < m_searchIndex.size() ? sl*m_searchIndexStride : size()-1);
+	return find(str, prefixMatch, left, right);
+}
 
-	SizeType left = 0;
-	SizeType right = size()-1;
+FlatTrieBase::SizeType FlatTrieBase::find(const std::string & str, bool prefixMatch, SizeType left, SizeType right) const {
 	SizeType mid  = (right-left)/2 + left;
 
 	std::string::size_type lLcp = calcLcp(strData(left), str);
 	if (lLcp == str.size()) {//first is match
-		return 0;
+		return left;
 	}
 	std::string::size_type rLcp = calcLcp(strData(right), str);
 	std::string::size_type mLcp = 0;
@@ -216,6 +253,10 @@ std::ostream& FlatTrieBase::printStats(std::ostream& out) const {
 	out << "sserialize::Static::UnicodeTrie::FlatTrieBase::stats--BEGIN" << std::endl;
 	out << "total data size=" << m_strData.size() + m_trie.getSizeInBytes() << std::endl;
 	out << "string data size=" << m_strData.size() << std::endl;
+	if (hasSearchIndex()) {
+		out << "search index stride=" << m_searchIndexStride << std::endl;
+		out << "search index size=" << 4+m_searchIndex.getSizeInBytes() << std::endl;
+	}
 	m_trie.printStats(out);
 	out << "sserialize::Static::UnicodeTrie::FlatTrieBase::stats--END" << std::endl;
 	return out;
@@ -0,0 +1,287 @@
+#include <sserialize/algorithm/sorted_set_functions.h>
+
+#include <algorithm>
+#include <array>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+	#define SSERIALIZE_SORTED_SET_HAS_X86_SIMD
+#endif
+
+namespace sserialize {
+namespace sortedset {
+namespace {
+
+inline bool isSkewed(std::size_t small, std::size_t large) {
+	return small*SkewThreshold < large;
+}
+
+inline uint32_t * copy(const uint32_t * begin, const uint32_t * end, uint32_t * dest) {
+	std::size_t count = end-begin;
+	::memmove(dest, begin, count*sizeof(uint32_t));
+	return dest+count;
+}
+
+//BEGIN scalar merge kernels
+
+template<bool T_PUSH_FIRST_SMALLER, bool T_PUSH_EQUAL, bool T_PUSH_SECOND_SMALLER, bool T_PUSH_FIRST_REMAINDER, bool T_PUSH_SECOND_REMAINDER>
+std::size_t merge(const uint32_t * a, const uint32_t * aEnd, const uint32_t * b, const uint32_t * bEnd, uint32_t * dest) {
+	uint32_t * destBegin = dest;
+	while (a != aEnd && b != bEnd) {
+		uint32_t av = *a;
+		uint32_t bv = *b;
+		if (av < bv) {
+			if (T_PUSH_FIRST_SMALLER) {
+				*dest = av;
+				++dest;
+			}
+			++a;
+		}
+		else if (bv < av) {
+			if (T_PUSH_SECOND_SMALLER) {
+				*dest = bv;
+				++dest;
+			}
+			++b;
+		}
+		else {
+			if (T_PUSH_EQUAL) {
+				*dest = av;
+				++dest;
+			}
+			++a;
+			++b;
+		}
+	}
+	if (T_PUSH_FIRST_REMAINDER) {
+		dest = copy(a, aEnd, dest);
+	}
+	if (T_PUSH_SECOND_REMAINDER) {
+		dest = copy(b, bEnd, dest);
+	}
+	return dest - destBegin;
+}
+
+//END scalar merge kernels
+//BEGIN galloping kernels
+
+///Elements of small that are (T_PUSH_FOUND=true) or are not (T_PUSH_FOUND=false) in large
+template<bool T_PUSH_FOUND>
+std::size_t gallopFilter(const uint32_t * small, const uint32_t * smallEnd, const uint32_t * large, const uint32_t * largeEnd, uint32_t * dest) {
+	uint32_t * destBegin = dest;
+	for(; small != smallEnd; ++small) {
+		large = gallop(large, largeEnd, *small);
+		bool found = large != largeEnd && *large == *small;
+		if (found == T_PUSH_FOUND) {
+			*dest = *small;
+			++dest;
+		}
+		if (large == largeEnd && T_PUSH_FOUND) {
+			break;
+		}
+	}
+	return dest - destBegin;
+}
+
+///Copies runs of large between consecutive elements of small
+///Elements of small are pushed if T_PUSH_SMALL, elements in both are pushed if T_PUSH_EQUAL
+template<bool T_PUSH_SMALL, bool T_PUSH_EQUAL>
+std::size_t gallopMerge(const uint32_t * small, const uint32_t * smallEnd, const uint32_t * large, const uint32_t * largeEnd, uint32_t * dest) {
+	uint32_t * destBegin = dest;
+	for(; small != smallEnd; ++small) {
+		const uint32_t * runEnd = gallop(large, largeEnd, *small);
+		dest = copy(large, runEnd, dest);
+		large = runEnd;
+		if (large != largeEnd && *large == *small) {
+			++large;
+			if (T_PUSH_EQUAL) {
+				*dest = *small;
+				++dest;
+			}
+		}
+		else if (T_PUSH_SMALL) {
+			*dest = *small;
+			++dest;
+		}
+	}
+	dest = copy(large, largeEnd, dest);
+	return dest - destBegin;
+}
+
+//END galloping kernels
+//BEGIN simd kernels
+
+#ifdef SSERIALIZE_SORTED_SET_HAS_X86_SIMD
+
+struct CompactionTable {
+	///shuffle masks moving the lanes selected by the index to the front
+	alignas(16) std::array<std::array<uint8_t, 16>, 16> masks;
+	constexpr CompactionTable() : masks{} {
+		for(uint32_t m(0); m < 16; ++m) {
+			uint32_t pos = 0;
+			for(uint32_t lane(0); lane < 4; ++lane) {
+				if (m & (uint32_t(1) << lane)) {
+					for(uint32_t b(0); b < 4; ++b) {
+						masks[m][4*pos+b] = uint8_t(4*lane+b);
+					}
+					++pos;
+				}
+			}
+			for(; pos < 4; ++pos) {
+				for(uint32_t b(0); b < 4; ++b) {
+					masks[m][4*pos+b] = 0x80;
+				}
+			}
+		}
+	}
+};
+
+constexpr CompactionTable compactionTable;
+
+///Block-wise all-pairs comparison of 4 elements of a with 4 elements of b.
+///The match mask of the current a block is accumulated over all b blocks it overlaps.
+///Once the a block is done, its matching (T_INTERSECT=true) or non-matching (T_INTERSECT=false) elements are stored to dest.
+///Since we may store up to 3 elements more than needed, dest has to hold at least aSize elements.
+template<bool T_INTERSECT>
+__attribute__((target("sse4.2")))
+std::size_t blockFilterSse42(const uint32_t * a, const uint32_t * aEnd, const uint32_t * b, const uint32_t * bEnd, uint32_t * dest) {
+	uint32_t * destBegin = dest;
+	const uint32_t * aEnd4 = a + ((aEnd-a) & ~std::ptrdiff_t(3));
+	const uint32_t * bEnd4 = b + ((bEnd-b) & ~std::ptrdiff_t(3));
+	int acc = 0;
+	while (a < aEnd4 && b < bEnd4) {
+		__m128i va = _mm_loadu_si128(reinterpret_cast<const __m128i*>(a));
+		__m128i vb = _mm_loadu_si128(reinterpret_cast<const __m128i*>(b));
+		__m128i cmp = _mm_or_si128(
+			_mm_or_si128(
+				_mm_cmpeq_epi32(va, vb),
+				_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(0,3,2,1)))
+			),
+			_mm_or_si128(
+				_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(1,0,3,2))),
+				_mm_cmpeq_epi32(va, _mm_shuffle_epi32(vb, _MM_SHUFFLE(2,1,0,3)))
+			)
+		);
+		acc |= _mm_movemask_ps(_mm_castsi128_ps(cmp));
+		uint32_t aMax = a[3];
+		uint32_t bMax = b[3];
+		if (aMax <= bMax) {
+			int m = T_INTERSECT ? acc : (~acc & 0xF);
+			__m128i shuffle = _mm_load_si128(reinterpret_cast<const __m128i*>(compactionTable.masks[m].data()));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_shuffle_epi8(va, shuffle));
+			dest += __builtin_popcount(m);
+			a += 4;
+			acc = 0;
+		}
+		if (bMax <= aMax) {
+			b += 4;
+		}
+	}
+	//the remainder, acc holds the matches of the first 4 elements of a with elements before b
+	for(uint32_t i(0); a != aEnd; ++a, ++i) {
+		bool found = i < 4 && (acc & (1 << i));
+		if (!found) {
+			for(; b != bEnd && *b < *a; ++b) {}
+			found = b != bEnd && *b == *a;
+		}
+		if (found == T_INTERSECT) {
+			*dest = *a;
+			++dest;
+		}
+	}
+	return dest - destBegin;
+}
+
+bool detectSimdSupport() {
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse4.2");
+}
+
+#else
+
+bool detectSimdSupport() {
+	return false;
+}
+
+#endif
+
+//END simd kernels
+
+}//end anonymous namespace
+
+bool hasSimdSupport() {
+	static const bool supported = detectSimdSupport();
+	return supported;
+}
+
+const uint32_t * gallop(const uint32_t * begin, const uint32_t * end, uint32_t v) {
+	if (begin == end || *begin >= v) {
+		return begin;
+	}
+	//*lo < v holds
+	const uint32_t * lo = begin;
+	std::size_t step = 1;
+	while (std::size_t(end-lo) > step && lo[step] < v) {
+		lo += step;
+		step *= 2;
+	}
+	const uint32_t * hi = std::size_t(end-lo) > step ? lo+step+1 : end;
+	return std::lower_bound(lo+1, hi, v);
+}
+
+std::size_t intersect(const uint32_t * a, std::size_t aSize, const uint32_t * b, std::size_t bSize, uint32_t * dest) {
+	if (aSize > bSize) {
+		std::swap(a, b);
+		std::swap(aSize, bSize);
+	}
+	if (!aSize) {
+		return 0;
+	}
+	if (isSkewed(aSize, bSize)) {
+		return gallopFilter<true>(a, a+aSize, b, b+bSize, dest);
+	}
+#ifdef SSERIALIZE_SORTED_SET_HAS_X86_SIMD
+	if (hasSimdSupport()) {
+		return blockFilterSse42<true>(a, a+aSize, b, b+bSize, dest);
+	}
+#endif
+	return merge<false, true, false, false, false>(a, a+aSize, b, b+bSize, dest);
+}
+
+std::size_t unite(const uint32_t * a, std::size_t aSize, const uint32_t * b, std::size_t bSize, uint32_t * dest) {
+	if (isSkewed(aSize, bSize)) {
+		return gallopMerge<true, true>(a, a+aSize, b, b+bSize, dest);
+	}
+	else if (isSkewed(bSize, aSize)) {
+		return gallopMerge<true, true>(b, b+bSize, a, a+aSize, dest);
+	}
+	return merge<true, true, true, true, true>(a, a+aSize, b, b+bSize, dest);
+}
+
+std::size_t difference(const uint32_t * a, std::size_t aSize, const uint32_t * b, std::size_t bSize, uint32_t * dest) {
+	if (isSkewed(aSize, bSize)) {
+		return gallopFilter<false>(a, a+aSize, b, b+bSize, dest);
+	}
+	else if (isSkewed(bSize, aSize)) {
+		return gallopMerge<false, false>(b, b+bSize, a, a+aSize, dest);
+	}
+#ifdef SSERIALIZE_SORTED_SET_HAS_X86_SIMD
+	if (hasSimdSupport()) {
+		return blockFilterSse42<false>(a, a+aSize, b, b+bSize, dest);
+	}
+#endif
+	return merge<true, false, false, true, false>(a, a+aSize, b, b+bSize, dest);
+}
+
+std::size_t symmetricDifference(const uint32_t * a, std::size_t aSize, const uint32_t * b, std::size_t bSize, uint32_t * dest) {
+	if (isSkewed(aSize, bSize)) {
+		return gallopMerge<true, false>(a, a+aSize, b, b+bSize, dest);
+	}
+	else if (isSkewed(bSize, aSize)) {
+		return gallopMerge<true, false>(b, b+bSize, a, a+aSize, dest);
+	}
+	return merge<true, false, true, true, true>(a, a+aSize, b, b+bSize, dest);
+}
+
+}}//end namespace sserialize::sortedset
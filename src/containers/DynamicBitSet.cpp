@@ -1,82 +1,279 @@
 #include <sserialize/containers/DynamicBitSet.h>
 #include <sserialize/containers/ItemIndexPrivates/ItemIndexPrivateDE.h>
 
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+	#define SSERIALIZE_DYNAMIC_BIT_SET_HAS_X86_SIMD
+#endif
 
 namespace sserialize {
 namespace detail {
 namespace DynamicBitSet {
+namespace {
+
+//BEGIN word kernels
+
+enum BinaryOp { BO_AND, BO_OR, BO_AND_NOT, BO_XOR };
+
+template<BinaryOp T_OP, typename T>
+inline T apply(T a, T b) {
+	switch (T_OP) {
+	case BO_AND:
+		return a & b;
+	case BO_OR:
+		return a | b;
+	case BO_AND_NOT:
+		return a & ~b;
+	case BO_XOR:
+	default:
+		return a ^ b;
+	}
+}
+
+///dest may alias a or b, the byte order is irrelevant for boolean operations
+template<BinaryOp T_OP>
+void combineScalar(const uint8_t * a, const uint8_t * b, uint8_t * dest, std::size_t bytes) {
+	std::size_t i = 0;
+	for(; i+8 <= bytes; i += 8) {
+		uint64_t av, bv;
+		::memcpy(&av, a+i, 8);
+		::memcpy(&bv, b+i, 8);
+		av = apply<T_OP>(av, bv);
+		::memcpy(dest+i, &av, 8);
+	}
+	for(; i < bytes; ++i) {
+		dest[i] = apply<T_OP>(a[i], b[i]);
+	}
+}
+
+SizeType countScalar(const uint8_t * d, std::size_t bytes) {
+	SizeType result = 0;
+	for(std::size_t i(0); i < bytes; i += 8) {
+		result += popCount<uint64_t>(loadWord(d+i, bytes-i));
+	}
+	return result;
+}
+
+#ifdef SSERIALIZE_DYNAMIC_BIT_SET_HAS_X86_SIMD
+
+template<BinaryOp T_OP>
+__attribute__((target("avx2")))
+void combineAvx2(const uint8_t * a, const uint8_t * b, uint8_t * dest, std::size_t bytes) {
+	std::size_t i = 0;
+	for(; i+32 <= bytes; i += 32) {
+		__m256i av = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(a+i));
+		__m256i bv = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(b+i));
+		__m256i rv;
+		switch (T_OP) {
+		case BO_AND:
+			rv = _mm256_and_si256(av, bv);
+			break;
+		case BO_OR:
+			rv = _mm256_or_si256(av, bv);
+			break;
+		case BO_AND_NOT:
+			rv = _mm256_andnot_si256(bv, av);
+			break;
+		case BO_XOR:
+		default:
+			rv = _mm256_xor_si256(av, bv);
+			break;
+		}
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest+i), rv);
+	}
+	combineScalar<T_OP>(a+i, b+i, dest+i, bytes-i);
+}
+
+__attribute__((target("popcnt")))
+SizeType countPopcnt(const uint8_t * d, std::size_t bytes) {
+	//4 independent accumulators to hide the latency of popcnt
+	SizeType r0 = 0, r1 = 0, r2 = 0, r3 = 0;
+	std::size_t i = 0;
+	for(; i+32 <= bytes; i += 32) {
+		r0 += __builtin_popcountll(loadWord(d+i));
+		r1 += __builtin_popcountll(loadWord(d+i+8));
+		r2 += __builtin_popcountll(loadWord(d+i+16));
+		r3 += __builtin_popcountll(loadWord(d+i+24));
+	}
+	for(; i < bytes; i += 8) {
+		r0 += __builtin_popcountll(loadWord(d+i, bytes-i));
+	}
+	return r0+r1+r2+r3;
+}
+
+bool hasAvx2() {
+	static const bool supported = []() {
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("avx2");
+	}();
+	return supported;
+}
+
+bool hasPopcnt() {
+	static const bool supported = []() {
+		__builtin_cpu_init();
+		return __builtin_cpu_supports("popcnt");
+	}();
+	return supported;
+}
+
+#endif
+
+template<BinaryOp T_OP>
+void combine(const uint8_t * a, const uint8_t * b, uint8_t * dest, std::size_t bytes) {
+#ifdef SSERIALIZE_DYNAMIC_BIT_SET_HAS_X86_SIMD
+	if (hasAvx2()) {
+		combineAvx2<T_OP>(a, b, dest, bytes);
+		return;
+	}
+#endif
+	combineScalar<T_OP>(a, b, dest, bytes);
+}
+
+SizeType count(const uint8_t * d, std::size_t bytes) {
+#ifdef SSERIALIZE_DYNAMIC_BIT_SET_HAS_X86_SIMD
+	if (hasPopcnt()) {
+		return countPopcnt(d, bytes);
+	}
+#endif
+	return countScalar(d, bytes);
+}
+
+bool isZero(const uint8_t * d, std::size_t bytes) {
+	for(std::size_t i(0); i < bytes; i += 8) {
+		if (loadWord(d+i, bytes-i)) {
+			return false;
+		}
+	}
+	return true;
+}
+
+//END word kernels
+
+///@return position of the largest set bit or DynamicBitSet::npos
+SizeType largestSetBit(const UByteArrayAdapter & data) {
+	UByteArrayAdapter::OffsetType s = data.size();
+	if (!s) {
+		return sserialize::DynamicBitSet::npos;
+	}
+	const UByteArrayAdapter::MemoryView mv(data.asMemView());
+	for(UByteArrayAdapter::OffsetType i(((s-1)/8)*8);; i -= 8) {
+		uint64_t w = loadWord(mv.data()+i, s-i);
+		if (w) {
+			return SizeType(i*8 + 63 - __builtin_clzll(w));
+		}
+		if (!i) {
+			break;
+		}
+	}
+	return sserialize::DynamicBitSet::npos;
+}
+
+///Creates a new in-memory bit set with T_OP applied to the first min(a.size(), b.size()) bytes
+///The remaining bytes of a and b are copied if copyRemainderA resp. copyRemainderB is true
+template<BinaryOp T_OP>
+UByteArrayAdapter combine(const UByteArrayAdapter & a, const UByteArrayAdapter & b, bool copyRemainderA, bool copyRemainderB) {
+	UByteArrayAdapter::OffsetType common = std::min(a.size(), b.size());
+	UByteArrayAdapter::OffsetType s = common;
+	if (copyRemainderA) {
+		s = std::max(s, a.size());
+	}
+	if (copyRemainderB) {
+		s = std::max(s, b.size());
+	}
+	UByteArrayAdapter d(UByteArrayAdapter::createCache(s, sserialize::MM_PROGRAM_MEMORY));
+	if (!s) {
+		return d;
+	}
+	const UByteArrayAdapter::MemoryView amv(a.asMemView());
+	const UByteArrayAdapter::MemoryView bmv(b.asMemView());
+	UByteArrayAdapter::MemoryView dmv(d.asMemView());
+	if (common) {
+		combine<T_OP>(amv.data(), bmv.data(), dmv.data(), common);
+	}
+	if (a.size() > common && copyRemainderA) {
+		::memcpy(dmv.data()+common, amv.data()+common, a.size()-common);
+	}
+	if (b.size() > common && copyRemainderB) {
+		::memcpy(dmv.data()+common, bmv.data()+common, b.size()-common);
+	}
+	if (dmv.isCopy()) {
+		dmv.flush(s);
+	}
+	return d;
+}
+
+///Applies T_OP to the first min(a.size(), b.size()) bytes of a, the remaining bytes of b are copied to a if copyRemainder is true
+template<BinaryOp T_OP>
+void combineInPlace(UByteArrayAdapter & a, const UByteArrayAdapter & b, bool copyRemainder) {
+	UByteArrayAdapter::OffsetType common = std::min(a.size(), b.size());
+	if (copyRemainder && a.size() < b.size()) {
+		a.resize(b.size());
+	}
+	if (!a.size()) {
+		return;
+	}
+	UByteArrayAdapter::MemoryView amv(a.asMemView());
+	const UByteArrayAdapter::MemoryView bmv(b.asMemView());
+	if (common) {
+		combine<T_OP>(amv.data(), bmv.data(), amv.data(), common);
+	}
+	if (copyRemainder && b.size() > common) {
+		::memcpy(amv.data()+common, bmv.data()+common, b.size()-common);
+	}
+	if (amv.isCopy()) {
+		amv.flush(a.size());
+	}
+}
+
+}//end anonymous namespace
 
 DynamicBitSetIdIterator::DynamicBitSetIdIterator() :
 m_p(0),
+m_size(0),
 m_off(0),
 m_curId(0),
-m_d(0),
-m_remainingBits(0)
+m_wordId(0),
+m_w(0)
 {}
 
 DynamicBitSetIdIterator::DynamicBitSetIdIterator(const sserialize::DynamicBitSet * p, SizeType offset) :
 m_p(p),
+m_size(p->data().size()),
 m_off(offset),
 m_curId(m_off*8),
-m_d(0),
-m_remainingBits(0)
+m_wordId(m_off*8),
+m_w(0)
 {
-	if (m_off < m_p->data().size()) {
-		m_d = m_p->data().at(m_off);
-		m_remainingBits = 8;
-		moveToNextSetBit();
+	if (m_off < m_size && m_p->data().isContiguous()) {
+		m_mem = m_p->data().asMemView();
 	}
+	moveToNextSetBit();
 }
 
 DynamicBitSetIdIterator::~DynamicBitSetIdIterator() {}
 
 void DynamicBitSetIdIterator::moveToNextSetBit() {
-	
-	for(; m_remainingBits && m_d;) {
-		if (m_d & 0x1) {
+	while (!m_w) {
+		if (m_off >= m_size) {
+			m_curId = m_size*8;
 			return;
 		}
-		
-		m_d >>= 1;
-		m_remainingBits -= 1;
-		m_curId += 1;
-	}
-	
-	m_curId += m_remainingBits;
-	m_off += 1;
-	SSERIALIZE_CHEAP_ASSERT_EQUAL(m_curId, m_off*8);
-	
-	m_remainingBits = 8;
-	for(; m_off < m_p->data().size();) {
-		m_d = m_p->data().at(m_off);
-		if (m_d) {
-			break;
+		std::size_t avail = std::min<UByteArrayAdapter::OffsetType>(8, m_size-m_off);
+		if (m_mem.size()) {
+			m_w = loadWord(m_mem.data()+m_off, avail);
 		}
 		else {
-			++m_off;
-			m_curId += 8;
+			uint8_t tmp[8];
+			for(std::size_t i(0); i < avail; ++i) {
+				tmp[i] = m_p->data().getUint8(m_off+i);
+			}
+			m_w = loadWord(tmp, avail);
 		}
+		m_wordId = m_off*8;
+		m_off += avail;
 	}
-	
-	if (m_off >= m_p->data().size()) {
-		m_remainingBits = 0;
-		SSERIALIZE_CHEAP_ASSERT_EQUAL(m_curId, m_off*8);
-		return;
-	}
-	
-	SSERIALIZE_CHEAP_ASSERT(m_d);
-	
-	for(; m_remainingBits && m_d;) {
-		if (m_d & 0x1) {
-			return;
-		}
-		
-		m_d >>= 1;
-		m_remainingBits -= 1;
-		m_curId += 1;
-	}
-	//we should never get to here
-	SSERIALIZE_CHEAP_ASSERT(false);
+	m_curId = m_wordId + SizeType(__builtin_ctzll(m_w));
 }
 
 SizeType DynamicBitSetIdIterator::get() const {
@@ -84,26 +281,21 @@ SizeType DynamicBitSetIdIterator::get() const {
 }
 
 void DynamicBitSetIdIterator::next() {
-	if (m_off >= m_p->data().size()) {
+	if (!m_w) {
 		return;
 	}
-	//m_remainingBits points to the currently set bit or beyond the data
-	SSERIALIZE_CHEAP_ASSERT(m_off >= m_p->data().size() || m_d & 0x1);
-	m_remainingBits -= 1; //remove currently pointed to bit
-	m_d >>= 1;
-	m_curId += 1;
-	SSERIALIZE_CHEAP_ASSERT(m_remainingBits < 8);
+	//remove currently pointed to bit
+	m_w &= m_w-1;
 	moveToNextSetBit();
 }
 
 bool DynamicBitSetIdIterator::notEq(const AbstractArrayIterator<SizeType> * other) const {
-	const DynamicBitSetIdIterator * o = static_cast<const DynamicBitSetIdIterator*>(other);
-	return o->m_off != m_off || o->m_remainingBits != m_remainingBits || o->m_curId != m_curId || o->m_d != m_d;
+	return !eq(other);
 }
 
 bool DynamicBitSetIdIterator::eq(const AbstractArrayIterator<SizeType> * other) const {
 	const DynamicBitSetIdIterator * o = static_cast<const DynamicBitSetIdIterator*>(other);
-	return o->m_off == m_off && o->m_remainingBits == m_remainingBits && o->m_curId == m_curId && o->m_d == m_d;
+	return o->m_p == m_p && o->m_curId == m_curId;
 }
 
 AbstractArrayIterator<SizeType> * DynamicBitSetIdIterator::copy() const {
@@ -131,39 +323,34 @@ bool DynamicBitSet::align(uint8_t shift) {
 
 
 IdType DynamicBitSet::smallestEntry() const {
-	IdType id = 0;
-	for(UByteArrayAdapter::OffsetType i = 0, s = m_data.size(); i < s; ++i) {
-		uint8_t d = m_data.getUint8(i);
-		if (d) {
-			return id + msb(d);
-		}
-		else {
-			id += 8;
+	UByteArrayAdapter::OffsetType s = m_data.size();
+	if (!s) {
+		return 0;
+	}
+	const UByteArrayAdapter::MemoryView mv(m_data.asMemView());
+	for(UByteArrayAdapter::OffsetType i(0); i < s; i += 8) {
+		uint64_t w = detail::DynamicBitSet::loadWord(mv.data()+i, s-i);
+		if (w) {
+			return IdType(i*8 + __builtin_ctzll(w));
 		}
 	}
-	return id;
+	return IdType(s*8);
 }
 
 
 bool DynamicBitSet::operator==(const DynamicBitSet & other) const {
-	UByteArrayAdapter::SizeType i = 0;
-	UByteArrayAdapter::SizeType s = std::min(m_data.size(), other.m_data.size());
-	for(; i < s; ++i) {
-		if (m_data[i] != other.m_data[i]) {
-			return false;
-		}
+	UByteArrayAdapter::OffsetType common = std::min(m_data.size(), other.m_data.size());
+	if (!m_data.size() || !other.m_data.size()) {
+		const UByteArrayAdapter & d = m_data.size() ? m_data : other.m_data;
+		return !d.size() || detail::DynamicBitSet::isZero(d.asMemView().data(), d.size());
 	}
-	for(s = m_data.size(); i < s; ++i) {
-		if (m_data[i]) {
-			return false;
-		}
+	const UByteArrayAdapter::MemoryView mv(m_data.asMemView());
+	const UByteArrayAdapter::MemoryView omv(other.m_data.asMemView());
+	if (::memcmp(mv.data(), omv.data(), common) != 0) {
+		return false;
 	}
-	for(s = other.m_data.size(); i < s; ++i) {
-		if (other.m_data[i]) {
-			return false;
-		}
-	}
-	return true;
+	return detail::DynamicBitSet::isZero(mv.data()+common, m_data.size()-common) &&
+		detail::DynamicBitSet::isZero(omv.data()+common, other.m_data.size()-common);
 }
 
 bool DynamicBitSet::operator!=(const DynamicBitSet & other) const {
@@ -171,30 +358,13 @@ bool DynamicBitSet::operator!=(const DynamicBitSet & other) const {
 }
 
 IdType DynamicBitSet::largestEntry() const {
-	if (m_data.size() == 0)
-		return 0;
-	IdType id = m_data.size()*8-1;
-	for(UByteArrayAdapter::OffsetType i = m_data.size(); i > 0; --i) { //this i substracted by 1 before geting the byte
-		uint8_t d = m_data.getUint8(i-1);
-		if (d) {
-			return id - (8-msb(d));
-		}
-		else {
-			id -= 8;
-		}
-	}
-	return id;
+	SizeType pos = detail::DynamicBitSet::largestSetBit(m_data);
+	return pos == npos ? 0 : IdType(pos);
 }
 
 IdType DynamicBitSet::upperBound() const {
-	if (m_data.size() == 0)
-		return 0;
-	for(UByteArrayAdapter::OffsetType i(m_data.size()); i > 0; --i) { //this i substracted by 1 before geting the byte
-		if (m_data.getUint8(i-1)) {
-			return 8*i;
-		}
-	}
-	return 0;
+	SizeType pos = detail::DynamicBitSet::largestSetBit(m_data);
+	return pos == npos ? 0 : IdType((pos/8+1)*8);
 }
 
 bool DynamicBitSet::isSet(sserialize::SizeType pos) const {
@@ -222,76 +392,79 @@ ItemIndex DynamicBitSet::toIndex(int type, ItemIndex::CompressionLevel cl) const
 }
 
 SizeType DynamicBitSet::size() const {
-	uint32_t resSize = 0;
+	return count();
+}
+
+SizeType DynamicBitSet::count() const {
+	if (!m_data.size()) {
+		return 0;
+	}
+	const UByteArrayAdapter::MemoryView mv(m_data.asMemView());
+	return detail::DynamicBitSet::count(mv.data(), m_data.size());
+}
+
+SizeType DynamicBitSet::rank(SizeType pos) const {
+	UByteArrayAdapter::OffsetType s = std::min<UByteArrayAdapter::OffsetType>(m_data.size(), pos/8);
+	if (!m_data.size()) {
+		return 0;
+	}
+	const UByteArrayAdapter::MemoryView mv(m_data.asMemView());
+	SizeType result = detail::DynamicBitSet::count(mv.data(), s);
+	if (s < m_data.size() && pos % 8) {
+		result += popCount<uint8_t>(mv.data()[s] & uint8_t(createMask(pos % 8)));
+	}
+	return result;
+}
+
+SizeType DynamicBitSet::select(SizeType n) const {
 	UByteArrayAdapter::OffsetType s = m_data.size();
-	UByteArrayAdapter::OffsetType i;
-	for(i = 0; i+4 <= s; i += 4) {//we can use this here as the order of the bits is not relevant
-		resSize += popCount<uint32_t>( m_data.getUint32(i) );
+	if (!s) {
+		return npos;
 	}
-	for(; i < s; ++i) {
-		resSize += popCount<uint8_t>( m_data.at(i));
+	const UByteArrayAdapter::MemoryView mv(m_data.asMemView());
+	for(UByteArrayAdapter::OffsetType i(0); i < s; i += 8) {
+		uint64_t w = detail::DynamicBitSet::loadWord(mv.data()+i, s-i);
+		SizeType c = popCount<uint64_t>(w);
+		if (n < c) {
+			//remove the n lowest set bits
+			for(; n; --n) {
+				w &= w-1;
+			}
+			return SizeType(i*8 + __builtin_ctzll(w));
+		}
+		n -= c;
 	}
-	return resSize;
+	return npos;
 }
 
 DynamicBitSet DynamicBitSet::operator&(const DynamicBitSet & other) const {
-	UByteArrayAdapter::OffsetType s = std::min<UByteArrayAdapter::SizeType>( m_data.size(), other.m_data.size());
-	UByteArrayAdapter d(UByteArrayAdapter::createCache(s, sserialize::MM_PROGRAM_MEMORY) );
-	for(UByteArrayAdapter::OffsetType i = 0; i < s; ++i) {
-		d[i] = m_data[i] & other.m_data[i];
-	}
-	return DynamicBitSet(d);
+	return DynamicBitSet(detail::DynamicBitSet::combine<detail::DynamicBitSet::BO_AND>(m_data, other.m_data, false, false));
 }
 
 DynamicBitSet DynamicBitSet::operator|(const DynamicBitSet & other) const {
-	UByteArrayAdapter::OffsetType smax = std::max<UByteArrayAdapter::SizeType>( m_data.size(), other.m_data.size());
-	UByteArrayAdapter d(UByteArrayAdapter::createCache(smax, sserialize::MM_PROGRAM_MEMORY) );
-	
-	UByteArrayAdapter::OffsetType i = 0;
-	UByteArrayAdapter::OffsetType s;
-	for(s = std::min<UByteArrayAdapter::OffsetType>( m_data.size(), other.m_data.size()); i < s; ++i) {
-		d[i] = m_data[i] | other.m_data[i];
-	}
-	for(s = m_data.size(); i < s; ++i) {
-		d[i] = m_data[i];
-	}
-	for(s = other.m_data.size(); i < s; ++i) {
-		d[i] = other.m_data[i];
-	}
-	return DynamicBitSet(d);
+	return DynamicBitSet(detail::DynamicBitSet::combine<detail::DynamicBitSet::BO_OR>(m_data, other.m_data, true, true));
 }
 
 DynamicBitSet DynamicBitSet::operator-(const DynamicBitSet & other) const {
-	UByteArrayAdapter::OffsetType s = std::min<UByteArrayAdapter::SizeType>( m_data.size(), other.m_data.size());
-	UByteArrayAdapter d(UByteArrayAdapter::createCache(s, sserialize::MM_PROGRAM_MEMORY) );
-	for(UByteArrayAdapter::OffsetType i = 0; i < s; ++i) {
-		d[i] = m_data[i] & (~other.m_data[i]);
-	}
-	return DynamicBitSet(d);
+	return DynamicBitSet(detail::DynamicBitSet::combine<detail::DynamicBitSet::BO_AND_NOT>(m_data, other.m_data, true, false));
 }
+
 DynamicBitSet DynamicBitSet::operator^(const DynamicBitSet & other) const {
-	UByteArrayAdapter::OffsetType smax = std::max<UByteArrayAdapter::SizeType>( m_data.size(), other.m_data.size());
-	UByteArrayAdapter d(UByteArrayAdapter::createCache(smax, sserialize::MM_PROGRAM_MEMORY) );
-	
-	UByteArrayAdapter::OffsetType i = 0;
-	UByteArrayAdapter::OffsetType s;
-	for(s = std::min<UByteArrayAdapter::OffsetType>( m_data.size(), other.m_data.size()); i < s; ++i) {
-		d[i] = m_data[i] ^ other.m_data[i];
-	}
-	for(s = m_data.size(); i < s; ++i) {
-		d[i] = m_data[i];
-	}
-	for(s = other.m_data.size(); i < s; ++i) {
-		d[i] = other.m_data[i];
-	}
-	return DynamicBitSet(d);
+	return DynamicBitSet(detail::DynamicBitSet::combine<detail::DynamicBitSet::BO_XOR>(m_data, other.m_data, true, true));
 }
 
 DynamicBitSet DynamicBitSet::operator~() const {
-	UByteArrayAdapter d(UByteArrayAdapter::createCache(m_data.size(), sserialize::MM_PROGRAM_MEMORY) );
 	UByteArrayAdapter::OffsetType s = m_data.size();
-	for(UByteArrayAdapter::OffsetType i = 0; i < s; ++i) {
-		d[i] = ~m_data[i];
+	UByteArrayAdapter d(UByteArrayAdapter::createCache(s, sserialize::MM_PROGRAM_MEMORY) );
+	if (s) {
+		const UByteArrayAdapter::MemoryView mv(m_data.asMemView());
+		UByteArrayAdapter::MemoryView dmv(d.asMemView());
+		for(UByteArrayAdapter::OffsetType i(0); i < s; ++i) {
+			dmv[i] = ~mv[i];
+		}
+		if (dmv.isCopy()) {
+			dmv.flush(s);
+		}
 	}
 	return DynamicBitSet(d);
 }
@@ -299,40 +472,22 @@ DynamicBitSet DynamicBitSet::operator~() const {
 
 DynamicBitSet & DynamicBitSet::operator&=(const DynamicBitSet & other) {
 	m_data.resize( std::min(m_data.size(), other.m_data.size()) );
-	for(UByteArrayAdapter::OffsetType i(0), s(m_data.size()); i < s; ++i) {
-		m_data[i] &= other.m_data[i];
-	}
+	detail::DynamicBitSet::combineInPlace<detail::DynamicBitSet::BO_AND>(m_data, other.m_data, false);
 	return *this;
 }
 
 DynamicBitSet & DynamicBitSet::operator|=(const DynamicBitSet & other) {
-	for(UByteArrayAdapter::OffsetType i(0), s(std::min(m_data.size(), other.m_data.size())); i < s; ++i) {
-		m_data[i] |= other.m_data[i];
-	}
-	if (m_data.size() < other.m_data.size()) {
-		auto s = m_data.size();
-		m_data.resize(other.m_data.size());
-		m_data.putData(s, UByteArrayAdapter(other.m_data, s));
-	}
+	detail::DynamicBitSet::combineInPlace<detail::DynamicBitSet::BO_OR>(m_data, other.m_data, true);
 	return *this;
 }
 
 DynamicBitSet & DynamicBitSet::operator-=(const DynamicBitSet & other) {
-	for(UByteArrayAdapter::OffsetType i(0), s(std::min(m_data.size(), other.m_data.size())); i < s; ++i) {
-		m_data[i] &= (~other.m_data[i]);
-	}
+	detail::DynamicBitSet::combineInPlace<detail::DynamicBitSet::BO_AND_NOT>(m_data, other.m_data, false);
 	return *this;
 }
 
 DynamicBitSet & DynamicBitSet::operator^=(const DynamicBitSet & other) {
-	for(UByteArrayAdapter::OffsetType i(0), s(std::min(m_data.size(), other.m_data.size())); i < s; ++i) {
-		m_data[i] ^= other.m_data[i];
-	}
-	if (m_data.size() < other.m_data.size()) {
-		auto s = m_data.size();
-		m_data.resize(other.m_data.size());
-		m_data.putData(s, UByteArrayAdapter(other.m_data, s));
-	}
+	detail::DynamicBitSet::combineInPlace<detail::DynamicBitSet::BO_XOR>(m_data, other.m_data, true);
 	return *this;
 }
 
@@ -17,6 +17,28 @@
 #include <sstream>
 
 namespace sserialize {
+namespace detail {
+
+ItemIndexSizeEstimator::SizeType ItemIndexSizeEstimator::size(int type) const {
+	switch(type) {
+	case ItemIndex::T_NATIVE:
+		return SizeType(4) + SizeType(4)*m_count;
+	case ItemIndex::T_DE:
+		return 8 + m_deDataSize;
+	case ItemIndex::T_RLE_DE:
+	{
+		SizeType dataSize = m_rleDeDataSize + rleSize();
+		return psize_vu32(m_count) + psize_vu32(narrow_check<uint32_t>(dataSize)) + dataSize;
+	}
+	case ItemIndex::T_ELIAS_FANO:
+		return ItemIndexPrivateEliasFano::storageSize(m_count, m_prev);
+	default:
+		throw sserialize::UnsupportedFeatureException("ItemIndexSizeEstimator: unsupported index type " + std::to_string(type));
+	}
+}
+
+}//end namespace detail
+
 
 ItemIndexFactory::ItemIndexFactory(bool memoryBased) :
 m_dataOffset(0),
@@ -27,6 +49,8 @@ m_idxTypes(sserialize::MM_SLOW_FILEBASED),
 m_hitCount(0),
 m_checkIndex(true),
 m_useDeduplication(true),
+m_verifyDeduplication(false),
+m_dedupHash(DH_FAST),
 m_type(ItemIndex::T_RLE_DE),
 m_compressionType(Static::ItemIndexStore::IC_NONE),
 m_growSize(16*1024*1024),
@@ -46,6 +70,8 @@ m_idxSizes(sserialize::MM_SLOW_FILEBASED),
 m_hitCount(other.m_hitCount.load()),
 m_checkIndex(other.m_checkIndex),
 m_useDeduplication(other.m_useDeduplication),
+m_verifyDeduplication(other.m_verifyDeduplication),
+m_dedupHash(other.m_dedupHash),
 m_type(other.m_type),
 m_compressionType(other.m_compressionType),
 m_growSize(other.m_growSize),
@@ -53,7 +79,9 @@ m_auxDataGrow(other.m_auxDataGrow)
 {
 	m_header = std::move(other.m_header);
 	m_indexStore = std::move(other.m_indexStore);
-	m_hash = std::move(other.m_hash);
+	for(std::size_t i(0); i < DataHashShardCount; ++i) {
+		m_hash[i].hash = std::move(other.m_hash[i].hash);
+	}
 	m_idToOffsets = std::move(other.m_idToOffsets);
 	m_idxSizes = std::move(other.m_idxSizes);
 	m_idxTypes = std::move(other.m_idxTypes);
@@ -68,11 +96,15 @@ ItemIndexFactory & ItemIndexFactory::operator=(ItemIndexFactory && other) {
 	m_hitCount.store(other.m_hitCount.load());
 	m_checkIndex = other.m_checkIndex;
 	m_useDeduplication = other.m_useDeduplication;
+	m_verifyDeduplication = other.m_verifyDeduplication;
+	m_dedupHash = other.m_dedupHash;
 	m_type = other.m_type;
 	m_compressionType = other.m_compressionType;
 	m_header = std::move(other.m_header);
 	m_indexStore = std::move(other.m_indexStore);
-	m_hash = std::move(other.m_hash);
+	for(std::size_t i(0); i < DataHashShardCount; ++i) {
+		m_hash[i].hash = std::move(other.m_hash[i].hash);
+	}
 	m_idToOffsets = std::move(other.m_idToOffsets);
 	m_idxSizes = std::move(other.m_idxSizes);
 	m_idxTypes = std::move(other.m_idxTypes);
@@ -105,7 +137,7 @@ void ItemIndexFactory::setIndexFile(sserialize::UByteArrayAdapter data) {
 	if (size()) { //clear everything
 		m_dataOffset = 0;
 		m_hitCount = 0;
-		m_hash.clear();
+		clearDeduplicationData();
 		m_idCounter = 0;
 		m_idToOffsets.clear();
 		m_idxSizes.clear();
@@ -128,7 +160,9 @@ std::vector<uint32_t> ItemIndexFactory::insert(const sserialize::Static::ItemInd
 	m_idToOffsets.reserve(store.size()+size());
 	m_idxSizes.reserve(store.size()+size());
 	if (m_useDeduplication) {
-		m_hash.reserve(store.size()+size());
+		for(DataHashShard & shard : m_hash) {
+			shard.hash.reserve((store.size()+size())/DataHashShardCount+1);
+		}
 	}
 	struct State {
 		sserialize::Static::ItemIndexStore const & src;
@@ -169,15 +203,35 @@ std::vector<uint32_t> ItemIndexFactory::insert(const sserialize::Static::ItemInd
 
 ItemIndexFactory::DataHashKey ItemIndexFactory::hashFunc(const UByteArrayAdapter & v) {
 	UByteArrayAdapter::MemoryView mv(v.asMemView());
+	if (m_dedupHash == DH_FAST) {
+		sserialize::FastHasher128<UByteArrayAdapter::MemoryView> hasher;
+		return hasher(mv);
+	}
 	sserialize::ShaHasher<UByteArrayAdapter::MemoryView> hasher;
 	return hasher(mv);
 }
 
 ItemIndexFactory::DataHashKey ItemIndexFactory::hashFunc(const std::vector<uint8_t> & v) {
+	if (m_dedupHash == DH_FAST) {
+		sserialize::FastHasher128< std::vector<uint8_t> > hasher;
+		return hasher(v);
+	}
 	sserialize::ShaHasher< std::vector<uint8_t> > hasher;
 	return hasher(v);
 }
 
+bool ItemIndexFactory::dataEqual(const DataHashValue & v, const std::vector<uint8_t> & idx) {
+	if (v.dataSize != idx.size()) {
+		return false;
+	}
+	if (!idx.size()) {
+		return true;
+	}
+	std::shared_lock<std::shared_mutex> dataGrowLock(m_dataGrowLock);
+	UByteArrayAdapter::MemoryView mv(m_indexStore.getMemView(v.dataOffset, v.dataSize));
+	return ::memcmp(mv.data(), idx.data(), idx.size()) == 0;
+}
+
 uint32_t ItemIndexFactory::addIndex(const ItemIndex & idx) {
 	std::vector<uint32_t> tmp;
 	idx.putInto(tmp);
@@ -190,32 +244,53 @@ Static::ItemIndexStore ItemIndexFactory::asItemIndexStore() {
 
 uint32_t ItemIndexFactory::addIndex(const std::vector<uint8_t> & idx, uint32_t idxSize, ItemIndex::Types type) {
 	SSERIALIZE_CHEAP_ASSERT(type & m_type);
+	if (m_useDeduplication) {
+		return addDeduplicatedIndex(idx, idxSize, type);
+	}
+	IndexId indexId;
 	sserialize::UByteArrayAdapter::OffsetType dataOffset;
+	reserveIndex(idx, indexId, dataOffset);
+	pushIndex(idx, idxSize, type, indexId, dataOffset);
+	return indexId;
+}
+
+uint32_t ItemIndexFactory::addDeduplicatedIndex(const std::vector<uint8_t> & idx, uint32_t idxSize, ItemIndex::Types type) {
 	IndexId indexId;
-	if (m_useDeduplication) {
-		ItemIndexFactory::DataHashKey hv = hashFunc(idx);
-		std::lock_guard<std::mutex> metaDataLock(m_metaDataLock);
-		IndexId & tmpId = m_hash[hv];
-		if (tmpId.valid()) {
+	sserialize::UByteArrayAdapter::OffsetType dataOffset;
+	ItemIndexFactory::DataHashKey hv = hashFunc(idx);
+	DataHashShard & shard = m_hash[dataHashShard(hv)];
+	std::unique_lock<std::mutex> shardLock(shard.lock);
+	auto it = shard.hash.find(hv);
+	if (it != shard.hash.end()) {
+		if (!m_verifyDeduplication || dataEqual(it->second, idx)) {
 			m_hitCount.fetch_add(1, std::memory_order_relaxed);
-			return tmpId;
-		}
-		else {
-			tmpId = m_idCounter; //sets value in m_hash
-			m_idCounter += 1;
-			indexId = tmpId;
-			
-			dataOffset = m_dataOffset;
-			m_dataOffset += idx.size();
+			return it->second.id;
 		}
+		//hash collision, store the data without deduplication entry
+		shardLock.unlock();
+		reserveIndex(idx, indexId, dataOffset);
 	}
 	else {
-		std::lock_guard<std::mutex> metaDataLock(m_metaDataLock);
-		indexId = m_idCounter;
-		m_idCounter += 1;
-		dataOffset = m_dataOffset;
-		m_dataOffset += idx.size();
+		reserveIndex(idx, indexId, dataOffset);
+		shard.hash.emplace(hv, DataHashValue{indexId, dataOffset, idx.size()});
+		//other threads may only compare against our data after it was written
+		if (!m_verifyDeduplication) {
+			shardLock.unlock();
+		}
 	}
+	pushIndex(idx, idxSize, type, indexId, dataOffset);
+	return indexId;
+}
+
+void ItemIndexFactory::reserveIndex(const std::vector<uint8_t> & idx, IndexId & indexId, UByteArrayAdapter::OffsetType & dataOffset) {
+	std::lock_guard<std::mutex> metaDataLock(m_metaDataLock);
+	indexId = m_idCounter;
+	m_idCounter += 1;
+	dataOffset = m_dataOffset;
+	m_dataOffset += idx.size();
+}
+
+void ItemIndexFactory::pushIndex(const std::vector<uint8_t> & idx, uint32_t idxSize, ItemIndex::Types type, IndexId indexId, UByteArrayAdapter::OffsetType dataOffset) {
 	//check if we need to grow the data
 	if (dataOffset+idx.size() >= m_indexStore.size()) {
 		std::lock_guard<std::shared_mutex> dataGrowLock(m_dataGrowLock);
@@ -246,17 +321,34 @@ uint32_t ItemIndexFactory::addIndex(const std::vector<uint8_t> & idx, uint32_t i
 			m_idxTypes.at(indexId) = type;
 		}
 	}
-	return indexId;
+}
+
+void ItemIndexFactory::clearDeduplicationData() {
+	for(DataHashShard & shard : m_hash) {
+		std::lock_guard<std::mutex> shardLock(shard.lock);
+		shard.hash.clear();
+	}
+}
+
+void ItemIndexFactory::setDeduplicationHash(DeduplicationHash dh) {
+	if (dh != m_dedupHash) {
+		m_dedupHash = dh;
+		recalculateDeduplicationData();
+	}
 }
 
 void ItemIndexFactory::recalculateDeduplicationData() {
+	clearDeduplicationData();
 	std::lock_guard<std::mutex> metaDataLock(m_metaDataLock);
 	std::shared_lock<std::shared_mutex> dataGrowLock(m_dataGrowLock);
-	m_hash.clear();
 	for(uint32_t id(0), s(size()); id < s; ++id) {
-		auto hv = hashFunc( this->indexDataById(id) );
-		SSERIALIZE_NORMAL_ASSERT(m_hash.count(hv) == 0);
-		m_hash[hv] = id;
+		UByteArrayAdapter::OffsetType dataOffset = m_idToOffsets.at(id);
+		UByteArrayAdapter::SizeType dataSize = (id+1 < s ? m_idToOffsets.at(id+1) : m_dataOffset) - dataOffset;
+		auto hv = hashFunc( UByteArrayAdapter(m_indexStore, dataOffset, dataSize) );
+		DataHashShard & shard = m_hash[dataHashShard(hv)];
+		std::lock_guard<std::mutex> shardLock(shard.lock);
+		SSERIALIZE_NORMAL_ASSERT(shard.hash.count(hv) == 0);
+		shard.hash[hv] = DataHashValue{id, dataOffset, dataSize};
 	}
 }
 
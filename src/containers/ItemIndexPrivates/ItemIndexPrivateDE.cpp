@@ -34,12 +34,16 @@ uint32_t ItemIndexPrivateDE::find(uint32_t id) const {
 uint32_t ItemIndexPrivateDE::at(uint32_t pos) const {
 	if (!size() || size() <= pos)
 		return 0;
-	int len = 0;
-	for(;m_cacheOffset <= pos;) {
-		m_curId += m_data.getVlPackedUint32(m_dataOffset, &len);
-		m_cache.putUint32(m_cacheOffset*4, m_curId);
-		m_dataOffset += len;
-		++m_cacheOffset;
+	//decode at least a small batch to amortize the setup of the bulk decoder
+	constexpr uint32_t BatchSize = 64;
+	uint32_t buffer[BatchSize];
+	while (m_cacheOffset <= pos) {
+		uint32_t count = std::min<uint32_t>(BatchSize, size()-m_cacheOffset);
+		m_dataOffset += m_data.getVlPackedDeltaUint32Array(m_dataOffset, buffer, count, m_curId);
+		for(uint32_t i(0); i < count; ++i, ++m_cacheOffset) {
+			m_cache.putUint32(m_cacheOffset*4, buffer[i]);
+		}
+		m_curId = buffer[count-1];
 	}
 	return m_cache.getUint32(pos*4);
 }
@@ -67,24 +71,23 @@ sserialize::UByteArrayAdapter::SizeType ItemIndexPrivateDE::getSizeInBytes() con
 }
 
 void ItemIndexPrivateDE::putInto(DynamicBitSet & bitSet) const {
+	constexpr uint32_t BatchSize = 1024;
+	uint32_t buffer[BatchSize];
 	UByteArrayAdapter tmpData(m_data);
-	uint32_t mySize = size();
-	uint32_t count = 0;
 	uint32_t prev = 0;
-	while(count < mySize) {
-		prev += tmpData.getVlPackedUint32();
-		bitSet.set(prev);
-		++count;
+	for(uint32_t remaining(size()); remaining;) {
+		uint32_t count = std::min<uint32_t>(BatchSize, remaining);
+		tmpData.getVlPackedDeltaUint32Array(buffer, count, prev);
+		for(uint32_t i(0); i < count; ++i) {
+			bitSet.set(buffer[i]);
+		}
+		prev = buffer[count-1];
+		remaining -= count;
 	}
 }
 
 void ItemIndexPrivateDE::putInto(uint32_t * dest) const {
-	UByteArrayAdapter tmpData(m_data);
-	uint32_t prev = 0;
-	for(uint32_t * destEnd(dest + size()); dest != destEnd; ++dest) {
-		prev += tmpData.getVlPackedUint32();
-		*dest = prev;
-	}
+	m_data.getVlPackedDeltaUint32Array(0, dest, size());
 }
 
 ItemIndexPrivate * ItemIndexPrivateDE::fromBitSet(const DynamicBitSet & bitSet) {
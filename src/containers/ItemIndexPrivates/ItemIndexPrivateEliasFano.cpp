@@ -467,6 +467,23 @@ uint32_t ItemIndexPrivateEliasFano::upperBoundStorage(uint32_t upperBound) {
 	return sserialize::msb(upperBound);
 }
 
+UByteArrayAdapter::SizeType ItemIndexPrivateEliasFano::storageSize(uint32_t count, uint32_t largestElement) {
+	if (!count) {
+		return psize_vu32(0);
+	}
+	uint32_t ub = upperBound(count, largestElement);
+	uint8_t lowerBits = numLowerBits(count, ub);
+	UByteArrayAdapter::SizeType result = psize_vu32(count) + psize_vu32(upperBoundStorage(ub));
+	if (lowerBits) {
+		result += CompactUintArray::minStorageBytes(lowerBits, count);
+	}
+	//the upper bits are unary coded gaps, one stop bit per entry and the sum of the gaps is the last upper part
+	uint64_t upperBitsCount = uint64_t(count) + ((largestElement - (count-1)) >> lowerBits);
+	uint32_t upperBitsDataSize = narrow_check<uint32_t>((upperBitsCount+7)/8);
+	result += psize_vu32(upperBitsDataSize) + upperBitsDataSize;
+	return result;
+}
+
 uint32_t ItemIndexPrivateEliasFano::upperBound() const {
 	if (size()) {
 		return uint32_t(1) << m_d.getVlPackedUint32(m_upperBoundBegin);
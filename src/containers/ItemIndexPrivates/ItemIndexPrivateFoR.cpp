@@ -80,9 +80,15 @@ sserialize::SizeType FoRBlock::decodeBlock(const sserialize::UByteArrayAdapter &
 		m_values[i] = prev;
 	}
 #else
-	sserialize::UByteArrayAdapter::MemoryView mv(d.getMemView(0, arrStorageSize));
+	sserialize::UByteArrayAdapter::BorrowedView bv(d.getBorrowedView(0, arrStorageSize));
+	sserialize::UByteArrayAdapter::MemoryView mv;
+	if (!bv.isContiguous()) {
+		mv = d.getMemView(0, arrStorageSize);
+	}
+	const uint8_t * dataBegin = (bv.isContiguous() ? bv.data() : mv.data());
+	const uint8_t * dataEnd = dataBegin + arrStorageSize;
 	uint32_t mask = sserialize::createMask(bpn);
-	const uint8_t * dit = mv.data();
+	const uint8_t * dit = dataBegin;
 	uint32_t * vit = m_values.data();
 	//in theory this loop can be computed in parallel (and hopefully is executed in parallel by the processor)
 	for(uint32_t i(0); i < size; ++i, ++vit) {
@@ -136,14 +142,20 @@ sserialize::SizeType FoRBlock::decodeBlock(const sserialize::UByteArrayAdapter &
 		}
 	}
 	else {
-		sserialize::UByteArrayAdapter::MemoryView mv(d.getMemView(0, blockStorageSize));
+		//borrow contiguous storage, this avoids the allocation and the reference counting of a MemoryView
+		sserialize::UByteArrayAdapter::BorrowedView bv(d.getBorrowedView(0, blockStorageSize));
+		sserialize::UByteArrayAdapter::MemoryView mv;
+		if (!bv.isContiguous()) {
+			mv = d.getMemView(0, blockStorageSize);
+		}
+		const uint8_t * dataBegin = (bv.isContiguous() ? bv.data() : mv.data());
+		const uint8_t * dataEnd = dataBegin + blockStorageSize;
 		const uint32_t mask = sserialize::createMask(bpn);
-		const uint8_t * dit = mv.data();
+		const uint8_t * dit = dataBegin;
 		uint32_t * vit = m_values.data();
 		uint32_t mySize = size;
 		
-		auto unpacker = BitpackingInterface::instance(bpn);
-		unpacker->unpack_blocks(dit, vit, mySize);
+		BitpackingInterface::shared(bpn).unpack_blocks(dit, vit, mySize);
 		
 		SSERIALIZE_NORMAL_ASSERT_EQUAL(std::size_t(vit-m_values.data()), size-mySize);
 		
@@ -158,7 +170,7 @@ sserialize::SizeType FoRBlock::decodeBlock(const sserialize::UByteArrayAdapter &
 			uint32_t i = 0;
 			uint64_t bitsBegin(0);
 			uint64_t bitsEnd(bpn);
-			for(const uint8_t * dend(mv.end()-8); dit+bitsBegin/8 <= dend; ++i) {
+			for(const uint8_t * dend(dataEnd-8); dit+bitsBegin/8 <= dend; ++i) {
 				SSERIALIZE_CHEAP_ASSERT_SMALLER(uint32_t(vit-m_values.data()), size);
 				uint64_t buffer;
 				uint32_t bb = bitsBegin/8;
@@ -180,7 +192,7 @@ sserialize::SizeType FoRBlock::decodeBlock(const sserialize::UByteArrayAdapter &
 				
 				uint32_t bb = bitsBegin/8;
 				uint32_t rs = (bb+sizeof(buffer))*8 - bitsEnd;
-				::memmove(&buffer, dit+bb, mv.end() - (dit+bb));
+				::memmove(&buffer, dit+bb, dataEnd - (dit+bb));
 				buffer = be64toh(buffer);
 				buffer >>= rs;
 				buffer &= mask;
@@ -202,9 +214,11 @@ sserialize::SizeType FoRBlock::decodeBlock(const sserialize::UByteArrayAdapter &
 //END FoRBlock
 //BEGIN FoRIterator
 
-FoRIterator::FoRIterator(uint32_t idxSize, const sserialize::CompactUintArray & bits, const sserialize::UByteArrayAdapter & data) :
+FoRIterator::FoRIterator(uint32_t idxSize, const sserialize::CompactUintArray & bits, const sserialize::UByteArrayAdapter & data, const BlockSkipTable & skipTable) :
+m_blockData(data),
 m_data(data),
 m_bits(bits),
+m_skipTable(skipTable),
 m_indexPos(0),
 m_indexSize(idxSize),
 m_blockPos(0)
@@ -256,6 +270,40 @@ FoRIterator::MyBaseClass * FoRIterator::copy() const {
 	return new FoRIterator(*this);
 }
 
+void FoRIterator::advanceTo(uint32_t id) {
+	if (m_indexPos >= m_indexSize || get() >= id) {
+		return;
+	}
+	if (m_block.back() < id) {
+		uint32_t defaultBlockSize = ItemIndexPrivatePFoR::BlockSizes.at(m_bits.at(0));
+		if (m_skipTable.size()) {
+			uint32_t entry = m_skipTable.entryFor(id);
+			uint32_t blockNum = m_skipTable.blockNum(entry);
+			if (blockNum > (m_indexPos-m_blockPos)/defaultBlockSize) {
+				m_indexPos = blockNum*defaultBlockSize;
+				m_blockPos = 0;
+				m_data = UByteArrayAdapter(m_blockData, m_skipTable.offset(entry));
+				fetchBlock(m_data, m_skipTable.prev(entry));
+			}
+		}
+		while (m_block.back() < id) {
+			m_indexPos += m_block.size() - m_blockPos;
+			m_blockPos = 0;
+			if (m_indexPos >= m_indexSize) {
+				return;
+			}
+			fetchBlock(m_data, m_block.back());
+		}
+	}
+	uint32_t blockPos = std::lower_bound(m_block.begin()+m_blockPos, m_block.end(), id) - m_block.begin();
+	m_indexPos += blockPos - m_blockPos;
+	m_blockPos = blockPos;
+}
+
+uint32_t FoRIterator::indexPosition() const {
+	return m_indexPos;
+}
+
 bool FoRIterator::fetchBlock(const UByteArrayAdapter& d, uint32_t prev) {
 	if (m_indexPos < m_indexSize) {
 		//there is exactly one partial block at the end
@@ -314,6 +362,23 @@ m_delete(false)
 	m_values.resize(ItemIndexPrivatePFoR::BlockSizes[blockSizeOffset]);
 }
 
+FoRCreator::FoRCreator(UByteArrayAdapter & data, uint32_t blockSizeOffset, const BlockSkipTableCreator & skipTable) :
+m_size(0),
+m_blockSizeOffset(blockSizeOffset),
+m_vpos(0),
+m_prev(0),
+m_vor(0),
+m_blockBits(1, m_blockSizeOffset),
+m_skipTable(skipTable),
+m_data(0, MM_PROGRAM_MEMORY),
+m_dest(&data),
+m_putPtr(m_dest->tellPutPtr()),
+m_delete(false)
+{
+	SSERIALIZE_CHEAP_ASSERT_SMALLER(blockSizeOffset, ItemIndexPrivatePFoR::BlockSizes.size());
+	m_values.resize(ItemIndexPrivatePFoR::BlockSizes[blockSizeOffset]);
+}
+
 FoRCreator::FoRCreator(FoRCreator&& other) :
 m_size(other.m_size),
 m_blockSizeOffset(other.m_blockSizeOffset),
@@ -322,6 +387,7 @@ m_vpos(other.m_vpos),
 m_prev(other.m_prev),
 m_vor(other.m_vor),
 m_blockBits(std::move(other.m_blockBits)),
+m_skipTable(std::move(other.m_skipTable)),
 m_data(std::move(other.m_data)),
 m_dest(std::move(other.m_dest)),
 m_putPtr(other.m_putPtr),
@@ -358,7 +424,12 @@ void FoRCreator::flush() {
 	if (m_vpos) {
 		flushBlock();
 	}
+	//the skip table marker of an empty index would be ambiguous
+	bool withSkipTable = m_skipTable.enabled() && m_size;
 	m_dest->putVlPackedUint32(m_size);
+	if (withSkipTable) {
+		m_dest->putVlPackedUint32(0);
+	}
 	m_dest->putVlPackedUint32(m_data.size());
 	m_dest->putData(m_data);
 	#ifdef SSERIALIZE_CHEAP_ASSERT_ENABLED
@@ -366,6 +437,9 @@ void FoRCreator::flush() {
 	#endif
 		CompactUintArray::create(m_blockBits, *m_dest, ItemIndexPrivatePFoR::BlockDescBitWidth);
 	SSERIALIZE_CHEAP_ASSERT_EQUAL(bits, ItemIndexPrivatePFoR::BlockDescBitWidth);
+	if (withSkipTable) {
+		m_skipTable.flush(*m_dest);
+	}
 }
 
 UByteArrayAdapter FoRCreator::flushedData() const {
@@ -396,6 +470,7 @@ void FoRCreator::flushBlock() {
 		return;
 	}
 	m_size += m_vpos;
+	m_skipTable.addBlock(m_blockBits.size()-1, m_prev - std::accumulate(m_values.begin(), m_values.begin()+m_vpos, uint32_t(0)), m_data.tellPutPtr());
 	uint32_t blockBits = CompactUintArray::minStorageBits(m_vor);
 	encodeBlock(m_data, m_values.begin(), m_values.begin()+m_vpos, blockBits);
 	m_blockBits.push_back(blockBits);
@@ -504,6 +579,10 @@ m_d(d)
 	SSERIALIZE_CHEAP_ASSERT_EQUAL(uint32_t(0), d.tellGetPtr());
 	m_size = d.getVlPackedUint32();
 	uint32_t blockDataSize = d.getVlPackedUint32();
+	bool withSkipTable = m_size && !blockDataSize;
+	if (withSkipTable) {
+		blockDataSize = d.getVlPackedUint32();
+	}
 	
 	totalSize += d.tellGetPtr();
 	
@@ -521,6 +600,11 @@ m_d(d)
 	totalSize += blockDataSize;
 	totalSize += m_bits.getSizeInBytes();
 	
+	if (withSkipTable) {
+		m_skipTable = detail::ItemIndexImpl::BlockSkipTable(UByteArrayAdapter(d, blockDataSize+m_bits.getSizeInBytes()));
+		totalSize += m_skipTable.getSizeInBytes();
+	}
+	
 	SSERIALIZE_CHEAP_ASSERT_SMALLER_OR_EQUAL(totalSize, m_d.size());
 	if (m_d.size() != totalSize) {
 		m_d = UByteArrayAdapter(m_d, 0, totalSize);
@@ -551,6 +635,20 @@ uint8_t ItemIndexPrivateFoR::bpn() const {
 	}
 }
 
+uint32_t
+ItemIndexPrivateFoR::find(uint32_t id) const {
+	//without skip table the binary search on the decoded cache is faster than decoding from the start
+	if (!hasSkipTable()) {
+		return ItemIndexPrivate::find(id);
+	}
+	std::unique_ptr<detail::ItemIndexImpl::FoRIterator> it(static_cast<detail::ItemIndexImpl::FoRIterator*>(cbegin()));
+	it->advanceTo(id);
+	if (it->indexPosition() < m_size && it->get() == id) {
+		return it->indexPosition();
+	}
+	return npos;
+}
+
 uint32_t
 ItemIndexPrivateFoR::at(uint32_t pos) const {
 	if (pos >= m_size) {
@@ -577,7 +675,7 @@ ItemIndexPrivateFoR::last() const {
 
 ItemIndexPrivateFoR::const_iterator
 ItemIndexPrivateFoR::cbegin() const {
-	return new detail::ItemIndexImpl::FoRIterator(size(), m_bits, m_blocks);
+	return new detail::ItemIndexImpl::FoRIterator(size(), m_bits, m_blocks, m_skipTable);
 }
 
 ItemIndexPrivateFoR::const_iterator
@@ -631,12 +729,29 @@ ItemIndexPrivateFoR::putInto(DynamicBitSet & bitSet) const {
 
 void
 ItemIndexPrivateFoR::putInto(uint32_t* dest) const {
-	dest = std::copy(m_cache.cbegin(), m_cache.cend(), dest);
-	
-	if (m_cache.size() < m_size) {
-		auto it(m_it);
-		for(uint32_t i = uint32_t(m_cache.size()); i < m_size; ++i, ++dest, ++it) {
-			*dest = *it;
+	if (m_cache.size()) {
+		dest = std::copy(m_cache.cbegin(), m_cache.cend(), dest);
+		
+		if (m_cache.size() < m_size) {
+			auto it(m_it);
+			for(uint32_t i = uint32_t(m_cache.size()); i < m_size; ++i, ++dest, ++it) {
+				*dest = *it;
+			}
+		}
+	}
+	else {
+		detail::ItemIndexImpl::FoRBlock block;
+		UByteArrayAdapter bd = m_blocks;
+		uint32_t defaultBlockSize = ItemIndexPrivatePFoR::BlockSizes.at(m_bits.at(0));
+		uint32_t prev = 0;
+		for(uint32_t blockNum(0), s(blockCount()); blockNum < s; ++blockNum) {
+			uint32_t blockSize = std::min<uint32_t>(defaultBlockSize, m_size - blockNum*defaultBlockSize);
+			uint32_t blockBits = m_bits.at(blockNum+1);
+			block.update(bd, prev, blockSize, blockBits);
+			bd += block.getSizeInBytes();
+			prev = block.back();
+			
+			dest = std::copy(block.begin(), block.end(), dest);
 		}
 	}
 }
@@ -649,6 +764,12 @@ ItemIndexPrivateFoR::uniteK(const sserialize::ItemIndexPrivate * other, uint32_t
 ItemIndexPrivate *
 ItemIndexPrivateFoR::intersect(const sserialize::ItemIndexPrivate * other) const {
 	const ItemIndexPrivateFoR * cother = dynamic_cast<const ItemIndexPrivateFoR*>(other);
+	if (hasSkipTable() && uint64_t(other->size())*sserialize::sortedset::SkewThreshold < size()) {
+		return skipIntersect(other);
+	}
+	if (cother && cother->hasSkipTable() && uint64_t(size())*sserialize::sortedset::SkewThreshold < cother->size()) {
+		return cother->skipIntersect(this);
+	}
 	if (!cother) {
 		return ItemIndexPrivate::doIntersect(other);
 	}
@@ -721,5 +842,38 @@ uint32_t ItemIndexPrivateFoR::blockSize() const {
 uint32_t ItemIndexPrivateFoR::blockCount() const {
 	return m_bits.maxCount() - 1;
 }
+
+bool ItemIndexPrivateFoR::hasSkipTable() const {
+	return m_skipTable.size();
+}
+
+const detail::ItemIndexImpl::BlockSkipTable & ItemIndexPrivateFoR::skipTable() const {
+	return m_skipTable;
+}
+
+uint32_t ItemIndexPrivateFoR::lowerBound(uint32_t id) const {
+	std::unique_ptr<detail::ItemIndexImpl::FoRIterator> it(static_cast<detail::ItemIndexImpl::FoRIterator*>(cbegin()));
+	it->advanceTo(id);
+	return it->indexPosition();
+}
+
+ItemIndexPrivate * ItemIndexPrivateFoR::skipIntersect(const sserialize::ItemIndexPrivate * small) const {
+	std::vector<uint32_t> ids(small->size());
+	small->putInto(ids.data());
+	
+	detail::ItemIndexImpl::FoRCreator creator;
+	std::unique_ptr<detail::ItemIndexImpl::FoRIterator> it(static_cast<detail::ItemIndexImpl::FoRIterator*>(cbegin()));
+	for(uint32_t id : ids) {
+		it->advanceTo(id);
+		if (it->indexPosition() >= m_size) {
+			break;
+		}
+		if (it->get() == id) {
+			creator.push_back(id);
+		}
+	}
+	creator.flush();
+	return creator.getPrivateIndex();
+}
 	
 }//end namespace
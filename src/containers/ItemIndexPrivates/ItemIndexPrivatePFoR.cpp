@@ -6,6 +6,95 @@ namespace sserialize {
 namespace detail {
 namespace ItemIndexImpl {
 
+//BEGIN BlockSkipTable
+
+BlockSkipTable::BlockSkipTable() :
+m_interval(0),
+m_dataSize(0)
+{}
+
+BlockSkipTable::BlockSkipTable(const sserialize::UByteArrayAdapter & d) {
+	int len = -1;
+	m_interval = d.getVlPackedUint32(0, &len);
+	if (len < 0 || !m_interval) {
+		throw sserialize::CorruptDataException("BlockSkipTable: invalid interval");
+	}
+	m_dataSize = len;
+	m_prev = BoundedCompactUintArray(UByteArrayAdapter(d, m_dataSize));
+	m_dataSize += m_prev.getSizeInBytes();
+	m_offset = BoundedCompactUintArray(UByteArrayAdapter(d, m_dataSize));
+	m_dataSize += m_offset.getSizeInBytes();
+	if (m_prev.size() != m_offset.size()) {
+		throw sserialize::CorruptDataException("BlockSkipTable: prev and offset arrays differ in size");
+	}
+}
+
+uint32_t BlockSkipTable::size() const {
+	return m_prev.size();
+}
+
+uint32_t BlockSkipTable::interval() const {
+	return m_interval;
+}
+
+sserialize::UByteArrayAdapter::SizeType BlockSkipTable::getSizeInBytes() const {
+	return m_dataSize;
+}
+
+uint32_t BlockSkipTable::blockNum(uint32_t entry) const {
+	return entry*m_interval;
+}
+
+uint32_t BlockSkipTable::prev(uint32_t entry) const {
+	return m_prev.at(entry);
+}
+
+uint32_t BlockSkipTable::offset(uint32_t entry) const {
+	return m_offset.at(entry);
+}
+
+uint32_t BlockSkipTable::entryFor(uint32_t id) const {
+	//prev values are strictly increasing except for the first two entries which may both be 0
+	uint32_t left = 0;
+	uint32_t right = size();
+	while (left+1 < right) {
+		uint32_t mid = left + (right-left)/2;
+		if (m_prev.at(mid) < id) {
+			left = mid;
+		}
+		else {
+			right = mid;
+		}
+	}
+	return left;
+}
+
+BlockSkipTableCreator::BlockSkipTableCreator(uint32_t interval) :
+m_interval(interval)
+{}
+
+bool BlockSkipTableCreator::enabled() const {
+	return m_interval;
+}
+
+void BlockSkipTableCreator::addBlock(uint32_t blockNum, uint32_t prev, sserialize::UByteArrayAdapter::SizeType offset) {
+	if (m_interval && blockNum % m_interval == 0) {
+		SSERIALIZE_CHEAP_ASSERT_EQUAL(blockNum/m_interval, m_prev.size());
+		m_prev.push_back(prev);
+		m_offset.push_back(sserialize::narrow_check<uint32_t>(offset));
+	}
+}
+
+void BlockSkipTableCreator::flush(sserialize::UByteArrayAdapter & dest) const {
+	if (m_interval) {
+		dest.putVlPackedUint32(m_interval);
+		BoundedCompactUintArray::create(m_prev, dest);
+		BoundedCompactUintArray::create(m_offset, dest);
+	}
+}
+
+//END BlockSkipTable
+
 PFoRBlock::PFoRBlock() :
 m_dataSize(0)
 {}
@@ -57,38 +146,41 @@ PFoRBlock::const_iterator PFoRBlock::cend() const {
 	return m_values.cend();
 }
 
-//TODO: decode fixed bit part with sse or something like that if blocks are large
-//It may already be a lot faster if we can increase the ipc of the code
-//The problem is as follows: input are n bit numbers arranged in an array of uint8_t in big endian (most significant byte first)
-//pad n bit to 32 and do ntoh on padded bytes
+//The fixed bit part is decoded by BitpackingInterface which uses simd unpackers if the cpu supports them
 
-sserialize::SizeType PFoRBlock::decodeBlock(sserialize::UByteArrayAdapter d, uint32_t prev, uint32_t size, uint32_t bpn) {
+sserialize::SizeType PFoRBlock::decodeBlock(const sserialize::UByteArrayAdapter & d, uint32_t prev, uint32_t size, uint32_t bpn) {
 	SSERIALIZE_CHEAP_ASSERT_EQUAL(UByteArrayAdapter::SizeType(0), d.tellGetPtr());
 	m_values.resize(size);
-	sserialize::SizeType getPtr = d.tellGetPtr();
 	sserialize::SizeType arrStorageSize = CompactUintArray::minStorageBytes(bpn, size);
+	//outliers follow the bit array, read them by position to leave d untouched
+	sserialize::UByteArrayAdapter::OffsetType outlierPos = arrStorageSize;
+	int len = 0;
 	if (size < 8) {
-		MultiBitIterator ait(UByteArrayAdapter(d, 0, arrStorageSize));
-		d.incGetPtr(arrStorageSize);
+		MultiBitIterator ait(d);
 		for(uint32_t i(0); i < size; ++i, ait += bpn) {
 			uint32_t v = ait.get32(bpn);
 			if (v == 0) {
-				v = d.getVlPackedUint32();
+				v = d.getVlPackedUint32(outlierPos, &len);
+				outlierPos += len;
 			}
 			prev += v;
 			m_values[i] = prev;
 		}
 	}
 	else {
-		sserialize::UByteArrayAdapter::MemoryView mv(d.getMemView(0, arrStorageSize));
-		d.incGetPtr(arrStorageSize);
+		sserialize::UByteArrayAdapter::BorrowedView bv(d.getBorrowedView(0, arrStorageSize));
+		sserialize::UByteArrayAdapter::MemoryView mv;
+		if (!bv.isContiguous()) {
+			mv = d.getMemView(0, arrStorageSize);
+		}
+		const uint8_t * dataBegin = (bv.isContiguous() ? bv.data() : mv.data());
+		const uint8_t * dataEnd = dataBegin + arrStorageSize;
 		const uint32_t mask = sserialize::createMask(bpn);
-		const uint8_t * dit = mv.data();
+		const uint8_t * dit = dataBegin;
 		uint32_t * vit = m_values.data();
 		uint32_t mySize = size;
 		
-		auto unpacker = BitpackingInterface::instance(bpn);
-		unpacker->unpack_blocks(dit, vit, mySize);
+		BitpackingInterface::shared(bpn).unpack_blocks(dit, vit, mySize);
 		SSERIALIZE_NORMAL_ASSERT_EQUAL(std::size_t(vit-m_values.data()), size-mySize);
 		
 		//parse the remainder
@@ -96,7 +188,7 @@ sserialize::SizeType PFoRBlock::decodeBlock(sserialize::UByteArrayAdapter d, uin
 			uint32_t i = 0;
 			uint64_t bitsBegin(0);
 			uint64_t bitsEnd(bpn);
-			for(const uint8_t * dend(mv.end()-8); dit+bitsBegin/8 <= dend; ++i) {
+			for(const uint8_t * dend(dataEnd-8); dit+bitsBegin/8 <= dend; ++i) {
 				SSERIALIZE_CHEAP_ASSERT_SMALLER(uint32_t(vit-m_values.data()), size);
 				uint64_t buffer;
 				uint32_t bb = bitsBegin/8;
@@ -117,7 +209,7 @@ sserialize::SizeType PFoRBlock::decodeBlock(sserialize::UByteArrayAdapter d, uin
 				
 				uint32_t bb = bitsBegin/8;
 				uint32_t rs = (bb+sizeof(buffer))*8 - bitsEnd;
-				::memmove(&buffer, dit+bb, mv.end() - (dit+bb));
+				::memmove(&buffer, dit+bb, dataEnd - (dit+bb));
 				buffer = be64toh(buffer);
 				buffer >>= rs;
 				buffer &= mask;
@@ -133,19 +225,22 @@ sserialize::SizeType PFoRBlock::decodeBlock(sserialize::UByteArrayAdapter d, uin
 		for(uint32_t i(0); i < size; ++i) {
 			uint32_t v = m_values[i];
 			if (v == 0) {
-				v = d.getVlPackedUint32();
+				v = d.getVlPackedUint32(outlierPos, &len);
+				outlierPos += len;
 			}
 			prev += v;
 			m_values[i] = prev;
 		}
 	}
-	return d.tellGetPtr() - getPtr;
+	return outlierPos;
 }
 
 
-PFoRIterator::PFoRIterator(uint32_t idxSize, const sserialize::CompactUintArray & bits, const sserialize::UByteArrayAdapter & data) :
+PFoRIterator::PFoRIterator(uint32_t idxSize, const sserialize::CompactUintArray & bits, const sserialize::UByteArrayAdapter & data, const BlockSkipTable & skipTable) :
+m_blockData(data),
 m_data(data),
 m_bits(bits),
+m_skipTable(skipTable),
 m_indexPos(0),
 m_indexSize(idxSize),
 m_blockPos(0)
@@ -197,6 +292,40 @@ PFoRIterator::MyBaseClass * PFoRIterator::copy() const {
 	return new PFoRIterator(*this);
 }
 
+void PFoRIterator::advanceTo(uint32_t id) {
+	if (m_indexPos >= m_indexSize || get() >= id) {
+		return;
+	}
+	if (m_block.back() < id) {
+		uint32_t defaultBlockSize = ItemIndexPrivatePFoR::BlockSizes.at(m_bits.at(0));
+		if (m_skipTable.size()) {
+			uint32_t entry = m_skipTable.entryFor(id);
+			uint32_t blockNum = m_skipTable.blockNum(entry);
+			if (blockNum > (m_indexPos-m_blockPos)/defaultBlockSize) {
+				m_indexPos = blockNum*defaultBlockSize;
+				m_blockPos = 0;
+				m_data = UByteArrayAdapter(m_blockData, m_skipTable.offset(entry));
+				fetchBlock(m_data, m_skipTable.prev(entry));
+			}
+		}
+		while (m_block.back() < id) {
+			m_indexPos += m_block.size() - m_blockPos;
+			m_blockPos = 0;
+			if (m_indexPos >= m_indexSize) {
+				return;
+			}
+			fetchBlock(m_data, m_block.back());
+		}
+	}
+	uint32_t blockPos = std::lower_bound(m_block.begin()+m_blockPos, m_block.end(), id) - m_block.begin();
+	m_indexPos += blockPos - m_blockPos;
+	m_blockPos = blockPos;
+}
+
+uint32_t PFoRIterator::indexPosition() const {
+	return m_indexPos;
+}
+
 bool PFoRIterator::fetchBlock(const UByteArrayAdapter& d, uint32_t prev) {
 	if (m_indexPos < m_indexSize) {
 		//there is exactly one partial block at the end
@@ -281,6 +410,21 @@ m_delete(false)
 	SSERIALIZE_CHEAP_ASSERT_SMALLER(m_blockSizeOffset, ItemIndexPrivatePFoR::BlockSizes.size());
 }
 
+PFoRCreator::PFoRCreator(UByteArrayAdapter & data, uint32_t blockSizeOffset, const BlockSkipTableCreator & skipTable) :
+m_fixedSize(false),
+m_size(0),
+m_blockSizeOffset(blockSizeOffset),
+m_prev(0),
+m_blockBits(1, m_blockSizeOffset),
+m_skipTable(skipTable),
+m_data(0, MM_PROGRAM_MEMORY),
+m_dest(&data),
+m_putPtr(m_dest->tellPutPtr()),
+m_delete(false)
+{
+	SSERIALIZE_CHEAP_ASSERT_SMALLER(blockSizeOffset, ItemIndexPrivatePFoR::BlockSizes.size());
+}
+
 PFoRCreator::PFoRCreator(PFoRCreator&& other) :
 m_fixedSize(other.m_fixedSize),
 m_size(other.m_size),
@@ -288,6 +432,7 @@ m_blockSizeOffset(other.m_blockSizeOffset),
 m_values(std::move(other.m_values)),
 m_prev(other.m_prev),
 m_blockBits(std::move(other.m_blockBits)),
+m_skipTable(std::move(other.m_skipTable)),
 m_data(std::move(other.m_data)),
 m_dest(std::move(other.m_dest)),
 m_putPtr(other.m_putPtr),
@@ -325,6 +470,7 @@ void PFoRCreator::flushBlock() {
 	if (!m_fixedSize) {
 		m_size += m_values.size();
 	}
+	m_skipTable.addBlock(m_blockBits.size()-1, m_prev - std::accumulate(m_values.begin(), m_values.end(), uint32_t(0)), m_data.tellPutPtr());
 	uint32_t blockBits = encodeBlock(m_data, m_values.begin(), m_od.begin(), m_od.end());
 	m_blockBits.push_back(blockBits);
 	m_values.clear();
@@ -335,7 +481,12 @@ void PFoRCreator::flush() {
 	if (m_values.size()) {
 		flushBlock();
 	}
+	//the skip table marker of an empty index would be ambiguous
+	bool withSkipTable = m_skipTable.enabled() && m_size;
 	m_dest->putVlPackedUint32(m_size);
+	if (withSkipTable) {
+		m_dest->putVlPackedUint32(0);
+	}
 	m_dest->putVlPackedUint32(m_data.size());
 	m_dest->putData(m_data);
 	#ifdef SSERIALIZE_CHEAP_ASSERT_ENABLED
@@ -345,6 +496,10 @@ void PFoRCreator::flush() {
 	CompactUintArray::create(m_blockBits, *m_dest, ItemIndexPrivatePFoR::BlockDescBitWidth);
 	
 	SSERIALIZE_CHEAP_ASSERT_EQUAL(bits, ItemIndexPrivatePFoR::BlockDescBitWidth);
+	
+	if (withSkipTable) {
+		m_skipTable.flush(*m_dest);
+	}
 }
 
 UByteArrayAdapter PFoRCreator::flushedData() const {
@@ -544,6 +699,10 @@ m_d(d)
 	SSERIALIZE_CHEAP_ASSERT_EQUAL(uint32_t(0), d.tellGetPtr());
 	m_size = d.getVlPackedUint32();
 	uint32_t blockDataSize = d.getVlPackedUint32();
+	bool withSkipTable = m_size && !blockDataSize;
+	if (withSkipTable) {
+		blockDataSize = d.getVlPackedUint32();
+	}
 	
 	totalSize += d.tellGetPtr();
 	
@@ -561,6 +720,11 @@ m_d(d)
 	totalSize += blockDataSize;
 	totalSize += m_bits.getSizeInBytes();
 	
+	if (withSkipTable) {
+		m_skipTable = detail::ItemIndexImpl::BlockSkipTable(UByteArrayAdapter(d, blockDataSize+m_bits.getSizeInBytes()));
+		totalSize += m_skipTable.getSizeInBytes();
+	}
+	
 	SSERIALIZE_CHEAP_ASSERT_SMALLER_OR_EQUAL(totalSize, m_d.size());
 	if (m_d.size() != totalSize) {
 		m_d = UByteArrayAdapter(m_d, 0, totalSize);
@@ -591,6 +755,20 @@ uint8_t ItemIndexPrivatePFoR::bpn() const {
 	}
 }
 
+uint32_t
+ItemIndexPrivatePFoR::find(uint32_t id) const {
+	//without skip table the binary search on the decoded cache is faster than decoding from the start
+	if (!hasSkipTable()) {
+		return ItemIndexPrivate::find(id);
+	}
+	std::unique_ptr<detail::ItemIndexImpl::PFoRIterator> it(static_cast<detail::ItemIndexImpl::PFoRIterator*>(cbegin()));
+	it->advanceTo(id);
+	if (it->indexPosition() < m_size && it->get() == id) {
+		return it->indexPosition();
+	}
+	return npos;
+}
+
 uint32_t
 ItemIndexPrivatePFoR::at(uint32_t pos) const {
 	if (pos >= m_size) {
@@ -617,7 +795,7 @@ ItemIndexPrivatePFoR::last() const {
 
 ItemIndexPrivatePFoR::const_iterator
 ItemIndexPrivatePFoR::cbegin() const {
-	return new detail::ItemIndexImpl::PFoRIterator(size(), m_bits, m_blocks);
+	return new detail::ItemIndexImpl::PFoRIterator(size(), m_bits, m_blocks, m_skipTable);
 }
 
 ItemIndexPrivatePFoR::const_iterator
@@ -671,12 +849,29 @@ ItemIndexPrivatePFoR::putInto(DynamicBitSet & bitSet) const {
 
 void
 ItemIndexPrivatePFoR::putInto(uint32_t* dest) const {
-	dest = std::copy(m_cache.cbegin(), m_cache.cend(), dest);
-	
-	if (m_cache.size() < m_size) {
-		auto it(m_it);
-		for(uint32_t i = uint32_t(m_cache.size()); i < m_size; ++i, ++dest, ++it) {
-			*dest = *it;
+	if (m_cache.size()) {
+		dest = std::copy(m_cache.cbegin(), m_cache.cend(), dest);
+		
+		if (m_cache.size() < m_size) {
+			auto it(m_it);
+			for(uint32_t i = uint32_t(m_cache.size()); i < m_size; ++i, ++dest, ++it) {
+				*dest = *it;
+			}
+		}
+	}
+	else {
+		detail::ItemIndexImpl::PFoRBlock block;
+		UByteArrayAdapter bd = m_blocks;
+		uint32_t defaultBlockSize = ItemIndexPrivatePFoR::BlockSizes.at(m_bits.at(0));
+		uint32_t prev = 0;
+		for(uint32_t blockNum(0), s(blockCount()); blockNum < s; ++blockNum) {
+			uint32_t blockSize = std::min<uint32_t>(defaultBlockSize, m_size - blockNum*defaultBlockSize);
+			uint32_t blockBits = m_bits.at(blockNum+1);
+			block.update(bd, prev, blockSize, blockBits);
+			bd += block.getSizeInBytes();
+			prev = block.back();
+			
+			dest = std::copy(block.begin(), block.end(), dest);
 		}
 	}
 }
@@ -689,6 +884,12 @@ ItemIndexPrivatePFoR::uniteK(const sserialize::ItemIndexPrivate * other, uint32_
 ItemIndexPrivate *
 ItemIndexPrivatePFoR::intersect(const sserialize::ItemIndexPrivate * other) const {
 	const ItemIndexPrivatePFoR * cother = dynamic_cast<const ItemIndexPrivatePFoR*>(other);
+	if (hasSkipTable() && uint64_t(other->size())*sserialize::sortedset::SkewThreshold < size()) {
+		return skipIntersect(other);
+	}
+	if (cother && cother->hasSkipTable() && uint64_t(size())*sserialize::sortedset::SkewThreshold < cother->size()) {
+		return cother->skipIntersect(this);
+	}
 	if (!cother) {
 		return ItemIndexPrivate::doIntersect(other);
 	}
@@ -762,6 +963,39 @@ uint32_t ItemIndexPrivatePFoR::blockCount() const {
 	return m_bits.maxCount() - 1;
 }
 
+bool ItemIndexPrivatePFoR::hasSkipTable() const {
+	return m_skipTable.size();
+}
+
+const detail::ItemIndexImpl::BlockSkipTable & ItemIndexPrivatePFoR::skipTable() const {
+	return m_skipTable;
+}
+
+uint32_t ItemIndexPrivatePFoR::lowerBound(uint32_t id) const {
+	std::unique_ptr<detail::ItemIndexImpl::PFoRIterator> it(static_cast<detail::ItemIndexImpl::PFoRIterator*>(cbegin()));
+	it->advanceTo(id);
+	return it->indexPosition();
+}
+
+ItemIndexPrivate * ItemIndexPrivatePFoR::skipIntersect(const sserialize::ItemIndexPrivate * small) const {
+	std::vector<uint32_t> ids(small->size());
+	small->putInto(ids.data());
+	
+	detail::ItemIndexImpl::PFoRCreator creator;
+	std::unique_ptr<detail::ItemIndexImpl::PFoRIterator> it(static_cast<detail::ItemIndexImpl::PFoRIterator*>(cbegin()));
+	for(uint32_t id : ids) {
+		it->advanceTo(id);
+		if (it->indexPosition() >= m_size) {
+			break;
+		}
+		if (it->get() == id) {
+			creator.push_back(id);
+		}
+	}
+	creator.flush();
+	return creator.getPrivateIndex();
+}
+
 //END INDEX
 
 }//end namespace sserialize
@@ -1,6 +1,7 @@
 #include <sserialize/containers/ItemIndexPrivates/ItemIndexPrivateRleDE.h>
 #include <sserialize/algorithm/utilfuncs.h>
 #include <sserialize/storage/pack_unpack_functions.h>
+#include <sserialize/storage/varint_functions.h>
 #include <sserialize/utility/exceptions.h>
 #include <sserialize/storage/SerializationInfo.h>
 #include <sserialize/utility/checks.h>
@@ -283,8 +284,48 @@ sserialize::UByteArrayAdapter::SizeType ItemIndexPrivateRleDE::getSizeInBytes()
 	return m_data.size() + sserialize::psize_v<uint32_t>(m_size) + sserialize::psize_v<uint32_t>(m_data.size());
 }
 
+namespace {
+
+///Bulk decodes the raw words of an index, the memory of the index is resolved once
+class RawWordReader final {
+public:
+	RawWordReader(const UByteArrayAdapter & data) :
+	m_mem(data.asMemView()),
+	m_src(m_mem.data()),
+	m_srcEnd(m_mem.data()+m_mem.size()),
+	m_pos(0),
+	m_size(0)
+	{}
+	inline uint32_t getVlPackedUint32() {
+		if (UNLIKELY_BRANCH(m_pos == m_size)) {
+			fill();
+		}
+		return m_buffer[m_pos++];
+	}
+private:
+	void fill() {
+		std::size_t bytes = 0;
+		m_size = (uint32_t) varint::decode(m_src, m_srcEnd, m_buffer, BatchSize, bytes);
+		if (!m_size) {
+			throw sserialize::CorruptDataException("ItemIndexPrivateRleDE");
+		}
+		m_src += bytes;
+		m_pos = 0;
+	}
+private:
+	static constexpr uint32_t BatchSize = 256;
+	const UByteArrayAdapter::MemoryView m_mem;
+	const uint8_t * m_src;
+	const uint8_t * m_srcEnd;
+	uint32_t m_buffer[BatchSize];
+	uint32_t m_pos;
+	uint32_t m_size;
+};
+
+}//end anonymous namespace
+
 void ItemIndexPrivateRleDE::putInto(DynamicBitSet & bitSet) const {
-	UByteArrayAdapter tmpData(m_data);
+	RawWordReader tmpData(m_data);
 	uint32_t mySize = size();
 	uint32_t count = 0;
 	uint32_t prev = 0;
@@ -314,7 +355,7 @@ void ItemIndexPrivateRleDE::putInto(DynamicBitSet & bitSet) const {
 }
 
 void ItemIndexPrivateRleDE::putInto(uint32_t * dest) const {
-	UByteArrayAdapter tmpData(m_data);
+	RawWordReader tmpData(m_data);
 	uint32_t * destEnd = dest + m_size;
 	uint32_t prev = 0;
 	while(dest != destEnd) {
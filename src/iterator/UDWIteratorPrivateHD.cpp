@@ -2,17 +2,40 @@
 
 namespace sserialize {
 
-UDWIteratorPrivateHD::UDWIteratorPrivateHD() {}
+UDWIteratorPrivateHD::UDWIteratorPrivateHD() :
+m_pending(0),
+m_pendingPos(0)
+{}
 
 UDWIteratorPrivateHD::UDWIteratorPrivateHD(const sserialize::MultiBitIterator & bitIterator, const RCPtrWrapper< sserialize::Static::HuffmanDecoder >& decoder) :
 m_bitIterator(bitIterator),
-m_decoder(decoder)
+m_decoder(decoder),
+m_pending(0),
+m_pendingPos(0)
 {}
 
 UDWIteratorPrivateHD::~UDWIteratorPrivateHD() {}
 
 uint32_t UDWIteratorPrivateHD::next() {
+	if (m_pending) {
+		uint32_t v = m_pending->values[m_pendingPos];
+		m_bitIterator += (uint32_t) m_pending->lengths[m_pendingPos];
+		m_pendingPos += 1;
+		if (m_pendingPos == m_pending->count) {
+			m_pending = 0;
+		}
+		return v;
+	}
 	uint32_t v = m_bitIterator.get32();
+	const Static::HuffmanDecoder::LookupEntry & e = m_decoder->lookup(v);
+	if (e.count) {
+		m_bitIterator += (uint32_t) e.lengths[0];
+		if (e.count > 1) {
+			m_pending = &e;
+			m_pendingPos = 1;
+		}
+		return e.values[0];
+	}
 	int len = m_decoder->decode(v, v);
 	if (len > 0) {
 		m_bitIterator += (uint32_t) len;
@@ -25,6 +48,7 @@ bool UDWIteratorPrivateHD::hasNext() {
 }
 
 void UDWIteratorPrivateHD::reset() {
+	m_pending = 0;
 	m_bitIterator.reset();
 }
 
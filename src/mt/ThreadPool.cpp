@@ -2,32 +2,142 @@
 #include <sserialize/utility/assert.h>
 
 namespace sserialize {
+namespace {
 
-void ThreadPool::taskWorkerFunc(uint32_t /*myThreadNumber*/) {
+thread_local const ThreadPool * currentPool = nullptr;
+thread_local uint32_t currentPoolWorker = 0;
+
+constexpr uint32_t MaxIdleRounds = 16;
+
+}//end anonymous namespace
+
+ThreadPool::ParallelForState::ParallelForState(std::size_t begin, std::size_t end, std::size_t grainSize) :
+begin(begin),
+end(end),
+grainSize(std::max<std::size_t>(grainSize, 1)),
+chunkCount((end-begin+this->grainSize-1)/this->grainSize),
+nextChunk(0),
+finishedChunks(0),
+done(false)
+{}
+
+void ThreadPool::taskWorkerFunc(uint32_t myThreadNumber) {
+	currentPool = this;
+	currentPoolWorker = myThreadNumber;
 	m_runningThreads.syncedWithNotifyAll([](uint32_t & v) { v += 1;});
+	//number of consecutive unsuccessful searches for a task
+	uint32_t idleRounds = 0;
 	while(m_online.load() == true) {
-		QueuedTaskFunction t;
+		if (runPendingTask(myThreadNumber)) {
+			idleRounds = 0;
+			continue;
+		}
+		//sleeping is expensive if tasks arrive at a high rate
+		if (idleRounds < MaxIdleRounds) {
+			++idleRounds;
+			std::this_thread::yield();
+			continue;
+		}
+		//sheduleTask increments m_queuedTasks before it checks m_sleepingThreads,
+		//we increment m_sleepingThreads before we check m_queuedTasks. Hence either we see the task or we get notified.
+		std::unique_lock<std::mutex> lck(m_sleepLck);
+		m_sleepingThreads += 1;
+		m_sleepCv.wait(lck, [this]() {
+			return !m_online.load() || m_queuedTasks.load() > 0;
+		});
+		m_sleepingThreads -= 1;
+	}
+	m_runningThreads.syncedWithNotifyAll([](uint32_t & v) { v -= 1;});
+	currentPool = nullptr;
+}
+
+bool ThreadPool::runPendingTask(uint32_t myQueue) {
+	QueuedTaskFunction t;
+	uint32_t queueCount = (uint32_t) m_queues.size();
+	//own queue is used as a stack to process recently sheduled (and likely cache-hot) tasks first
+	{
+		WorkerQueue & wq = *m_queues[myQueue];
+		std::lock_guard<std::mutex> lck(wq.lck);
+		if (wq.tasks.size()) {
+			t = std::move(wq.tasks.back());
+			wq.tasks.pop_back();
+			m_queuedTasks -= 1;
+		}
+	}
+	//steal the oldest task of some other queue
+	for(uint32_t i(1); !t && i < queueCount; ++i) {
+		WorkerQueue & wq = *m_queues[(myQueue+i)%queueCount];
+		std::lock_guard<std::mutex> lck(wq.lck);
+		if (wq.tasks.size()) {
+			t = std::move(wq.tasks.front());
+			wq.tasks.pop_front();
+			m_queuedTasks -= 1;
+		}
+	}
+	if (!t) {
+		return false;
+	}
+	t();//do the task
+	if (m_unfinishedTasks.fetch_sub(1) == 1) {
+		std::lock_guard<std::mutex> lck(m_flushLck);
+		m_flushCv.notify_all();
+	}
+	return true;
+}
+
+void ThreadPool::wakeUp() {
+	//Awake workers may be busy with long running tasks, hence a queued task always wakes up a sleeping worker.
+	//Spurious wake ups are cheap compared to a task waiting for a busy worker.
+	if (m_sleepingThreads.load() > 0 && m_queuedTasks.load() > 0) {
+		//taking the lock makes sure that the worker is either waiting or has not yet checked m_queuedTasks
 		{
-			auto qlck(m_qi.uniqueLock());
-			if (m_online.load() && m_qi.unsyncedValue().q.empty()) {
-				m_qi.wait(qlck);
-			}
-			//this is needed in case of spurious wake-ups or if the queue was shutdown while we were waiting
-			if (!m_online.load() || m_qi.unsyncedValue().q.empty()) {
-				continue;
+			std::lock_guard<std::mutex> lck(m_sleepLck);
+		}
+		m_sleepCv.notify_one();
+	}
+}
+
+uint32_t ThreadPool::currentWorker() const {
+	if (currentPool == this) {
+		return currentPoolWorker;
+	}
+	return numThreads();
+}
+
+void ThreadPool::wait(ParallelForState & state) {
+	uint32_t myQueue = currentWorker();
+	if (myQueue < numThreads()) {
+		//we may not block here since other tasks of this pool may depend on us
+		while (state.finishedChunks.load(std::memory_order_acquire) < state.chunkCount) {
+			if (!runPendingTask(myQueue)) {
+				std::this_thread::yield();
 			}
-			m_qi.unsyncedValue().runningTasks += 1;
-			t = std::move(m_qi.unsyncedValue().q.front());
-			m_qi.unsyncedValue().q.pop();
 		}
-		t();//do the task
-		m_qi.syncedWithNotifyAll([](QueueInfo & v) { v.runningTasks -= 1;});
 	}
-	m_runningThreads.syncedWithNotifyAll([](uint32_t & v) { v -= 1;});
+	else {
+		auto lck(state.done.uniqueLock());
+		while (!state.done.unsyncedValue()) {
+			state.done.wait(lck);
+		}
+	}
 }
 
 void ThreadPool::start(uint32_t count) {
 	SSERIALIZE_CHEAP_ASSERT(!m_online.load());
+	//redistribute tasks that were not executed yet
+	std::deque<QueuedTaskFunction> remaining;
+	for(std::unique_ptr<WorkerQueue> & wq : m_queues) {
+		std::move(wq->tasks.begin(), wq->tasks.end(), std::back_inserter(remaining));
+	}
+	m_queues.clear();
+	//there is always at least one queue to accept tasks
+	while (m_queues.size() < std::max<uint32_t>(count, 1)) {
+		m_queues.emplace_back(new WorkerQueue());
+	}
+	for(std::size_t i(0), s(remaining.size()); i < s; ++i) {
+		m_queues[i%m_queues.size()]->tasks.push_back(std::move(remaining[i]));
+	}
+	
 	m_online.store(true);
 	m_threads.reserve(count);
 	while (m_threads.size() < count) {
@@ -43,20 +153,30 @@ void ThreadPool::start(uint32_t count) {
 
 void ThreadPool::stop() {
 	m_online = false;
+	{
+		//workers check m_online while holding m_sleepLck
+		std::lock_guard<std::mutex> lck(m_sleepLck);
+		m_sleepCv.notify_all();
+	}
 	auto rthlck(m_runningThreads.uniqueLock());
 	while(m_runningThreads.unsyncedValue() > 0) {
-		//this is needed to ensure that worker threads are either waiting or are before their quelock
-		//if they are waiting then this will all wake them up
-		//if they are before their queue lock then m_online will already be false and they will stop execution
-		m_qi.syncedWithNotifyAll([](const QueueInfo &){});
-		m_runningThreads.wait(rthlck); //is wait atomic for unlock?
+		m_runningThreads.wait(rthlck);
 	}
+	rthlck.unlock();
 	for(std::thread & t : m_threads) {
 		t.join();
 	}
+	m_threads.clear();
 }
 
-ThreadPool::ThreadPool(uint32_t numThreads) : m_online(false), m_runningThreads(0) {
+ThreadPool::ThreadPool(uint32_t numThreads) :
+m_online(false),
+m_queuedTasks(0),
+m_unfinishedTasks(0),
+m_nextQueue(0),
+m_sleepingThreads(0),
+m_runningThreads(0)
+{
 	start(numThreads);
 }
 
@@ -65,16 +185,25 @@ ThreadPool::~ThreadPool() {
 }
 
 void ThreadPool::flushQueue() {
-	auto qlck(m_qi.uniqueLock());
-	while(m_qi.unsyncedValue().q.size() || m_qi.unsyncedValue().runningTasks > 0) {
-		m_qi.wait(qlck);
+	uint32_t myQueue = currentWorker();
+	if (myQueue < numThreads()) {
+		//we are a task ourself, help until there is nothing left to do
+		while (m_queuedTasks.load() > 0) {
+			if (!runPendingTask(myQueue)) {
+				std::this_thread::yield();
+			}
+		}
+		return;
+	}
+	std::unique_lock<std::mutex> lck(m_flushLck);
+	while (m_unfinishedTasks.load() > 0) {
+		m_flushCv.wait(lck);
 	}
-	SSERIALIZE_CHEAP_ASSERT_EQUAL((uint32_t) 0, m_qi.unsyncedValue().runningTasks);
-	SSERIALIZE_CHEAP_ASSERT_EQUAL((std::size_t) 0, m_qi.unsyncedValue().q.size());
+	SSERIALIZE_CHEAP_ASSERT_EQUAL((std::size_t) 0, m_queuedTasks.load());
 }
 
 std::size_t ThreadPool::queueSize() const {
-	return m_qi.unsyncedValue().q.size();
+	return m_queuedTasks.load();
 }
 
 void ThreadPool::numThreads(uint32_t num) {
@@ -87,9 +216,18 @@ uint32_t ThreadPool::numThreads() const {
 }
 
 bool ThreadPool::sheduleTask(QueuedTaskFunction t) {
-	m_qi.syncedWithNotifyOne([&t](QueueInfo & v) {
-		v.q.push( QueuedTaskFunction(t) );
-	});
+	uint32_t queue = currentWorker();
+	if (queue >= m_queues.size()) {
+		queue = m_nextQueue.fetch_add(1, std::memory_order_relaxed) % m_queues.size();
+	}
+	m_unfinishedTasks += 1;
+	{
+		WorkerQueue & wq = *m_queues[queue];
+		std::lock_guard<std::mutex> lck(wq.lck);
+		wq.tasks.push_back(std::move(t));
+		m_queuedTasks += 1;
+	}
+	wakeUp();
 	return true;
 }
 
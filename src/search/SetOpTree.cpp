@@ -106,6 +106,13 @@ void SetOpTree::setMinStrLen(uint32_t size) {
 	priv()->setMinStrLen(size);
 }
 
+void SetOpTree::setThreadCount(uint32_t threadCount) {
+	if (privRc() > 1) {
+		copyPrivate();
+	}
+	priv()->setThreadCount(threadCount);
+}
+
 void SetOpTree::buildTree(const std::string & queryString) {
 	if (privRc() > 1) {
 		copyPrivate();
@@ -7,6 +7,10 @@
 #include <sserialize/vendor/utf8.h>
 #include <sserialize/utility/log.h>
 #include <sserialize/containers/ItemIndexIteratorSetOp.h>
+#include <sserialize/mt/ThreadPool.h>
+#include <algorithm>
+#include <limits>
+#include <atomic>
 
 namespace sserialize {
 
@@ -141,7 +145,137 @@ bool SetOpTreePrivateComplex::parseQuery(const std::string& queryString, SetOpTr
 }
 
 
-ItemIndex SetOpTreePrivateComplex::doSetOperationsRecurse(SetOpTreePrivateComplex::Node* node) {
+uint32_t SetOpTreePrivateComplex::estimateSize(Node * node) const {
+	if (!node) {
+		return 0;
+	}
+	if (node->cached) {
+		return node->index.size();
+	}
+	switch (node->type) {
+		case (Node::COMPLETE):
+		{
+			auto it = m_completions.find(CompletionKey(node->completeString, node->cqtype));
+			return (it != m_completions.end() ? it->second.size() : 0);
+		}
+		case (Node::INTERSECT):
+			return std::min(estimateSize(node->children[0]), estimateSize(node->children[1]));
+		case (Node::UNITE):
+		case (Node::SYMMETRIC_DIFFERENCE):
+		{
+			uint64_t tmp = uint64_t(estimateSize(node->children[0])) + estimateSize(node->children[1]);
+			return (uint32_t) std::min<uint64_t>(tmp, std::numeric_limits<uint32_t>::max());
+		}
+		case (Node::DIFFERENCE):
+			return estimateSize(node->children[0]);
+		case (Node::EXTERNAL):
+		default://unknown
+			return std::numeric_limits<uint32_t>::max();
+	}
+}
+
+void SetOpTreePrivateComplex::collectOperands(Node * node, uint32_t opType, std::vector<Node*> & operands) const {
+	auto op = (opType == Node::INTERSECT ? SetOpTree::SelectableOpFilter::OP_INTERSECT : SetOpTree::SelectableOpFilter::OP_UNITE);
+	if (node->type == opType && !node->cached && !node->children[0]->efSupport(op) && !node->children[1]->efSupport(op)) {
+		collectOperands(node->children[0], opType, operands);
+		collectOperands(node->children[1], opType, operands);
+	}
+	else {
+		operands.push_back(node);
+	}
+}
+
+bool SetOpTreePrivateComplex::collectCompletions(Node * node, std::vector<CompletionKey> & dest) const {
+	if (!node || node->cached) {
+		return true;
+	}
+	if (node->type == Node::EXTERNAL || node->externalFunc) {
+		return false;
+	}
+	if (node->type == Node::COMPLETE) {
+		dest.emplace_back(node->completeString, node->cqtype);
+	}
+	bool ok = true;
+	for(Node * child : node->children) {
+		ok = collectCompletions(child, dest) && ok;
+	}
+	return ok;
+}
+
+void SetOpTreePrivateComplex::calcOperands(const std::vector<Node*> & operands, std::vector<ItemIndex> & dest, bool parallel) {
+	dest.resize(operands.size());
+	std::vector<uint32_t> parallelOperands;
+	if (parallel && m_threadCount > 1) {
+		//Completions are shared between all nodes with the same completion string
+		//ItemIndex is not thread-safe, hence only operands using distinct completions are evaluated in parallel
+		std::vector< std::vector<CompletionKey> > keys(operands.size());
+		std::vector<bool> independent(operands.size(), false);
+		std::map<CompletionKey, uint32_t> keyCount;
+		for(uint32_t i(0), s((uint32_t) operands.size()); i < s; ++i) {
+			Node * node = operands[i];
+			//leafs are cheap
+			if (!node->cached && (node->type & Node::OPERATION)) {
+				independent[i] = collectCompletions(node, keys[i]);
+			}
+			for(const CompletionKey & key : keys[i]) {
+				keyCount[key] += 1;
+			}
+		}
+		for(uint32_t i(0), s((uint32_t) operands.size()); i < s; ++i) {
+			bool ok = independent[i];
+			for(const CompletionKey & key : keys[i]) {
+				ok = ok && keyCount.at(key) == 1;
+			}
+			if (ok) {
+				parallelOperands.push_back(i);
+			}
+		}
+	}
+	if (parallelOperands.size() > 1) {
+		struct State {
+			SetOpTreePrivateComplex * that;
+			const std::vector<Node*> * operands;
+			std::vector<ItemIndex> * dest;
+			const std::vector<uint32_t> * todo;
+			std::atomic<uint32_t> i{0};
+		} state;
+		state.that = this;
+		state.operands = &operands;
+		state.dest = &dest;
+		state.todo = &parallelOperands;
+		
+		struct Worker {
+			State * state;
+			void operator()() {
+				while (true) {
+					uint32_t i = state->i.fetch_add(1, std::memory_order_relaxed);
+					if (i >= state->todo->size()) {
+						break;
+					}
+					uint32_t opPos = state->todo->at(i);
+					(*(state->dest))[opPos] = state->that->doSetOperationsRecurse(state->operands->at(opPos), false);
+				}
+			}
+			Worker(State * state) : state(state) {}
+			Worker(const Worker & other) : state(other.state) {}
+		};
+		uint32_t threadCount = std::min<uint32_t>(m_threadCount, (uint32_t) parallelOperands.size());
+		sserialize::ThreadPool::execute(Worker(&state), threadCount, sserialize::ThreadPool::CopyTaskTag());
+	}
+	else {
+		parallelOperands.clear();
+	}
+	for(uint32_t i(0), j(0), s((uint32_t) operands.size()); i < s; ++i) {
+		if (j < parallelOperands.size() && parallelOperands[j] == i) {
+			++j;
+		}
+		else {
+			dest[i] = doSetOperationsRecurse(operands[i], parallel);
+		}
+	}
+}
+
+ItemIndex SetOpTreePrivateComplex::doSetOperationsRecurse(SetOpTreePrivateComplex::Node* node, bool parallel) {
 	if (!node)
 		return ItemIndex();
 	if (node->cached)
@@ -149,17 +283,20 @@ ItemIndex SetOpTreePrivateComplex::doSetOperationsRecurse(SetOpTreePrivateComple
 	ItemIndex tmpIndex;
 	switch (node->type) {
 		case (Node::COMPLETE):
-			tmpIndex = m_completions.at( std::pair<std::string, uint8_t>(node->completeString, node->cqtype));
+			tmpIndex = m_completions.at( CompletionKey(node->completeString, node->cqtype));
 			break;
 		case (Node::DIFFERENCE):
 			if (node->children[0]->efSupport( SetOpTree::SelectableOpFilter::OP_DIFF_FIRST ) ) {
-				tmpIndex = (*(node->children[0]->externalFunc))(SetOpTree::SelectableOpFilter::OP_DIFF_FIRST, node->children[0]->completeString, doSetOperationsRecurse(node->children[1]));
+				tmpIndex = (*(node->children[0]->externalFunc))(SetOpTree::SelectableOpFilter::OP_DIFF_FIRST, node->children[0]->completeString, doSetOperationsRecurse(node->children[1], parallel));
 			}
 			else if (node->children[1]->efSupport( SetOpTree::SelectableOpFilter::OP_DIFF_SECOND) ) {
-				tmpIndex = (*(node->children[1]->externalFunc))(SetOpTree::SelectableOpFilter::OP_DIFF_SECOND, node->children[1]->completeString, doSetOperationsRecurse(node->children[0]));
+				tmpIndex = (*(node->children[1]->externalFunc))(SetOpTree::SelectableOpFilter::OP_DIFF_SECOND, node->children[1]->completeString, doSetOperationsRecurse(node->children[0], parallel));
 			}
 			else {
-				tmpIndex =  ItemIndex::difference(doSetOperationsRecurse(node->children[0]), doSetOperationsRecurse(node->children[1]));
+				tmpIndex = doSetOperationsRecurse(node->children[0], parallel);
+				if (tmpIndex.size()) {
+					tmpIndex =  ItemIndex::difference(tmpIndex, doSetOperationsRecurse(node->children[1], parallel));
+				}
 			}
 			break;
 		case (Node::EXTERNAL):
@@ -167,35 +304,69 @@ ItemIndex SetOpTreePrivateComplex::doSetOperationsRecurse(SetOpTreePrivateComple
 			break;
 		case (Node::INTERSECT):
 			if (node->children[0]->efSupport( SetOpTree::SelectableOpFilter::OP_INTERSECT ) ) {
-				tmpIndex = (*(node->children[0]->externalFunc))(SetOpTree::SelectableOpFilter::OP_INTERSECT, node->children[0]->completeString, doSetOperationsRecurse(node->children[1]));
+				tmpIndex = (*(node->children[0]->externalFunc))(SetOpTree::SelectableOpFilter::OP_INTERSECT, node->children[0]->completeString, doSetOperationsRecurse(node->children[1], parallel));
 			}
 			else if (node->children[1]->efSupport( SetOpTree::SelectableOpFilter::OP_INTERSECT) ) {
-				tmpIndex = (*(node->children[1]->externalFunc))(SetOpTree::SelectableOpFilter::OP_INTERSECT, node->children[1]->completeString, doSetOperationsRecurse(node->children[0]));
+				tmpIndex = (*(node->children[1]->externalFunc))(SetOpTree::SelectableOpFilter::OP_INTERSECT, node->children[1]->completeString, doSetOperationsRecurse(node->children[0], parallel));
 			}
 			else {
-				tmpIndex =  ItemIndex::intersect(doSetOperationsRecurse(node->children[0]), doSetOperationsRecurse(node->children[1]));
+				std::vector<Node*> operands;
+				collectOperands(node, Node::INTERSECT, operands);
+				std::vector< std::pair<uint32_t, Node*> > sortedOperands;
+				for(Node * operand : operands) {
+					sortedOperands.emplace_back(estimateSize(operand), operand);
+				}
+				std::stable_sort(sortedOperands.begin(), sortedOperands.end(),
+					[](const std::pair<uint32_t, Node*> & a, const std::pair<uint32_t, Node*> & b) { return a.first < b.first; });
+				tmpIndex = doSetOperationsRecurse(sortedOperands.front().second, parallel);
+				if (!tmpIndex.size()) {
+					break;
+				}
+				operands.clear();
+				for(auto it(sortedOperands.begin()+1), end(sortedOperands.end()); it != end; ++it) {
+					operands.push_back(it->second);
+				}
+				if (parallel && m_threadCount > 1) {
+					//the smallest operand was not empty, the remaining ones are evaluated in parallel
+					std::vector<ItemIndex> operandIdx;
+					calcOperands(operands, operandIdx, parallel);
+					for(std::size_t i(0), s(operandIdx.size()); i < s && tmpIndex.size(); ++i) {
+						tmpIndex = ItemIndex::intersect(tmpIndex, operandIdx[i]);
+					}
+				}
+				else {
+					for(std::size_t i(0), s(operands.size()); i < s && tmpIndex.size(); ++i) {
+						tmpIndex = ItemIndex::intersect(tmpIndex, doSetOperationsRecurse(operands[i], parallel));
+					}
+				}
 			}
 			break;
 		case (Node::SYMMETRIC_DIFFERENCE):
 			if (node->children[0]->efSupport( SetOpTree::SelectableOpFilter::OP_XOR ) ) {
-				tmpIndex = (*(node->children[0]->externalFunc))(SetOpTree::SelectableOpFilter::OP_XOR, node->children[0]->completeString, doSetOperationsRecurse(node->children[1]));
+				tmpIndex = (*(node->children[0]->externalFunc))(SetOpTree::SelectableOpFilter::OP_XOR, node->children[0]->completeString, doSetOperationsRecurse(node->children[1], parallel));
 			}
 			else if (node->children[1]->efSupport( SetOpTree::SelectableOpFilter::OP_XOR) ) {
-				tmpIndex = (*(node->children[1]->externalFunc))(SetOpTree::SelectableOpFilter::OP_XOR, node->children[1]->completeString, doSetOperationsRecurse(node->children[0]));
+				tmpIndex = (*(node->children[1]->externalFunc))(SetOpTree::SelectableOpFilter::OP_XOR, node->children[1]->completeString, doSetOperationsRecurse(node->children[0], parallel));
 			}
 			else {
-				tmpIndex =  ItemIndex::symmetricDifference(doSetOperationsRecurse(node->children[0]), doSetOperationsRecurse(node->children[1]));
+				std::vector<ItemIndex> operandIdx;
+				calcOperands(node->children, operandIdx, parallel);
+				tmpIndex =  ItemIndex::symmetricDifference(operandIdx[0], operandIdx[1]);
 			}
 			break;
 		case (Node::UNITE):
 			if (node->children[0]->efSupport( SetOpTree::SelectableOpFilter::OP_UNITE) ) {
-				tmpIndex = (*(node->children[0]->externalFunc))(SetOpTree::SelectableOpFilter::OP_UNITE, node->children[0]->completeString, doSetOperationsRecurse(node->children[1]));
+				tmpIndex = (*(node->children[0]->externalFunc))(SetOpTree::SelectableOpFilter::OP_UNITE, node->children[0]->completeString, doSetOperationsRecurse(node->children[1], parallel));
 			}
 			else if (node->children[1]->efSupport( SetOpTree::SelectableOpFilter::OP_UNITE) ) {
-				tmpIndex = (*(node->children[1]->externalFunc))(SetOpTree::SelectableOpFilter::OP_UNITE, node->children[1]->completeString, doSetOperationsRecurse(node->children[0]));
+				tmpIndex = (*(node->children[1]->externalFunc))(SetOpTree::SelectableOpFilter::OP_UNITE, node->children[1]->completeString, doSetOperationsRecurse(node->children[0], parallel));
 			}
 			else {
-				tmpIndex =  ItemIndex::unite(doSetOperationsRecurse(node->children[0]), doSetOperationsRecurse(node->children[1]));
+				std::vector<Node*> operands;
+				collectOperands(node, Node::UNITE, operands);
+				std::vector<ItemIndex> operandIdx;
+				calcOperands(operands, operandIdx, parallel);
+				tmpIndex =  ItemIndex::unite(operandIdx);
 			}
 			break;
 		default:
@@ -242,7 +413,7 @@ ItemIndex SetOpTreePrivateComplex::doSetOperationsRecurse(SetOpTreePrivateComple
 			}
 			break;
 		case (Node::EXTERNAL):
-			if (refTree && node->type == refTree->type && node->completeString == refTree->completeString) {
+			if (refTree && refTree->cached && node->type == refTree->type && node->completeString == refTree->completeString) {
 				diff = UDT_EQUAL;
 				tmpIndex = refTree->index;
 			}
@@ -251,7 +422,8 @@ ItemIndex SetOpTreePrivateComplex::doSetOperationsRecurse(SetOpTreePrivateComple
 			}
 			break;
 		case (Node::INTERSECT):
-			if (refTree && node->type == refTree->type) {
+			//the index of refTree is only valid if it was cached, intersections are not cached if they were part of a chain
+			if (refTree && refTree->cached && node->type == refTree->type) {
 				TreeDiffTypes lDiff = UDT_DIFFERENT;
 				TreeDiffTypes rDiff = UDT_DIFFERENT;
 				ItemIndex lIdx, rIdx;
@@ -328,13 +500,12 @@ ItemIndex SetOpTreePrivateComplex::doSetOperationsRecurse(SetOpTreePrivateComple
 	return tmpIndex;
 }
 
-//trie has to be should be cached
+//Inner nodes of intersection chains and operands skipped by the evaluation are not cached, these are computed here
 bool SetOpTreePrivateComplex::charHintsCheckChanged(Node * node, Node * child, const ItemIndex & index) {
 	ItemIndex tmpIndex = index;
 	while (node) {
 		if (! node->cached) {
-			std::cout << "Charhints uncached tree!" << std::endl;
-			return false;
+			doSetOperationsRecurse(node, false);
 		}
 		switch (node->type) {
 			case (Node::COMPLETE):
@@ -456,13 +627,15 @@ ItemIndexIterator SetOpTreePrivateComplex::createItemIndexIteratorTree(SetOpTree
 
 SetOpTreePrivateComplex::SetOpTreePrivateComplex() :
 SetOpTreePrivate(),
-m_rootNode(0)
+m_rootNode(0),
+m_threadCount(1)
 {
 }
 
 SetOpTreePrivateComplex::SetOpTreePrivateComplex(const SetOpTreePrivateComplex & other) :
 SetOpTreePrivate(),
-m_rootNode(0)
+m_rootNode(0),
+m_threadCount(other.m_threadCount)
 {
 	m_strCompleter = other.m_strCompleter;
 	m_queryString = other.m_queryString;
@@ -480,6 +653,13 @@ SetOpTreePrivateComplex::~SetOpTreePrivateComplex() {
 	clear();
 }
 
+void SetOpTreePrivateComplex::setThreadCount(uint32_t threadCount) {
+	if (threadCount == 0) {
+		threadCount = std::thread::hardware_concurrency();
+	}
+	m_threadCount = std::max<uint32_t>(threadCount, 1);
+}
+
 void SetOpTreePrivateComplex::buildTree(const std::string & queryString) {
 	if (m_rootNode) {
 		if (m_queryString == queryString) {
@@ -533,7 +713,7 @@ ItemIndex SetOpTreePrivateComplex::doSetOperations() {
 	if (!m_rootNode)
 		return ItemIndex();
 	else
-		return doSetOperationsRecurse(m_rootNode);
+		return doSetOperationsRecurse(m_rootNode, m_threadCount > 1);
 }
 
 
@@ -217,33 +217,49 @@ bool CellQueryResult::fullMatch(uint32_t pos) const {
 }
 
 CellQueryResult CellQueryResult::operator/(const sserialize::CellQueryResult& o) const {
+	return intersect(o, 1);
+}
+
+CellQueryResult CellQueryResult::operator+(const sserialize::CellQueryResult & o) const {
+	return unite(o, 1);
+}
+
+CellQueryResult CellQueryResult::operator-(const CellQueryResult & o) const {
+	return diff(o, 1);
+}
+
+CellQueryResult CellQueryResult::operator^(const CellQueryResult & o) const {
+	return symDiff(o, 1);
+}
+
+CellQueryResult CellQueryResult::intersect(const CellQueryResult & o, uint32_t threadCount) const {
 	if ((flags() | o.flags()) & FF_EMPTY) {
 		return CellQueryResult();
 	}
 	else {
-		return CellQueryResult(m_priv->intersect(o.m_priv.priv()));
+		return CellQueryResult(m_priv->intersect(o.m_priv.priv(), threadCount));
 	}
 }
 
-CellQueryResult CellQueryResult::operator+(const sserialize::CellQueryResult & o) const {
+CellQueryResult CellQueryResult::unite(const CellQueryResult & o, uint32_t threadCount) const {
 	if (flags() & FF_EMPTY) {
 		return o;
 	}
 	else {
-		return CellQueryResult(m_priv->unite(o.m_priv.priv()));
+		return CellQueryResult(m_priv->unite(o.m_priv.priv(), threadCount));
 	}
 }
 
-CellQueryResult CellQueryResult::operator-(const CellQueryResult & o) const {
+CellQueryResult CellQueryResult::diff(const CellQueryResult & o, uint32_t threadCount) const {
 	if ((flags() | o.flags()) & FF_EMPTY) {
 		return *this;
 	}
 	else {
-		return CellQueryResult(m_priv->diff(o.m_priv.priv()));
+		return CellQueryResult(m_priv->diff(o.m_priv.priv(), threadCount));
 	}
 }
 
-CellQueryResult CellQueryResult::operator^(const CellQueryResult & o) const {
+CellQueryResult CellQueryResult::symDiff(const CellQueryResult & o, uint32_t threadCount) const {
 	if (flags() & FF_EMPTY) {
 		return o;
 	}
@@ -251,7 +267,7 @@ CellQueryResult CellQueryResult::operator^(const CellQueryResult & o) const {
 		return *this;
 	}
 	else {
-		return CellQueryResult(m_priv->symDiff(o.m_priv.priv()));
+		return CellQueryResult(m_priv->symDiff(o.m_priv.priv(), threadCount));
 	}
 }
 
@@ -2,6 +2,7 @@
 #include <sserialize/containers/ItemIndexFactory.h>
 #include <sserialize/storage/UByteArrayAdapter.h>
 #include <sserialize/mt/ThreadPool.h>
+#include <exception>
 
 namespace sserialize {
 namespace detail {
@@ -236,17 +237,137 @@ uint32_t CellQueryResult::maxItems() const {
 	return tmp;
 }
 
-CellQueryResult * CellQueryResult::intersect(const CellQueryResult * oPtr) const {
-	SSERIALIZE_CHEAP_ASSERT(flagCheck(flags(), oPtr->flags()));
+CellQueryResult * CellQueryResult::intersect(const CellQueryResult * other, uint32_t threadCount) const {
+	SSERIALIZE_CHEAP_ASSERT(flagCheck(flags(), other->flags()));
+	return setOp(*other, &CellQueryResult::intersectImp, threadCount);
+}
+
+CellQueryResult * CellQueryResult::unite(const CellQueryResult * other, uint32_t threadCount) const {
+	SSERIALIZE_CHEAP_ASSERT(flagCheck(flags(), other->flags()));
+	return setOp(*other, &CellQueryResult::uniteImp, threadCount);
+}
+
+CellQueryResult * CellQueryResult::diff(const CellQueryResult * other, uint32_t threadCount) const {
+	SSERIALIZE_CHEAP_ASSERT(flagCheck(flags(), other->flags()));
+	return setOp(*other, &CellQueryResult::diffImp, threadCount);
+}
+
+CellQueryResult * CellQueryResult::symDiff(const CellQueryResult * other, uint32_t threadCount) const {
+	SSERIALIZE_CHEAP_ASSERT(flagCheck(flags(), other->flags()));
+	return setOp(*other, &CellQueryResult::symDiffImp, threadCount);
+}
+
+CellQueryResult * CellQueryResult::setOp(const CellQueryResult & o, SetOpImp op, uint32_t threadCount) const {
+	if (threadCount == 0) {
+		threadCount = std::thread::hardware_concurrency();
+	}
+	
+	uint32_t totalCells = cellCount() + o.cellCount();
+	//more parts than threads since the costs of cells differ a lot
+	uint32_t partCount = std::min<uint32_t>(4*threadCount, totalCells/MinCellsPerSetOpPart);
+	
+	if (threadCount <= 1 || partCount <= 1) {
+		CellQueryResult * rPtr = new CellQueryResult(m_ci, m_idxStore, m_flags);
+		(this->*op)(o, SetOpRange{0, cellCount(), 0, o.cellCount()}, *rPtr);
+		return rPtr;
+	}
+	
+	struct State {
+		const CellQueryResult * that;
+		const CellQueryResult * o;
+		SetOpImp op;
+		std::vector<SetOpRange> ranges;
+		std::vector<CellQueryResult*> results;
+		std::vector<std::exception_ptr> errors;
+		std::atomic<uint32_t> i{0};
+	} state;
+	state.that = this;
+	state.o = &o;
+	state.op = op;
+	
+	//split at the cell ids of equally spaced cells of the larger operand
+	{
+		auto cellIdSmaller = [](const CellDesc & cd, uint32_t cellId) { return cd.cellId < cellId; };
+		const std::vector<CellDesc> & splitSrc = (cellCount() < o.cellCount() ? o.m_desc : m_desc);
+		SetOpRange range{0, 0, 0, 0};
+		for(uint32_t p(1); p < partCount; ++p) {
+			uint32_t splitCellId = splitSrc[(uint64_t(splitSrc.size())*p)/partCount].cellId;
+			range.myEnd = (uint32_t)(std::lower_bound(m_desc.cbegin()+range.myBegin, m_desc.cend(), splitCellId, cellIdSmaller) - m_desc.cbegin());
+			range.oEnd = (uint32_t)(std::lower_bound(o.m_desc.cbegin()+range.oBegin, o.m_desc.cend(), splitCellId, cellIdSmaller) - o.m_desc.cbegin());
+			if (range.mySize() || range.oSize()) {
+				state.ranges.push_back(range);
+				range.myBegin = range.myEnd;
+				range.oBegin = range.oEnd;
+			}
+		}
+		range.myEnd = cellCount();
+		range.oEnd = o.cellCount();
+		state.ranges.push_back(range);
+	}
+	state.results.resize(state.ranges.size(), 0);
+	state.errors.resize(state.ranges.size());
+	
+	struct Worker {
+		State * state;
+		void operator()() {
+			while (true) {
+				uint32_t i = state->i.fetch_add(1, std::memory_order_relaxed);
+				if (i >= state->ranges.size()) {
+					break;
+				}
+				CellQueryResult * r = new CellQueryResult(state->that->m_ci, state->that->m_idxStore, state->that->m_flags);
+				try {
+					(state->that->*(state->op))(*(state->o), state->ranges[i], *r);
+				}
+				catch (...) {
+					state->errors[i] = std::current_exception();
+					delete r;
+					continue;
+				}
+				state->results[i] = r;
+			}
+		}
+		Worker(State * state) : state(state) {}
+		Worker(const Worker & other) : state(other.state) {}
+	};
+	
+	sserialize::ThreadPool::execute(Worker(&state), threadCount, sserialize::ThreadPool::CopyTaskTag());
+	
+	for(const std::exception_ptr & e : state.errors) {
+		if (e) {
+			for(CellQueryResult * part : state.results) {
+				delete part;
+			}
+			std::rethrow_exception(e);
+		}
+	}
 	
-	const CellQueryResult & o = *oPtr;
+	//stitch the parts together, ItemIndex is trivially relocatable, hence the parts are moved with memcpy
+	std::size_t resultSize = 0;
+	for(CellQueryResult * part : state.results) {
+		resultSize += part->m_desc.size();
+	}
 	CellQueryResult * rPtr = new CellQueryResult(m_ci, m_idxStore, m_flags);
 	CellQueryResult & r = *rPtr;
-	r.m_desc.reserve(std::min<std::size_t>(m_desc.size(), o.m_desc.size()));
-	r.m_idx = (IndexDesc*) malloc(sizeof(IndexDesc) * std::min<std::size_t>(m_desc.size(), o.m_desc.size()));
+	r.m_desc.reserve(resultSize);
+	r.m_idx = (IndexDesc*) ::malloc(sizeof(IndexDesc) * resultSize);
+	for(CellQueryResult * part : state.results) {
+		::memcpy((void*)(r.m_idx + r.m_desc.size()), (void*)part->m_idx, sizeof(IndexDesc) * part->m_desc.size());
+		r.m_desc.insert(r.m_desc.end(), part->m_desc.cbegin(), part->m_desc.cend());
+		//the indexes are owned by r now
+		part->m_desc.clear();
+		delete part;
+	}
+	SSERIALIZE_EXPENSIVE_ASSERT(r.selfCheck());
+	return rPtr;
+}
+
+void CellQueryResult::intersectImp(const CellQueryResult & o, const SetOpRange & range, CellQueryResult & r) const {
+	r.m_desc.reserve(std::min<std::size_t>(range.mySize(), range.oSize()));
+	r.m_idx = (IndexDesc*) malloc(sizeof(IndexDesc) * std::min<std::size_t>(range.mySize(), range.oSize()));
 	
 
-	for(uint32_t myI(0), myEnd((uint32_t)m_desc.size()), oI(0), oEnd((uint32_t)o.m_desc.size()); myI < myEnd && oI < oEnd;) {
+	for(uint32_t myI(range.myBegin), myEnd(range.myEnd), oI(range.oBegin), oEnd(range.oEnd); myI < myEnd && oI < oEnd;) {
 		const CellDesc & myCD = m_desc[myI];
 		const CellDesc & oCD = o.m_desc[oI];
 		uint32_t myCellId = myCD.cellId;
@@ -314,18 +435,13 @@ CellQueryResult * CellQueryResult::intersect(const CellQueryResult * oPtr) const
 		++myI;
 		++oI;
 	}
-	return rPtr;
 }
 
-CellQueryResult * CellQueryResult::unite(const CellQueryResult * other) const {
-	SSERIALIZE_CHEAP_ASSERT(flagCheck(flags(), other->flags()));
-	const CellQueryResult & o = *other;
-	CellQueryResult * rPtr = new CellQueryResult(m_ci, m_idxStore, m_flags);
-	CellQueryResult & r = *rPtr;
-	r.m_desc.reserve(m_desc.size() + o.m_desc.size());
-	r.m_idx = (IndexDesc*) malloc(sizeof(IndexDesc) * (m_desc.size() + o.m_desc.size()));
+void CellQueryResult::uniteImp(const CellQueryResult & o, const SetOpRange & range, CellQueryResult & r) const {
+	r.m_desc.reserve(range.mySize() + range.oSize());
+	r.m_idx = (IndexDesc*) malloc(sizeof(IndexDesc) * (range.mySize() + range.oSize()));
 	
-	uint32_t myI(0), myEnd((uint32_t)m_desc.size()), oI(0), oEnd((uint32_t)o.m_desc.size());
+	uint32_t myI(range.myBegin), myEnd(range.myEnd), oI(range.oBegin), oEnd(range.oEnd);
 	for(; myI < myEnd && oI < oEnd;) {
 		const CellDesc & myCD = m_desc[myI];
 		const CellDesc & oCD = o.m_desc[oI];
@@ -438,20 +554,15 @@ CellQueryResult * CellQueryResult::unite(const CellQueryResult * other) const {
 		r.m_desc.push_back(oCD);
 		++oI;
 	}
-	SSERIALIZE_CHEAP_ASSERT_LARGER_OR_EQUAL(r.m_desc.size(), std::max<std::size_t>(m_desc.size(), o.m_desc.size()));
-	return rPtr;
+	SSERIALIZE_CHEAP_ASSERT_LARGER_OR_EQUAL(r.m_desc.size(), std::max<std::size_t>(range.mySize(), range.oSize()));
 }
 
-CellQueryResult * CellQueryResult::diff(const CellQueryResult * other) const {
-	SSERIALIZE_CHEAP_ASSERT(flagCheck(flags(), other->flags()));
-	const CellQueryResult & o = *other;
-	CellQueryResult * rPtr = new CellQueryResult(m_ci, m_idxStore, m_flags);
-	CellQueryResult & r = *rPtr;
-	r.m_desc.reserve(m_desc.size());
-	r.m_idx = (IndexDesc*) malloc(sizeof(IndexDesc) * m_desc.size());
+void CellQueryResult::diffImp(const CellQueryResult & o, const SetOpRange & range, CellQueryResult & r) const {
+	r.m_desc.reserve(range.mySize());
+	r.m_idx = (IndexDesc*) malloc(sizeof(IndexDesc) * range.mySize());
 	
-	uint32_t myI(0), myEnd((uint32_t) m_desc.size());
-	for(uint32_t oI(0), oEnd((uint32_t)o.m_desc.size()); myI < myEnd && oI < oEnd;) {
+	uint32_t myI(range.myBegin), myEnd(range.myEnd);
+	for(uint32_t oI(range.oBegin), oEnd(range.oEnd); myI < myEnd && oI < oEnd;) {
 		const CellDesc & myCD = m_desc[myI];
 		const CellDesc & oCD = o.m_desc[oI];
 		uint32_t myCellId = myCD.cellId;
@@ -471,7 +582,8 @@ CellQueryResult * CellQueryResult::diff(const CellQueryResult * other) const {
 			++oI;
 			continue;
 		}
-		if (!oCD.fullMatch && (myCD.fetched || oCD.fetched || m_idx[myI].idxPtr != o.m_idx[oI].idxPtr)) {
+		//idxPtr is only valid for partial matches that are not fetched
+		if (!oCD.fullMatch && (myCD.fullMatch || myCD.fetched || oCD.fetched || m_idx[myI].idxPtr != o.m_idx[oI].idxPtr)) {
 			const sserialize::ItemIndex & myPIdx = idx(myI);
 			const sserialize::ItemIndex & oPIdx = o.idx(oI);
 			sserialize::ItemIndex res(myPIdx - oPIdx);
@@ -496,19 +608,14 @@ CellQueryResult * CellQueryResult::diff(const CellQueryResult * other) const {
 		++myI;
 		continue;
 	}
-	SSERIALIZE_CHEAP_ASSERT_SMALLER_OR_EQUAL(r.m_desc.size(), m_desc.size());
-	return rPtr;
+	SSERIALIZE_CHEAP_ASSERT_SMALLER_OR_EQUAL(r.m_desc.size(), range.mySize());
 }
 
-CellQueryResult * CellQueryResult::symDiff(const CellQueryResult * other) const {
-	SSERIALIZE_CHEAP_ASSERT(flagCheck(flags(), other->flags()));
-	const CellQueryResult & o = *other;
-	CellQueryResult * rPtr = new CellQueryResult(m_ci, m_idxStore, m_flags);
-	CellQueryResult & r = *rPtr;
-	r.m_desc.reserve(m_desc.size() + o.m_desc.size());
-	r.m_idx = (IndexDesc*) malloc(sizeof(IndexDesc) * (m_desc.size() + o.m_desc.size()));
+void CellQueryResult::symDiffImp(const CellQueryResult & o, const SetOpRange & range, CellQueryResult & r) const {
+	r.m_desc.reserve(range.mySize() + range.oSize());
+	r.m_idx = (IndexDesc*) malloc(sizeof(IndexDesc) * (range.mySize() + range.oSize()));
 	
-	uint32_t myI(0), myEnd((uint32_t)m_desc.size()), oI(0), oEnd((uint32_t)o.m_desc.size());
+	uint32_t myI(range.myBegin), myEnd(range.myEnd), oI(range.oBegin), oEnd(range.oEnd);
 	for(; myI < myEnd && oI < oEnd;) {
 		const CellDesc & myCD = m_desc[myI];
 		const CellDesc & oCD = o.m_desc[oI];
@@ -539,7 +646,8 @@ CellQueryResult * CellQueryResult::symDiff(const CellQueryResult * other) const
 			continue;
 		}
 		int ct = (myCD.fullMatch << 1) | oCD.fullMatch;
-		if (ct != 0x3 && (myCD.fetched || oCD.fetched || m_idx[myI].idxPtr != o.m_idx[oI].idxPtr)) {
+		//idxPtr is only valid for partial matches that are not fetched
+		if (ct != 0x3 && (ct != 0x0 || myCD.fetched || oCD.fetched || m_idx[myI].idxPtr != o.m_idx[oI].idxPtr)) {
 			const sserialize::ItemIndex & myPIdx = idx(myI);
 			const sserialize::ItemIndex & oPIdx = o.idx(oI);
 			sserialize::ItemIndex res(myPIdx ^ oPIdx);
@@ -577,8 +685,7 @@ CellQueryResult * CellQueryResult::symDiff(const CellQueryResult * other) const
 		++oI;
 		continue;
 	}
-	SSERIALIZE_CHEAP_ASSERT_SMALLER_OR_EQUAL(r.m_desc.size(), (m_desc.size() + o.m_desc.size()));
-	return rPtr;
+	SSERIALIZE_CHEAP_ASSERT_SMALLER_OR_EQUAL(r.m_desc.size(), (range.mySize() + range.oSize()));
 }
 
 CellQueryResult * CellQueryResult::allToFull() const {
@@ -0,0 +1,286 @@
+#include <sserialize/spatial/GeoPolygonEdgeIndex.h>
+#include <sserialize/storage/pack_unpack_functions.h>
+#include <sserialize/utility/exceptions.h>
+#include <algorithm>
+#include <cmath>
+
+namespace sserialize {
+namespace spatial {
+namespace {
+
+///Maps v in [min, max] to [0, count), monotone in v, values outside of [min, max] are clamped
+inline uint32_t toCell(double v, double min, double max, uint32_t count) {
+	double extent = max - min;
+	if (!(extent > 0) || count <= 1) {
+		return 0;
+	}
+	double c = (v - min) / extent * count;
+	if (!(c > 0)) {
+		return 0;
+	}
+	if (c >= count) {
+		return count-1;
+	}
+	return (uint32_t) c;
+}
+
+} //end namespace
+
+GeoPolygonEdgeIndex::GeoPolygonEdgeIndex() :
+m_slabCount(0),
+m_latCells(0),
+m_lonCells(0)
+{}
+
+GeoPolygonEdgeIndex::GeoPolygonEdgeIndex(const UByteArrayAdapter & d) :
+GeoPolygonEdgeIndex()
+{
+	UByteArrayAdapter data(d);
+	data.resetGetPtr();
+	SSERIALIZE_VERSION_MISSMATCH_CHECK(Version, data.getUint8(), "sserialize::spatial::GeoPolygonEdgeIndex");
+	double minLat = data.getDouble();
+	double maxLat = data.getDouble();
+	double minLon = data.getDouble();
+	double maxLon = data.getDouble();
+	m_boundary = GeoRect(minLat, maxLat, minLon, maxLon);
+	uint32_t pointCount = data.getVlPackedUint32();
+	m_slabCount = data.getVlPackedUint32();
+	m_latCells = data.getVlPackedUint32();
+	m_lonCells = data.getVlPackedUint32();
+	if (data.tellGetPtr() + UByteArrayAdapter::OffsetType(pointCount)*2*sizeof(double) + UByteArrayAdapter::OffsetType(m_latCells)*m_lonCells > data.size()) {
+		throw sserialize::CorruptDataException("sserialize::spatial::GeoPolygonEdgeIndex: data too small");
+	}
+	m_lat.resize(pointCount);
+	m_lon.resize(pointCount);
+	for(double & x : m_lat) {
+		x = data.getDouble();
+	}
+	for(double & x : m_lon) {
+		x = data.getDouble();
+	}
+	if (m_slabCount) {
+		m_slabBegin.resize(m_slabCount+1);
+		for(uint32_t & x : m_slabBegin) {
+			x = data.getVlPackedUint32();
+		}
+		m_slabEdges.resize(m_slabBegin.back());
+		for(uint32_t & x : m_slabEdges) {
+			x = data.getVlPackedUint32();
+			if (!x || x >= pointCount) {
+				throw sserialize::CorruptDataException("sserialize::spatial::GeoPolygonEdgeIndex: invalid edge");
+			}
+		}
+	}
+	m_cells.resize(std::size_t(m_latCells)*m_lonCells);
+	data.getData(m_cells.data(), m_cells.size());
+}
+
+GeoPolygonEdgeIndex::~GeoPolygonEdgeIndex() {}
+
+GeoPolygonEdgeIndex::CellState GeoPolygonEdgeIndex::cellState(uint32_t latCell, uint32_t lonCell) const {
+	return (CellState) m_cells.at(std::size_t(lonCell)*m_latCells + latCell);
+}
+
+uint32_t GeoPolygonEdgeIndex::boundaryCellCount() const {
+	return (uint32_t) std::count(m_cells.begin(), m_cells.end(), CS_BOUNDARY);
+}
+
+UByteArrayAdapter::OffsetType GeoPolygonEdgeIndex::getSizeInBytes() const {
+	UByteArrayAdapter::OffsetType s = 1 + 4*sizeof(double);
+	s += psize_vu32(size()) + psize_vu32(m_slabCount) + psize_vu32(m_latCells) + psize_vu32(m_lonCells);
+	s += UByteArrayAdapter::OffsetType(size())*2*sizeof(double);
+	for(uint32_t x : m_slabBegin) {
+		s += psize_vu32(x);
+	}
+	for(uint32_t x : m_slabEdges) {
+		s += psize_vu32(x);
+	}
+	s += m_cells.size();
+	return s;
+}
+
+bool GeoPolygonEdgeIndex::contains(const GeoPoint & p) const {
+	return contains(p.lat(), p.lon());
+}
+
+bool GeoPolygonEdgeIndex::contains(double lat, double lon) const {
+	if (!m_slabCount || !m_boundary.contains(lat, lon)) {
+		return false;
+	}
+	switch (m_cells[std::size_t(lonCell(lon))*m_latCells + latCell(lat)]) {
+	case CS_INSIDE:
+		return true;
+	case CS_OUTSIDE:
+		return false;
+	default:
+		return slabContains(lat, lon);
+	}
+}
+
+UByteArrayAdapter & GeoPolygonEdgeIndex::append(UByteArrayAdapter & dest) const {
+	dest.putUint8(Version);
+	dest.putDouble(m_boundary.minLat());
+	dest.putDouble(m_boundary.maxLat());
+	dest.putDouble(m_boundary.minLon());
+	dest.putDouble(m_boundary.maxLon());
+	dest.putVlPackedUint32(size());
+	dest.putVlPackedUint32(m_slabCount);
+	dest.putVlPackedUint32(m_latCells);
+	dest.putVlPackedUint32(m_lonCells);
+	for(double x : m_lat) {
+		dest.putDouble(x);
+	}
+	for(double x : m_lon) {
+		dest.putDouble(x);
+	}
+	for(uint32_t x : m_slabBegin) {
+		dest.putVlPackedUint32(x);
+	}
+	for(uint32_t x : m_slabEdges) {
+		dest.putVlPackedUint32(x);
+	}
+	dest.putData(m_cells);
+	return dest;
+}
+
+uint32_t GeoPolygonEdgeIndex::slab(double lon) const {
+	return toCell(lon, m_boundary.minLon(), m_boundary.maxLon(), m_slabCount);
+}
+
+uint32_t GeoPolygonEdgeIndex::latCell(double lat) const {
+	return toCell(lat, m_boundary.minLat(), m_boundary.maxLat(), m_latCells);
+}
+
+uint32_t GeoPolygonEdgeIndex::lonCell(double lon) const {
+	return toCell(lon, m_boundary.minLon(), m_boundary.maxLon(), m_lonCells);
+}
+
+bool GeoPolygonEdgeIndex::slabContains(double lat, double lon) const {
+	uint32_t s = slab(lon);
+	const double * vlat = m_lat.data();
+	const double * vlon = m_lon.data();
+	bool c = false;
+	for(auto it(m_slabEdges.begin()+m_slabBegin[s]), end(m_slabEdges.begin()+m_slabBegin[s+1]); it != end; ++it) {
+		uint32_t i = *it;
+		uint32_t j = i-1;
+		if (vlat[i] == lat && vlon[i] == lon) {
+			return false;
+		}
+		if (((vlon[i] > lon) != (vlon[j] > lon)) && (lat < (vlat[j]-vlat[i]) * (lon-vlon[i]) / (vlon[j]-vlon[i]) + vlat[i])) {
+			c = !c;
+		}
+	}
+	return c;
+}
+
+void GeoPolygonEdgeIndex::build(uint32_t slabCount, uint32_t rasterSize) {
+	uint32_t n = size();
+	if (n < 2) {
+		return;
+	}
+	if (!rasterSize) {
+		rasterSize = std::clamp<uint32_t>((uint32_t) std::ceil(2*std::sqrt(double(n))), 1, 1024);
+	}
+	m_latCells = rasterSize;
+	m_lonCells = rasterSize;
+	if (slabCount) {
+		m_slabCount = slabCount;
+	}
+	else {
+		//edges spanning many slabs make the index large, use fewer slabs in this case
+		m_slabCount = std::clamp<uint32_t>(n/2, 1, 1 << 16);
+		while (m_slabCount > 1) {
+			uint64_t entries = 0;
+			for(uint32_t i(1); i < n; ++i) {
+				entries += slab(std::max(m_lon[i-1], m_lon[i])) - slab(std::min(m_lon[i-1], m_lon[i])) + 1;
+			}
+			if (entries <= uint64_t(16)*n) {
+				break;
+			}
+			m_slabCount /= 2;
+		}
+	}
+
+	//slabs: every edge is stored in all slabs its longitude range overlaps
+	//slab() is monotone, hence all points of an edge end up in these slabs
+	m_slabBegin.assign(m_slabCount+1, 0);
+	for(uint32_t i(1); i < n; ++i) {
+		uint32_t first = slab(std::min(m_lon[i-1], m_lon[i]));
+		uint32_t last = slab(std::max(m_lon[i-1], m_lon[i]));
+		for(uint32_t s(first); s <= last; ++s) {
+			m_slabBegin[s+1] += 1;
+		}
+	}
+	for(uint32_t s(0); s < m_slabCount; ++s) {
+		m_slabBegin[s+1] += m_slabBegin[s];
+	}
+	m_slabEdges.resize(m_slabBegin.back());
+	std::vector<uint32_t> slabPos(m_slabBegin.begin(), m_slabBegin.end()-1);
+	for(uint32_t i(1); i < n; ++i) {
+		uint32_t first = slab(std::min(m_lon[i-1], m_lon[i]));
+		uint32_t last = slab(std::max(m_lon[i-1], m_lon[i]));
+		for(uint32_t s(first); s <= last; ++s) {
+			m_slabEdges[slabPos[s]++] = i;
+		}
+	}
+
+	//raster: mark all cells an edge passes through as boundary cells
+	//cells are widened by eps to be on the safe side with respect to rounding errors of the crossing test
+	const double minLat = m_boundary.minLat();
+	const double minLon = m_boundary.minLon();
+	const double latExtent = m_boundary.maxLat() - minLat;
+	const double lonExtent = m_boundary.maxLon() - minLon;
+	const double latEps = 1e-9 * (1 + latExtent);
+	const double lonEps = 1e-9 * (1 + lonExtent);
+	const double cellLat = latExtent / m_latCells;
+	const double cellLon = lonExtent / m_lonCells;
+	m_cells.assign(std::size_t(m_latCells)*m_lonCells, CS_OUTSIDE);
+	for(uint32_t i(1); i < n; ++i) {
+		double lat0 = m_lat[i-1], lon0 = m_lon[i-1];
+		double lat1 = m_lat[i], lon1 = m_lon[i];
+		if (lon0 > lon1) {
+			std::swap(lat0, lat1);
+			std::swap(lon0, lon1);
+		}
+		uint32_t firstRow = lonCell(lon0 - lonEps);
+		uint32_t lastRow = lonCell(lon1 + lonEps);
+		for(uint32_t row(firstRow); row <= lastRow; ++row) {
+			double segLat0 = lat0, segLat1 = lat1;
+			if (lon1 > lon0) {
+				double rowLon0 = std::max(lon0, minLon + row*cellLon - lonEps);
+				double rowLon1 = std::min(lon1, minLon + (row+1)*cellLon + lonEps);
+				if (rowLon0 > rowLon1) {
+					continue;
+				}
+				segLat0 = lat0 + (lat1-lat0) * ((rowLon0-lon0) / (lon1-lon0));
+				segLat1 = lat0 + (lat1-lat0) * ((rowLon1-lon0) / (lon1-lon0));
+			}
+			uint32_t firstCell = latCell(std::min(segLat0, segLat1) - latEps);
+			uint32_t lastCell = latCell(std::max(segLat0, segLat1) + latEps);
+			std::fill(m_cells.begin() + std::size_t(row)*m_latCells + firstCell, m_cells.begin() + std::size_t(row)*m_latCells + lastCell + 1, CS_BOUNDARY);
+		}
+	}
+
+	//no edge crosses a run of non-boundary cells within a row, so one crossing test decides the whole run
+	for(uint32_t row(0); row < m_lonCells; ++row) {
+		uint8_t * cells = m_cells.data() + std::size_t(row)*m_latCells;
+		for(uint32_t begin(0); begin < m_latCells;) {
+			if (cells[begin] == CS_BOUNDARY) {
+				++begin;
+				continue;
+			}
+			uint32_t end = begin+1;
+			for(; end < m_latCells && cells[end] != CS_BOUNDARY; ++end) {}
+			double lat = minLat + (begin+0.5)*cellLat;
+			double lon = minLon + (row+0.5)*cellLon;
+			uint8_t state = CS_BOUNDARY;
+			if (latCell(lat) == begin && lonCell(lon) == row) {
+				state = (slabContains(lat, lon) ? CS_INSIDE : CS_OUTSIDE);
+			}
+			std::fill(cells+begin, cells+end, state);
+			begin = end;
+		}
+	}
+}
+
+}}//end namespace sserialize::spatial
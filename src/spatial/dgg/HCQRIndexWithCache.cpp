@@ -2,23 +2,57 @@
 
 namespace sserialize::spatial::dgg {
 
-HCQRIndexWithCache::HCQRIndexWithCache(HCQRIndexPtr const & base, uint32_t cacheSize) :
-m_base(base)
-{
-	setCacheSize(cacheSize);
-}
+HCQRIndexWithCache::HCQRIndexWithCache(HCQRIndexPtr const & base, uint32_t cacheSize, std::size_t cacheByteSize) :
+m_base(base),
+m_cache(cacheSize, cacheByteSize)
+{}
 
 HCQRIndexWithCache::~HCQRIndexWithCache() {}
 
 HCQRIndexWithCache::HCQRIndexPtr
-HCQRIndexWithCache::make(HCQRIndexPtr const & base, uint32_t cacheSize) {
-	return HCQRIndexPtr( new HCQRIndexWithCache(base, cacheSize) );
+HCQRIndexWithCache::make(HCQRIndexPtr const & base, uint32_t cacheSize, std::size_t cacheByteSize) {
+	return HCQRIndexPtr( new HCQRIndexWithCache(base, cacheSize, cacheByteSize) );
 }
 
 void
 HCQRIndexWithCache::setCacheSize(uint32_t size) {
-    std::lock_guard<std::mutex> lck(m_cacheLock);
-    m_cache.setSize(size);
+    m_cache.setCapacity(size, m_cache.maxCost());
+}
+
+void
+HCQRIndexWithCache::setCacheByteSize(std::size_t size) {
+    m_cache.setCapacity(m_cache.maxEntries(), size);
+}
+
+HCQRIndexWithCache::CacheStats
+HCQRIndexWithCache::cacheStats() const {
+    return m_cache.stats();
+}
+
+void
+HCQRIndexWithCache::resetCacheStats() {
+    m_cache.resetStats();
+}
+
+void
+HCQRIndexWithCache::clearCache() {
+    m_cache.clear();
+}
+
+template<typename T_FUNC>
+HCQRIndexWithCache::HCQRPtr
+HCQRIndexWithCache::cached(CacheKey const & ck, T_FUNC func) const {
+    HCQRPtr result;
+    if (m_cache.find(ck, result)) {
+        return result;
+    }
+    result = func();
+    std::size_t byteSize = ResultBaseSize;
+    if (result) {
+        byteSize += std::size_t(result->numberOfNodes())*NodeSize;
+    }
+    m_cache.insert(ck, result, byteSize);
+    return result;
 }
 
 sserialize::StringCompleter::SupportedQuerries
@@ -28,63 +62,28 @@ HCQRIndexWithCache::getSupportedQueries() const {
 
 HCQRIndexWithCache::HCQRPtr
 HCQRIndexWithCache::complete(const std::string & qstr, const sserialize::StringCompleter::QuerryType qt) const {
-    CacheKey ck(CacheKey::ITEMS_AND_REGIONS, qt, qstr);
-    std::lock_guard<std::mutex> lck(m_cacheLock);
-    if (m_cache.count(ck)) {
-        return m_cache.find(ck);
-    }
-    auto result = m_base->complete(qstr, qt);
-    m_cache.insert(ck, result);
-    return result;
+    return cached(CacheKey(CacheKey::ITEMS_AND_REGIONS, qt, qstr), [&]() { return m_base->complete(qstr, qt); });
 }
 
 HCQRIndexWithCache::HCQRPtr
 HCQRIndexWithCache::items(const std::string & qstr, const sserialize::StringCompleter::QuerryType qt) const {
-    CacheKey ck(CacheKey::ITEMS, qt, qstr);
-    std::lock_guard<std::mutex> lck(m_cacheLock);
-    if (m_cache.count(ck)) {
-        return m_cache.find(ck);
-    }
-    auto result = m_base->items(qstr, qt);
-    m_cache.insert(ck, result);
-    return result;
+    return cached(CacheKey(CacheKey::ITEMS, qt, qstr), [&]() { return m_base->items(qstr, qt); });
 }
 
 HCQRIndexWithCache::HCQRPtr
 HCQRIndexWithCache::regions(const std::string & qstr, const sserialize::StringCompleter::QuerryType qt) const {
-    CacheKey ck(CacheKey::REGIONS, qt, qstr);
-    std::lock_guard<std::mutex> lck(m_cacheLock);
-    if (m_cache.count(ck)) {
-        return m_cache.find(ck);
-    }
-    auto result = m_base->regions(qstr, qt);
-    m_cache.insert(ck, result);
-    return result;
+    return cached(CacheKey(CacheKey::REGIONS, qt, qstr), [&]() { return m_base->regions(qstr, qt); });
 }
 
 
 HCQRIndexWithCache::HCQRPtr
 HCQRIndexWithCache::cell(uint32_t cellId) const {
-    CacheKey ck(CacheKey::CELL, 0, std::to_string(cellId));
-    std::lock_guard<std::mutex> lck(m_cacheLock);
-    if (m_cache.count(ck)) {
-        return m_cache.find(ck);
-    }
-    auto result = m_base->cell(cellId);
-    m_cache.insert(ck, result);
-    return result;
+    return cached(CacheKey(CacheKey::CELL, 0, std::to_string(cellId)), [&]() { return m_base->cell(cellId); });
 }
 
 HCQRIndexWithCache::HCQRPtr
 HCQRIndexWithCache::region(uint32_t regionId) const {
-    CacheKey ck(CacheKey::REGION, 0, std::to_string(regionId));
-    std::lock_guard<std::mutex> lck(m_cacheLock);
-    if (m_cache.count(ck)) {
-        return m_cache.find(ck);
-    }
-    auto result = m_base->region(regionId);
-    m_cache.insert(ck, result);
-    return result;
+    return cached(CacheKey(CacheKey::REGION, 0, std::to_string(regionId)), [&]() { return m_base->region(regionId); });
 }
 
 HCQRIndexWithCache::SpatialGridInfo const &
@@ -4,8 +4,11 @@
 #include <sserialize/utility/debuggerfunctions.h>
 #include <sserialize/containers/ItemIndexFactory.h>
 #include <sserialize/spatial/CellQueryResult.h>
+#include <sserialize/mt/ThreadPool.h>
 
 #include <memory>
+#include <numeric>
+#include <exception>
 
 namespace sserialize::spatial::dgg::impl::detail::HCQRSpatialGrid {
 
@@ -15,35 +18,35 @@ m_f(flags),
 m_itemIndexId(itemIndexId)
 {}
 
-std::unique_ptr<TreeNode>
-TreeNode::make_unique(PixelId pixelId, int flags, uint32_t itemIndexId) {
+TreeNode *
+TreeNode::make(TreeNodeArena & arena, PixelId pixelId, int flags, uint32_t itemIndexId) {
 	SSERIALIZE_CHEAP_ASSERT(flags == IS_INTERNAL || itemIndexId != std::numeric_limits<uint32_t>::max() || flags == IS_FULL_MATCH);
-	return std::unique_ptr<TreeNode>( new TreeNode(pixelId, flags, itemIndexId) );
+	return arena.make(pixelId, flags, itemIndexId);
 }
 
-std::unique_ptr<TreeNode>
-TreeNode::shallowCopy() const {
+TreeNode *
+TreeNode::shallowCopy(TreeNodeArena & arena) const {
     SSERIALIZE_CHEAP_ASSERT(!isFetched());
-    return TreeNode::make_unique(pixelId(), m_f, m_itemIndexId);
+    return TreeNode::make(arena, pixelId(), m_f, m_itemIndexId);
 }
 
-std::unique_ptr<TreeNode>
-TreeNode::shallowCopy(uint32_t fetchedItemIndexId) const {
+TreeNode *
+TreeNode::shallowCopy(TreeNodeArena & arena, uint32_t fetchedItemIndexId) const {
     SSERIALIZE_CHEAP_ASSERT(isFetched());
-    return TreeNode::make_unique(pixelId(), m_f, fetchedItemIndexId);
+    return TreeNode::make(arena, pixelId(), m_f, fetchedItemIndexId);
 }
 
-std::unique_ptr<TreeNode>
-TreeNode::shallowCopy(Children && newChildren) const {
+TreeNode *
+TreeNode::shallowCopy(TreeNodeArena & arena, Children && newChildren) const {
     SSERIALIZE_CHEAP_ASSERT(isInternal())
-    auto result = TreeNode::make_unique(pixelId(), m_f);
+    auto result = TreeNode::make(arena, pixelId(), m_f);
     result->children() = std::move(newChildren);
     return result;
 }
 
 void TreeNode::sortChildren() {
 	sort(children().begin(), children().end(),
-		[](std::unique_ptr<TreeNode> const & a, std::unique_ptr<TreeNode> const & b) -> bool {
+		[](TreeNode const * a, TreeNode const * b) -> bool {
 			return a->pixelId() < b->pixelId();
 		}
 	);
@@ -53,6 +56,64 @@ bool TreeNode::valid() const {
 	return (flags() == IS_INTERNAL && children().size()) || (flags() == IS_FULL_MATCH && itemIndexId() == npos) || (flags() == IS_FETCHED && itemIndexId() != npos) || (flags() == IS_PARTIAL_MATCH && itemIndexId() != npos);
 }
 
+TreeNodeArena::~TreeNodeArena() {
+	clear();
+}
+
+TreeNodeArena &
+TreeNodeArena::operator=(TreeNodeArena && other) {
+	if (this != &other) {
+		clear();
+		m_blocks = std::move(other.m_blocks);
+		other.m_blocks.clear();
+	}
+	return *this;
+}
+
+TreeNode *
+TreeNodeArena::make(PixelId pixelId, int flags, uint32_t itemIndexId) {
+	if (!m_blocks.size() || m_blocks.back().size == m_blocks.back().capacity) {
+		std::size_t capacity = m_blocks.size() ? std::min(2*m_blocks.back().capacity, MaxBlockSize) : MinBlockSize;
+		m_blocks.push_back(Block{std::unique_ptr<NodeStorage[]>(new NodeStorage[capacity]), capacity, 0});
+	}
+	Block & block = m_blocks.back();
+	TreeNode * node = new (block.nodes[block.size].data) TreeNode(pixelId, flags, itemIndexId);
+	block.size += 1;
+	return node;
+}
+
+void
+TreeNodeArena::splice(TreeNodeArena && other) {
+	if (!m_blocks.size()) {
+		m_blocks = std::move(other.m_blocks);
+	}
+	else {
+		for(Block & block : other.m_blocks) {
+			m_blocks.push_back(std::move(block));
+		}
+	}
+	other.m_blocks.clear();
+}
+
+std::size_t
+TreeNodeArena::size() const {
+	std::size_t result = 0;
+	for(Block const & block : m_blocks) {
+		result += block.size;
+	}
+	return result;
+}
+
+void
+TreeNodeArena::clear() {
+	for(Block & block : m_blocks) {
+		for(std::size_t i(0); i < block.size; ++i) {
+			std::destroy_at(std::launder(reinterpret_cast<TreeNode*>(block.nodes[i].data)));
+		}
+	}
+	m_blocks.clear();
+}
+
 }//end namespace sserialize::spatial::dgg::impl::detail::HCQRSpatialGrid
 
 namespace sserialize::spatial::dgg::impl {
@@ -74,32 +135,32 @@ HCQRSpatialGrid::HCQRSpatialGrid(
 ) :
 HCQRSpatialGrid(idxStore, sg, sgi)
 {
-    std::unordered_map<PixelId, std::unique_ptr<TreeNode>> clevel;
+    std::unordered_map<PixelId, TreeNodePtr> clevel;
     clevel.reserve(cqr.cellCount());
     for(auto it(cqr.begin()), end(cqr.end()); it != end; ++it) {
 		if (it.fullMatch()) {
 			PixelId pId = this->sgi().pixelId( CompressedPixelId(it.cellId()) );
-			clevel[pId] = TreeNode::make_unique(pId, TreeNode::IS_FULL_MATCH);
+			clevel[pId] = makeNode(pId, TreeNode::IS_FULL_MATCH);
 		}
 		else if (it.fetched()) {
 			PixelId pId = this->sgi().pixelId( CompressedPixelId(it.cellId()) );
 			m_fetchedItems.push_back( it.idx() );
-			clevel[pId] = TreeNode::make_unique(pId, TreeNode::IS_FETCHED, m_fetchedItems.size());
+			clevel[pId] = makeNode(pId, TreeNode::IS_FETCHED, m_fetchedItems.size());
 		}
 		else {
 			PixelId pId = this->sgi().pixelId( CompressedPixelId(it.cellId()) );
-			clevel[pId] = TreeNode::make_unique(pId, TreeNode::IS_PARTIAL_MATCH, it.idxId());
+			clevel[pId] = makeNode(pId, TreeNode::IS_PARTIAL_MATCH, it.idxId());
 		}
     }
     while (clevel.size() > 1 || (clevel.size() && this->sg().level( clevel.begin()->second->pixelId() ) > 0)) {
 		SSERIALIZE_EXPENSIVE_ASSERT_EXEC(auto clvl = this->sg().level( clevel.begin()->second->pixelId() ); );
-        std::unordered_map<PixelId, std::unique_ptr<TreeNode>> plevel;
+        std::unordered_map<PixelId, TreeNodePtr> plevel;
         for(auto & x : clevel) {
 			SSERIALIZE_EXPENSIVE_ASSERT_EQUAL(clvl, this->sg().level( x.second->pixelId() ));
             PixelId pPId = this->sg().parent( x.second->pixelId() );
             auto & parent = plevel[pPId];
             if (!parent) {
-                parent = TreeNode::make_unique(pPId, TreeNode::IS_INTERNAL);
+                parent = makeNode(pPId, TreeNode::IS_INTERNAL);
             }
             parent->children().emplace_back( std::move(x.second) );
         }
@@ -116,13 +177,15 @@ HCQRSpatialGrid(idxStore, sg, sgi)
 }
 
 HCQRSpatialGrid::HCQRSpatialGrid(
-	TreeNodePtr && root,
+	TreeNodeArena && arena,
+	TreeNodePtr root,
 	sserialize::Static::ItemIndexStore idxStore,
 	sserialize::RCPtrWrapper<sserialize::spatial::dgg::interface::SpatialGrid> sg,
 	sserialize::RCPtrWrapper<sserialize::spatial::dgg::interface::SpatialGridInfo> sgi
 ) :
 Parent(sg, sgi),
-m_root(std::move(root)),
+m_arena(std::move(arena)),
+m_root(root),
 m_items(idxStore)
 {}
 
@@ -226,10 +289,10 @@ HCQRSpatialGrid::items() const {
 struct HCQRSpatialGrid::HCQRSpatialGridOpHelper {
     HCQRSpatialGrid & dest;
     HCQRSpatialGridOpHelper(HCQRSpatialGrid & dest) : dest(dest) {}
-    std::unique_ptr<HCQRSpatialGrid::TreeNode> deepCopy(HCQRSpatialGrid const & src, HCQRSpatialGrid::TreeNode const & node) {
+    HCQRSpatialGrid::TreeNodePtr deepCopy(HCQRSpatialGrid const & src, HCQRSpatialGrid::TreeNode const & node) {
 		SSERIALIZE_NORMAL_ASSERT(node.valid());
 		if (node.isInternal()) {
-			auto result = node.shallowCopy();
+			auto result = node.shallowCopy(dest.m_arena);
 			for(auto const & x : node.children()) {
 				result->children().emplace_back( this->deepCopy(src, *x) );
 			}
@@ -237,10 +300,10 @@ struct HCQRSpatialGrid::HCQRSpatialGridOpHelper {
 		}
         else if (node.isFetched()) {
             dest.m_fetchedItems.emplace_back( src.items(node) );
-            return node.shallowCopy(dest.m_fetchedItems.size()-1);
+            return node.shallowCopy(dest.m_arena, dest.m_fetchedItems.size()-1);
         }
         else {
-            return node.shallowCopy();
+            return node.shallowCopy(dest.m_arena);
         }
     }
 
@@ -263,10 +326,103 @@ struct HCQRSpatialGrid::HCQRSpatialGridOpHelper {
 
     void sortChildren(TreeNode & node) {
 		SSERIALIZE_NORMAL_ASSERT(node.valid());
-        sort(node.children().begin(), node.children().end(), [](std::unique_ptr<TreeNode> const & a, std::unique_ptr<TreeNode> const & b) {
+        sort(node.children().begin(), node.children().end(), [](TreeNode const * a, TreeNode const * b) {
             return a->pixelId() < b->pixelId();
         });
     }
+
+    ///Computes the result of the two internal root nodes by processing the pairs of their children with dest.threadCount() threads.
+    ///Children only present in one of the operands are copied if keepFirstOnly or keepSecondOnly is set.
+    ///Each subtree is computed into its own grid, its nodes and fetched items are moved to dest afterwards.
+    template<typename TRecurser>
+    TreeNodePtr parallelRoot(HCQRSpatialGrid const & firstSg, HCQRSpatialGrid const & secondSg, TreeNode const & first, TreeNode const & second, bool keepFirstOnly, bool keepSecondOnly) {
+		SSERIALIZE_CHEAP_ASSERT(first.isInternal() && second.isInternal());
+		SSERIALIZE_CHEAP_ASSERT_EQUAL(first.pixelId(), second.pixelId());
+		struct Task {
+			TreeNode const * first;
+			TreeNode const * second;
+			sserialize::RCPtrWrapper<Self> part;
+			TreeNodePtr result{nullptr};
+			std::exception_ptr error;
+		};
+		std::vector<Task> tasks;
+		auto fIt = first.children().begin();
+		auto fEnd = first.children().end();
+		auto sIt = second.children().begin();
+		auto sEnd = second.children().end();
+		while (fIt != fEnd || sIt != sEnd) {
+			if (sIt == sEnd || (fIt != fEnd && (*fIt)->pixelId() < (*sIt)->pixelId())) {
+				if (keepFirstOnly) {
+					tasks.push_back(Task{*fIt, nullptr, {}, nullptr, {}});
+				}
+				++fIt;
+			}
+			else if (fIt == fEnd || (*fIt)->pixelId() > (*sIt)->pixelId()) {
+				if (keepSecondOnly) {
+					tasks.push_back(Task{nullptr, *sIt, {}, nullptr, {}});
+				}
+				++sIt;
+			}
+			else {
+				tasks.push_back(Task{*fIt, *sIt, {}, nullptr, {}});
+				++fIt;
+				++sIt;
+			}
+		}
+		std::vector<std::size_t> taskIds(tasks.size());
+		std::iota(taskIds.begin(), taskIds.end(), 0);
+		sserialize::ThreadPool::map([&](std::size_t i) {
+			Task & task = tasks[i];
+			try {
+				task.part = dest.emptyResult();
+				TRecurser rec(firstSg, secondSg, *task.part);
+				if (task.first && task.second) {
+					task.result = rec(*task.first, *task.second);
+				}
+				else if (task.first) {
+					task.result = rec.deepCopy(firstSg, *task.first);
+				}
+				else {
+					task.result = rec.deepCopy(secondSg, *task.second);
+				}
+			}
+			catch (...) {
+				task.error = std::current_exception();
+			}
+		}, taskIds.begin(), taskIds.end(), std::max<uint32_t>(1, std::min<std::size_t>(dest.threadCount(), tasks.size())), 1);
+		
+		TreeNodePtr result = dest.makeNode(first.pixelId(), TreeNode::IS_INTERNAL);
+		for(Task & task : tasks) {
+			if (task.error) {
+				std::rethrow_exception(task.error);
+			}
+			if (!task.result) {
+				continue;
+			}
+			uint32_t offset = dest.m_fetchedItems.size();
+			if (offset) {
+				shiftFetchedItemIndexIds(*task.result, offset);
+			}
+			for(sserialize::ItemIndex & x : task.part->m_fetchedItems) {
+				dest.m_fetchedItems.emplace_back(std::move(x));
+			}
+			dest.m_arena.splice(std::move(task.part->m_arena));
+			result->children().push_back(task.result);
+		}
+		if (!result->children().size()) {
+			return TreeNodePtr();
+		}
+		return result;
+	}
+
+	void shiftFetchedItemIndexIds(TreeNode & node, uint32_t offset) {
+		if (node.isFetched()) {
+			node.setItemIndexId(node.itemIndexId() + offset);
+		}
+		for(TreeNodePtr x : node.children()) {
+			shiftFetchedItemIndexIds(*x, offset);
+		}
+	}
 };
 
 HCQRSpatialGrid::HCQRPtr
@@ -282,13 +438,13 @@ HCQRSpatialGrid::operator/(HCQR const & other) const {
         firstSg(firstSg),
         secondSg(secondSg)
         {}
-        std::unique_ptr<TreeNode> operator()(TreeNode const & firstNode, TreeNode const & secondNode) {
+        TreeNodePtr operator()(TreeNode const & firstNode, TreeNode const & secondNode) {
 			SSERIALIZE_NORMAL_ASSERT(firstNode.valid());
 			SSERIALIZE_NORMAL_ASSERT(secondNode.valid());
-			std::unique_ptr<TreeNode> rptr;
+			TreeNodePtr rptr{nullptr};
 			if (firstNode.isFullMatch() && secondNode.isFullMatch()) {
 				SSERIALIZE_CHEAP_ASSERT_EQUAL(firstSg.sg().level(firstNode.pixelId()), secondSg.sg().level(secondNode.pixelId()));
-				rptr = TreeNode::make_unique(resultPixelId(firstNode, secondNode), TreeNode::IS_FULL_MATCH);
+				rptr = dest.makeNode(resultPixelId(firstNode, secondNode), TreeNode::IS_FULL_MATCH);
 			}
             else if (firstNode.isFullMatch() && secondNode.isInternal()) {
 				SSERIALIZE_CHEAP_ASSERT_EQUAL(firstSg.sg().level(firstNode.pixelId()), secondSg.sg().level(secondNode.pixelId()));
@@ -301,13 +457,13 @@ HCQRSpatialGrid::operator/(HCQR const & other) const {
             else if (firstNode.isLeaf() && secondNode.isLeaf()) {
                 auto result = firstSg.items(firstNode) / secondSg.items(secondNode);
                 if (!result.size()) {
-                    return std::unique_ptr<TreeNode>();
+                    return TreeNodePtr();
                 }
                 dest.m_fetchedItems.emplace_back(result);
-                rptr = TreeNode::make_unique(resultPixelId(firstNode, secondNode), TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1);
+                rptr = dest.makeNode(resultPixelId(firstNode, secondNode), TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1);
             }
             else {
-                rptr = TreeNode::make_unique(resultPixelId(firstNode, secondNode), TreeNode::IS_INTERNAL);
+                rptr = dest.makeNode(resultPixelId(firstNode, secondNode), TreeNode::IS_INTERNAL);
 
                 if (firstNode.isInternal() && secondNode.isInternal()) {
                     auto fIt = firstNode.children().begin();
@@ -353,7 +509,7 @@ HCQRSpatialGrid::operator/(HCQR const & other) const {
                 }
 
                 if (!rptr->children().size()) {
-                    rptr = std::unique_ptr<TreeNode>();
+                    rptr = TreeNodePtr();
                 }
             }
 			#ifdef SSERIALIZE_EXPENSIVE_ASSERT_ENABLED
@@ -377,10 +533,16 @@ HCQRSpatialGrid::operator/(HCQR const & other) const {
 			return rptr;
         }
     };
-    sserialize::RCPtrWrapper<Self> dest( new Self(m_items, sgPtr(), sgiPtr()) );
-	if (m_root && static_cast<Self const &>(other).m_root) {
-		Recurser rec(*this, static_cast<Self const &>(other), *dest);
-		dest->m_root = rec(*(this->m_root), *(static_cast<Self const &>(other).m_root));
+    sserialize::RCPtrWrapper<Self> dest( emptyResult() );
+	Self const & otherSg = static_cast<Self const &>(other);
+	if (m_root && otherSg.m_root) {
+		Recurser rec(*this, otherSg, *dest);
+		if (m_threadCount > 1 && m_root->isInternal() && otherSg.m_root->isInternal() && m_root->pixelId() == otherSg.m_root->pixelId()) {
+			dest->m_root = rec.parallelRoot<Recurser>(*this, otherSg, *m_root, *otherSg.m_root, false, false);
+		}
+		else {
+			dest->m_root = rec(*m_root, *otherSg.m_root);
+		}
 	}
 	SSERIALIZE_EXPENSIVE_ASSERT_EQUAL(items() / other.items(), dest->items());
     return dest;
@@ -402,12 +564,12 @@ HCQRSpatialGrid::operator+(HCQR const & other) const {
         TreeNodePtr operator()(TreeNode const & firstNode, TreeNode const & secondNode) {
 			SSERIALIZE_NORMAL_ASSERT(firstNode.valid());
 			SSERIALIZE_NORMAL_ASSERT(secondNode.valid());
-			TreeNodePtr rptr;
+			TreeNodePtr rptr{nullptr};
 			if (firstNode.isFullMatch()) {
-				rptr = TreeNode::make_unique(firstNode.pixelId(), TreeNode::IS_FULL_MATCH);
+				rptr = dest.makeNode(firstNode.pixelId(), TreeNode::IS_FULL_MATCH);
 			}
             else if (secondNode.isFullMatch()) {
-				rptr = TreeNode::make_unique(secondNode.pixelId(), TreeNode::IS_FULL_MATCH);
+				rptr = dest.makeNode(secondNode.pixelId(), TreeNode::IS_FULL_MATCH);
             }
             else if (firstNode.isLeaf() && secondNode.isLeaf()) {
 				auto fnLvl = firstSg.level(firstNode);
@@ -426,10 +588,10 @@ HCQRSpatialGrid::operator+(HCQR const & other) const {
 				}
 				SSERIALIZE_CHEAP_ASSERT(result.size());
                 dest.m_fetchedItems.emplace_back(result);
-                rptr = TreeNode::make_unique(resultPixelId(firstNode, secondNode), TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1);
+                rptr = dest.makeNode(resultPixelId(firstNode, secondNode), TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1);
             }
             else {
-                rptr = TreeNode::make_unique(resultPixelId(firstNode, secondNode), TreeNode::IS_INTERNAL);
+                rptr = dest.makeNode(resultPixelId(firstNode, secondNode), TreeNode::IS_INTERNAL);
 
                 if (firstNode.isInternal() && secondNode.isInternal()) {
                     auto fIt = firstNode.children().begin();
@@ -468,12 +630,12 @@ HCQRSpatialGrid::operator+(HCQR const & other) const {
 					auto sEnd = virtSecondPids.end();
 					auto secondNodeItems = secondSg.items(secondNode);
                     for(;fIt != fEnd && sIt != sEnd; ++sIt) {
-						TreeNodePtr x;
+						TreeNodePtr x{nullptr};
 						if (*sIt < (*fIt)->pixelId()) {
 							auto result = secondNodeItems / secondSg.sgi().items(*sIt);
 							if (result.size()) {
 								dest.m_fetchedItems.emplace_back(result);
-								x = TreeNode::make_unique(*sIt, TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1);
+								x = dest.makeNode(*sIt, TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1);
 							}
 						}
 						else {
@@ -489,7 +651,7 @@ HCQRSpatialGrid::operator+(HCQR const & other) const {
 						auto result = secondNodeItems / secondSg.sgi().items(*sIt);
 						if (result.size()) {
 							dest.m_fetchedItems.emplace_back(result);
-							rptr->children().emplace_back( TreeNode::make_unique(*sIt, TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1) );
+							rptr->children().emplace_back( dest.makeNode(*sIt, TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1) );
 						}
 					}
                 }
@@ -503,12 +665,12 @@ HCQRSpatialGrid::operator+(HCQR const & other) const {
 					auto fEnd = virtFirstPids.end();
 					auto firstNodeItems = firstSg.items(firstNode);
                     for(;fIt != fEnd && sIt != sEnd; ++fIt) {
-						TreeNodePtr x;
+						TreeNodePtr x{nullptr};
 						if (*fIt < (*sIt)->pixelId()) {
 							auto result = firstNodeItems / firstSg.sgi().items(*fIt);
 							if (result.size()) {
 								dest.m_fetchedItems.emplace_back(result);
-								x = TreeNode::make_unique(*fIt, TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1);
+								x = dest.makeNode(*fIt, TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1);
 							}
 						}
 						else {
@@ -524,7 +686,7 @@ HCQRSpatialGrid::operator+(HCQR const & other) const {
 						auto result = firstNodeItems / firstSg.sgi().items(*fIt);
 						if (result.size()) {
 							dest.m_fetchedItems.emplace_back(result);
-							rptr->children().emplace_back( TreeNode::make_unique(*fIt, TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1) );
+							rptr->children().emplace_back( dest.makeNode(*fIt, TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1) );
 						}
 					}
                 }
@@ -534,10 +696,16 @@ HCQRSpatialGrid::operator+(HCQR const & other) const {
             return rptr;
         }
     };
-    sserialize::RCPtrWrapper<Self> dest( new Self(m_items, sgPtr(), sgiPtr()) );
-	if (m_root && static_cast<Self const &>(other).m_root) {
-		Recurser rec(*this, static_cast<Self const &>(other), *dest);
-		dest->m_root = rec(*(this->m_root), *(static_cast<Self const &>(other).m_root));
+    sserialize::RCPtrWrapper<Self> dest( emptyResult() );
+	Self const & otherSg = static_cast<Self const &>(other);
+	if (m_root && otherSg.m_root) {
+		Recurser rec(*this, otherSg, *dest);
+		if (m_threadCount > 1 && m_root->isInternal() && otherSg.m_root->isInternal() && m_root->pixelId() == otherSg.m_root->pixelId()) {
+			dest->m_root = rec.parallelRoot<Recurser>(*this, otherSg, *m_root, *otherSg.m_root, true, true);
+		}
+		else {
+			dest->m_root = rec(*m_root, *otherSg.m_root);
+		}
 	}
 	SSERIALIZE_EXPENSIVE_ASSERT_EQUAL(items() + other.items(), dest->items());
     return dest;
@@ -559,13 +727,13 @@ HCQRSpatialGrid::operator-(HCQR const & other) const {
         auto level(HCQRSpatialGrid const & sg, TreeNode const & node) {
 			return sg.sg().level(node.pixelId());
 		}
-        std::unique_ptr<TreeNode> operator()(TreeNode const & firstNode, TreeNode const & secondNode) {
+        TreeNodePtr operator()(TreeNode const & firstNode, TreeNode const & secondNode) {
 			SSERIALIZE_NORMAL_ASSERT(firstNode.valid());
 			SSERIALIZE_NORMAL_ASSERT(secondNode.valid());
-			TreeNodePtr rptr;
+			TreeNodePtr rptr{nullptr};
 			if (secondNode.isFullMatch() && level(firstSg, firstNode) >= level(secondSg, secondNode)) {
 				SSERIALIZE_CHEAP_ASSERT_EQUAL(level(firstSg, firstNode), level(secondSg, secondNode));
-				rptr = std::unique_ptr<TreeNode>();
+				rptr = TreeNodePtr();
 			}
             else if (firstNode.isLeaf() && secondNode.isLeaf()) {
 				auto fnLvl = firstSg.level(firstNode);
@@ -589,13 +757,13 @@ HCQRSpatialGrid::operator-(HCQR const & other) const {
 					result = firstSg.items(firstNode) - (secondSg.items(secondNode) / secondSg.sgi().items(firstNode.pixelId()));
 				}
                 if (!result.size()) {
-                    rptr = std::unique_ptr<TreeNode>();
+                    rptr = TreeNodePtr();
                 }
                 dest.m_fetchedItems.emplace_back(result);
-                rptr = TreeNode::make_unique(resultPixelId(firstNode, secondNode), TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1);
+                rptr = dest.makeNode(resultPixelId(firstNode, secondNode), TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1);
             }
             else {
-                rptr = TreeNode::make_unique(resultPixelId(firstNode, secondNode), TreeNode::IS_INTERNAL);
+                rptr = dest.makeNode(resultPixelId(firstNode, secondNode), TreeNode::IS_INTERNAL);
 
                 if (firstNode.isInternal() && secondNode.isInternal()) {
                     auto fIt = firstNode.children().begin();
@@ -646,9 +814,8 @@ HCQRSpatialGrid::operator-(HCQR const & other) const {
 					auto fEnd = virtFirstPids.end();
 					if (firstNode.isFullMatch()) {
 						for(;fIt != fEnd && sIt != sEnd; ++fIt) {
-							TreeNodePtr x;
 							if (*fIt < (*sIt)->pixelId()) {
-								rptr->children().emplace_back(TreeNode::make_unique(*fIt, TreeNode::IS_FULL_MATCH));
+								rptr->children().emplace_back(dest.makeNode(*fIt, TreeNode::IS_FULL_MATCH));
 							}
 							else {
 								SSERIALIZE_ASSERT_EQUAL(*fIt, (*sIt)->pixelId());
@@ -660,18 +827,18 @@ HCQRSpatialGrid::operator-(HCQR const & other) const {
 							}
 						}
 						for(; fIt != fEnd; ++fIt) {
-							rptr->children().emplace_back(TreeNode::make_unique(*fIt, TreeNode::IS_FULL_MATCH));
+							rptr->children().emplace_back(dest.makeNode(*fIt, TreeNode::IS_FULL_MATCH));
 						}
 					}
 					else {
 						sserialize::ItemIndex firstNodeItems = firstSg.items(firstNode);
 						for(;fIt != fEnd && sIt != sEnd; ++fIt) {
-							TreeNodePtr x;
+							TreeNodePtr x{nullptr};
 							if (*fIt < (*sIt)->pixelId()) {
 								auto result = firstNodeItems / firstSg.sgi().items(*fIt);
 								if (result.size()) {
 									dest.m_fetchedItems.emplace_back(result);
-									x = TreeNode::make_unique(*fIt, TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1);
+									x = dest.makeNode(*fIt, TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1);
 								}
 							}
 							else { //second < first should not happen since virtFirstPids contains ALL children
@@ -687,7 +854,7 @@ HCQRSpatialGrid::operator-(HCQR const & other) const {
 							auto result = firstNodeItems / firstSg.sgi().items(*fIt);
 							if (result.size()) {
 								dest.m_fetchedItems.emplace_back(result);
-								rptr->children().emplace_back( TreeNode::make_unique(*fIt, TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1) );
+								rptr->children().emplace_back( dest.makeNode(*fIt, TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1) );
 							}
 						}
 					}
@@ -750,10 +917,16 @@ HCQRSpatialGrid::operator-(HCQR const & other) const {
 			return rptr;
         }
     };
-    sserialize::RCPtrWrapper<Self> dest( new Self(m_items, sgPtr(), sgiPtr()) );
-	if (m_root && static_cast<Self const &>(other).m_root) {
-		Recurser rec(*this, static_cast<Self const &>(other), *dest);
-		dest->m_root = rec(*(this->m_root), *(static_cast<Self const &>(other).m_root));
+    sserialize::RCPtrWrapper<Self> dest( emptyResult() );
+	Self const & otherSg = static_cast<Self const &>(other);
+	if (m_root && otherSg.m_root) {
+		Recurser rec(*this, otherSg, *dest);
+		if (m_threadCount > 1 && m_root->isInternal() && otherSg.m_root->isInternal() && m_root->pixelId() == otherSg.m_root->pixelId()) {
+			dest->m_root = rec.parallelRoot<Recurser>(*this, otherSg, *m_root, *otherSg.m_root, true, false);
+		}
+		else {
+			dest->m_root = rec(*m_root, *otherSg.m_root);
+		}
 	}
 	SSERIALIZE_EXPENSIVE_ASSERT_EQUAL(items() - other.items(), dest->items());
     return dest;
@@ -770,7 +943,7 @@ HCQRSpatialGrid::compactified(SizeType maxPMLevel) const {
         dest(dest),
         maxPMLevel(maxPMLevel)
         {}
-        std::unique_ptr<TreeNode> operator()(TreeNode const & node) const {
+        TreeNodePtr operator()(TreeNode const & node) const {
 			SSERIALIZE_NORMAL_ASSERT(node.valid());
             if (node.isInternal()) {
                 TreeNode::Children children;
@@ -797,38 +970,38 @@ HCQRSpatialGrid::compactified(SizeType maxPMLevel) const {
                             }
                         }
                         dest.m_fetchedItems.emplace_back(merged);
-                        auto result = TreeNode::make_unique(node.pixelId(), TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1);
+                        auto result = dest.makeNode(node.pixelId(), TreeNode::IS_FETCHED, dest.m_fetchedItems.size()-1);
 						SSERIALIZE_EXPENSIVE_ASSERT_EQUAL(that.items(node), dest.items(*result));
 						return result;
                     } 
                 }
                 //merging was not possible
                 if ((flags & (~TreeNode::IS_FULL_MATCH)) || that.sg().childrenCount(node.pixelId()) != children.size()) {
-                    auto result = node.shallowCopy(std::move(children));
+                    auto result = node.shallowCopy(dest.m_arena, std::move(children));
 					SSERIALIZE_EXPENSIVE_ASSERT_EQUAL(that.items(node), dest.items(*result));
 					return result;
                 }
                 else {
-					auto result = TreeNode::make_unique(node.pixelId(), TreeNode::IS_FULL_MATCH);
+					auto result = dest.makeNode(node.pixelId(), TreeNode::IS_FULL_MATCH);
 					SSERIALIZE_EXPENSIVE_ASSERT_EQUAL(that.items(node), dest.items(*result));
 					return result;
                 }
             }
             else if (node.isFetched()) {
                 dest.m_fetchedItems.emplace_back( that.items(node) );
-                auto result = node.shallowCopy(dest.m_fetchedItems.size()-1);
+                auto result = node.shallowCopy(dest.m_arena, dest.m_fetchedItems.size()-1);
 				SSERIALIZE_EXPENSIVE_ASSERT_EQUAL(that.items(node), dest.items(*result));
 				return result;
             }
             else {
-                auto result = node.shallowCopy();
+                auto result = node.shallowCopy(dest.m_arena);
 				SSERIALIZE_EXPENSIVE_ASSERT_EQUAL(that.items(node), dest.items(*result));
 				return result;
             }
         };
     };
 
-    sserialize::RCPtrWrapper<Self> dest( new Self(m_items, sgPtr(), sgiPtr()) );
+    sserialize::RCPtrWrapper<Self> dest( emptyResult() );
 	if (m_root) {
 		Recurser rec(*this, *dest, maxPMLevel);
 		dest->m_root = rec(*m_root);
@@ -847,11 +1020,11 @@ HCQRSpatialGrid::expanded(SizeType level) const {
         that(that),
         level(level)
         {}
-        std::unique_ptr<TreeNode> operator()(TreeNode const & node) {
+        TreeNodePtr operator()(TreeNode const & node) {
 			SSERIALIZE_NORMAL_ASSERT(node.valid());
             return rec(node, 0);
         }
-        std::unique_ptr<TreeNode> rec(TreeNode const & node, SizeType myLevel) {
+        TreeNodePtr rec(TreeNode const & node, SizeType myLevel) {
 			SSERIALIZE_NORMAL_ASSERT(node.valid());
             if (myLevel >= level) {
                 return deepCopy(that, node);
@@ -861,15 +1034,15 @@ HCQRSpatialGrid::expanded(SizeType level) const {
                 for(auto const & x : node.children()) {
                     children.emplace_back( rec(*x, myLevel+1) );
                 }
-                return node.shallowCopy(std::move(children));
+                return node.shallowCopy(dest.m_arena, std::move(children));
             }
             else if (node.isFullMatch()) {
-                auto result = node.shallowCopy();
+                auto result = node.shallowCopy(dest.m_arena);
                 expandFullMatchNode(*result, myLevel);
                 return result;
             }
             else {
-                auto result = TreeNode::make_unique(node.pixelId(), TreeNode::IS_INTERNAL);
+                auto result = dest.makeNode(node.pixelId(), TreeNode::IS_INTERNAL);
                 expandPartialMatchNode(*result, myLevel, that.items(node));
                 return result;
             }
@@ -882,7 +1055,7 @@ HCQRSpatialGrid::expanded(SizeType level) const {
             node.setFlags(TreeNode::IS_INTERNAL);
             auto childrenCount = that.sg().childrenCount(node.pixelId());
             for(decltype(childrenCount) i(0); i < childrenCount; ++i) {
-                node.children().emplace_back(TreeNode::make_unique(that.sg().index(node.pixelId(), i), TreeNode::IS_FULL_MATCH));
+                node.children().emplace_back(dest.makeNode(that.sg().index(node.pixelId(), i), TreeNode::IS_FULL_MATCH));
             }
             sortChildren(node);
             for(auto & x : node.children()) {
@@ -902,12 +1075,12 @@ HCQRSpatialGrid::expanded(SizeType level) const {
                 auto childPixelId = that.sg().index(node.pixelId(), i);
                 sserialize::ItemIndex childFmIdx = that.sgi().items(childPixelId);
                 sserialize::ItemIndex childPmIdx = childFmIdx / items;
-                node.children().emplace_back(TreeNode::make_unique(childPixelId, TreeNode::IS_INTERNAL));
+                node.children().emplace_back(dest.makeNode(childPixelId, TreeNode::IS_INTERNAL));
                 expandPartialMatchNode(*node.children().back(), myLevel+1, childPmIdx);
             }
         }
     };
-    sserialize::RCPtrWrapper<Self> dest( new Self(m_items, sgPtr(), sgiPtr()) );
+    sserialize::RCPtrWrapper<Self> dest( emptyResult() );
 	if (m_root) {
 		Recurser rec(*dest, *this, level);
 		dest->m_root = rec(*m_root);
@@ -918,33 +1091,47 @@ HCQRSpatialGrid::expanded(SizeType level) const {
 HCQRSpatialGrid::HCQRPtr
 HCQRSpatialGrid::allToFull() const {
     struct Recurser {
-        std::unique_ptr<TreeNode> operator()(TreeNode const & node) {
+        HCQRSpatialGrid & dest;
+        Recurser(HCQRSpatialGrid & dest) : dest(dest) {}
+        TreeNodePtr operator()(TreeNode const & node) {
 			SSERIALIZE_NORMAL_ASSERT(node.valid());
             if (node.isInternal()) {
                 TreeNode::Children children;
                 for(auto const & x : node.children()) {
                     children.emplace_back((*this)(*x));
                 }
-                return node.shallowCopy(std::move(children));
+                return node.shallowCopy(dest.m_arena, std::move(children));
             }
             else {
-                return TreeNode::make_unique(node.pixelId(), TreeNode::IS_FULL_MATCH);
+                return dest.makeNode(node.pixelId(), TreeNode::IS_FULL_MATCH);
             }
         }
     };
-    sserialize::RCPtrWrapper<Self> dest( new Self(m_items, sgPtr(), sgiPtr()) );
+    sserialize::RCPtrWrapper<Self> dest( emptyResult() );
 	if (m_root) {
-		Recurser rec;
+		Recurser rec(*dest);
 		dest->m_root = rec(*m_root);
 	}
     return dest;
 }
 
-std::unique_ptr<HCQRSpatialGrid::TreeNode> const &
+HCQRSpatialGrid::TreeNodePtr const &
 HCQRSpatialGrid::root() const {
 	return m_root;
 }
 
+sserialize::RCPtrWrapper<HCQRSpatialGrid>
+HCQRSpatialGrid::emptyResult() const {
+	sserialize::RCPtrWrapper<Self> result( new Self(m_items, sgPtr(), sgiPtr()) );
+	result->m_threadCount = m_threadCount;
+	return result;
+}
+
+HCQRSpatialGrid::TreeNodePtr
+HCQRSpatialGrid::makeNode(PixelId pixelId, int flags, uint32_t itemIndexId) {
+	return TreeNode::make(m_arena, pixelId, flags, itemIndexId);
+}
+
 sserialize::ItemIndex
 HCQRSpatialGrid::items(TreeNode const & node) const {
 	SSERIALIZE_NORMAL_ASSERT(node.valid());
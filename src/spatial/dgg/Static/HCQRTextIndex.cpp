@@ -117,7 +117,7 @@ uint32_t CompactTree::nodeCount() const {
 	return m_d.getVlPackedUint32(0);
 }
 
-CompactTree::HCQRSpatialGrid::TreeNodePtr CompactTree::tree(SpatialGrid const & sg) const {
+CompactTree::HCQRSpatialGrid::TreeNodePtr CompactTree::tree(SpatialGrid const & sg, HCQRSpatialGrid::TreeNodeArena & arena) const {
 	sserialize::UByteArrayAdapter d(m_d);
 	uint32_t nc = d.getVlPackedUint32();
 	d.shrinkToGetPtr();
@@ -126,7 +126,8 @@ CompactTree::HCQRSpatialGrid::TreeNodePtr CompactTree::tree(SpatialGrid const &
 	std::unordered_map<HCQRSpatialGrid::PixelId, HCQRSpatialGrid::TreeNodePtr> nodes;
 	for(uint32_t i(0), s(nc); i < s; ++i) {
 		it >> n;
-		HCQRSpatialGrid::TreeNode::make_unique(
+		HCQRSpatialGrid::TreeNode::make(
+			arena,
 			n.pixelId(),
 			(n.isFullMatch() ? HCQRSpatialGrid::TreeNode::IS_FULL_MATCH : HCQRSpatialGrid::TreeNode::IS_PARTIAL_MATCH),
 			n.itemIndexId()
@@ -138,9 +139,9 @@ CompactTree::HCQRSpatialGrid::TreeNodePtr CompactTree::tree(SpatialGrid const &
 		for(auto & x : nodes) {
 			auto pid = sg.parent(x.first);
 			if (!tmp.count(pid)) {
-				tmp[pid] = HCQRSpatialGrid::TreeNode::make_unique(pid, HCQRSpatialGrid::TreeNode::IS_INTERNAL);
+				tmp[pid] = HCQRSpatialGrid::TreeNode::make(arena, pid, HCQRSpatialGrid::TreeNode::IS_INTERNAL);
 			}
-			tmp.at(pid)->children().push_back(std::move(x.second));
+			tmp.at(pid)->children().push_back(x.second);
 		}
 		
 		std::swap(tmp, nodes);
@@ -148,7 +149,7 @@ CompactTree::HCQRSpatialGrid::TreeNodePtr CompactTree::tree(SpatialGrid const &
 			x.second->sortChildren();
 		}
 	}
-	return std::move(nodes.at(sg.rootPixelId()));
+	return nodes.at(sg.rootPixelId());
 }
 	
 }//end namespace detail::HCQRTextIndex
@@ -305,8 +306,9 @@ HCQRTextIndex::hcqrFromPayload(Payload::Type const & d) const {
 	else {
 		using MyHCQR = sserialize::spatial::dgg::impl::HCQRSpatialGrid;
 		detail::HCQRTextIndex::CompactTree ctree(d);
-		auto rn = ctree.tree(sg());
-		return HCQRPtr( new MyHCQR(std::move(rn), idxStore(), sgPtr(), sgiPtr()) );
+		MyHCQR::TreeNodeArena arena;
+		auto rn = ctree.tree(sg(), arena);
+		return HCQRPtr( new MyHCQR(std::move(arena), rn, idxStore(), sgPtr(), sgiPtr()) );
 	}
 }
 
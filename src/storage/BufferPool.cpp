@@ -0,0 +1,58 @@
+#include <sserialize/storage/BufferPool.h>
+
+namespace sserialize {
+
+BufferPool::BufferPool(std::size_t maxBuffers, std::size_t maxBufferCapacity) :
+m_maxBuffers(maxBuffers),
+m_maxBufferCapacity(maxBufferCapacity)
+{}
+
+BufferPool::~BufferPool() {
+	for(std::vector<uint8_t> * buffer : m_buffers) {
+		delete buffer;
+	}
+}
+
+std::vector<uint8_t> * BufferPool::acquire(std::size_t size) {
+	std::vector<uint8_t> * buffer = 0;
+	{
+		std::lock_guard<std::mutex> lck(m_lock);
+		m_stats.acquired += 1;
+		//most recently released buffers first, their memory is most likely still cached
+		if (m_buffers.size()) {
+			buffer = m_buffers.back();
+			m_buffers.pop_back();
+			m_stats.reused += 1;
+		}
+	}
+	if (buffer) {
+		buffer->resize(size);
+	}
+	else {
+		buffer = new std::vector<uint8_t>(size);
+	}
+	return buffer;
+}
+
+void BufferPool::release(std::vector<uint8_t> * buffer) {
+	if (!buffer) {
+		return;
+	}
+	if (buffer->capacity() <= m_maxBufferCapacity) {
+		std::lock_guard<std::mutex> lck(m_lock);
+		if (m_buffers.size() < m_maxBuffers) {
+			m_buffers.push_back(buffer);
+			return;
+		}
+	}
+	delete buffer;
+}
+
+BufferPool::Stats BufferPool::stats() const {
+	std::lock_guard<std::mutex> lck(m_lock);
+	Stats result = m_stats;
+	result.pooled = m_buffers.size();
+	return result;
+}
+
+}//end namespace sserialize
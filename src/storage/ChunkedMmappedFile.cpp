@@ -3,6 +3,7 @@
 #include <sserialize/algorithm/utilfuncs.h>
 #include <sserialize/utility/log.h>
 #include <sserialize/utility/checks.h>
+#include <sserialize/utility/exceptions.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -14,8 +15,84 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <string.h>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <deque>
 
 namespace sserialize {
+namespace detail {
+namespace ChunkedMmappedFile {
+
+class Prefetcher final {
+public:
+	typedef sserialize::ChunkedMmappedFile::SizeType SizeType;
+public:
+	Prefetcher(int fd) : m_fd(fd), m_thread(&Prefetcher::run, this) {}
+	~Prefetcher() {
+		{
+			std::lock_guard<std::mutex> lck(m_lock);
+			m_stop = true;
+			m_requests.clear();
+		}
+		m_cv.notify_all();
+		m_thread.join();
+	}
+	///offset needs to be page aligned, the region has to be within the file
+	void push(SizeType offset, SizeType len) {
+		{
+			std::lock_guard<std::mutex> lck(m_lock);
+			//old requests are likely outdated if the consumer is faster than the disk
+			if (m_requests.size() >= MaxPendingRequests) {
+				m_requests.pop_front();
+			}
+			m_requests.emplace_back(offset, len);
+		}
+		m_cv.notify_one();
+	}
+private:
+	static constexpr std::size_t MaxPendingRequests = 64;
+private:
+	void run() {
+		std::unique_lock<std::mutex> lck(m_lock);
+		while (true) {
+			while (!m_stop && m_requests.empty()) {
+				m_cv.wait(lck);
+			}
+			if (m_stop) {
+				return;
+			}
+			std::pair<SizeType, SizeType> r = m_requests.front();
+			m_requests.pop_front();
+			lck.unlock();
+			load(r.first, r.second);
+			lck.lock();
+		}
+	}
+	void load(SizeType offset, SizeType len) {
+		uint8_t * data = (uint8_t*) ::mmap64(0, len, PROT_READ, MAP_SHARED, m_fd, offset);
+		if (data == MAP_FAILED) {
+			return;
+		}
+		::madvise(data, len, MADV_WILLNEED);
+		//touching the pages makes sure that they are loaded by this thread and not on first access
+		long int pageSize = std::max<long int>(512, sysconf(_SC_PAGE_SIZE));
+		volatile uint8_t v = 0;
+		for(const uint8_t * d(data), * s(data+len); d < s; d += pageSize) {
+			v = v + *d;
+		}
+		::munmap(data, len);
+	}
+private:
+	int m_fd;
+	std::mutex m_lock;
+	std::condition_variable m_cv;
+	std::deque< std::pair<SizeType, SizeType> > m_requests;
+	bool m_stop{false};
+	std::thread m_thread;
+};
+
+}}//end namespace detail::ChunkedMmappedFile
 
 
 ChunkedMmappedFile::ChunkedMmappedFile() : MyParentClass(new ChunkedMmappedFilePrivate(0)) {}
@@ -52,17 +129,13 @@ bool ChunkedMmappedFile::close() {
 	return priv()->do_close();
 }
 
-uint8_t & ChunkedMmappedFile::operator[](const SizeType offset) {
-	return priv()->operator[](offset);
-}
-
-const uint8_t & ChunkedMmappedFile::operator[](const SizeType offset) const {
-	return priv()->operator[](offset);
+uint8_t ChunkedMmappedFile::operator[](const SizeType offset) const {
+	ChunkLease l(lease(offset));
+	return *l.at(offset);
 }
 
-
-uint8_t * ChunkedMmappedFile::data(const SizeType offset) {
-	return priv()->data(offset);
+ChunkedMmappedFile::ChunkLease ChunkedMmappedFile::lease(const SizeType offset) const {
+	return priv()->lease(priv()->chunk(offset));
 }
 
 void ChunkedMmappedFile::read(const ChunkedMmappedFile::SizeType offset, uint8_t* dest, SizeType& len) const {
@@ -96,11 +169,100 @@ void ChunkedMmappedFile::setCacheCount(uint32_t count){
 	priv()->setCacheCount(count);
 }
 
+uint32_t ChunkedMmappedFile::mappedChunkCount() const {
+	return priv()->mappedChunkCount();
+}
+
+void ChunkedMmappedFile::setReadahead(uint32_t chunkCount) {
+	priv()->setReadahead(chunkCount);
+}
+
+void ChunkedMmappedFile::prefetch(SizeType offset, SizeType len) {
+	priv()->prefetch(offset, len);
+}
+
 
 bool ChunkedMmappedFile::resize(SizeType size) {
 	return priv()->resize(size);
 }
 
+//ChunkLease
+
+ChunkedMmappedFile::ChunkLease::ChunkLease() :
+m_slot(0),
+m_data(0),
+m_offset(0),
+m_size(0)
+{}
+
+ChunkedMmappedFile::ChunkLease::ChunkLease(detail::ChunkedMmappedFile::ChunkSlot * slot, uint8_t * data, SizeType offset, SizeType size) :
+m_slot(slot),
+m_data(data),
+m_offset(offset),
+m_size(size)
+{}
+
+ChunkedMmappedFile::ChunkLease::ChunkLease(const ChunkLease & other) :
+m_slot(other.m_slot),
+m_data(other.m_data),
+m_offset(other.m_offset),
+m_size(other.m_size)
+{
+	if (m_slot) {
+		m_slot->pins.fetch_add(1, std::memory_order_relaxed);
+	}
+}
+
+ChunkedMmappedFile::ChunkLease::ChunkLease(ChunkLease && other) :
+m_slot(other.m_slot),
+m_data(other.m_data),
+m_offset(other.m_offset),
+m_size(other.m_size)
+{
+	other.m_slot = 0;
+	other.m_data = 0;
+}
+
+ChunkedMmappedFile::ChunkLease::~ChunkLease() {
+	release();
+}
+
+ChunkedMmappedFile::ChunkLease & ChunkedMmappedFile::ChunkLease::operator=(const ChunkLease & other) {
+	if (this != &other) {
+		if (other.m_slot) {
+			other.m_slot->pins.fetch_add(1, std::memory_order_relaxed);
+		}
+		release();
+		m_slot = other.m_slot;
+		m_data = other.m_data;
+		m_offset = other.m_offset;
+		m_size = other.m_size;
+	}
+	return *this;
+}
+
+ChunkedMmappedFile::ChunkLease & ChunkedMmappedFile::ChunkLease::operator=(ChunkLease && other) {
+	if (this != &other) {
+		release();
+		m_slot = other.m_slot;
+		m_data = other.m_data;
+		m_offset = other.m_offset;
+		m_size = other.m_size;
+		other.m_slot = 0;
+		other.m_data = 0;
+	}
+	return *this;
+}
+
+void ChunkedMmappedFile::ChunkLease::release() {
+	if (m_slot) {
+		m_slot->pins.fetch_sub(1, std::memory_order_release);
+		m_slot = 0;
+		m_data = 0;
+	}
+}
+
+
 //Private implementation
 
 
@@ -117,12 +279,64 @@ ChunkedMmappedFilePrivate::~ChunkedMmappedFilePrivate() {
 }
 
 void ChunkedMmappedFilePrivate::setCacheCount(uint32_t count) {
-	while (m_cache.occupyCount() > count) {
-		ChunkIndexType victim = m_cache.findVictim();
-		do_unmap(victim);
-		m_cache.evict(victim);
-	}
+	std::lock_guard<std::mutex> lck(m_mapLock);
 	m_maxOccupyCount = count;
+	while (m_mapped.size() > count && evictOne()) {}
+}
+
+ChunkedMmappedFilePrivate::ChunkIndexType ChunkedMmappedFilePrivate::mappedChunkCount() {
+	std::lock_guard<std::mutex> lck(m_mapLock);
+	return (ChunkIndexType) m_mapped.size();
+}
+
+void ChunkedMmappedFilePrivate::setReadahead(uint32_t chunkCount) {
+	std::lock_guard<std::mutex> lck(m_mapLock);
+	m_readaheadChunks = chunkCount;
+	if (!chunkCount) {
+		stopPrefetcher();
+	}
+}
+
+void ChunkedMmappedFilePrivate::prefetch(SizeType offset, SizeType len) {
+	std::lock_guard<std::mutex> lck(m_mapLock);
+	do_prefetch(offset, len);
+}
+
+void ChunkedMmappedFilePrivate::do_prefetch(SizeType offset, SizeType len) {
+	if (!valid() || offset >= m_size || !len) {
+		return;
+	}
+	len = std::min<SizeType>(len, m_size - offset);
+	//mmap needs a page aligned offset, chunks are page aligned
+	SizeType alignedOffset = offset & ~SizeType(m_chunkMask);
+	len += offset - alignedOffset;
+	if (!m_prefetcher) {
+		m_prefetcher.reset(new detail::ChunkedMmappedFile::Prefetcher(m_fd));
+	}
+	m_prefetcher->push(alignedOffset, len);
+}
+
+void ChunkedMmappedFilePrivate::readahead(ChunkIndexType chunk) {
+	if (m_readaheadChunks && chunk == m_lastMappedChunk+1) {
+		ChunkIndexType begin = std::max<ChunkIndexType>(chunk+1, m_readaheadEnd);
+		ChunkIndexType chunkCount = this->chunk(m_size-1)+1;
+		ChunkIndexType end = (ChunkIndexType) std::min<SizeType>(SizeType(chunk)+1+m_readaheadChunks, chunkCount);
+		if (begin < end) {
+			do_prefetch(SizeType(begin) << m_chunkShift, SizeType(end-begin) << m_chunkShift);
+			m_readaheadEnd = end;
+		}
+	}
+	else if (chunk < m_lastMappedChunk) {
+		//we jumped back, a new sequential scan may start
+		m_readaheadEnd = 0;
+	}
+	m_lastMappedChunk = chunk;
+}
+
+void ChunkedMmappedFilePrivate::stopPrefetcher() {
+	m_prefetcher.reset();
+	m_readaheadEnd = 0;
+	m_lastMappedChunk = std::numeric_limits<ChunkIndexType>::max();
 }
 
 
@@ -149,8 +363,7 @@ bool ChunkedMmappedFilePrivate::do_open() {
 		return false;
 	}
 	
-	//init the cache
-	m_cache = DirectRandomCache<uint8_t*>(narrow_check<uint32_t>( size()/chunkSize() + 1), nullptr);
+	resetSlots();
 	
 	return true;
 }
@@ -161,6 +374,10 @@ bool ChunkedMmappedFilePrivate::do_close() {
 		return false;
 	}
 	
+	{
+		std::lock_guard<std::mutex> lck(m_mapLock);
+		stopPrefetcher();
+	}
 	bool allOk = do_unmap();
 	
 	if (::close(m_fd) == -1) {
@@ -177,16 +394,32 @@ bool ChunkedMmappedFilePrivate::do_close() {
 }
 
 bool ChunkedMmappedFilePrivate::do_unmap() {
-	ChunkIndexType victim;
+	std::lock_guard<std::mutex> lck(m_mapLock);
+	//unmapping a pinned chunk would leave the lease with a dangling pointer
+	for(ChunkIndexType chunk : m_mapped) {
+		if (m_slots[chunk].pins.load(std::memory_order_acquire)) {
+			throw sserialize::PreconditionViolationException("ChunkedMmappedFile: chunk " + std::to_string(chunk) + " of " + m_fileName + " is still leased");
+		}
+	}
 	bool allOk = true;
-	while(m_cache.occupyCount()) {
-		victim = m_cache.findVictim();
-		allOk = do_unmap(victim) && allOk;
-		m_cache.evict(victim);
+	for(ChunkIndexType chunk : m_mapped) {
+		bool unmapOk = true;
+		if (!tryEvict(chunk, unmapOk)) {
+			throw sserialize::PreconditionViolationException("ChunkedMmappedFile: chunk " + std::to_string(chunk) + " of " + m_fileName + " got leased during unmap");
+		}
+		allOk = unmapOk && allOk;
 	}
+	m_mapped.clear();
+	m_clockHand = 0;
 	return allOk;
 }
 
+void ChunkedMmappedFilePrivate::resetSlots() {
+	SSERIALIZE_CHEAP_ASSERT(m_mapped.empty());
+	m_chunkCount = narrow_check<ChunkIndexType>( m_size/chunkSize() + 1);
+	m_slots.reset(new detail::ChunkedMmappedFile::ChunkSlot[m_chunkCount]);
+}
+
 
 inline uint8_t * ChunkedMmappedFilePrivate::do_map(const ChunkIndexType chunk) {
 	int mmap_proto = PROT_READ;
@@ -203,31 +436,95 @@ inline uint8_t * ChunkedMmappedFilePrivate::do_map(const ChunkIndexType chunk) {
 	return data;
 }
 
-bool ChunkedMmappedFilePrivate::do_unmap(const sserialize::ChunkedMmappedFilePrivate::ChunkIndexType chunk) {
+bool ChunkedMmappedFilePrivate::do_unmap(const sserialize::ChunkedMmappedFilePrivate::ChunkIndexType chunk, uint8_t * data) {
 	if (m_syncOnClose) {
-		do_sync(chunk);
+		do_sync(chunk, data);
 	}
 	
-	uint8_t * data = m_cache.directAccess(chunk);
-	
 	if (::munmap(data, sizeOfChunk(chunk)) == -1) {
 		return false;
 	}
 	return true;
 }
 
-bool ChunkedMmappedFilePrivate::do_sync(const sserialize::ChunkedMmappedFilePrivate::ChunkIndexType chunk) {
-	uint8_t * data = m_cache.directAccess(chunk);
+bool ChunkedMmappedFilePrivate::do_sync(const sserialize::ChunkedMmappedFilePrivate::ChunkIndexType chunk, uint8_t * data) {
 	int result = ::msync(data, sizeOfChunk(chunk), MS_SYNC);
 	return result == 0;
 }
 
+bool ChunkedMmappedFilePrivate::tryEvict(ChunkIndexType chunk, bool & unmapOk) {
+	detail::ChunkedMmappedFile::ChunkSlot & slot = m_slots[chunk];
+	uint32_t expected = 0;
+	//readers that pin the chunk from now on see the flag and fall back to taking m_mapLock
+	if (!slot.pins.compare_exchange_strong(expected, slot.EvictionFlag, std::memory_order_acq_rel)) {
+		return false;
+	}
+	uint8_t * data = slot.data.exchange(nullptr, std::memory_order_acq_rel);
+	unmapOk = do_unmap(chunk, data);
+	slot.used.store(false, std::memory_order_relaxed);
+	//there may be pins of readers that saw the flag and did not yet remove their pin
+	slot.pins.fetch_sub(slot.EvictionFlag, std::memory_order_release);
+	return true;
+}
+
+bool ChunkedMmappedFilePrivate::evictOne() {
+	//two rounds: the first one may only clear the used flags
+	for(std::size_t i(0), s(2*m_mapped.size()); i < s; ++i, ++m_clockHand) {
+		if (m_clockHand >= m_mapped.size()) {
+			m_clockHand = 0;
+		}
+		ChunkIndexType chunk = m_mapped[m_clockHand];
+		if (m_slots[chunk].used.exchange(false, std::memory_order_relaxed)) {
+			continue;
+		}
+		bool unmapOk = true;
+		if (tryEvict(chunk, unmapOk)) {
+			m_mapped[m_clockHand] = m_mapped.back();
+			m_mapped.pop_back();
+			return true;
+		}
+	}
+	return false;
+}
+
+uint8_t * ChunkedMmappedFilePrivate::mapAndPin(ChunkIndexType chunk) {
+	detail::ChunkedMmappedFile::ChunkSlot & slot = m_slots[chunk];
+	//nobody can evict the chunk while we hold the lock
+	uint8_t * data = slot.data.load(std::memory_order_relaxed);
+	if (!data) {
+		//pinned chunks are never evicted, hence we may end up with more mapped chunks than m_maxOccupyCount
+		while (m_mapped.size() >= m_maxOccupyCount && evictOne()) {}
+		data = do_map(chunk);
+		if (!data) {
+			throw sserialize::IOException("ChunkedMmappedFile: mapping chunk " + std::to_string(chunk) + " of " + m_fileName + " failed");
+		}
+		slot.data.store(data, std::memory_order_release);
+		m_mapped.push_back(chunk);
+		readahead(chunk);
+	}
+	slot.pins.fetch_add(1, std::memory_order_acquire);
+	slot.used.store(true, std::memory_order_relaxed);
+	return data;
+}
 
-uint8_t * ChunkedMmappedFilePrivate::data(const ChunkedMmappedFilePrivate::SizeType offset) {
-	auto chunk = this->chunk(offset);
-	SizeType inChunkOffSet = this->inChunkOffSet(offset);
-	uint8_t * data = chunkData(chunk);
-	return data + inChunkOffSet;
+ChunkedMmappedFile::ChunkLease ChunkedMmappedFilePrivate::lease(const ChunkIndexType chunk) {
+	detail::ChunkedMmappedFile::ChunkSlot & slot = m_slots[chunk];
+	SizeType offset = SizeType(chunk) << m_chunkShift;
+	//lock-free path for mapped chunks
+	uint32_t pins = slot.pins.fetch_add(1, std::memory_order_acquire);
+	if (!(pins & slot.EvictionFlag)) {
+		uint8_t * data = slot.data.load(std::memory_order_acquire);
+		if (data) {
+			if (!slot.used.load(std::memory_order_relaxed)) {
+				slot.used.store(true, std::memory_order_relaxed);
+			}
+			return ChunkedMmappedFile::ChunkLease(&slot, data, offset, sizeOfChunk(chunk));
+		}
+	}
+	slot.pins.fetch_sub(1, std::memory_order_release);
+	std::lock_guard<std::mutex> lck(m_mapLock);
+	uint8_t * data = mapAndPin(chunk);
+	return ChunkedMmappedFile::ChunkLease(&slot, data, offset, sizeOfChunk(chunk));
 }
 
 void ChunkedMmappedFilePrivate::read(const ChunkedMmappedFilePrivate::SizeType offset, uint8_t * dest, SizeType& len) {
@@ -242,21 +539,18 @@ void ChunkedMmappedFilePrivate::read(const ChunkedMmappedFilePrivate::SizeType o
 		len = 0;
 		return;
 	}
-	uint8_t * dest_end = dest+len;
-	SizeType chunkSize = this->chunkSize();
-	
 	ChunkIndexType beginChunk = chunk(offset);
 	ChunkIndexType endChunk = chunk(offset+len-1);
-
-	::memmove(dest, chunkData(beginChunk)+inChunkOffSet(offset), sizeof(uint8_t)*std::min<SizeType>(len, chunkSize-inChunkOffSet(offset)));
-	dest += sizeof(uint8_t)*std::min<SizeType>(len, chunkSize-inChunkOffSet(offset));
-	for(ChunkIndexType i = beginChunk+1; i < endChunk; ++i) {//copy all chunks from within
-		::memmove(dest, chunkData(i), sizeof(uint8_t)*chunkSize);
-		dest += chunkSize;
-	}
-	if (beginChunk < endChunk) { //copy things from the last chunk
-		::memmove(dest, chunkData(endChunk), sizeof(uint8_t)*(dest_end-dest));
+	SizeType srcOffset = offset;
+	uint8_t * dest_end = dest+len;
+	for(ChunkIndexType i = beginChunk; i <= endChunk; ++i) {
+		ChunkedMmappedFile::ChunkLease l = lease(i);
+		SizeType copyLen = std::min<SizeType>(dest_end-dest, l.offset()+l.size()-srcOffset);
+		::memmove(dest, l.at(srcOffset), sizeof(uint8_t)*copyLen);
+		dest += copyLen;
+		srcOffset += copyLen;
 	}
+	SSERIALIZE_CHEAP_ASSERT(dest == dest_end);
 }
 
 void ChunkedMmappedFilePrivate::write(const uint8_t* src, const SizeType destOffset, SizeType& len) {
@@ -271,49 +565,22 @@ void ChunkedMmappedFilePrivate::write(const uint8_t* src, const SizeType destOff
 		len = 0;
 		return;
 	}
-
-	SizeType chunkSize = this->chunkSize();
-	
 	ChunkIndexType beginChunk = chunk(destOffset);
 	ChunkIndexType endChunk = chunk(destOffset+len-1);
-	
+	SizeType myDestOffset = destOffset;
 	uint8_t const * src_end = src+len;
-	
-	::memmove(chunkData(beginChunk)+inChunkOffSet(destOffset), src, sizeof(uint8_t)*std::min<SizeType>(len, chunkSize-inChunkOffSet(destOffset)));
-	src += sizeof(uint8_t)*std::min<SizeType>(len, chunkSize-inChunkOffSet(destOffset));
-	for(ChunkIndexType i = beginChunk+1; i < endChunk; ++i) {//copy all chunks from within
-		::memmove(chunkData(i), src, sizeof(uint8_t)*chunkSize);
-		src += chunkSize;
-	}
-	if (beginChunk < endChunk) {
-		SSERIALIZE_CHEAP_ASSERT_SMALLER_OR_EQUAL(std::size_t(src_end-src), sizeOfChunk(endChunk));
-		::memmove(chunkData(endChunk), src, sizeof(uint8_t)*(src_end-src));
+	for(ChunkIndexType i = beginChunk; i <= endChunk; ++i) {
+		ChunkedMmappedFile::ChunkLease l = lease(i);
+		SizeType copyLen = std::min<SizeType>(src_end-src, l.offset()+l.size()-myDestOffset);
+		::memmove(l.at(myDestOffset), src, sizeof(uint8_t)*copyLen);
+		src += copyLen;
+		myDestOffset += copyLen;
 	}
+	SSERIALIZE_CHEAP_ASSERT(src == src_end);
 }
 
 
-uint8_t* ChunkedMmappedFilePrivate::chunkData(const sserialize::ChunkedMmappedFilePrivate::ChunkIndexType chunk) {
-	uint8_t * data = m_cache[chunk]; //returns null if not set, usage will be increased by one, but also reset to zero below due to insertion
-	if (data) {
-		SSERIALIZE_CHEAP_ASSERT(data);
-		return data;
-	}
-	else {
-		if (m_cache.occupyCount() >= m_maxOccupyCount) {
-			ChunkIndexType victim = m_cache.findVictim(); //this should be valid!
-			do_unmap(victim);
-			m_cache.evict(victim);
-		}
-		
-		uint8_t * data = do_map(chunk);
-		
-		m_cache.insert(chunk, data);
-		SSERIALIZE_CHEAP_ASSERT(data);
-		return data;
-	}
-}
-
-ChunkedMmappedFilePrivate::ChunkSizeType ChunkedMmappedFilePrivate::sizeOfChunk(ChunkIndexType chunk) {
+ChunkedMmappedFilePrivate::ChunkSizeType ChunkedMmappedFilePrivate::sizeOfChunk(ChunkIndexType chunk) const {
 	SizeType chunkSize = this->chunkSize();
 	if (chunk*chunkSize+chunkSize > m_size) {
 		return  (ChunkSizeType) (m_size - chunk*chunkSize);
@@ -334,6 +601,11 @@ ChunkedMmappedFilePrivate::ChunkSizeType ChunkedMmappedFilePrivate::inChunkOffSe
 
 
 bool ChunkedMmappedFilePrivate::resize(const ChunkedMmappedFilePrivate::SizeType size) {
+	//the prefetcher may not touch pages beyond the new end of the file
+	{
+		std::lock_guard<std::mutex> lck(m_mapLock);
+		stopPrefetcher();
+	}
 	if (!do_unmap()) {
 		return false;
 	}
@@ -347,7 +619,7 @@ bool ChunkedMmappedFilePrivate::resize(const ChunkedMmappedFilePrivate::SizeType
 	else {
 		m_size = size;
 	}
-	m_cache = DirectRandomCache<uint8_t*>(narrow_check<uint32_t>( m_size/chunkSize() + 1), nullptr);
+	resetSlots();
 	return allOk;
 }
 
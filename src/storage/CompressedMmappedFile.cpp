@@ -5,7 +5,8 @@
 #include <sserialize/utility/log.h>
 #include <sserialize/stats/ProgressInfo.h>
 #include <sserialize/containers/SortedOffsetIndexPrivate.h>
-#include <minilzo/minilzo.h>
+#include <sserialize/containers/ConcurrentCache.h>
+#include <sserialize/mt/ThreadPool.h>
 #include <sys/types.h>
 #include <sys/stat.h>
 #include <unistd.h>
@@ -17,10 +18,37 @@
 #include <stdlib.h>
 #include <errno.h>
 #include <string.h>
-#define COMPRESSED_MMAPPED_FILE_VERSION 1
-#define COMPRESSED_MMAPPED_FILE_HEADER_SIZE 12
+#define COMPRESSED_MMAPPED_FILE_VERSION 2
+#define COMPRESSED_MMAPPED_FILE_HEADER_SIZE 13
+#define COMPRESSED_MMAPPED_FILE_V1_HEADER_SIZE 12
 
 namespace sserialize {
+namespace detail {
+namespace CompressedMmappedFile {
+
+///State shared by all compressed files
+struct SharedState {
+	typedef sserialize::CompressedMmappedFilePrivate::ChunkDataPtr ChunkDataPtr;
+	///(file id, chunk) -> decompressed chunk
+	typedef sserialize::ConcurrentCache<std::pair<uint64_t, uint32_t>, ChunkDataPtr> Cache;
+	static constexpr std::size_t DefaultCacheSize = std::size_t(256) << 20;
+	///few shards since entries are large and the limit is split among the shards
+	static constexpr uint32_t CacheShardCount = 4;
+	Cache cache;
+	ThreadPool pool;
+	std::atomic<uint64_t> nextFileId;
+	SharedState() :
+	cache(Cache::Unlimited, DefaultCacheSize, CacheShardCount),
+	pool(std::max<uint32_t>(ThreadPool::hardware_concurrency(), 1)),
+	nextFileId(0)
+	{}
+	static SharedState & instance() {
+		static SharedState state;
+		return state;
+	}
+};
+
+}}//end namespace detail::CompressedMmappedFile
 
 
 CompressedMmappedFile::CompressedMmappedFile() : MyParentClass(new CompressedMmappedFilePrivate()) {}
@@ -89,70 +117,108 @@ void CompressedMmappedFile::setCacheCount(uint32_t count){
 	priv()->setCacheCount(count);
 }
 
+void CompressedMmappedFile::setDecodeAhead(uint32_t chunkCount) {
+	priv()->setDecodeAhead(chunkCount);
+}
 
-//Private implementation
+void CompressedMmappedFile::setSharedCacheSize(std::size_t bytes) {
+	detail::CompressedMmappedFile::SharedState::instance().cache.setCapacity(detail::CompressedMmappedFile::SharedState::Cache::Unlimited, bytes);
+}
+
+std::size_t CompressedMmappedFile::sharedCacheSize() {
+	return detail::CompressedMmappedFile::SharedState::instance().cache.maxCost();
+}
 
-#define HEAP_ALLOC_MINI_LZO(var,size) \
-    lzo_align_t __LZO_MMODEL var [ ((size) + (sizeof(lzo_align_t) - 1)) / sizeof(lzo_align_t) ]
+std::size_t CompressedMmappedFile::sharedCacheUsage() {
+	return detail::CompressedMmappedFile::SharedState::instance().cache.stats().cost;
+}
+
+void CompressedMmappedFile::setDecompressionThreadCount(uint32_t count) {
+	detail::CompressedMmappedFile::SharedState::instance().pool.numThreads(std::max<uint32_t>(count, 1));
+}
+
+Compressor::CompressionTypes CompressedMmappedFile::codec() const {
+	return priv()->codec();
+}
+
+Compressor::CompressionTypes CompressedMmappedFile::codec(const SizeType offset) const {
+	return priv()->chunkCodec(priv()->chunk(offset));
+}
 
 
+//Private implementation
+
 bool CompressedMmappedFile::create(const UByteArrayAdapter & src, UByteArrayAdapter & dest, uint8_t chunkSizeExponent, double compressionRatio) {
-	if (chunkSizeExponent < 16)
+	return create(src, dest, chunkSizeExponent, compressionRatio, std::vector<Compressor::CompressionTypes>(1, Compressor::CT_LZO));
+}
+
+bool CompressedMmappedFile::create(const UByteArrayAdapter & src, UByteArrayAdapter & dest, uint8_t chunkSizeExponent, double compressionRatio, const std::vector<Compressor::CompressionTypes> & codecs) {
+	if (chunkSizeExponent < 16 || chunkSizeExponent > 31 || codecs.empty())
 		return false;
+	std::vector<Compressor> compressors;
+	for(Compressor::CompressionTypes ct : codecs) {
+		if (!Compressor::supported(ct)) {
+			return false;
+		}
+		compressors.emplace_back(ct);
+	}
 	sserialize::UByteArrayAdapter::OffsetType beginning = dest.tellPutPtr();
 	std::vector<SizeType> destOffsets;
-	DynamicBitSet chunkTypeBitSet(UByteArrayAdapter(new std::vector<uint8_t>(), true));
+	std::vector<uint8_t> chunkCodecs;
 	SizeType chunkSize = (static_cast<SizeType>(1) << chunkSizeExponent);
-
-	chunkTypeBitSet.data().growStorage(src.size()/chunkSize + ((src.size() % chunkSize) ? 1 : 0));
-
-	uint8_t * inBuf = new uint8_t[chunkSize];
-	uint8_t * outBuf = new uint8_t[chunkSize*2];
-
-	HEAP_ALLOC_MINI_LZO(wrkmem, LZO1X_1_MEM_COMPRESS);
 	
+	std::size_t maxCompressedSize = chunkSize;
+	for(const Compressor & c : compressors) {
+		maxCompressedSize = std::max(maxCompressedSize, c.maxCompressedSize(chunkSize));
+	}
+
+	std::vector<uint8_t> inBuf(chunkSize);
+	std::vector<uint8_t> outBuf(maxCompressedSize);
+	std::vector<uint8_t> bestBuf(maxCompressedSize);
 	
 	ProgressInfo  progressInfo;
 	progressInfo.begin(src.size(), "CompressedMmappedFile::create");
-	for(std::size_t i = 0, chunkNum = 0; i < src.size(); i += chunkSize, ++chunkNum) {
+	for(std::size_t i = 0; i < src.size(); i += chunkSize) {
 		progressInfo(i);
 		destOffsets.push_back(dest.tellPutPtr()-beginning);
 		
-		lzo_uint inBufLen = 0;
-		lzo_uint outBufLen = chunkSize*2;
-		for(; inBufLen < chunkSize && inBufLen+i < src.size(); ++inBufLen) {
-			inBuf[inBufLen] = src.at(inBufLen+i);
-		}
-		int r = ::lzo1x_1_compress(inBuf,inBufLen,outBuf,&outBufLen,wrkmem);
-		if (r != LZO_E_OK) {
-			delete[] inBuf;
-			delete[] outBuf;
-			return false;
+		std::size_t inBufLen = std::min<std::size_t>(chunkSize, src.size()-i);
+		src.getData(i, inBuf.data(), inBufLen);
+		
+		//choose the codec with the smallest output
+		Compressor::CompressionTypes bestCodec = Compressor::CT_NONE;
+		int64_t bestLen = std::numeric_limits<int64_t>::max();
+		for(const Compressor & c : compressors) {
+			int64_t outBufLen = c.compress(inBuf.data(), inBufLen, outBuf.data(), outBuf.size());
+			if (outBufLen >= 0 && outBufLen < bestLen) {
+				bestLen = outBufLen;
+				bestCodec = c.type();
+				bestBuf.swap(outBuf);
+			}
 		}
 		
-		double cmpRatio = (double)inBufLen / outBufLen;
-		if (cmpRatio >= compressionRatio) {
-			dest.putData(outBuf, outBufLen);
-			chunkTypeBitSet.set(chunkNum);
+		if (bestCodec != Compressor::CT_NONE && bestLen > 0 && (double)inBufLen / bestLen >= compressionRatio) {
+			dest.putData(bestBuf.data(), bestLen);
+			chunkCodecs.push_back(bestCodec);
 		}
 		else {
-			dest.putData(inBuf, inBufLen);
+			dest.putData(inBuf.data(), inBufLen);
+			chunkCodecs.push_back(Compressor::CT_NONE);
 		}
 	}
-	delete[] inBuf;
-	delete[] outBuf;
 	
 	progressInfo.end("CompressedMmappedFile::create completed");
 
 	sserialize::UByteArrayAdapter::OffsetType dataSize = dest.tellPutPtr() - beginning;
 	
 	Static::SortedOffsetIndexPrivate::create(destOffsets, dest);
-	dest.putData(chunkTypeBitSet.data());
+	dest.putData(chunkCodecs);
 
 	std::vector<uint8_t> header(COMPRESSED_MMAPPED_FILE_HEADER_SIZE, 0);
 	header[0] = chunkSizeExponent;
 	p_u40(src.size(), &header[1]);
 	p_u40(dataSize, &header[6]);
+	header[11] = codecs.front();
 	header[COMPRESSED_MMAPPED_FILE_HEADER_SIZE-1] = COMPRESSED_MMAPPED_FILE_VERSION;
 	
 	dest.putData(header);
@@ -165,10 +231,16 @@ m_size(0),
 m_fd(-1),
 m_pageSize(sysconf(_SC_PAGE_SIZE)),
 m_compressedSize(0),
+m_chunkIndexData(0),
+m_chunkIndexMapLen(0),
+m_codec(Compressor::CT_NONE),
+m_fileId(0),
 m_chunkShift(0),
 m_chunkMask(0),
 m_maxOccupyCount(32),
-m_cache(0, 0xFFFFFFFF)
+m_cache(0, 0xFFFFFFFF),
+m_decodeAhead(2),
+m_lastChunk(std::numeric_limits<ChunkIndexType>::max())
 {}
 
 CompressedMmappedFilePrivate::~CompressedMmappedFilePrivate() {
@@ -176,23 +248,18 @@ CompressedMmappedFilePrivate::~CompressedMmappedFilePrivate() {
 }
 
 void CompressedMmappedFilePrivate::setCacheCount(sserialize::CompressedMmappedFilePrivate::ChunkIndexType count) {
-	if (valid() && chunkSize()*count > m_decTileFile.size()) {
-		m_decTileFile.resize(chunkSize()*count);
-		//repopulate free list
-		m_freeList.clear();
-		m_freeList.reserve(count);
-		for(std::size_t i = 0; i < count; ++i)
-			m_freeList.push_back(i);
-	}
-	m_maxOccupyCount = count;
+	m_maxOccupyCount = std::max<ChunkIndexType>(count, 1);
 	uint32_t dummy1, dummy2;
 	while(m_cache.occupyCount() > 0) {
 		evict(dummy1, dummy2);
 	}
 	
-	m_chunkStorage.resize(count, 0);
+	m_chunkStorage.assign(m_maxOccupyCount, ChunkDataPtr());
 }
 
+void CompressedMmappedFilePrivate::setDecodeAhead(uint32_t chunkCount) {
+	m_decodeAhead = chunkCount;
+}
 
 bool CompressedMmappedFilePrivate::do_open() {
 	OffsetType fileSize;
@@ -219,17 +286,31 @@ bool CompressedMmappedFilePrivate::do_open() {
 	SSERIALIZE_EQUAL_LENGTH_CHECK(COMPRESSED_MMAPPED_FILE_HEADER_SIZE, ::read(m_fd, headerData, COMPRESSED_MMAPPED_FILE_HEADER_SIZE), "sserialize::CompressedMmappedFile::open");
 	::lseek64(m_fd, 0, SEEK_SET);
 	
-	if (headerData[COMPRESSED_MMAPPED_FILE_HEADER_SIZE-1] != COMPRESSED_MMAPPED_FILE_VERSION) {
+	uint8_t version = headerData[COMPRESSED_MMAPPED_FILE_HEADER_SIZE-1];
+	std::size_t headerSize;
+	//header fields start at header
+	const uint8_t * header;
+	if (version == COMPRESSED_MMAPPED_FILE_VERSION) {
+		headerSize = COMPRESSED_MMAPPED_FILE_HEADER_SIZE;
+		header = headerData;
+		m_codec = Compressor::CompressionTypes(header[11]);
+	}
+	else if (version == 1) {
+		headerSize = COMPRESSED_MMAPPED_FILE_V1_HEADER_SIZE;
+		header = headerData + (COMPRESSED_MMAPPED_FILE_HEADER_SIZE-COMPRESSED_MMAPPED_FILE_V1_HEADER_SIZE);
+		m_codec = Compressor::CT_LZO;
+	}
+	else {
 		sserialize::err("CompressedMmappedFile::open", "Wrong version for file " + m_fileName);
 		::close(m_fd);
 		m_fd = -1;
 		return false;
 	}
 	
-	m_chunkShift = headerData[0];
+	m_chunkShift = header[0];
 	m_chunkMask = createMask(m_chunkShift);
-	m_size = up_u40(&headerData[1]);
-	m_compressedSize = up_u40(&headerData[6]);
+	m_size = up_u40(&header[1]);
+	m_compressedSize = up_u40(&header[6]);
 	
 	if ( (std::size_t) (m_compressedSize / chunkSize()) + 1 > (std::size_t) std::numeric_limits<ChunkIndexType>::max() ) {
 		throw sserialize::OutOfBoundsException("CompressedMmappedFile: too many chunks");
@@ -238,7 +319,7 @@ bool CompressedMmappedFilePrivate::do_open() {
 	//prepare the data for the index
 	size_t mapOverHead = (m_compressedSize % m_pageSize);
 	off_t beginOffset = m_compressedSize - mapOverHead; //offset in pageSizes
-	size_t mapLen = fileSize - COMPRESSED_MMAPPED_FILE_HEADER_SIZE - beginOffset;
+	size_t mapLen = fileSize - headerSize - beginOffset;
 	m_chunkIndexData = (uint8_t*) ::mmap(0, mapLen, PROT_READ, MAP_SHARED, m_fd, beginOffset);
 	if (m_chunkIndexData == MAP_FAILED) {
 		sserialize::err("CompressedMmappedFile", "Maping the chunk index data failed");
@@ -259,55 +340,86 @@ bool CompressedMmappedFilePrivate::do_open() {
 		m_fd = -1;
 		return false;
 	}
-	m_chunkTypeBitSet = DynamicBitSet(chunkIndexAdap+m_chunkIndex.getSizeInBytes());
-	
-	//prepare the cache
-	if (!MmappedFile::createCacheFile(chunkSize()*m_maxOccupyCount, m_decTileFile)) {
-		sserialize::err("CompressedMmappedFile", "Creating the decompression storage failed");
-		m_chunkIndex = Static::SortedOffsetIndex();
-		::munmap(m_chunkIndexData, mapLen);
-		::close(m_fd);
-		m_fd = -1;
+	m_chunkIndexMapLen = mapLen;
+	
+	UByteArrayAdapter chunkCodecsAdap = chunkIndexAdap+m_chunkIndex.getSizeInBytes();
+	m_chunkCodecs.assign(m_chunkIndex.size(), Compressor::CT_NONE);
+	if (version == 1) {
+		DynamicBitSet chunkTypeBitSet(chunkCodecsAdap);
+		for(ChunkIndexType i(0), s(m_chunkIndex.size()); i < s; ++i) {
+			if (chunkTypeBitSet.isSet(i)) {
+				m_chunkCodecs[i] = Compressor::CT_LZO;
+			}
+		}
+	}
+	else if (chunkCodecsAdap.size() >= m_chunkCodecs.size()) {
+		chunkCodecsAdap.getData(0, m_chunkCodecs.data(), m_chunkCodecs.size());
+	}
+	else {
+		sserialize::err("CompressedMmappedFile::open", "Chunk codecs are missing in " + m_fileName);
+		do_close();
 		return false;
 	}
 	
-	m_freeList.reserve(m_maxOccupyCount);
-	for(std::size_t i = 0; i < m_maxOccupyCount; ++i)
-		m_freeList.push_back(i);
-	m_chunkStorage = std::vector<uint8_t*>(m_maxOccupyCount, 0);
-	
+	m_decompressors.clear();
+	for(uint8_t ct : m_chunkCodecs) {
+		if (!Compressor::supported(ct)) {
+			sserialize::err("CompressedMmappedFile::open", "Unsupported codec " + std::to_string(ct) + " in " + m_fileName);
+			do_close();
+			return false;
+		}
+		if (ct >= m_decompressors.size()) {
+			m_decompressors.resize(ct+1);
+		}
+		if (m_decompressors[ct].type() != ct) {
+			m_decompressors[ct] = Compressor(Compressor::CompressionTypes(ct));
+		}
+	}
 	
+	//prepare the cache
+	m_fileId = detail::CompressedMmappedFile::SharedState::instance().nextFileId.fetch_add(1, std::memory_order_relaxed);
+	m_chunkStorage.assign(m_maxOccupyCount, ChunkDataPtr());
 	m_cache = MyCacheType(m_chunkIndex.size(), std::numeric_limits<uint32_t>::max());
+	m_lastChunk = std::numeric_limits<ChunkIndexType>::max();
 	
 	return true;
 }
 
 bool CompressedMmappedFilePrivate::do_close() {
+	//background decompression needs the file
+	waitForInFlight();
+	
 	uint32_t dummy1, dummy2;
 	while(m_cache.occupyCount() > 0) {
 		evict(dummy1, dummy2);
 	}
+	
+	//nobody will ask for chunks of this file again
+	if (m_fd >= 0) {
+		auto & sharedCache = detail::CompressedMmappedFile::SharedState::instance().cache;
+		for(ChunkIndexType i(0), s(m_chunkCodecs.size()); i < s; ++i) {
+			if (m_chunkCodecs[i] != Compressor::CT_NONE) {
+				sharedCache.erase(std::make_pair(m_fileId, i));
+			}
+		}
+	}
 
 	m_cache.clear();
-	m_freeList.clear();
-	m_decTileFile.close();
 	m_chunkIndex = Static::SortedOffsetIndex();
 	m_chunkStorage.clear();
+	m_chunkCodecs.clear();
+	m_decompressors.clear();
 	
-	//unmap the chunk index
+	if (m_fd < 0) {
+		return false;
+	}
 	
-	OffsetType fileSize;
-	struct ::stat64 stFileInfo;
-	if (::fstat64(m_fd,&stFileInfo) == 0) {
-		fileSize = stFileInfo.st_size;
+	//unmap the chunk index
+	if (m_chunkIndexData) {
+		::munmap(m_chunkIndexData, m_chunkIndexMapLen);
+		m_chunkIndexData = 0;
+		m_chunkIndexMapLen = 0;
 	}
-	else
-		return false;
-
-	size_t beginOffset = m_compressedSize / m_pageSize; //offset in pageSizes
-	size_t mapLen = fileSize - (m_pageSize*beginOffset+6);
-	::munmap(m_chunkIndexData, mapLen);
-	m_chunkIndexData = 0;
 	
 	//and close the file
 	m_size = 0;
@@ -316,7 +428,7 @@ bool CompressedMmappedFilePrivate::do_close() {
 	return true;
 }
 
-void CompressedMmappedFilePrivate::mmapChunkParameters(sserialize::CompressedMmappedFilePrivate::ChunkIndexType chunk, size_t& mapOverHead, off_t& beginOffset, size_t& mapLen) {
+void CompressedMmappedFilePrivate::mmapChunkParameters(sserialize::CompressedMmappedFilePrivate::ChunkIndexType chunk, size_t& mapOverHead, off_t& beginOffset, size_t& mapLen) const {
 	SizeType offset = m_chunkIndex.at(chunk);
 	ChunkSizeType chunkLen;
 	if (chunk+1 < m_chunkIndex.size()) {
@@ -331,7 +443,7 @@ void CompressedMmappedFilePrivate::mmapChunkParameters(sserialize::CompressedMma
 }
 
 
-uint8_t* CompressedMmappedFilePrivate::mmapChunk(sserialize::CompressedMmappedFilePrivate::ChunkIndexType chunk) {
+CompressedMmappedFilePrivate::ChunkDataPtr CompressedMmappedFilePrivate::mmapChunk(sserialize::CompressedMmappedFilePrivate::ChunkIndexType chunk) const {
 	size_t mapOverHead;
 	off_t beginOffset;
 	size_t mapLen;
@@ -341,24 +453,14 @@ uint8_t* CompressedMmappedFilePrivate::mmapChunk(sserialize::CompressedMmappedFi
 	uint8_t * data = (uint8_t*) mmap(0, mapLen, PROT_READ, MAP_SHARED, m_fd, beginOffset);
 	if (data == MAP_FAILED) {
 		sserialize::err("CompressedMmappedFile", "Maping a chunk failed");
-		return 0;
+		return ChunkDataPtr();
 	}
-	return data+mapOverHead;
+	return ChunkDataPtr(data+mapOverHead, [data, mapLen](uint8_t *) {
+		::munmap(data, mapLen);
+	});
 }
 
-void CompressedMmappedFilePrivate::ummapChunk(sserialize::CompressedMmappedFilePrivate::ChunkIndexType chunk, uint8_t* data) {
-	size_t mapOverHead;
-	off_t beginOffset;
-	size_t mapLen;
-	
-	mmapChunkParameters(chunk, mapOverHead, beginOffset, mapLen);
-	
-	::munmap(data-mapOverHead, mapLen);
-}
-
-
-
-bool CompressedMmappedFilePrivate::do_unpack(sserialize::CompressedMmappedFilePrivate::ChunkIndexType chunk, uint8_t* dest) {
+CompressedMmappedFilePrivate::ChunkDataPtr CompressedMmappedFilePrivate::do_unpack(sserialize::CompressedMmappedFilePrivate::ChunkIndexType chunk) const {
 	size_t mapOverHead;
 	off_t beginOffset;
 	size_t mapLen;
@@ -369,28 +471,94 @@ bool CompressedMmappedFilePrivate::do_unpack(sserialize::CompressedMmappedFilePr
 	if (data == MAP_FAILED) {
 		sserialize::err("CompressedMmappedFile", "Maping a chunk failed");
 		::perror("CompressedMmappedFile::do_unpack::mmap");
-		return false;
+		return ChunkDataPtr();
 	}
 	
-	lzo_uint destLen = chunkSize();
-	int ok = ::lzo1x_decompress(data+mapOverHead, mapLen-mapOverHead, dest, &destLen, 0);
+	ChunkDataPtr dest(new uint8_t[chunkSize()], std::default_delete<uint8_t[]>());
+	int64_t destLen = m_decompressors[m_chunkCodecs[chunk]].decompress(data+mapOverHead, mapLen-mapOverHead, dest.get(), chunkSize());
 	
 	::munmap(data, mapLen);
 	
-	return (ok == LZO_E_OK);
+	if (destLen != (int64_t) sizeOfChunk(chunk)) {
+		sserialize::err("CompressedMmappedFile", "Decompressing chunk " + std::to_string(chunk) + " of " + m_fileName + " failed");
+		return ChunkDataPtr();
+	}
+	return dest;
+}
+
+CompressedMmappedFilePrivate::ChunkDataPtr CompressedMmappedFilePrivate::populate(sserialize::CompressedMmappedFilePrivate::ChunkIndexType chunk) {
+	if (m_chunkCodecs[chunk] == Compressor::CT_NONE) { //no compression, just mmapp the chunk
+		return mmapChunk(chunk);
+	}
+	auto & sharedCache = detail::CompressedMmappedFile::SharedState::instance().cache;
+	ChunkDataPtr data;
+	if (sharedCache.find(std::make_pair(m_fileId, chunk), data)) {
+		return data;
+	}
+	std::shared_future<ChunkDataPtr> inFlight;
+	{
+		std::lock_guard<std::mutex> lck(m_inFlightLock);
+		auto it = m_inFlight.find(chunk);
+		if (it != m_inFlight.end()) {
+			inFlight = it->second;
+		}
+	}
+	if (inFlight.valid()) {
+		return inFlight.get();
+	}
+	data = do_unpack(chunk);
+	if (data) {
+		sharedCache.insert(std::make_pair(m_fileId, chunk), data, sizeOfChunk(chunk));
+	}
+	return data;
+}
+
+void CompressedMmappedFilePrivate::decodeAhead(ChunkIndexType chunk) {
+	bool sequential = (chunk == m_lastChunk+1);
+	m_lastChunk = chunk;
+	if (!m_decodeAhead || !sequential) {
+		return;
+	}
+	auto & state = detail::CompressedMmappedFile::SharedState::instance();
+	ChunkIndexType end = (ChunkIndexType) std::min<std::size_t>(std::size_t(chunk)+1+m_decodeAhead, m_chunkCodecs.size());
+	for(ChunkIndexType i(chunk+1); i < end; ++i) {
+		if (m_chunkCodecs[i] == Compressor::CT_NONE || m_cache.occupied(i) || state.cache.contains(std::make_pair(m_fileId, i))) {
+			continue;
+		}
+		auto promise = std::make_shared< std::promise<ChunkDataPtr> >();
+		{
+			std::lock_guard<std::mutex> lck(m_inFlightLock);
+			if (m_inFlight.count(i)) {
+				continue;
+			}
+			m_inFlight[i] = promise->get_future().share();
+		}
+		state.pool.sheduleTask([this, i, promise]() {
+			ChunkDataPtr data = do_unpack(i);
+			if (data) {
+				detail::CompressedMmappedFile::SharedState::instance().cache.insert(std::make_pair(m_fileId, i), data, sizeOfChunk(i));
+			}
+			{
+				std::lock_guard<std::mutex> lck(m_inFlightLock);
+				m_inFlight.erase(i);
+			}
+			//this may be gone from here on
+			promise->set_value(data);
+		});
+	}
 }
 
-bool CompressedMmappedFilePrivate::populate(sserialize::CompressedMmappedFilePrivate::ChunkIndexType chunk, uint8_t*& dest) {
-	if (m_chunkTypeBitSet.isSet(chunk)) {
-		//get a free chunk from the free list (there always has to be one, otherwise this function was called without evition)
-		SizeType decChunkOffset = m_freeList.back() * (SizeType) chunkSize();
-		m_freeList.pop_back();
-		dest = m_decTileFile.data()+decChunkOffset;
-		return do_unpack(chunk, dest);
+void CompressedMmappedFilePrivate::waitForInFlight() {
+	std::vector< std::shared_future<ChunkDataPtr> > inFlight;
+	{
+		std::lock_guard<std::mutex> lck(m_inFlightLock);
+		for(const auto & x : m_inFlight) {
+			inFlight.push_back(x.second);
+		}
 	}
-	else { //no compression, just mmapp the chunk
-		dest = mmapChunk(chunk);
-		return (dest != 0);
+	//tasks remove themselves from m_inFlight before they are done
+	for(const auto & x : inFlight) {
+		x.wait();
 	}
 }
 
@@ -400,19 +568,8 @@ bool CompressedMmappedFilePrivate::evict(sserialize::CompressedMmappedFilePrivat
 	evictedChunk = m_cache.findVictim();
 	associatedChunkStoragePostion = m_cache.directAccess(evictedChunk);
 	m_cache.evict(evictedChunk);
-	
-	//check the type of the cacheline
-	if (m_chunkTypeBitSet.isSet(evictedChunk)) { //compressed tile
-		uint8_t * decTileDataBegin = m_decTileFile.data();
-		std::ptrdiff_t decTileNum = m_chunkStorage[associatedChunkStoragePostion] - decTileDataBegin;
-		decTileNum /= chunkSize();
-		m_freeList.push_back(decTileNum);
-	}
-	else {
-		ummapChunk(evictedChunk, m_chunkStorage[associatedChunkStoragePostion]);
-	}
-	
-	m_chunkStorage[associatedChunkStoragePostion] = 0;
+	//decompressed chunks may still be in the shared cache, mmapped chunks are unmapped once nobody uses them
+	m_chunkStorage[associatedChunkStoragePostion].reset();
 	return true;
 }
 
@@ -422,7 +579,12 @@ CompressedMmappedFilePrivate::ChunkIndexType CompressedMmappedFilePrivate::chunk
 	return ((m_compressedSize % chunkSize()) ? tmp+1 : tmp); 
 }
 
-uint8_t * CompressedMmappedFilePrivate::chunkData(const sserialize::CompressedMmappedFilePrivate::ChunkIndexType chunk) {
+CompressedMmappedFilePrivate::ChunkSizeType CompressedMmappedFilePrivate::sizeOfChunk(ChunkIndexType chunk) const {
+	//only the last chunk may be smaller
+	return std::min<SizeType>(chunkSize(), m_size - (SizeType(chunk) << m_chunkShift));
+}
+
+CompressedMmappedFilePrivate::ChunkDataPtr CompressedMmappedFilePrivate::chunkDataPtr(const sserialize::CompressedMmappedFilePrivate::ChunkIndexType chunk) {
 	uint32_t chunkStoragePostion = m_cache[chunk]; //returns -1 if not set, usage will be increased by one, but also reset to zero below due to insertion
 	if (chunkStoragePostion < std::numeric_limits<uint32_t>::max()) {
 		return m_chunkStorage[chunkStoragePostion];
@@ -436,16 +598,21 @@ uint8_t * CompressedMmappedFilePrivate::chunkData(const sserialize::CompressedMm
 			chunkStoragePostion = m_cache.occupyCount();
 		}
 		
-		uint8_t* & data = m_chunkStorage[chunkStoragePostion];
-		if (!populate(chunk, data))
-			data = 0;
+		ChunkDataPtr & data = m_chunkStorage[chunkStoragePostion];
+		data = populate(chunk);
 		
 		m_cache.insert(chunk, chunkStoragePostion);
+		decodeAhead(chunk);
 		
 		return data;
 	}
 }
 
+uint8_t * CompressedMmappedFilePrivate::chunkData(const sserialize::CompressedMmappedFilePrivate::ChunkIndexType chunk) {
+	//the chunk stays referenced by m_chunkStorage until it is evicted
+	return chunkDataPtr(chunk).get();
+}
+
 uint8_t * CompressedMmappedFilePrivate::data(const CompressedMmappedFilePrivate::SizeType offset) {
 	ChunkIndexType chunk = this->chunk(offset);
 	SizeType inChunkOffSet = this->inChunkOffSet(offset);
@@ -461,20 +628,21 @@ void CompressedMmappedFilePrivate::read(const CompressedMmappedFilePrivate::Size
 	if (offset+len > m_size) {
 		len =  m_size - offset;
 	}
-	
-	SizeType chunkSize = this->chunkSize();
+	if (!len) {
+		return;
+	}
 	
 	ChunkIndexType beginChunk = chunk(offset);
 	ChunkIndexType endChunk = chunk(offset+len-1);
-
-	::memmove(dest, chunkData(beginChunk)+inChunkOffSet(offset), sizeof(uint8_t)*std::min<SizeType>(len, chunkSize-inChunkOffSet(offset)));
-	dest += sizeof(uint8_t)*std::min<ChunkSizeType>(len, chunkSize-inChunkOffSet(offset));
-	for(ChunkIndexType i = beginChunk+1; i < endChunk; ++i) {//copy all chunks from within
-		::memmove(dest, chunkData(i), sizeof(uint8_t)*chunkSize);
-		dest += chunkSize;
-	}
-	if (beginChunk < endChunk) { //copy things from the last chunk
-		::memmove(dest, chunkData(endChunk), sizeof(uint8_t)*inChunkOffSet(offset+len));
+	SizeType srcOffset = offset;
+	uint8_t * dest_end = dest+len;
+	for(ChunkIndexType i = beginChunk; i <= endChunk; ++i) {
+		//hold a reference in case the chunk gets evicted by chunks following it
+		ChunkDataPtr data = chunkDataPtr(i);
+		SizeType copyLen = std::min<SizeType>(dest_end-dest, chunkSize()-inChunkOffSet(srcOffset));
+		::memmove(dest, data.get()+inChunkOffSet(srcOffset), sizeof(uint8_t)*copyLen);
+		dest += copyLen;
+		srcOffset += copyLen;
 	}
 }
 
@@ -1,5 +1,6 @@
 #include <sserialize/storage/UByteArrayAdapter.h>
 #include <sserialize/storage/pack_unpack_functions.h>
+#include <sserialize/storage/varint_functions.h>
 #include <sserialize/utility/log.h>
 #include "UByteArrayAdapterPrivates/UByteArrayAdapterPrivates.h"
 #include <iostream>
@@ -50,6 +51,69 @@ sserialize::UByteArrayAdapter MemoryView::dataBase() const {
 	return m_priv->dataBase();
 }
 
+BorrowedView::BorrowedView(const uint8_t * data, const MyPrivate * priv, OffsetType offset, OffsetType size) :
+m_data(data),
+m_priv(priv),
+m_offset(offset),
+m_size(size)
+{}
+
+BorrowedView BorrowedView::slice(OffsetType pos, OffsetType size) const {
+	range_check(pos, size);
+	return BorrowedView(m_data ? m_data+pos : nullptr, m_priv, m_offset+pos, size);
+}
+
+BorrowedView::OffsetType BorrowedView::getData(OffsetType pos, uint8_t * dest, OffsetType len) const {
+	range_check(pos, 0);
+	len = std::min<OffsetType>(len, m_size-pos);
+	if (m_data) {
+		::memmove(dest, m_data+pos, len);
+	}
+	else if (len) {
+		m_priv->get(m_offset+pos, dest, len);
+	}
+	return len;
+}
+
+sserialize::UByteArrayAdapter BorrowedView::adapter() const {
+	if (!m_priv) {
+		return sserialize::UByteArrayAdapter();
+	}
+	return sserialize::UByteArrayAdapter(const_cast<MyPrivate*>(m_priv), m_offset, m_size);
+}
+
+void BorrowedView::throwOutOfBounds(OffsetType pos, OffsetType length) const {
+	throw OutOfBoundsException(pos, length, m_size);
+}
+
+uint8_t BorrowedView::privGetUint8(OffsetType pos) const {
+	return m_priv->getUint8(m_offset+pos);
+}
+
+uint16_t BorrowedView::privGetUint16(OffsetType pos) const {
+	return m_priv->getUint16(m_offset+pos);
+}
+
+uint32_t BorrowedView::privGetUint24(OffsetType pos) const {
+	return m_priv->getUint24(m_offset+pos);
+}
+
+uint32_t BorrowedView::privGetUint32(OffsetType pos) const {
+	return m_priv->getUint32(m_offset+pos);
+}
+
+uint64_t BorrowedView::privGetUint64(OffsetType pos) const {
+	return m_priv->getUint64(m_offset+pos);
+}
+
+uint32_t BorrowedView::privGetVlPackedUint32(OffsetType pos, int * length) const {
+	return m_priv->getVlPackedUint32(m_offset+pos, length);
+}
+
+uint64_t BorrowedView::privGetVlPackedUint64(OffsetType pos, int * length) const {
+	return m_priv->getVlPackedUint64(m_offset+pos, length);
+}
+
 }}//end namespace detail::__UByteArrayAdapter
 
 //CTORS
@@ -103,6 +167,10 @@ UByteArrayAdapter(new UByteArrayAdapterPrivateVector(data), 0, data->size())
 	m_priv->setDeleteOnClose(deleteOnClose);
 }
 
+UByteArrayAdapter::UByteArrayAdapter(std::vector< uint8_t >* data, const RCPtrWrapper<BufferPool> & pool) :
+UByteArrayAdapter(new UByteArrayAdapterPrivatePooledVector(data, pool), 0, data->size())
+{}
+
 
 UByteArrayAdapter::UByteArrayAdapter(const UByteArrayAdapter & adapter) :
 m_priv(adapter.m_priv),
@@ -693,6 +761,19 @@ const UByteArrayAdapter::MemoryView UByteArrayAdapter::getMemView(const OffsetTy
 	return const_cast<UByteArrayAdapter*>(this)->getMemView(pos, size);
 }
 
+UByteArrayAdapter::BorrowedView UByteArrayAdapter::getBorrowedView(const OffsetType pos, OffsetType size) const {
+	range_check(pos, size);
+	const uint8_t * data = 0;
+	if (size && m_priv->isContiguous()) {
+		data = &(*m_priv)[m_offSet+pos];
+	}
+	return BorrowedView(data, m_priv.get(), m_offSet+pos, size);
+}
+
+UByteArrayAdapter::BorrowedView UByteArrayAdapter::asBorrowedView() const {
+	return getBorrowedView(0, size());
+}
+
 INLINE_WITH_LTO
 int64_t UByteArrayAdapter::getInt64(const OffsetType pos) const {
 	range_check(pos, 8);
@@ -804,6 +885,76 @@ int32_t UByteArrayAdapter::getVlPackedInt32(const OffsetType pos, int * length)
 	return res;
 }
 
+namespace {
+
+template<typename T>
+UByteArrayAdapter::OffsetType getVlPackedArray(const UByteArrayAdapter & d, UByteArrayAdapter::OffsetType pos, T * dest, UByteArrayAdapter::SizeType count) {
+	typedef UByteArrayAdapter::OffsetType OffsetType;
+	if (!count) {
+		return 0;
+	}
+	if (pos >= d.size()) {
+		throw OutOfBoundsException(pos, 1, d.size());
+	}
+	std::size_t bytes = 0;
+	if (d.isContiguous()) {
+		const uint8_t * src = &d[pos];
+		if (varint::decode(src, src+(d.size()-pos), dest, count, bytes) != count) {
+			throw OutOfBoundsException(pos, bytes, d.size());
+		}
+		return bytes;
+	}
+	uint8_t buffer[4096];
+	OffsetType cur = pos;
+	while (count) {
+		OffsetType len = d.getData(cur, buffer, sizeof(buffer));
+		std::size_t decoded = varint::decode(buffer, buffer+len, dest, count, bytes);
+		if (!decoded) {
+			throw OutOfBoundsException(pos, cur-pos+len, d.size());
+		}
+		dest += decoded;
+		count -= decoded;
+		cur += bytes;
+	}
+	return cur-pos;
+}
+
+}//end anonymous namespace
+
+UByteArrayAdapter::OffsetType UByteArrayAdapter::getVlPackedUint64Array(const OffsetType pos, uint64_t * dest, SizeType count) const {
+	return getVlPackedArray(*this, pos, dest, count);
+}
+
+UByteArrayAdapter::OffsetType UByteArrayAdapter::getVlPackedInt64Array(const OffsetType pos, int64_t * dest, SizeType count) const {
+	uint64_t * udest = reinterpret_cast<uint64_t*>(dest);
+	OffsetType len = getVlPackedArray(*this, pos, udest, count);
+	varint::toSigned(udest, udest+count);
+	return len;
+}
+
+UByteArrayAdapter::OffsetType UByteArrayAdapter::getVlPackedUint32Array(const OffsetType pos, uint32_t * dest, SizeType count) const {
+	return getVlPackedArray(*this, pos, dest, count);
+}
+
+UByteArrayAdapter::OffsetType UByteArrayAdapter::getVlPackedInt32Array(const OffsetType pos, int32_t * dest, SizeType count) const {
+	uint32_t * udest = reinterpret_cast<uint32_t*>(dest);
+	OffsetType len = getVlPackedArray(*this, pos, udest, count);
+	varint::toSigned(udest, udest+count);
+	return len;
+}
+
+UByteArrayAdapter::OffsetType UByteArrayAdapter::getVlPackedDeltaUint64Array(const OffsetType pos, uint64_t * dest, SizeType count, uint64_t start) const {
+	OffsetType len = getVlPackedArray(*this, pos, dest, count);
+	varint::prefixSum(dest, dest+count, start);
+	return len;
+}
+
+UByteArrayAdapter::OffsetType UByteArrayAdapter::getVlPackedDeltaUint32Array(const OffsetType pos, uint32_t * dest, SizeType count, uint32_t start) const {
+	OffsetType len = getVlPackedArray(*this, pos, dest, count);
+	varint::prefixSum(dest, dest+count, start);
+	return len;
+}
+
 INLINE_WITH_LTO
 UByteArrayAdapter::OffsetType UByteArrayAdapter::getOffset(const OffsetType pos) const {
 	range_check(pos, SSERIALIZE_OFFSET_BYTE_COUNT);
@@ -1312,6 +1463,30 @@ int32_t UByteArrayAdapter::getVlPackedInt32() {
 	return res;
 }
 
+void UByteArrayAdapter::getVlPackedUint64Array(uint64_t * dest, SizeType count) {
+	m_getPtr += getVlPackedUint64Array(m_getPtr, dest, count);
+}
+
+void UByteArrayAdapter::getVlPackedInt64Array(int64_t * dest, SizeType count) {
+	m_getPtr += getVlPackedInt64Array(m_getPtr, dest, count);
+}
+
+void UByteArrayAdapter::getVlPackedUint32Array(uint32_t * dest, SizeType count) {
+	m_getPtr += getVlPackedUint32Array(m_getPtr, dest, count);
+}
+
+void UByteArrayAdapter::getVlPackedInt32Array(int32_t * dest, SizeType count) {
+	m_getPtr += getVlPackedInt32Array(m_getPtr, dest, count);
+}
+
+void UByteArrayAdapter::getVlPackedDeltaUint64Array(uint64_t * dest, SizeType count, uint64_t start) {
+	m_getPtr += getVlPackedDeltaUint64Array(m_getPtr, dest, count, start);
+}
+
+void UByteArrayAdapter::getVlPackedDeltaUint32Array(uint32_t * dest, SizeType count, uint32_t start) {
+	m_getPtr += getVlPackedDeltaUint32Array(m_getPtr, dest, count, start);
+}
+
 UByteArrayAdapter::OffsetType UByteArrayAdapter::getData(uint8_t * dest, UByteArrayAdapter::OffsetType len) {
 	len = getData(m_getPtr, dest, len);
 	m_getPtr += len;
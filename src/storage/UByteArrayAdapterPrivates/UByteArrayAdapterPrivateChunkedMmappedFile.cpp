@@ -6,7 +6,31 @@ SSERIALIZE_NAMESPACE_INLINE_UBA_NON_CONTIGUOUS
 namespace UByteArrayAdapterNonContiguous {
 
 UByteArrayAdapterPrivateChunkedMmappedFile::UByteArrayAdapterPrivateChunkedMmappedFile(const ChunkedMmappedFile& file) : m_file(file) {}
-UByteArrayAdapterPrivateChunkedMmappedFile::~UByteArrayAdapterPrivateChunkedMmappedFile() {}
+UByteArrayAdapterPrivateChunkedMmappedFile::~UByteArrayAdapterPrivateChunkedMmappedFile() {
+	//leases have to be gone before the file is closed
+	releaseReferencedChunks();
+}
+
+uint8_t * UByteArrayAdapterPrivateChunkedMmappedFile::pinnedData(UByteArrayAdapter::OffsetType pos) const {
+	std::lock_guard<std::mutex> locker(m_referencedChunksLock);
+	for(const ChunkedMmappedFile::ChunkLease & l : m_referencedChunks) {
+		if (l.contains(pos)) {
+			return l.at(pos);
+		}
+	}
+	//replaces the oldest lease, hence at most ReferencedChunkCount chunks are pinned by this storage
+	ChunkedMmappedFile::ChunkLease & l = m_referencedChunks[m_nextReferencedChunk];
+	m_nextReferencedChunk = (m_nextReferencedChunk+1) % ReferencedChunkCount;
+	l = m_file.lease(pos);
+	return l.at(pos);
+}
+
+void UByteArrayAdapterPrivateChunkedMmappedFile::releaseReferencedChunks() {
+	std::lock_guard<std::mutex> locker(m_referencedChunksLock);
+	for(ChunkedMmappedFile::ChunkLease & l : m_referencedChunks) {
+		l = ChunkedMmappedFile::ChunkLease();
+	}
+}
 
 UByteArrayAdapter::OffsetType UByteArrayAdapterPrivateChunkedMmappedFile::size() const {
 	return m_file.size();
@@ -18,6 +42,7 @@ bool UByteArrayAdapterPrivateChunkedMmappedFile::shrinkStorage(UByteArrayAdapter
 #ifdef SSERIALIZE_WITH_THREADS
 	std::lock_guard<std::mutex> locker(m_fileLock);
 #endif
+	releaseReferencedChunks();
 	return m_file.resize(size);
 }
 
@@ -26,8 +51,10 @@ bool UByteArrayAdapterPrivateChunkedMmappedFile::growStorage(UByteArrayAdapter::
 #ifdef SSERIALIZE_WITH_THREADS
 	std::lock_guard<std::mutex> locker(m_fileLock);
 #endif
-	if (m_file.size() < size)
+	if (m_file.size() < size) {
+		releaseReferencedChunks();
 		return m_file.resize(size);
+	}
 	return true;
 }
 
@@ -35,19 +62,24 @@ void UByteArrayAdapterPrivateChunkedMmappedFile::setDeleteOnClose(bool del) {
 	m_file.setDeleteOnClose(del);
 }
 
-//Access functions
-uint8_t & UByteArrayAdapterPrivateChunkedMmappedFile::operator[](UByteArrayAdapter::OffsetType pos) {
+void UByteArrayAdapterPrivateChunkedMmappedFile::advice(UByteArrayAdapter::AdviseType at, UByteArrayAdapter::SizeType begin, UByteArrayAdapter::SizeType size) {
+	if (at == UByteArrayAdapter::AT_READ || at == UByteArrayAdapter::AT_LOAD) {
 #ifdef SSERIALIZE_WITH_THREADS
-	std::lock_guard<std::mutex> locker(m_fileLock);
+		std::lock_guard<std::mutex> locker(m_fileLock);
 #endif
-	return m_file.operator[](pos);
+		m_file.prefetch(begin, size);
+	}
+}
+
+//Access functions
+//A reference cannot carry a lease, hence it stays valid until ReferencedChunkCount other chunks were referenced
+//or the storage is resized or destroyed
+uint8_t & UByteArrayAdapterPrivateChunkedMmappedFile::operator[](UByteArrayAdapter::OffsetType pos) {
+	return *pinnedData(pos);
 }
 
 const uint8_t & UByteArrayAdapterPrivateChunkedMmappedFile::operator[](UByteArrayAdapter::OffsetType pos) const {
-#ifdef SSERIALIZE_WITH_THREADS
-	std::lock_guard<std::mutex> locker(m_fileLock);
-#endif
-	return m_file.operator[](pos);
+	return *pinnedData(pos);
 }
 
 int64_t UByteArrayAdapterPrivateChunkedMmappedFile::getInt64(UByteArrayAdapter::OffsetType pos) const {
@@ -292,10 +324,11 @@ void UByteArrayAdapterPrivateChunkedMmappedFile::putUint16(UByteArrayAdapter::Of
 }
 
 void UByteArrayAdapterPrivateChunkedMmappedFile::putUint8(UByteArrayAdapter::OffsetType pos, uint8_t value) {
+	SizeType len = 1;
 #ifdef SSERIALIZE_WITH_THREADS
 	std::lock_guard<std::mutex> locker(m_fileLock);
 #endif
-	m_file[pos] = value;
+	m_file.write(&value, pos, len);
 }
 
 void UByteArrayAdapterPrivateChunkedMmappedFile::putOffset(UByteArrayAdapter::OffsetType pos, UByteArrayAdapter::OffsetType value) {
@@ -2,9 +2,8 @@
 #define SSERIALIZE_UBYTE_ARRAY_ADAPTER_CHUNKED_MMAPPED_FILE_H
 #include "UByteArrayAdapterPrivate.h"
 #include <sserialize/storage/ChunkedMmappedFile.h>
-#ifdef SSERIALIZE_WITH_THREADS
+#include <array>
 #include <mutex>
-#endif
 
 namespace sserialize {
 #ifndef SSERIALIZE_UBA_ONLY_CONTIGUOUS
@@ -20,6 +19,15 @@ private:
 #ifdef SSERIALIZE_WITH_THREADS
 	mutable std::mutex m_fileLock;
 #endif
+	static constexpr std::size_t ReferencedChunkCount = 4;
+	///the last chunks operator[] returned a reference into, older leases are released
+	mutable std::array<ChunkedMmappedFile::ChunkLease, ReferencedChunkCount> m_referencedChunks;
+	mutable std::size_t m_nextReferencedChunk{0};
+	///guards m_referencedChunks independent of SSERIALIZE_WITH_THREADS
+	mutable std::mutex m_referencedChunksLock;
+private:
+	uint8_t * pinnedData(UByteArrayAdapter::OffsetType pos) const;
+	void releaseReferencedChunks();
 public:
 	UByteArrayAdapterPrivateChunkedMmappedFile(const ChunkedMmappedFile& file);
 	virtual ~UByteArrayAdapterPrivateChunkedMmappedFile();
@@ -31,6 +39,9 @@ public:
 	virtual bool growStorage(UByteArrayAdapter::OffsetType size);
 
 	virtual void setDeleteOnClose(bool del);
+	
+	///AT_READ and AT_LOAD prefetch the region in the background
+	virtual void advice(UByteArrayAdapter::AdviseType at, UByteArrayAdapter::SizeType begin, UByteArrayAdapter::SizeType size) override;
 
 //Access functions
 	virtual uint8_t & operator[](UByteArrayAdapter::OffsetType pos) ;
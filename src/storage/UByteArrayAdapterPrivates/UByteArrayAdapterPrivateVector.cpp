@@ -37,4 +37,15 @@ bool UByteArrayAdapterPrivateVector::growStorage(UByteArrayAdapter::OffsetType s
 	return true;
 }
 
+UByteArrayAdapterPrivatePooledVector::UByteArrayAdapterPrivatePooledVector(std::vector<uint8_t> * data, const RCPtrWrapper<BufferPool> & pool) :
+UByteArrayAdapterPrivateVector(data),
+m_buffer(data),
+m_pool(pool)
+{}
+
+UByteArrayAdapterPrivatePooledVector::~UByteArrayAdapterPrivatePooledVector() {
+	m_deleteOnClose = false;
+	m_pool->release(m_buffer);
+}
+
 } //end namespace sserialize
\ No newline at end of file
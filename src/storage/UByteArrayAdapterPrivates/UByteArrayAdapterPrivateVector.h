@@ -2,6 +2,7 @@
 #define UBYTE_ARRAY_ADAPTER_PRIVATE_VECTOR_H
 #include "UByteArrayAdapterPrivateContainer.h"
 #include "UByteArrayAdapterPrivateArray.h"
+#include <sserialize/storage/BufferPool.h>
 #include <vector>
 
 namespace sserialize {
@@ -17,6 +18,15 @@ public:
 	virtual bool growStorage(UByteArrayAdapter::OffsetType size) override;
 };
 
+///Hands its vector back to the pool on destruction
+class UByteArrayAdapterPrivatePooledVector: public UByteArrayAdapterPrivateVector {
+	std::vector<uint8_t> * m_buffer;
+	RCPtrWrapper<BufferPool> m_pool;
+public:
+	UByteArrayAdapterPrivatePooledVector(std::vector<uint8_t> * data, const RCPtrWrapper<BufferPool> & pool);
+	virtual ~UByteArrayAdapterPrivatePooledVector();
+};
+
 }
 
 #endif
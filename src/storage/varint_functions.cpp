@@ -0,0 +1,228 @@
+#include <sserialize/storage/varint_functions.h>
+
+#include <array>
+#include <limits>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+	#define SSERIALIZE_VARINT_HAS_X86_SIMD
+#endif
+
+namespace sserialize {
+namespace varint {
+namespace {
+
+template<typename T>
+constexpr std::size_t maxLength() {
+	return std::numeric_limits<T>::digits/7 + (std::numeric_limits<T>::digits % 7 ? 1 : 0);
+}
+
+//BEGIN scalar kernels
+
+///src has to contain at least maxLength<T>() bytes
+template<typename T>
+inline T decodeUnchecked(const uint8_t * & src) {
+	T result = 0;
+	for(std::size_t i(0); i < maxLength<T>(); ++i) {
+		uint8_t b = src[i];
+		result |= static_cast<T>(b & 0x7F) << (7*i);
+		if (!(b & 0x80)) {
+			src += i+1;
+			return result;
+		}
+	}
+	src += maxLength<T>();
+	return result;
+}
+
+///@return false if the number is not completely contained in [src, srcEnd), src is not changed in this case
+template<typename T>
+inline bool decodeChecked(const uint8_t * & src, const uint8_t * srcEnd, T & value) {
+	T result = 0;
+	const uint8_t * it = src;
+	for(std::size_t i(0); i < maxLength<T>(); ++i, ++it) {
+		if (it == srcEnd) {
+			return false;
+		}
+		result |= static_cast<T>(*it & 0x7F) << (7*i);
+		if (!(*it & 0x80)) {
+			++it;
+			break;
+		}
+	}
+	src = it;
+	value = result;
+	return true;
+}
+
+template<typename T>
+std::size_t decodeScalar(const uint8_t * & src, const uint8_t * srcEnd, T * dest, std::size_t count) {
+	std::size_t i = 0;
+	for(; i < count && std::size_t(srcEnd-src) >= maxLength<T>(); ++i) {
+		dest[i] = decodeUnchecked<T>(src);
+	}
+	for(; i < count && decodeChecked<T>(src, srcEnd, dest[i]); ++i) {}
+	return i;
+}
+
+//END scalar kernels
+//BEGIN simd kernels
+
+#ifdef SSERIALIZE_VARINT_HAS_X86_SIMD
+
+struct DecodeTable {
+	struct Entry {
+		///moves the bytes of number i into the 16 bit lane i
+		std::array<uint8_t, 16> shuffle;
+		///number of decoded numbers
+		uint8_t count;
+		///number of consumed bytes
+		uint8_t bytes;
+	};
+	///indexed by the continuation bits of 8 consecutive bytes
+	std::array<Entry, 256> entries;
+	constexpr DecodeTable() : entries{} {
+		for(uint32_t m(0); m < 256; ++m) {
+			Entry & e = entries[m];
+			for(uint32_t i(0); i < 16; ++i) {
+				e.shuffle[i] = 0x80;
+			}
+			uint32_t pos = 0;
+			uint32_t count = 0;
+			while (pos < 8) {
+				if (!(m & (uint32_t(1) << pos))) {
+					e.shuffle[2*count] = uint8_t(pos);
+					pos += 1;
+				}
+				else if (pos+1 < 8 && !(m & (uint32_t(1) << (pos+1)))) {
+					e.shuffle[2*count] = uint8_t(pos);
+					e.shuffle[2*count+1] = uint8_t(pos+1);
+					pos += 2;
+				}
+				else {
+					break;
+				}
+				++count;
+			}
+			e.count = uint8_t(count);
+			e.bytes = uint8_t(pos);
+		}
+	}
+};
+
+constexpr DecodeTable decodeTable;
+
+///Decodes while at least 16 bytes are available and at least 16 numbers are requested
+///This way every step may store up to 16 numbers and read 16 bytes
+__attribute__((target("sse4.1")))
+std::size_t decodeSse41(const uint8_t * & src, const uint8_t * srcEnd, uint32_t * dest, std::size_t count) {
+	uint32_t * destBegin = dest;
+	uint32_t * destEnd = dest + count;
+	const __m128i lowMask = _mm_set1_epi16(0x007F);
+	const __m128i highMask = _mm_set1_epi16(0x7F00);
+	while (srcEnd - src >= 16 && destEnd - dest >= 16) {
+		__m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src));
+		uint32_t m = uint32_t(_mm_movemask_epi8(in));
+		if (!m) {
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_cvtepu8_epi32(in));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest+4), _mm_cvtepu8_epi32(_mm_srli_si128(in, 4)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest+8), _mm_cvtepu8_epi32(_mm_srli_si128(in, 8)));
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest+12), _mm_cvtepu8_epi32(_mm_srli_si128(in, 12)));
+			src += 16;
+			dest += 16;
+			continue;
+		}
+		const DecodeTable::Entry & e = decodeTable.entries[m & 0xFF];
+		if (!e.count) {
+			*dest = decodeUnchecked<uint32_t>(src);
+			++dest;
+			continue;
+		}
+		__m128i shuffle = _mm_loadu_si128(reinterpret_cast<const __m128i*>(e.shuffle.data()));
+		__m128i v = _mm_shuffle_epi8(in, shuffle);
+		v = _mm_or_si128(_mm_and_si128(v, lowMask), _mm_srli_epi16(_mm_and_si128(v, highMask), 1));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest), _mm_cvtepu16_epi32(v));
+		_mm_storeu_si128(reinterpret_cast<__m128i*>(dest+4), _mm_cvtepu16_epi32(_mm_srli_si128(v, 8)));
+		src += e.bytes;
+		dest += e.count;
+	}
+	return dest - destBegin;
+}
+
+bool detectSimdSupport() {
+	__builtin_cpu_init();
+	return __builtin_cpu_supports("sse4.1");
+}
+
+#else
+
+bool detectSimdSupport() {
+	return false;
+}
+
+#endif
+
+//END simd kernels
+
+template<typename T>
+void toSignedImp(T * begin, T * end) {
+	for(; begin != end; ++begin) {
+		T sign = *begin & 0x1;
+		//-x = ~x + 1 = (x ^ (T)-1) + 1
+		*begin = ((*begin >> 1) ^ (T(0) - sign)) + sign;
+	}
+}
+
+template<typename T>
+T prefixSumImp(T * begin, T * end, T prev) {
+	for(; begin != end; ++begin) {
+		prev += *begin;
+		*begin = prev;
+	}
+	return prev;
+}
+
+}//end anonymous namespace
+
+bool hasSimdSupport() {
+	static const bool supported = detectSimdSupport();
+	return supported;
+}
+
+std::size_t decode(const uint8_t * src, const uint8_t * srcEnd, uint32_t * dest, std::size_t count, std::size_t & bytes) {
+	const uint8_t * srcBegin = src;
+	std::size_t decoded = 0;
+#ifdef SSERIALIZE_VARINT_HAS_X86_SIMD
+	if (hasSimdSupport()) {
+		decoded = decodeSse41(src, srcEnd, dest, count);
+	}
+#endif
+	decoded += decodeScalar<uint32_t>(src, srcEnd, dest+decoded, count-decoded);
+	bytes = src - srcBegin;
+	return decoded;
+}
+
+std::size_t decode(const uint8_t * src, const uint8_t * srcEnd, uint64_t * dest, std::size_t count, std::size_t & bytes) {
+	const uint8_t * srcBegin = src;
+	std::size_t decoded = decodeScalar<uint64_t>(src, srcEnd, dest, count);
+	bytes = src - srcBegin;
+	return decoded;
+}
+
+void toSigned(uint32_t * begin, uint32_t * end) {
+	toSignedImp(begin, end);
+}
+
+void toSigned(uint64_t * begin, uint64_t * end) {
+	toSignedImp(begin, end);
+}
+
+uint32_t prefixSum(uint32_t * begin, uint32_t * end, uint32_t prev) {
+	return prefixSumImp(begin, end, prev);
+}
+
+uint64_t prefixSum(uint64_t * begin, uint64_t * end, uint64_t prev) {
+	return prefixSumImp(begin, end, prev);
+}
+
+}}//end namespace sserialize::varint
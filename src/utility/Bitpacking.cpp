@@ -1,10 +1,17 @@
 #include <sserialize/utility/Bitpacking.h>
 #include <sserialize/utility/exceptions.h>
 
+#include <array>
+
 namespace sserialize {
 	
 std::unique_ptr<BitpackingInterface> BitpackingInterface::instance(uint32_t bpn) {
-#define C(__BPN) case __BPN: return std::unique_ptr<BitpackingInterface>( new Bitpacking<__BPN>() );
+	return instance(bpn, detail::bitpacking::supportedInstructionLevel());
+}
+
+std::unique_ptr<BitpackingInterface> BitpackingInterface::instance(uint32_t bpn, InstructionLevel il) {
+	auto simdUnpack = detail::bitpacking::simdUnpacker(bpn, il);
+#define C(__BPN) case __BPN: return std::unique_ptr<BitpackingInterface>( new Bitpacking<__BPN>(simdUnpack) );
 	switch (bpn) {
 	C(1); C(2); C(3); C(4); C(5); C(6); C(7); C(8); C(9); C(10);
 	C(11); C(12); C(13); C(14); C(15); C(16); C(17); C(18); C(19); C(20);
@@ -19,4 +26,19 @@ std::unique_ptr<BitpackingInterface> BitpackingInterface::instance(uint32_t bpn)
 #undef C
 }
 
+const BitpackingInterface & BitpackingInterface::shared(uint32_t bpn) {
+	static const std::array<std::unique_ptr<BitpackingInterface>, 65> instances = []() {
+		std::array<std::unique_ptr<BitpackingInterface>, 65> tmp;
+		for(uint32_t i(1); i < 57; ++i) {
+			tmp[i] = instance(i);
+		}
+		tmp[64] = instance(64);
+		return tmp;
+	}();
+	if (bpn >= instances.size() || !instances[bpn]) {
+		throw sserialize::UnsupportedFeatureException("BitpackingInterface: unsupported block bits: " + std::to_string(bpn));
+	}
+	return *instances[bpn];
+}
+
 }//end namespace sserialize
@@ -4,32 +4,96 @@
 #include "detail/Compressor/Compressors.h"
 
 namespace sserialize {
+namespace detail {
+namespace Compressor {
+namespace {
 
-Compressor::Compressor(Compressor::CompressionTypes ct)
+struct Codec {
+	const char * name;
+	Interface* (*create)();
+};
+
+template<typename T_COMPRESSOR>
+Interface * createCodec() {
+	return new T_COMPRESSOR();
+}
+
+///Registry of all codecs, indexed by sserialize::Compressor::CompressionTypes
+const Codec codecs[sserialize::Compressor::CT__COUNT] = {
+	{"none", &createCodec<NoneCompressor>},
+	{"lzo", &createCodec<LzoCompressor>},
+	{"lz4", &createCodec<Lz4Compressor>},
+	{"lz4hc", &createCodec<Lz4HcCompressor>}
+};
+
+}}}//end namespace detail::Compressor::<anonymous>
+
+Compressor::Compressor(Compressor::CompressionTypes ct) :
+m_type(ct)
 {
-	switch(ct) {
-	case CT_NONE:
-		m_priv.reset(new detail::Compressor::NoneCompressor());
-		break;
-	case CT_LZO:
-		break;
-	default:
-		throw sserialize::TypeMissMatchException("sserialize::Compressor::Compressor");
-		break;
-	};
+	if (!supported(ct)) {
+		throw sserialize::TypeMissMatchException("sserialize::Compressor::Compressor: unsupported compression type " + std::to_string(ct));
+	}
+	m_priv.reset(detail::Compressor::codecs[ct].create());
 }
 
+Compressor::Compressor(const Compressor & other) = default;
+
 Compressor::~Compressor() {}
 
+Compressor & Compressor::operator=(const Compressor & other) = default;
+
 
 int64_t Compressor::compress(const sserialize::UByteArrayAdapter & src, sserialize::UByteArrayAdapter & dest) const {
-	return m_priv->compress(src, dest);
+	const UByteArrayAdapter::MemoryView srcD = src.getMemView(0, src.size());
+	UByteArrayAdapter::MemoryView destD = dest.getMemView(0, dest.size());
+	int64_t destLen = compress(srcD.get(), srcD.size(), destD.get(), destD.size());
+	if (destLen >= 0) {
+		destD.flush(destLen);
+	}
+	return destLen;
 }
 
 int64_t Compressor::decompress(const sserialize::UByteArrayAdapter & src, sserialize::UByteArrayAdapter & dest) const {
-	return m_priv->decompress(src, dest);
+	const UByteArrayAdapter::MemoryView srcD = src.getMemView(0, src.size());
+	UByteArrayAdapter::MemoryView destD = dest.getMemView(0, dest.size());
+	int64_t destLen = decompress(srcD.get(), srcD.size(), destD.get(), destD.size());
+	if (destLen >= 0) {
+		destD.flush(destLen);
+	}
+	return destLen;
 }
 
+int64_t Compressor::compress(const uint8_t * src, std::size_t srcSize, uint8_t * dest, std::size_t destCapacity) const {
+	return m_priv->compress(src, srcSize, dest, destCapacity);
+}
 
+int64_t Compressor::decompress(const uint8_t * src, std::size_t srcSize, uint8_t * dest, std::size_t destCapacity) const {
+	return m_priv->decompress(src, srcSize, dest, destCapacity);
+}
+
+std::size_t Compressor::maxCompressedSize(std::size_t srcSize) const {
+	return m_priv->maxCompressedSize(srcSize);
+}
+
+bool Compressor::supported(uint32_t ct) {
+	return ct < CT__COUNT;
+}
+
+std::string Compressor::name(CompressionTypes ct) {
+	if (!supported(ct)) {
+		return "invalid";
+	}
+	return detail::Compressor::codecs[ct].name;
+}
+
+Compressor::CompressionTypes Compressor::fromName(const std::string & name) {
+	for(uint32_t i(0); i < CT__COUNT; ++i) {
+		if (name == detail::Compressor::codecs[i].name) {
+			return CompressionTypes(i);
+		}
+	}
+	throw sserialize::TypeMissMatchException("sserialize::Compressor: no codec named " + name);
+}
 
-}//end namespace sserialize
\ No newline at end of file
+}//end namespace sserialize
@@ -0,0 +1,243 @@
+#include <sserialize/utility/Bitpacking.h>
+
+#include <array>
+#include <utility>
+#include <string.h>
+
+#if defined(__x86_64__) || defined(__i386__)
+	#include <immintrin.h>
+	#define SSERIALIZE_BITPACKING_HAS_X86_SIMD
+#endif
+
+//The packed format is a big endian bit stream: number i occupies bits [i*bpn, (i+1)*bpn)
+//A group of 8 numbers therefore always occupies exactly bpn bytes and starts on a byte boundary.
+//The kernels below decode one group at a time: each half (4 numbers) of a group fits into 16 Bytes.
+//For every number we shuffle the (up to) 4 bytes starting at its first byte into a 32 bit lane in big endian order.
+//Shifting the lane left by the intra-byte offset aligns the number to the most significant bit.
+//Numbers with more than 25 bits may span 5 bytes, the bits of the fifth byte are shuffled into a second lane and or'ed in.
+//A final right shift by 32-bpn removes the bits following the number.
+
+namespace sserialize {
+namespace detail {
+namespace bitpacking {
+namespace {
+
+template<uint32_t bpn>
+struct SimdUnpackTables {
+	static_assert(bpn > 0 && bpn <= 32);
+	///first byte of the second half of a group
+	static constexpr uint32_t HalfBegin = (4*bpn)/8;
+	///Number of bytes read from the beginning of a group
+	static constexpr uint32_t GroupReadBytes = HalfBegin + 16;
+	static constexpr bool NeedsFifthByte = bpn > 25;
+
+	static constexpr uint32_t relativeByte(uint32_t j) {
+		return (j*bpn)/8 - (j < 4 ? 0 : HalfBegin);
+	}
+	static constexpr uint8_t shuffleIndex(uint32_t j, uint32_t k) {
+		return relativeByte(j)+k < 16 ? uint8_t(relativeByte(j)+k) : uint8_t(0x80);
+	}
+	static constexpr std::array<uint8_t, 32> calc_be32() {
+		std::array<uint8_t, 32> tmp{};
+		for(uint32_t j(0); j < 8; ++j) {
+			for(uint32_t b(0); b < 4; ++b) {
+				tmp[4*j+b] = shuffleIndex(j, 3-b);
+			}
+		}
+		return tmp;
+	}
+	static constexpr std::array<uint8_t, 32> calc_b4() {
+		std::array<uint8_t, 32> tmp{};
+		for(uint32_t j(0); j < 8; ++j) {
+			tmp[4*j] = shuffleIndex(j, 4);
+			tmp[4*j+1] = tmp[4*j+2] = tmp[4*j+3] = 0x80;
+		}
+		return tmp;
+	}
+	static constexpr std::array<uint32_t, 8> calc_ls() {
+		std::array<uint32_t, 8> tmp{};
+		for(uint32_t j(0); j < 8; ++j) {
+			tmp[j] = (j*bpn)%8;
+		}
+		return tmp;
+	}
+	static constexpr std::array<uint32_t, 8> calc_b4rs() {
+		std::array<uint32_t, 8> tmp{};
+		for(uint32_t j(0); j < 8; ++j) {
+			tmp[j] = 8-(j*bpn)%8;
+		}
+		return tmp;
+	}
+	static constexpr std::array<uint32_t, 8> calc_mul() {
+		std::array<uint32_t, 8> tmp{};
+		for(uint32_t j(0); j < 8; ++j) {
+			tmp[j] = uint32_t(1) << ((j*bpn)%8);
+		}
+		return tmp;
+	}
+	static constexpr bool fifthByteAvailable() {
+		for(uint32_t j(0); j < 8; ++j) {
+			if ((j*bpn)%8 + bpn > 32 && relativeByte(j)+4 >= 16) {
+				return false;
+			}
+		}
+		return true;
+	}
+	static_assert(fifthByteAvailable());
+
+	alignas(32) static constexpr std::array<uint8_t, 32> be32 = calc_be32();
+	alignas(32) static constexpr std::array<uint8_t, 32> b4 = calc_b4();
+	alignas(32) static constexpr std::array<uint32_t, 8> ls = calc_ls();
+	alignas(32) static constexpr std::array<uint32_t, 8> b4rs = calc_b4rs();
+	alignas(32) static constexpr std::array<uint32_t, 8> mul = calc_mul();
+};
+
+#ifdef SSERIALIZE_BITPACKING_HAS_X86_SIMD
+
+template<uint32_t bpn>
+__attribute__((target("sse4.2")))
+void unpack_groups_sse42(const uint8_t * src, uint32_t * dest, std::size_t groups) {
+	using T = SimdUnpackTables<bpn>;
+	const __m128i be32[2] = {
+		_mm_load_si128(reinterpret_cast<const __m128i*>(T::be32.data())),
+		_mm_load_si128(reinterpret_cast<const __m128i*>(T::be32.data()+16))
+	};
+	const __m128i b4[2] = {
+		_mm_load_si128(reinterpret_cast<const __m128i*>(T::b4.data())),
+		_mm_load_si128(reinterpret_cast<const __m128i*>(T::b4.data()+16))
+	};
+	const __m128i mul[2] = {
+		_mm_load_si128(reinterpret_cast<const __m128i*>(T::mul.data())),
+		_mm_load_si128(reinterpret_cast<const __m128i*>(T::mul.data()+4))
+	};
+	for(std::size_t g(0); g < groups; ++g, src += bpn, dest += 8) {
+		for(uint32_t h(0); h < 2; ++h) {
+			__m128i in = _mm_loadu_si128(reinterpret_cast<const __m128i*>(src + (h ? T::HalfBegin : 0)));
+			__m128i v = _mm_shuffle_epi8(in, be32[h]);
+			v = _mm_mullo_epi32(v, mul[h]);
+			if constexpr (T::NeedsFifthByte) {
+				__m128i lo = _mm_shuffle_epi8(in, b4[h]);
+				lo = _mm_srli_epi32(_mm_mullo_epi32(lo, mul[h]), 8);
+				v = _mm_or_si128(v, lo);
+			}
+			v = _mm_srli_epi32(v, 32-bpn);
+			_mm_storeu_si128(reinterpret_cast<__m128i*>(dest+4*h), v);
+		}
+	}
+}
+
+template<uint32_t bpn>
+__attribute__((target("avx2")))
+void unpack_groups_avx2(const uint8_t * src, uint32_t * dest, std::size_t groups) {
+	using T = SimdUnpackTables<bpn>;
+	const __m256i be32 = _mm256_load_si256(reinterpret_cast<const __m256i*>(T::be32.data()));
+	const __m256i b4 = _mm256_load_si256(reinterpret_cast<const __m256i*>(T::b4.data()));
+	const __m256i ls = _mm256_load_si256(reinterpret_cast<const __m256i*>(T::ls.data()));
+	const __m256i b4rs = _mm256_load_si256(reinterpret_cast<const __m256i*>(T::b4rs.data()));
+	for(std::size_t g(0); g < groups; ++g, src += bpn, dest += 8) {
+		__m256i in = _mm256_inserti128_si256(
+			_mm256_castsi128_si256(_mm_loadu_si128(reinterpret_cast<const __m128i*>(src))),
+			_mm_loadu_si128(reinterpret_cast<const __m128i*>(src+T::HalfBegin)),
+			1
+		);
+		__m256i v = _mm256_shuffle_epi8(in, be32);
+		v = _mm256_sllv_epi32(v, ls);
+		if constexpr (T::NeedsFifthByte) {
+			__m256i lo = _mm256_shuffle_epi8(in, b4);
+			v = _mm256_or_si256(v, _mm256_srlv_epi32(lo, b4rs));
+		}
+		v = _mm256_srli_epi32(v, 32-bpn);
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(dest), v);
+	}
+}
+
+#endif
+
+///The kernels read GroupReadBytes from the start of each group.
+///Groups near the end of the input are decoded from a zero-padded copy to not read beyond src+count*bpn/8
+template<uint32_t bpn, void (*T_KERNEL)(const uint8_t*, uint32_t*, std::size_t)>
+const uint8_t * unpack(const uint8_t * src, uint32_t * dest, uint32_t count) {
+	using T = SimdUnpackTables<bpn>;
+	SSERIALIZE_CHEAP_ASSERT_EQUAL(count%8, uint32_t(0));
+	const std::size_t groups = count/8;
+	const std::size_t srcBytes = groups*bpn;
+	std::size_t safeGroups = 0;
+	if (srcBytes >= T::GroupReadBytes) {
+		safeGroups = std::min<std::size_t>(groups, (srcBytes - T::GroupReadBytes)/bpn + 1);
+		T_KERNEL(src, dest, safeGroups);
+	}
+	if (safeGroups < groups) {
+		uint8_t buffer[2*T::GroupReadBytes] = {0};
+		std::size_t remainderBytes = srcBytes - safeGroups*bpn;
+		SSERIALIZE_CHEAP_ASSERT_SMALLER_OR_EQUAL(remainderBytes + T::GroupReadBytes, sizeof(buffer));
+		::memmove(buffer, src+safeGroups*bpn, remainderBytes);
+		T_KERNEL(buffer, dest+safeGroups*8, groups-safeGroups);
+	}
+	return src+srcBytes;
+}
+
+template<template<uint32_t> class T_KERNEL_SELECTOR, std::size_t... I>
+constexpr std::array<UnpackFunction, 33> unpackers(std::index_sequence<I...>) {
+	return std::array<UnpackFunction, 33>{{ nullptr, &unpack<I+1, T_KERNEL_SELECTOR<I+1>::kernel>... }};
+}
+
+#ifdef SSERIALIZE_BITPACKING_HAS_X86_SIMD
+
+template<uint32_t bpn>
+struct Sse42Kernel {
+	static constexpr void (*kernel)(const uint8_t*, uint32_t*, std::size_t) = &unpack_groups_sse42<bpn>;
+};
+
+template<uint32_t bpn>
+struct Avx2Kernel {
+	static constexpr void (*kernel)(const uint8_t*, uint32_t*, std::size_t) = &unpack_groups_avx2<bpn>;
+};
+
+InstructionLevel detectInstructionLevel() {
+	__builtin_cpu_init();
+	if (__builtin_cpu_supports("avx2")) {
+		return IL_AVX2;
+	}
+	if (__builtin_cpu_supports("sse4.2")) {
+		return IL_SSE42;
+	}
+	return IL_SCALAR;
+}
+
+#else
+
+InstructionLevel detectInstructionLevel() {
+	return IL_SCALAR;
+}
+
+#endif
+
+}//end anonymous namespace
+
+InstructionLevel supportedInstructionLevel() {
+	static const InstructionLevel il = detectInstructionLevel();
+	return il;
+}
+
+UnpackFunction simdUnpacker(uint32_t bpn, InstructionLevel il) {
+	if (bpn == 0 || bpn > 32 || il > supportedInstructionLevel()) {
+		return nullptr;
+	}
+#ifdef SSERIALIZE_BITPACKING_HAS_X86_SIMD
+	using seq = std::make_index_sequence<32>;
+	static constexpr std::array<UnpackFunction, 33> sse42 = unpackers<Sse42Kernel>(seq{});
+	static constexpr std::array<UnpackFunction, 33> avx2 = unpackers<Avx2Kernel>(seq{});
+	switch (il) {
+	case IL_AVX2:
+		return avx2[bpn];
+	case IL_SSE42:
+		return sse42[bpn];
+	default:
+		return nullptr;
+	}
+#else
+	return nullptr;
+#endif
+}
+
+}}}//end namespace sserialize::detail::bitpacking
@@ -2,4 +2,5 @@
 #define SSERIALIZE_DETAIL_COMPRESSOR_COMPRESSORS_H
 #include "NoneCompressor.h"
 #include "LZOCompressor.h"
-#endif
\ No newline at end of file
+#include "LZ4Compressor.h"
+#endif
@@ -1,10 +1,10 @@
 #ifndef SSERIALIZE_DETAIL_COMPRESSOR_INTERFACE_H
 #define SSERIALIZE_DETAIL_COMPRESSOR_INTERFACE_H
 #include <sserialize/utility/refcounting.h>
+#include <cstdint>
+#include <cstddef>
 
 namespace sserialize {
-class UByteArrayAdapter;
-
 namespace detail {
 namespace Compressor {
 
@@ -12,10 +12,13 @@ class Interface: public RefCountObject {
 public:
 	Interface() {}
 	virtual ~Interface() {}
-	virtual int64_t compress(const sserialize::UByteArrayAdapter & src, sserialize::UByteArrayAdapter & dest) const = 0;
-	virtual int64_t decompress(const sserialize::UByteArrayAdapter & src, sserialize::UByteArrayAdapter & dest) const = 0;
+	///@return number of bytes written to dest, -1 on failure
+	virtual int64_t compress(const uint8_t * src, std::size_t srcSize, uint8_t * dest, std::size_t destCapacity) const = 0;
+	///@return number of bytes written to dest, -1 on failure
+	virtual int64_t decompress(const uint8_t * src, std::size_t srcSize, uint8_t * dest, std::size_t destCapacity) const = 0;
+	virtual std::size_t maxCompressedSize(std::size_t srcSize) const = 0;
 };
 
 }}}//end namespace
 
-#endif
\ No newline at end of file
+#endif
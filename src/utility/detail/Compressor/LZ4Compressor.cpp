@@ -0,0 +1,348 @@
+#include "LZ4Compressor.h"
+#include <vector>
+#include <algorithm>
+#include <string.h>
+
+namespace sserialize {
+namespace detail {
+namespace Compressor {
+namespace {
+
+constexpr std::size_t MinMatch = 4;
+///the last LastLiterals bytes are always literals
+constexpr std::size_t LastLiterals = 5;
+///a match has to start at least MatchFindLimit bytes before the end of the input
+constexpr std::size_t MatchFindLimit = 12;
+constexpr std::size_t MaxDistance = 0xFFFF;
+constexpr uint32_t RunMask = 0xF;
+
+inline uint32_t read32(const uint8_t * p) {
+	uint32_t v;
+	::memcpy(&v, p, sizeof(v));
+	return v;
+}
+
+template<uint32_t T_BITS>
+inline uint32_t hash(uint32_t v) {
+	return (v * 2654435761u) >> (32 - T_BITS);
+}
+
+///@return number of equal bytes of a and b, b is not read beyond bEnd
+inline std::size_t commonLength(const uint8_t * a, const uint8_t * b, const uint8_t * bEnd) {
+	const uint8_t * bBegin = b;
+	while (b+sizeof(uint64_t) <= bEnd) {
+		uint64_t av, bv;
+		::memcpy(&av, a, sizeof(av));
+		::memcpy(&bv, b, sizeof(bv));
+		uint64_t diff = av ^ bv;
+		if (diff) {
+			return (b - bBegin) + (__builtin_ctzll(diff) >> 3);
+		}
+		a += sizeof(uint64_t);
+		b += sizeof(uint64_t);
+	}
+	for(; b < bEnd && *a == *b; ++a, ++b) {}
+	return b - bBegin;
+}
+
+class Writer {
+	uint8_t * m_begin;
+	uint8_t * m_op;
+	uint8_t * m_end;
+private:
+	inline void putLength(std::size_t len) {
+		for(; len >= 255; len -= 255) {
+			*m_op++ = 255;
+		}
+		*m_op++ = uint8_t(len);
+	}
+	///upper bound of the bytes needed to encode a sequence
+	static inline std::size_t sequenceSize(std::size_t literalLength, std::size_t matchLength) {
+		return 1 + literalLength + (literalLength/255+1) + 2 + (matchLength/255+1);
+	}
+public:
+	Writer(uint8_t * dest, std::size_t destCapacity) : m_begin(dest), m_op(dest), m_end(dest+destCapacity) {}
+	///@param matchLength full length of the match, at least MinMatch
+	inline bool putSequence(const uint8_t * literals, std::size_t literalLength, std::size_t offset, std::size_t matchLength) {
+		if (std::size_t(m_end-m_op) < sequenceSize(literalLength, matchLength)) {
+			return false;
+		}
+		uint8_t * token = m_op++;
+		uint8_t t;
+		if (literalLength >= RunMask) {
+			t = RunMask << 4;
+			putLength(literalLength - RunMask);
+		}
+		else {
+			t = uint8_t(literalLength << 4);
+		}
+		::memcpy(m_op, literals, literalLength);
+		m_op += literalLength;
+		m_op[0] = uint8_t(offset);
+		m_op[1] = uint8_t(offset >> 8);
+		m_op += 2;
+		matchLength -= MinMatch;
+		if (matchLength >= RunMask) {
+			t |= RunMask;
+			putLength(matchLength - RunMask);
+		}
+		else {
+			t |= uint8_t(matchLength);
+		}
+		*token = t;
+		return true;
+	}
+	inline bool putLastLiterals(const uint8_t * literals, std::size_t literalLength) {
+		if (std::size_t(m_end-m_op) < 1 + literalLength + (literalLength/255+1)) {
+			return false;
+		}
+		if (literalLength >= RunMask) {
+			*m_op++ = RunMask << 4;
+			putLength(literalLength - RunMask);
+		}
+		else {
+			*m_op++ = uint8_t(literalLength << 4);
+		}
+		::memcpy(m_op, literals, literalLength);
+		m_op += literalLength;
+		return true;
+	}
+	inline int64_t size() const { return m_op - m_begin; }
+};
+
+///Hash chain match finder, positions are inserted lazily up to the position that is searched
+class HashChain {
+public:
+	static constexpr uint32_t HashBits = 15;
+private:
+	const uint8_t * m_src;
+	///position+1 of the last occurence of a hash, 0 if there is none
+	std::vector<uint32_t> m_head;
+	///distance to the previous position with the same hash, 0 if there is none within MaxDistance
+	std::vector<uint16_t> m_chain;
+	uint32_t m_nextToInsert;
+	uint32_t m_maxAttempts;
+public:
+	HashChain(const uint8_t * src, uint32_t maxAttempts) :
+	m_src(src),
+	m_head(std::size_t(1) << HashBits, 0),
+	m_chain(MaxDistance+1, 0),
+	m_nextToInsert(0),
+	m_maxAttempts(maxAttempts)
+	{}
+	inline void insertUpTo(const uint8_t * ip) {
+		uint32_t target = uint32_t(ip - m_src);
+		for(; m_nextToInsert < target; ++m_nextToInsert) {
+			uint32_t & head = m_head[hash<HashBits>(read32(m_src+m_nextToInsert))];
+			std::size_t delta = head ? m_nextToInsert - (head-1) : 0;
+			m_chain[m_nextToInsert & MaxDistance] = uint16_t(delta <= MaxDistance ? delta : 0);
+			head = m_nextToInsert+1;
+		}
+	}
+	///@return length of the longest match or 0 if there is none of at least MinMatch bytes
+	inline std::size_t find(const uint8_t * ip, const uint8_t * matchLimit, const uint8_t * & match) {
+		insertUpTo(ip);
+		uint32_t pos = uint32_t(ip - m_src);
+		uint32_t head = m_head[hash<HashBits>(read32(ip))];
+		if (!head) {
+			return 0;
+		}
+		std::size_t bestLength = 0;
+		uint32_t candidate = head-1;
+		uint32_t seq = read32(ip);
+		std::size_t maxLength = matchLimit - ip;
+		for(uint32_t attempt(0); attempt < m_maxAttempts && pos - candidate <= MaxDistance; ++attempt) {
+			const uint8_t * ref = m_src + candidate;
+			if ((bestLength < MinMatch || ref[bestLength] == ip[bestLength]) && read32(ref) == seq) {
+				std::size_t len = MinMatch + commonLength(ref+MinMatch, ip+MinMatch, matchLimit);
+				if (len > bestLength) {
+					bestLength = len;
+					match = ref;
+					if (len == maxLength) {
+						break;
+					}
+				}
+			}
+			uint16_t delta = m_chain[candidate & MaxDistance];
+			if (!delta || delta > candidate) {
+				break;
+			}
+			candidate -= delta;
+		}
+		return bestLength >= MinMatch ? bestLength : 0;
+	}
+};
+
+}//end anonymous namespace
+
+Lz4Compressor::Lz4Compressor() {}
+
+Lz4Compressor::~Lz4Compressor() {}
+
+int64_t Lz4Compressor::compress(const uint8_t * src, std::size_t srcSize, uint8_t * dest, std::size_t destCapacity) const {
+	constexpr uint32_t HashBits = 14;
+	const uint8_t * ip = src;
+	const uint8_t * anchor = src;
+	const uint8_t * iend = src + srcSize;
+	Writer writer(dest, destCapacity);
+	if (srcSize > MatchFindLimit) {
+		const uint8_t * mfLimit = iend - MatchFindLimit;
+		const uint8_t * matchLimit = iend - LastLiterals;
+		//positions relative to src, there is no empty marker since candidates are verified anyway
+		std::vector<uint32_t> table(std::size_t(1) << HashBits, 0);
+		++ip;
+		while (ip < mfLimit) {
+			uint32_t seq = read32(ip);
+			uint32_t & entry = table[hash<HashBits>(seq)];
+			const uint8_t * ref = src + entry;
+			entry = uint32_t(ip - src);
+			if (std::size_t(ip - ref) > MaxDistance || read32(ref) != seq) {
+				//skip faster through incompressible data
+				ip += 1 + ((ip - anchor) >> 6);
+				continue;
+			}
+			while (ip > anchor && ref > src && ip[-1] == ref[-1]) {
+				--ip;
+				--ref;
+			}
+			std::size_t matchLength = MinMatch + commonLength(ref+MinMatch, ip+MinMatch, matchLimit);
+			if (!writer.putSequence(anchor, ip-anchor, ip-ref, matchLength)) {
+				return -1;
+			}
+			ip += matchLength;
+			anchor = ip;
+			if (ip < mfLimit) {
+				table[hash<HashBits>(read32(ip-2))] = uint32_t(ip-2-src);
+			}
+		}
+	}
+	if (!writer.putLastLiterals(anchor, iend-anchor)) {
+		return -1;
+	}
+	return writer.size();
+}
+
+int64_t Lz4Compressor::decompress(const uint8_t * src, std::size_t srcSize, uint8_t * dest, std::size_t destCapacity) const {
+	const uint8_t * ip = src;
+	const uint8_t * iend = src + srcSize;
+	uint8_t * op = dest;
+	uint8_t * oend = dest + destCapacity;
+	while (true) {
+		if (ip >= iend) {
+			return -1;
+		}
+		uint32_t token = *ip++;
+		std::size_t literalLength = token >> 4;
+		if (literalLength == RunMask) {
+			uint8_t b;
+			do {
+				if (ip >= iend) {
+					return -1;
+				}
+				b = *ip++;
+				literalLength += b;
+			} while (b == 255);
+		}
+		if (literalLength > std::size_t(iend-ip) || literalLength > std::size_t(oend-op)) {
+			return -1;
+		}
+		::memcpy(op, ip, literalLength);
+		op += literalLength;
+		ip += literalLength;
+		if (ip == iend) {
+			break;
+		}
+		if (iend-ip < 2) {
+			return -1;
+		}
+		std::size_t offset = std::size_t(ip[0]) | (std::size_t(ip[1]) << 8);
+		ip += 2;
+		if (!offset || offset > std::size_t(op-dest)) {
+			return -1;
+		}
+		std::size_t matchLength = token & RunMask;
+		if (matchLength == RunMask) {
+			uint8_t b;
+			do {
+				if (ip >= iend) {
+					return -1;
+				}
+				b = *ip++;
+				matchLength += b;
+			} while (b == 255);
+		}
+		matchLength += MinMatch;
+		if (matchLength > std::size_t(oend-op)) {
+			return -1;
+		}
+		const uint8_t * match = op - offset;
+		if (offset >= matchLength) {
+			::memcpy(op, match, matchLength);
+		}
+		else if (offset >= sizeof(uint64_t)) {
+			//overlapping, but every block only reads bytes that were already written
+			for(std::size_t i(0); i < matchLength; i += sizeof(uint64_t)) {
+				::memcpy(op+i, match+i, std::min<std::size_t>(sizeof(uint64_t), matchLength-i));
+			}
+		}
+		else {
+			for(std::size_t i(0); i < matchLength; ++i) {
+				op[i] = match[i];
+			}
+		}
+		op += matchLength;
+	}
+	return op - dest;
+}
+
+std::size_t Lz4Compressor::maxCompressedSize(std::size_t srcSize) const {
+	return srcSize + srcSize/255 + 16;
+}
+
+Lz4HcCompressor::Lz4HcCompressor(uint32_t maxAttempts) :
+m_maxAttempts(maxAttempts)
+{}
+
+Lz4HcCompressor::~Lz4HcCompressor() {}
+
+int64_t Lz4HcCompressor::compress(const uint8_t * src, std::size_t srcSize, uint8_t * dest, std::size_t destCapacity) const {
+	const uint8_t * ip = src;
+	const uint8_t * anchor = src;
+	const uint8_t * iend = src + srcSize;
+	Writer writer(dest, destCapacity);
+	if (srcSize > MatchFindLimit) {
+		const uint8_t * mfLimit = iend - MatchFindLimit;
+		const uint8_t * matchLimit = iend - LastLiterals;
+		HashChain hc(src, m_maxAttempts);
+		while (ip < mfLimit) {
+			const uint8_t * match = 0;
+			std::size_t matchLength = hc.find(ip, matchLimit, match);
+			if (!matchLength) {
+				++ip;
+				continue;
+			}
+			//lazy matching: prefer a longer match starting at the next position
+			while (ip+1 < mfLimit) {
+				const uint8_t * nextMatch = 0;
+				std::size_t nextLength = hc.find(ip+1, matchLimit, nextMatch);
+				if (nextLength <= matchLength) {
+					break;
+				}
+				++ip;
+				match = nextMatch;
+				matchLength = nextLength;
+			}
+			if (!writer.putSequence(anchor, ip-anchor, ip-match, matchLength)) {
+				return -1;
+			}
+			ip += matchLength;
+			anchor = ip;
+		}
+	}
+	if (!writer.putLastLiterals(anchor, iend-anchor)) {
+		return -1;
+	}
+	return writer.size();
+}
+
+}}}//end namespace
@@ -0,0 +1,41 @@
+#ifndef SSERIALIZE_DETAIL_COMPRESSOR_LZ4_COMPRESSOR_H
+#define SSERIALIZE_DETAIL_COMPRESSOR_LZ4_COMPRESSOR_H
+#include "Interface.h"
+
+namespace sserialize {
+namespace detail {
+namespace Compressor {
+
+/** Compressor for the LZ4 block format.
+  * A block is a sequence of (token, literal length, literals, match offset, match length).
+  * The token stores 4 bits of the literal length and 4 bits of the match length,
+  * longer lengths are continued with bytes of 255 until a byte smaller than 255.
+  * Matches are at least 4 bytes long with an offset of at most 64 KiB.
+  * The last sequence only consists of literals and spans at least the last 5 bytes.
+  *
+  * The format is decoded without any tables which makes decompression very fast.
+  */
+class Lz4Compressor: public Interface {
+public:
+	Lz4Compressor();
+	virtual ~Lz4Compressor();
+	virtual int64_t compress(const uint8_t * src, std::size_t srcSize, uint8_t * dest, std::size_t destCapacity) const override;
+	virtual int64_t decompress(const uint8_t * src, std::size_t srcSize, uint8_t * dest, std::size_t destCapacity) const override;
+	virtual std::size_t maxCompressedSize(std::size_t srcSize) const override;
+};
+
+///Same format as Lz4Compressor, but uses hash chains and lazy matching to find longer matches
+class Lz4HcCompressor: public Lz4Compressor {
+public:
+	static constexpr uint32_t DefaultMaxAttempts = 256;
+private:
+	uint32_t m_maxAttempts;
+public:
+	Lz4HcCompressor(uint32_t maxAttempts = DefaultMaxAttempts);
+	virtual ~Lz4HcCompressor();
+	virtual int64_t compress(const uint8_t * src, std::size_t srcSize, uint8_t * dest, std::size_t destCapacity) const override;
+};
+
+}}}//end namespace
+
+#endif
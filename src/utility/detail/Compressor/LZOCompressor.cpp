@@ -1,6 +1,6 @@
 #include "LZOCompressor.h"
-#include <sserialize/storage/UByteArrayAdapter.h>
 #include <minilzo/minilzo.h>
+#include <vector>
 
 namespace sserialize {
 namespace detail {
@@ -14,34 +14,38 @@ LzoCompressor::~LzoCompressor() {}
     lzo_align_t __LZO_MMODEL var [ ((size) + (sizeof(lzo_align_t) - 1)) / sizeof(lzo_align_t) ]
 
 
-int64_t LzoCompressor::compress(const sserialize::UByteArrayAdapter & src, sserialize::UByteArrayAdapter & dest) const {
+int64_t LzoCompressor::compress(const uint8_t * src, std::size_t srcSize, uint8_t * dest, std::size_t destCapacity) const {
 	HEAP_ALLOC_MINI_LZO(wrkmem, LZO1X_1_MEM_COMPRESS);
-	const UByteArrayAdapter::MemoryView srcD = src.getMemView(0, src.size());
-	UByteArrayAdapter::MemoryView destD = dest.getMemView(0, dest.size());
-	lzo_uint destLen = destD.size();
-	int ok = ::lzo1x_1_compress(srcD.get(), srcD.size(), destD.get(), &destLen, wrkmem);
-	if (ok != LZO_E_OK) {
+	//lzo1x_1_compress does not check the size of the output buffer
+	std::vector<uint8_t> tmp;
+	uint8_t * out = dest;
+	if (destCapacity < maxCompressedSize(srcSize)) {
+		tmp.resize(maxCompressedSize(srcSize));
+		out = tmp.data();
+	}
+	lzo_uint destLen = 0;
+	int ok = ::lzo1x_1_compress(src, srcSize, out, &destLen, wrkmem);
+	if (ok != LZO_E_OK || destLen > destCapacity) {
 		return -1;
 	}
-	else {
-		destD.flush(destLen);
-		return (int64_t) destLen;
+	if (out != dest) {
+		std::copy(out, out+destLen, dest);
 	}
+	return (int64_t) destLen;
 }
 
-int64_t LzoCompressor::decompress(const sserialize::UByteArrayAdapter & src, sserialize::UByteArrayAdapter & dest) const {
-	const UByteArrayAdapter::MemoryView srcD = src.getMemView(0, src.size());
-	UByteArrayAdapter::MemoryView destD = dest.getMemView(0, dest.size());
-	lzo_uint destLen = destD.size();
-	int ok = ::lzo1x_decompress_safe(srcD.get(), src.size(), destD.get(), & destLen, 0);
+int64_t LzoCompressor::decompress(const uint8_t * src, std::size_t srcSize, uint8_t * dest, std::size_t destCapacity) const {
+	lzo_uint destLen = destCapacity;
+	int ok = ::lzo1x_decompress_safe(src, srcSize, dest, &destLen, 0);
 	if (ok != LZO_E_OK) {
 		return -1;
 	}
-	else {
-		destD.flush(destLen);
-		return (int64_t) destLen;
-	}
+	return (int64_t) destLen;
 }
 
+std::size_t LzoCompressor::maxCompressedSize(std::size_t srcSize) const {
+	//see the lzo faq
+	return srcSize + srcSize/16 + 64 + 3;
+}
 
-}}}//end namespace
\ No newline at end of file
+}}}//end namespace
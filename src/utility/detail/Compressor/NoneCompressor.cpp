@@ -1,5 +1,5 @@
 #include "NoneCompressor.h"
-#include <sserialize/storage/UByteArrayAdapter.h>
+#include <string.h>
 
 namespace sserialize {
 namespace detail {
@@ -8,14 +8,20 @@ namespace Compressor {
 NoneCompressor::NoneCompressor() {}
 NoneCompressor::~NoneCompressor() {}
 
-int64_t NoneCompressor::decompress(const UByteArrayAdapter& src, UByteArrayAdapter & dest) const {
-	dest.putData(0, src);
-	return (int64_t) src.size();
+int64_t NoneCompressor::decompress(const uint8_t * src, std::size_t srcSize, uint8_t * dest, std::size_t destCapacity) const {
+	if (srcSize > destCapacity) {
+		return -1;
+	}
+	::memmove(dest, src, srcSize);
+	return (int64_t) srcSize;
 }
 
-int64_t NoneCompressor::compress(const UByteArrayAdapter& src, UByteArrayAdapter & dest) const {
-	dest.putData(0, src);
-	return (int64_t) src.size();
+int64_t NoneCompressor::compress(const uint8_t * src, std::size_t srcSize, uint8_t * dest, std::size_t destCapacity) const {
+	return decompress(src, srcSize, dest, destCapacity);
 }
 
-}}}//end namespace sserialize::detail::Compressor
\ No newline at end of file
+std::size_t NoneCompressor::maxCompressedSize(std::size_t srcSize) const {
+	return srcSize;
+}
+
+}}}//end namespace sserialize::detail::Compressor
@@ -10,10 +10,11 @@ class NoneCompressor: public Interface {
 public:
 	NoneCompressor();
 	virtual ~NoneCompressor();
-	virtual int64_t decompress(const sserialize::UByteArrayAdapter& src, sserialize::UByteArrayAdapter & dest) const override;
-	virtual int64_t compress(const sserialize::UByteArrayAdapter& src, sserialize::UByteArrayAdapter & dest) const override;
+	virtual int64_t decompress(const uint8_t * src, std::size_t srcSize, uint8_t * dest, std::size_t destCapacity) const override;
+	virtual int64_t compress(const uint8_t * src, std::size_t srcSize, uint8_t * dest, std::size_t destCapacity) const override;
+	virtual std::size_t maxCompressedSize(std::size_t srcSize) const override;
 };
 
 }}}//end namespace sserialize::detail::Compressor
 
-#endif
\ No newline at end of file
+#endif
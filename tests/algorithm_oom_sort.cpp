@@ -12,6 +12,8 @@ CPPUNIT_TEST( testUnique );
 CPPUNIT_TEST( testSortOOMArray );
 CPPUNIT_TEST( testUniqueOOMArray );
 CPPUNIT_TEST( testSortUniqueOOMArray );
+CPPUNIT_TEST( testLoserTree );
+CPPUNIT_TEST( testParallelMerge );
 CPPUNIT_TEST_SUITE_END();
 public:
 	virtual void setUp() {}
@@ -171,6 +173,75 @@ public:
 		}
 	}
 	
+	void testLoserTree() {
+		for(uint32_t k(1); k < 20; ++k) {
+			std::vector< std::vector<uint32_t> > sources(k);
+			std::vector<uint32_t> expected;
+			for(auto & source : sources) {
+				source.resize(rand() % 100);
+				std::generate(source.begin(), source.end(), []() { return rand() % 50; });
+				std::sort(source.begin(), source.end());
+				expected.insert(expected.end(), source.begin(), source.end());
+			}
+			std::sort(expected.begin(), expected.end());
+			
+			sserialize::detail::oom::LoserTree<uint32_t, std::less<uint32_t>> tree(k, std::less<uint32_t>());
+			std::vector<std::size_t> positions(k, 0);
+			for(uint32_t i(0); i < k; ++i) {
+				if (sources[i].size()) {
+					tree.set(i, uint32_t(sources[i].front()));
+				}
+			}
+			tree.build();
+			std::vector<uint32_t> result;
+			while (!tree.empty()) {
+				uint32_t i = tree.top();
+				result.push_back(tree.topValue());
+				positions[i] += 1;
+				if (positions[i] < sources[i].size()) {
+					tree.replaceTop(uint32_t(sources[i][positions[i]]));
+				}
+				else {
+					tree.popTop();
+				}
+			}
+			CPPUNIT_ASSERT_MESSAGE(sserialize::toString("k=", k), expected == result);
+		}
+	}
+	
+	void testParallelMerge() {
+		for(uint32_t threadCount : {1, 3, 4}) {
+			for(bool makeUnique : {false, true}) {
+				for(bool prefetch : {false, true}) {
+					std::string info = sserialize::toString("threadCount=", threadCount, ", makeUnique=", makeUnique, ", prefetch=", prefetch);
+					std::vector<uint32_t> realData(1025*1023*519/64);
+					//many duplicates to produce unbalanced ranges
+					std::generate(realData.begin(), realData.end(), []() { return rand() % 10000; });
+					sserialize::OOMArray<uint32_t> data(sserialize::MM_PROGRAM_MEMORY);
+					data.replace(data.end(), realData.begin(), realData.end());
+					
+					sserialize::detail::oom::SortTraits<false, std::less<uint32_t>, std::equal_to<uint32_t>> sortTraits;
+					sortTraits
+						.maxMemoryUsage((static_cast<uint64_t>(1) << 22)/64)
+						.mmt(sserialize::MM_PROGRAM_MEMORY)
+						.maxThreadCount(threadCount)
+						.queueDepth(8)
+						.makeUnique(makeUnique)
+						.prefetch(prefetch)
+						.ioFetchLock(!prefetch)
+						.ioFlushLock(!prefetch);
+					
+					sserialize::oom_sort(data.begin(), data.end(), sortTraits);
+					
+					std::sort(realData.begin(), realData.end());
+					auto end2 = makeUnique ? std::unique(realData.begin(), realData.end()) : realData.end();
+					CPPUNIT_ASSERT_EQUAL_MESSAGE(info, std::distance(realData.begin(), end2), std::distance(data.begin(), data.end()));
+					CPPUNIT_ASSERT_MESSAGE(info, std::equal(realData.begin(), end2, data.begin()));
+				}
+			}
+		}
+	}
+	
 };
 
 int main(int argc, char ** argv) {
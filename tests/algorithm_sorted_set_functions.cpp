@@ -0,0 +1,98 @@
+#include "TestBase.h"
+#include <sserialize/algorithm/sorted_set_functions.h>
+#include <algorithm>
+#include <random>
+#include <set>
+
+class TestSortedSetFunctions: public sserialize::tests::TestBase {
+CPPUNIT_TEST_SUITE( TestSortedSetFunctions );
+CPPUNIT_TEST( testGallop );
+CPPUNIT_TEST( testBalanced );
+CPPUNIT_TEST( testSkewed );
+CPPUNIT_TEST( testEmpty );
+CPPUNIT_TEST_SUITE_END();
+private:
+	std::vector<uint32_t> create(std::mt19937 & gen, std::size_t size, uint32_t maxId) {
+		std::set<uint32_t> tmp;
+		std::uniform_int_distribution<uint32_t> d(0, maxId);
+		while (tmp.size() < size) {
+			tmp.insert(d(gen));
+		}
+		return std::vector<uint32_t>(tmp.begin(), tmp.end());
+	}
+	template<typename T_FUNC, typename T_STD_FUNC>
+	void check(const std::vector<uint32_t> & a, const std::vector<uint32_t> & b, std::size_t maxSize, T_FUNC func, T_STD_FUNC stdFunc, const std::string & name) {
+		std::vector<uint32_t> expected;
+		stdFunc(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(expected));
+		//guard element to detect writes past maxSize
+		std::vector<uint32_t> result(maxSize+1, 0xFEFEFEFE);
+		std::size_t resultSize = func(a.data(), a.size(), b.data(), b.size(), result.data());
+		CPPUNIT_ASSERT_EQUAL_MESSAGE(name, uint32_t(0xFEFEFEFE), result.back());
+		CPPUNIT_ASSERT_EQUAL_MESSAGE(name, expected.size(), resultSize);
+		result.resize(resultSize);
+		CPPUNIT_ASSERT_MESSAGE(name, expected == result);
+	}
+	void check(const std::vector<uint32_t> & a, const std::vector<uint32_t> & b) {
+		using namespace sserialize;
+		using It = std::vector<uint32_t>::const_iterator;
+		using OutIt = std::back_insert_iterator< std::vector<uint32_t> >;
+		std::string info = sserialize::toString("aSize=", a.size(), ", bSize=", b.size());
+		check(a, b, std::min(a.size(), b.size()), &sortedset::intersect, &std::set_intersection<It, It, OutIt>, "intersect: " + info);
+		check(a, b, a.size()+b.size(), &sortedset::unite, &std::set_union<It, It, OutIt>, "unite: " + info);
+		check(a, b, a.size(), &sortedset::difference, &std::set_difference<It, It, OutIt>, "difference: " + info);
+		check(a, b, a.size()+b.size(), &sortedset::symmetricDifference, &std::set_symmetric_difference<It, It, OutIt>, "symmetricDifference: " + info);
+	}
+public:
+	void testGallop() {
+		std::mt19937 gen(0);
+		std::vector<uint32_t> a = create(gen, 1000, 10000);
+		for(uint32_t v(0); v <= 10001; ++v) {
+			for(std::size_t begin : {std::size_t(0), std::size_t(17), a.size()/2}) {
+				const uint32_t * expected = std::lower_bound(a.data()+begin, a.data()+a.size(), v);
+				CPPUNIT_ASSERT(expected == sserialize::sortedset::gallop(a.data()+begin, a.data()+a.size(), v));
+			}
+		}
+	}
+	void testBalanced() {
+		std::mt19937 gen(1);
+		for(uint32_t round(0); round < 500; ++round) {
+			std::uniform_int_distribution<std::size_t> sizeDist(0, 300);
+			uint32_t maxId = 10 + round*2;
+			std::size_t aSize = std::min<std::size_t>(sizeDist(gen), maxId);
+			std::size_t bSize = std::min<std::size_t>(sizeDist(gen), maxId);
+			check(create(gen, aSize, maxId), create(gen, bSize, maxId));
+		}
+	}
+	void testSkewed() {
+		std::mt19937 gen(2);
+		for(uint32_t round(0); round < 200; ++round) {
+			std::uniform_int_distribution<std::size_t> sizeDist(1, 20);
+			std::size_t small = sizeDist(gen);
+			std::size_t large = small*sserialize::sortedset::SkewThreshold*2 + round;
+			std::vector<uint32_t> a = create(gen, small, 100000);
+			std::vector<uint32_t> b = create(gen, large, 100000);
+			//make sure that there are common elements
+			std::vector<uint32_t> c;
+			std::set_union(a.begin(), a.end(), b.begin(), b.begin()+small, std::back_inserter(c));
+			check(c, b);
+			check(b, c);
+		}
+	}
+	void testEmpty() {
+		std::mt19937 gen(3);
+		std::vector<uint32_t> a = create(gen, 100, 1000);
+		check(a, std::vector<uint32_t>());
+		check(std::vector<uint32_t>(), a);
+		check(std::vector<uint32_t>(), std::vector<uint32_t>());
+		check(a, a);
+	}
+};
+
+int main(int argc, char ** argv) {
+	sserialize::tests::TestBase::init(argc, argv);
+
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(  TestSortedSetFunctions::suite() );
+	bool ok = runner.run();
+	return ok ? 0 : 1;
+}
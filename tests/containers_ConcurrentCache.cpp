@@ -0,0 +1,207 @@
+#include "TestBase.h"
+#include <sserialize/containers/ConcurrentCache.h>
+#include <sserialize/mt/ThreadPool.h>
+#include <random>
+#include <thread>
+#include <atomic>
+
+class TestConcurrentCache: public sserialize::tests::TestBase {
+CPPUNIT_TEST_SUITE( TestConcurrentCache );
+CPPUNIT_TEST( testFindInsert );
+CPPUNIT_TEST( testEntryLimit );
+CPPUNIT_TEST( testCostLimit );
+CPPUNIT_TEST( testSmallCapacity );
+CPPUNIT_TEST( testFrequentlyUsed );
+CPPUNIT_TEST( testStats );
+CPPUNIT_TEST( testConcurrent );
+CPPUNIT_TEST( testConcurrentSetCapacity );
+CPPUNIT_TEST_SUITE_END();
+private:
+	using Cache = sserialize::ConcurrentCache<uint32_t, uint32_t>;
+public:
+	void testFindInsert() {
+		Cache cache;
+		uint32_t v = 0;
+		CPPUNIT_ASSERT(!cache.find(1, v));
+		cache.insert(1, 10);
+		cache.insert(2, 20);
+		CPPUNIT_ASSERT(cache.find(1, v));
+		CPPUNIT_ASSERT_EQUAL(uint32_t(10), v);
+		CPPUNIT_ASSERT(cache.find(2, v));
+		CPPUNIT_ASSERT_EQUAL(uint32_t(20), v);
+		cache.insert(1, 11);
+		CPPUNIT_ASSERT(cache.find(1, v));
+		CPPUNIT_ASSERT_EQUAL(uint32_t(11), v);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(2), cache.size());
+		cache.erase(1);
+		CPPUNIT_ASSERT(!cache.contains(1));
+		CPPUNIT_ASSERT(cache.contains(2));
+		cache.clear();
+		CPPUNIT_ASSERT_EQUAL(std::size_t(0), cache.size());
+	}
+	void testEntryLimit() {
+		for(uint32_t shards : {1, 4, 16}) {
+			Cache cache(100, Cache::Unlimited, shards);
+			for(uint32_t i(0); i < 10000; ++i) {
+				cache.insert(i, i);
+				CPPUNIT_ASSERT(cache.size() <= 100+shards);
+			}
+			CPPUNIT_ASSERT(cache.size() >= 50);
+			cache.setCapacity(10);
+			CPPUNIT_ASSERT(cache.size() <= 10+shards);
+		}
+	}
+	void testCostLimit() {
+		Cache cache(Cache::Unlimited, 1000, 1);
+		for(uint32_t i(0); i < 1000; ++i) {
+			cache.insert(i, i, 1+i%50);
+			CPPUNIT_ASSERT(cache.stats().cost <= 1000);
+		}
+		//too large to be cached
+		cache.insert(5000, 5000, 1001);
+		CPPUNIT_ASSERT(!cache.contains(5000));
+		cache.setCapacity(Cache::Unlimited, 100);
+		CPPUNIT_ASSERT(cache.stats().cost <= 100);
+	}
+	void testSmallCapacity() {
+		uint32_t v = 0;
+		//small caches must not be split into shards holding a single entry each
+		Cache cache(2, 1000);
+		CPPUNIT_ASSERT_EQUAL(uint32_t(2), cache.shardCount());
+		cache.insert(1, 10, 400);
+		CPPUNIT_ASSERT(cache.find(1, v));
+		CPPUNIT_ASSERT_EQUAL(uint32_t(10), v);
+		for(uint32_t i(0); i < 100; ++i) {
+			cache.insert(i, i);
+			CPPUNIT_ASSERT(cache.size() <= 2);
+		}
+		
+		//0 disables the cache
+		cache.setCapacity(0);
+		CPPUNIT_ASSERT_EQUAL(uint32_t(0), cache.shardCount());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(0), cache.size());
+		cache.insert(1, 10);
+		CPPUNIT_ASSERT(!cache.find(1, v));
+		CPPUNIT_ASSERT(!cache.contains(1));
+		cache.erase(1);
+		
+		cache.setCapacity(5, 0);
+		cache.insert(1, 10);
+		CPPUNIT_ASSERT(!cache.contains(1));
+		
+		cache.setCapacity(5);
+		CPPUNIT_ASSERT_EQUAL(uint32_t(5), cache.shardCount());
+		cache.insert(1, 10);
+		CPPUNIT_ASSERT(cache.find(1, v));
+		CPPUNIT_ASSERT_EQUAL(uint32_t(10), v);
+		
+		Cache disabled(0);
+		disabled.insert(1, 10);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(0), disabled.size());
+	}
+	void testFrequentlyUsed() {
+		Cache cache(64, Cache::Unlimited, 1);
+		uint32_t v;
+		for(uint32_t i(0); i < 10000; ++i) {
+			//keys 0..9 are used in every round
+			for(uint32_t hot(0); hot < 10; ++hot) {
+				if (!cache.find(hot, v)) {
+					cache.insert(hot, hot);
+				}
+			}
+			cache.insert(1000+i, i);
+		}
+		for(uint32_t hot(0); hot < 10; ++hot) {
+			CPPUNIT_ASSERT(cache.contains(hot));
+		}
+	}
+	void testStats() {
+		Cache cache(10, Cache::Unlimited, 1);
+		uint32_t v;
+		for(uint32_t i(0); i < 20; ++i) {
+			cache.insert(i, i);
+		}
+		cache.find(19, v);
+		cache.find(1000, v);
+		Cache::Stats stats = cache.stats();
+		CPPUNIT_ASSERT_EQUAL(uint64_t(1), stats.hits);
+		CPPUNIT_ASSERT_EQUAL(uint64_t(1), stats.misses);
+		CPPUNIT_ASSERT_EQUAL(uint64_t(20), stats.insertions);
+		CPPUNIT_ASSERT_EQUAL(uint64_t(10), stats.evictions);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(10), stats.size);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(10), stats.cost);
+		cache.resetStats();
+		stats = cache.stats();
+		CPPUNIT_ASSERT_EQUAL(uint64_t(0), stats.hits + stats.misses + stats.insertions + stats.evictions);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(10), stats.size);
+	}
+	void testConcurrent() {
+		Cache cache(1000, 10000);
+		std::atomic<uint32_t> seed(0);
+		std::atomic<uint32_t> wrongValues(0);
+		sserialize::ThreadPool::execute([&]() {
+			std::mt19937 gen(seed.fetch_add(1));
+			std::uniform_int_distribution<uint32_t> d(0, 5000);
+			for(uint32_t i(0); i < 20000; ++i) {
+				uint32_t key = d(gen);
+				uint32_t v;
+				if (cache.find(key, v)) {
+					if (v != 2*key) {
+						wrongValues += 1;
+					}
+				}
+				else {
+					cache.insert(key, 2*key, 1+key%20);
+				}
+			}
+		}, 8, sserialize::ThreadPool::CopyTaskTag());
+		Cache::Stats stats = cache.stats();
+		CPPUNIT_ASSERT_EQUAL(uint32_t(0), wrongValues.load());
+		CPPUNIT_ASSERT_EQUAL(uint64_t(8*20000), stats.hits + stats.misses);
+		CPPUNIT_ASSERT_EQUAL(stats.insertions, stats.misses);
+		CPPUNIT_ASSERT(stats.size <= 1000+cache.shardCount());
+	}
+	void testConcurrentSetCapacity() {
+		Cache cache(1000);
+		std::atomic<uint32_t> seed(0);
+		std::atomic<uint32_t> wrongValues(0);
+		std::atomic<bool> done(false);
+		std::thread resizer([&]() {
+			std::size_t capacities[] = {0, 1, 3, 16, 100, 1000};
+			for(uint32_t i(0); !done.load(); ++i) {
+				cache.setCapacity(capacities[i % 6]);
+				std::this_thread::yield();
+			}
+		});
+		sserialize::ThreadPool::execute([&]() {
+			std::mt19937 gen(seed.fetch_add(1));
+			std::uniform_int_distribution<uint32_t> d(0, 5000);
+			for(uint32_t i(0); i < 20000; ++i) {
+				uint32_t key = d(gen);
+				uint32_t v;
+				if (cache.find(key, v)) {
+					if (v != 2*key) {
+						wrongValues += 1;
+					}
+				}
+				else {
+					cache.insert(key, 2*key);
+				}
+			}
+		}, 8, sserialize::ThreadPool::CopyTaskTag());
+		done = true;
+		resizer.join();
+		CPPUNIT_ASSERT_EQUAL(uint32_t(0), wrongValues.load());
+		cache.setCapacity(10);
+		CPPUNIT_ASSERT(cache.size() <= 10+cache.shardCount());
+	}
+};
+
+int main(int argc, char ** argv) {
+	sserialize::tests::TestBase::init(argc, argv);
+
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(  TestConcurrentCache::suite() );
+	bool ok = runner.run();
+	return ok ? 0 : 1;
+}
@@ -36,6 +36,9 @@ CPPUNIT_TEST( testIntersection );
 CPPUNIT_TEST( testMerge );
 CPPUNIT_TEST( testDifference );
 CPPUNIT_TEST( testSymDiff );
+CPPUNIT_TEST( testDifferentSizes );
+CPPUNIT_TEST( testRankSelect );
+CPPUNIT_TEST( testSmallestLargest );
 CPPUNIT_TEST_SUITE_END();
 private:
 	int testCount;
@@ -210,6 +213,83 @@ public:
 		}
 	}
 	
+	void testDifferentSizes() {
+		//sizes that are not a multiple of the word and simd block sizes
+		for(uint32_t aMax : {7, 100, 1000, 4099}) {
+			for(uint32_t bMax : {9, 513, 4001}) {
+				std::set<uint32_t> a( myCreateNumbers(aMax/3+1, aMax) );
+				std::set<uint32_t> b( myCreateNumbers(bMax/3+1, bMax) );
+				std::string info = "aMax=" + std::to_string(aMax) + ", bMax=" + std::to_string(bMax);
+				std::vector<uint32_t> i, u, d, s, tmp;
+				std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(i));
+				std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(u));
+				std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(d));
+				std::set_symmetric_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(s));
+				
+				DynamicBitSet bitSetA(createBitSet(a));
+				DynamicBitSet bitSetB(createBitSet(b));
+				
+				(bitSetA & bitSetB).putInto(std::back_inserter(tmp));
+				CPPUNIT_ASSERT_MESSAGE("& " + info, i == tmp);
+				tmp.clear();
+				(bitSetA | bitSetB).putInto(std::back_inserter(tmp));
+				CPPUNIT_ASSERT_MESSAGE("| " + info, u == tmp);
+				tmp.clear();
+				(bitSetA - bitSetB).putInto(std::back_inserter(tmp));
+				CPPUNIT_ASSERT_MESSAGE("- " + info, d == tmp);
+				tmp.clear();
+				(bitSetA ^ bitSetB).putInto(std::back_inserter(tmp));
+				CPPUNIT_ASSERT_MESSAGE("^ " + info, s == tmp);
+				tmp.clear();
+				
+				DynamicBitSet bitSetOp(createBitSet(a));
+				bitSetOp -= bitSetB;
+				CPPUNIT_ASSERT_MESSAGE("-= " + info, bitSetOp == (bitSetA - bitSetB));
+				bitSetOp |= bitSetB;
+				CPPUNIT_ASSERT_MESSAGE("|= " + info, bitSetOp == (bitSetA | bitSetB));
+				bitSetOp ^= bitSetA;
+				CPPUNIT_ASSERT_MESSAGE("^= " + info, bitSetOp == (bitSetB - bitSetA));
+				bitSetOp &= bitSetA;
+				CPPUNIT_ASSERT_MESSAGE("&= " + info, bitSetOp.size() == 0);
+				
+				DynamicBitSet inverted(~bitSetA);
+				CPPUNIT_ASSERT_EQUAL_MESSAGE("~ " + info, SizeType(bitSetA.data().size()*8 - a.size()), inverted.count());
+				CPPUNIT_ASSERT_MESSAGE("~ " + info, (inverted & bitSetA).count() == 0);
+			}
+		}
+	}
+	
+	void testRankSelect() {
+		std::set<uint32_t> realValues( myCreateNumbers(2000, 0xFFFF) );
+		DynamicBitSet bitSet(createBitSet(realValues));
+		std::vector<uint32_t> values(realValues.begin(), realValues.end());
+		CPPUNIT_ASSERT_EQUAL(SizeType(values.size()), bitSet.count());
+		for(uint32_t pos(0); pos <= values.back()+100; ++pos) {
+			SizeType expected = std::lower_bound(values.begin(), values.end(), pos) - values.begin();
+			CPPUNIT_ASSERT_EQUAL_MESSAGE("rank at " + std::to_string(pos), expected, bitSet.rank(pos));
+		}
+		for(std::size_t n(0); n < values.size(); ++n) {
+			CPPUNIT_ASSERT_EQUAL_MESSAGE("select of " + std::to_string(n), SizeType(values[n]), bitSet.select(n));
+		}
+		CPPUNIT_ASSERT_EQUAL(DynamicBitSet::npos, bitSet.select(values.size()));
+	}
+	
+	void testSmallestLargest() {
+		for(uint32_t first : {0, 1, 7, 8, 63, 64, 65, 1000}) {
+			for(uint32_t last : {first, first+1, first+63, first+64, first+1001}) {
+				DynamicBitSet bitSet;
+				bitSet.set(first);
+				bitSet.set(last);
+				CPPUNIT_ASSERT_EQUAL(IdType(first), bitSet.smallestEntry());
+				CPPUNIT_ASSERT_EQUAL(IdType(last), bitSet.largestEntry());
+				CPPUNIT_ASSERT_EQUAL(IdType((last/8+1)*8), bitSet.upperBound());
+			}
+		}
+		DynamicBitSet bitSet;
+		CPPUNIT_ASSERT_EQUAL(IdType(0), bitSet.largestEntry());
+		CPPUNIT_ASSERT_EQUAL(IdType(0), bitSet.upperBound());
+	}
+	
 };
 
 int main(int argc, char ** argv) {
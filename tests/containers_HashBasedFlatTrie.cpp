@@ -4,6 +4,7 @@
 #include <sserialize/utility/printers.h>
 #include <sserialize/storage/Size.h>
 #include <sstream>
+#include <memory>
 #include "TestBase.h"
 
 const char * inFileName = 0;
@@ -27,6 +28,8 @@ public:
 	void testParallelSerialization();
 	void testStaticNode();
 	void testStaticSearch();
+	void testStaticSearchIndex();
+	void testMerge();
 protected:
 	using SizeType = sserialize::Size;
 	using ValueType = sserialize::Size;
@@ -77,6 +80,8 @@ CPPUNIT_TEST( testSerialization );
 CPPUNIT_TEST( testStaticNode );
 CPPUNIT_TEST( testTrieEquality );
 CPPUNIT_TEST( testStaticSearch );
+CPPUNIT_TEST( testStaticSearchIndex );
+CPPUNIT_TEST( testMerge );
 // CPPUNIT_TEST( testParentChildRelation );
 CPPUNIT_TEST_SUITE_END();
 public:
@@ -172,6 +177,8 @@ CPPUNIT_TEST( testSerialization );
 CPPUNIT_TEST( testParallelSerialization );
 CPPUNIT_TEST( testStaticNode );
 CPPUNIT_TEST( testStaticSearch );
+CPPUNIT_TEST( testStaticSearchIndex );
+CPPUNIT_TEST( testMerge );
 CPPUNIT_TEST( testSpecialStaticSearch );
 // CPPUNIT_TEST( testParentChildRelation );
 CPPUNIT_TEST_SUITE_END();
@@ -435,6 +442,130 @@ TestHashBasedFlatTrieBase::testStaticSearch() {
 		CPPUNIT_ASSERT_EQUAL_MESSAGE("search broken for" + str, ValueType(i), sft.at(str, false));
 	}
 }
+
+void
+TestHashBasedFlatTrieBase::testStaticSearchIndex() {
+	if (!numTestStrings())
+		return;
+
+	sserialize::UByteArrayAdapter hftOut(sserialize::UByteArrayAdapter::createCache(1, sserialize::MM_PROGRAM_MEMORY));
+	m_ht.append(hftOut, [](const MyT::NodePtr & n) { return n->value(); }, 1, 0);
+	MyST sft(hftOut);
+	CPPUNIT_ASSERT(!sft.hasSearchIndex());
+	CPPUNIT_ASSERT_EQUAL(hftOut.tellPutPtr(), sft.getSizeInBytes());
+	
+	//strings, prefixes and strings that are not in the trie
+	std::vector<std::string> queries;
+	for(std::size_t i(0), s(numTestStrings()); i < s; ++i) {
+		const std::string & str = testString(i);
+		queries.push_back(str);
+		queries.push_back(str + "A");
+		queries.push_back(str + "\xFF");
+		if (str.size()) {
+			queries.push_back(str.substr(0, str.size()-1));
+			queries.push_back(str.substr(0, str.size()/2));
+		}
+	}
+	for(std::size_t i(0), s(numCheckStrings()); i < s; ++i) {
+		queries.push_back(checkString(i));
+	}
+	queries.push_back("");
+	queries.push_back("\xFF\xFF");
+	
+	for(MyST::SizeType stride : {1, 2, 3, 7, 64}) {
+		sserialize::UByteArrayAdapter indexedOut(sserialize::UByteArrayAdapter::createCache(1, sserialize::MM_PROGRAM_MEMORY));
+		m_ht.append(indexedOut, [](const MyT::NodePtr & n) { return n->value(); }, 1, stride);
+		MyST indexed(indexedOut);
+		CPPUNIT_ASSERT(indexed.hasSearchIndex());
+		CPPUNIT_ASSERT_EQUAL(stride, indexed.searchIndexStride());
+		CPPUNIT_ASSERT_EQUAL(indexedOut.tellPutPtr(), indexed.getSizeInBytes());
+		for(const std::string & str : queries) {
+			for(bool prefixMatch : {false, true}) {
+				CPPUNIT_ASSERT_EQUAL_MESSAGE("search index broken for " + str, sft.find(str, prefixMatch), indexed.find(str, prefixMatch));
+			}
+		}
+		for(std::size_t i(0), s(numTestStrings()); i < s; ++i) {
+			const std::string & str = testString(i);
+			CPPUNIT_ASSERT_EQUAL_MESSAGE("search broken for" + str, ValueType(i), indexed.at(str, false));
+		}
+	}
+}
+
+void
+TestHashBasedFlatTrieBase::testMerge() {
+	constexpr std::size_t TrieCount = 3;
+	//string i is inserted into trie i%TrieCount and together with its suffixes into trie (i+1)%TrieCount
+	auto insertSuffixes = [](MyT & t, const std::string & str) {
+		auto sstr = t.insert(str);
+		std::string::const_iterator strIt(str.cbegin()), strEnd(str.cend());
+		if (strIt == strEnd) {
+			return;
+		}
+		for(utf8::next(strIt, strEnd); strIt != strEnd; utf8::next(strIt, strEnd)) {
+			t.insert(sstr.addOffset(std::distance(str.cbegin(), strIt)));
+		}
+	};
+	auto setValues = [this](MyT & t) {
+		for(std::size_t i(0), s(numTestStrings()); i < s; ++i) {
+			if (t.count(testString(i))) {
+				t.at(testString(i)) = i;
+			}
+		}
+	};
+	MyT ref;
+	std::vector< std::unique_ptr<MyT> > tries;
+	for(std::size_t i(0); i < TrieCount; ++i) {
+		tries.emplace_back(new MyT());
+	}
+	for(std::size_t i(0), s(numTestStrings()); i < s; ++i) {
+		tries[i % TrieCount]->insert(testString(i));
+		insertSuffixes(*tries[(i+1) % TrieCount], testString(i));
+		insertSuffixes(ref, testString(i));
+	}
+	setValues(ref);
+	MyT merged;
+	for(std::size_t i(0); i < TrieCount; ++i) {
+		setValues(*tries[i]);
+		merged.merge(std::move(*tries[i]));
+		CPPUNIT_ASSERT_EQUAL(SizeType(0), tries[i]->size());
+	}
+	CPPUNIT_ASSERT_EQUAL(ref.size(), merged.size());
+	
+	ref.finalize();
+	merged.finalize();
+	auto refIt = ref.cbegin();
+	for(auto it(merged.cbegin()), end(merged.cend()); it != end; ++it, ++refIt) {
+		CPPUNIT_ASSERT_EQUAL(ref.toStr(refIt->first), merged.toStr(it->first));
+		CPPUNIT_ASSERT_EQUAL(refIt->second, it->second);
+	}
+	SizeType offendingString;
+	CPPUNIT_ASSERT(merged.valid(offendingString));
+	
+	//strings already present in the destination do not use additional storage
+	MyT a, b;
+	for(std::size_t i(0), s(numTestStrings()); i < s; ++i) {
+		a.insert(testString(i));
+		b.insert(testString(i));
+	}
+	auto storageSize = a.minStorageSize();
+	a.merge(std::move(b));
+	CPPUNIT_ASSERT_EQUAL(storageSize, a.minStorageSize());
+	
+	//suffixes share the data of their string after merging
+	MyT suffixes, dest;
+	std::size_t stringDataSize = 0;
+	for(std::size_t i(0), s(numTestStrings()); i < s; ++i) {
+		insertSuffixes(suffixes, testString(i));
+		stringDataSize += testString(i).size();
+	}
+	dest.insert(testString(0));
+	//the hash table must not grow, hence only the string data changes the storage size
+	dest.reserve(2*suffixes.size());
+	storageSize = dest.minStorageSize();
+	dest.merge(std::move(suffixes));
+	CPPUNIT_ASSERT(dest.minStorageSize() - storageSize <= stringDataSize);
+}
+
 //END Implementation of TestHashBasedFlatTrieBase
 
 int main(int argc, char ** argv) {
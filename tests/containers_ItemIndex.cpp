@@ -95,6 +95,116 @@ public:
 	ItemIndexPrivateSerializedTest() : ItemIndexPrivateBaseTest(T_TYPE) {}
 };
 
+template<typename T_PRIVATE_INDEX, typename T_ITERATOR, typename T_CREATOR>
+class ItemIndexPrivateSkipTableTest: public sserialize::tests::TestBase {
+CPPUNIT_TEST_SUITE( ItemIndexPrivateSkipTableTest );
+CPPUNIT_TEST( testEquality );
+CPPUNIT_TEST( testAdvanceTo );
+CPPUNIT_TEST( testFind );
+CPPUNIT_TEST( testIntersect );
+CPPUNIT_TEST( testCreator );
+CPPUNIT_TEST_SUITE_END();
+private:
+	std::vector<uint32_t> m_src;
+private:
+	sserialize::ItemIndex create(const std::vector<uint32_t> & src, sserialize::ItemIndex::CompressionLevel cl, uint32_t skipTableInterval) {
+		sserialize::UByteArrayAdapter dest(0, sserialize::MM_PROGRAM_MEMORY);
+		T_PRIVATE_INDEX::create(src, dest, cl, skipTableInterval);
+		dest.resetPtrs();
+		return sserialize::ItemIndex::createInstance<T_PRIVATE_INDEX>(dest);
+	}
+	const T_PRIVATE_INDEX * priv(const sserialize::ItemIndex & idx) {
+		return static_cast<const T_PRIVATE_INDEX*>(idx.priv());
+	}
+	template<typename T_FUNC>
+	void forAllConfigs(T_FUNC func) {
+		for(auto cl : {sserialize::ItemIndex::CL_LOW, sserialize::ItemIndex::CL_MID, sserialize::ItemIndex::CL_HIGH}) {
+			for(uint32_t skipTableInterval : {0, 1, 3}) {
+				func(create(m_src, cl, skipTableInterval), skipTableInterval);
+			}
+		}
+	}
+public:
+	virtual void setUp() override {
+		m_src.clear();
+		uint32_t id = 0;
+		for(uint32_t i(0); i < 20000; ++i) {
+			id += 1 + (rand() % 64);
+			m_src.push_back(id);
+		}
+	}
+	void testEquality() {
+		forAllConfigs([this](const sserialize::ItemIndex & idx, uint32_t skipTableInterval) {
+			CPPUNIT_ASSERT_EQUAL(skipTableInterval > 0, priv(idx)->hasSkipTable());
+			CPPUNIT_ASSERT(idx == m_src);
+		});
+	}
+	void testAdvanceTo() {
+		forAllConfigs([this](const sserialize::ItemIndex & idx, uint32_t) {
+			std::unique_ptr<T_ITERATOR> it( static_cast<T_ITERATOR*>(priv(idx)->cbegin()) );
+			uint32_t target = 0;
+			while (true) {
+				target += rand() % 2000;
+				it->advanceTo(target);
+				uint32_t expected = std::lower_bound(m_src.begin(), m_src.end(), target) - m_src.begin();
+				CPPUNIT_ASSERT_EQUAL(expected, it->indexPosition());
+				if (expected >= m_src.size()) {
+					break;
+				}
+				CPPUNIT_ASSERT_EQUAL(m_src.at(expected), it->get());
+			}
+		});
+	}
+	void testFind() {
+		forAllConfigs([this](const sserialize::ItemIndex & idx, uint32_t) {
+			for(uint32_t i(0); i < 200; ++i) {
+				uint32_t pos = rand() % m_src.size();
+				CPPUNIT_ASSERT_EQUAL(pos, priv(idx)->find(m_src.at(pos)));
+				CPPUNIT_ASSERT_EQUAL(pos, priv(idx)->lowerBound(m_src.at(pos)));
+				if (pos == 0 || m_src.at(pos-1)+1 < m_src.at(pos)) {
+					CPPUNIT_ASSERT_EQUAL(pos, priv(idx)->lowerBound(m_src.at(pos)-1));
+					CPPUNIT_ASSERT_EQUAL(sserialize::ItemIndex::npos, priv(idx)->find(m_src.at(pos)-1));
+				}
+			}
+			CPPUNIT_ASSERT_EQUAL(sserialize::ItemIndex::npos, priv(idx)->find(m_src.back()+1));
+			CPPUNIT_ASSERT_EQUAL(uint32_t(m_src.size()), priv(idx)->lowerBound(m_src.back()+1));
+		});
+	}
+	void testIntersect() {
+		std::vector<uint32_t> small;
+		for(uint32_t i(0); i < 50; ++i) {
+			small.push_back(m_src.at(rand() % m_src.size()) + (rand() % 2));
+		}
+		std::sort(small.begin(), small.end());
+		small.erase(std::unique(small.begin(), small.end()), small.end());
+		std::vector<uint32_t> expected;
+		std::set_intersection(m_src.begin(), m_src.end(), small.begin(), small.end(), std::back_inserter(expected));
+		forAllConfigs([&,this](const sserialize::ItemIndex & idx, uint32_t) {
+			sserialize::ItemIndex smallIdx = create(small, sserialize::ItemIndex::CL_DEFAULT, 0);
+			CPPUNIT_ASSERT(expected == (idx / smallIdx));
+			CPPUNIT_ASSERT(expected == (smallIdx / idx));
+			CPPUNIT_ASSERT(expected == (idx / sserialize::ItemIndex(small)));
+		});
+	}
+	void testCreator() {
+		for(uint32_t skipTableInterval : {1, 2, 5}) {
+			sserialize::UByteArrayAdapter dest(0, sserialize::MM_PROGRAM_MEMORY);
+			T_CREATOR creator(dest, sserialize::ItemIndexPrivatePFoR::DefaultBlockSizeOffset, sserialize::detail::ItemIndexImpl::BlockSkipTableCreator(skipTableInterval));
+			for(uint32_t x : m_src) {
+				creator.push_back(x);
+			}
+			creator.flush();
+			sserialize::ItemIndex idx = creator.getIndex();
+			CPPUNIT_ASSERT(priv(idx)->hasSkipTable());
+			CPPUNIT_ASSERT(idx == m_src);
+			for(uint32_t i(0); i < 100; ++i) {
+				uint32_t pos = rand() % m_src.size();
+				CPPUNIT_ASSERT_EQUAL(pos, priv(idx)->find(m_src.at(pos)));
+			}
+		}
+	}
+};
+
 int main(int argc, char ** argv) {
 	sserialize::tests::TestBase::init(argc, argv);
 	
@@ -154,9 +264,11 @@ int main(int argc, char ** argv) {
 	}
 	if (selectedTests & sserialize::ItemIndex::T_PFOR) {
 		runner.addTest(  ItemIndexPrivateSerializedTest<sserialize::ItemIndex::T_PFOR>::suite() );
+		runner.addTest(  ItemIndexPrivateSkipTableTest<sserialize::ItemIndexPrivatePFoR, sserialize::detail::ItemIndexImpl::PFoRIterator, sserialize::detail::ItemIndexImpl::PFoRCreator>::suite() );
 	}
 	if (selectedTests & sserialize::ItemIndex::T_FOR) {
 		runner.addTest(  ItemIndexPrivateSerializedTest<sserialize::ItemIndex::T_FOR>::suite() );
+		runner.addTest(  ItemIndexPrivateSkipTableTest<sserialize::ItemIndexPrivateFoR, sserialize::detail::ItemIndexImpl::FoRIterator, sserialize::detail::ItemIndexImpl::FoRCreator>::suite() );
 	}
 	
 	if (sserialize::tests::TestBase::popProtector()) {
@@ -1,5 +1,7 @@
 #include <stdlib.h>
 #include <vector>
+#include <set>
+#include <cstring>
 #include <sserialize/algorithm/utilfuncs.h>
 #include <sserialize/containers/ItemIndexPrivates/ItemIndexPrivateRleDE.h>
 #include <sserialize/containers/ItemIndex.h>
@@ -15,6 +17,11 @@ template<uint32_t T_SET_COUNT, uint32_t T_MAX_SET_FILL, int T_IDX_TYPE>
 class ItemIndexFactoryTest: public sserialize::tests::TestBase {
 CPPUNIT_TEST_SUITE( ItemIndexFactoryTest );
 CPPUNIT_TEST( testSameId );
+CPPUNIT_TEST( testDeduplicationHash );
+CPPUNIT_TEST( testFastHasherShortInputs );
+CPPUNIT_TEST( testConcurrentInsert );
+CPPUNIT_TEST( testSizeEstimation );
+CPPUNIT_TEST( testMultipleSelection );
 CPPUNIT_TEST( testIdxSize );
 CPPUNIT_TEST( testIdxFromId );
 CPPUNIT_TEST( testInitFromStatic );
@@ -22,6 +29,7 @@ CPPUNIT_TEST( testSerializedEquality );
 CPPUNIT_TEST( testCompressionHuffman );
 CPPUNIT_TEST( testCompressionLZO );
 CPPUNIT_TEST( testCompressionVarUint );
+CPPUNIT_TEST( testCache );
 CPPUNIT_TEST_SUITE_END();
 private:
 	ItemIndexFactory m_idxFactory;
@@ -57,6 +65,96 @@ public:
 		}
 	}
 	
+	void testDeduplicationHash() {
+		uint32_t hitCount = m_idxFactory.hitCount();
+		for(auto dh : {ItemIndexFactory::DH_SHA3, ItemIndexFactory::DH_FAST}) {
+			m_idxFactory.setDeduplicationHash(dh);
+			CPPUNIT_ASSERT_EQUAL(dh, m_idxFactory.deduplicationHash());
+			for(bool verify : {false, true}) {
+				m_idxFactory.setDeduplicationVerification(verify);
+				for(uint32_t i = 0; i < m_sets.size(); ++i) {
+					uint32_t id = m_idxFactory.addIndex(m_sets[i]);
+					CPPUNIT_ASSERT_EQUAL(m_setIds[i], id);
+				}
+			}
+		}
+		CPPUNIT_ASSERT_EQUAL(uint32_t(hitCount + 4*m_sets.size()), m_idxFactory.hitCount());
+		m_idxFactory.setDeduplicationVerification(false);
+	}
+	
+	///both halves of the digest have to depend on the input, also for inputs shorter than a block
+	void testFastHasherShortInputs() {
+		FastHasher128<std::vector<uint8_t>> hasher;
+		for(uint32_t len(1); len <= 33; ++len) {
+			std::set<uint64_t> low, high;
+			for(uint32_t i(0); i < 256; ++i) {
+				std::vector<uint8_t> data(len, 0);
+				data[i % len] = (uint8_t) i;
+				data[(i+len/2) % len] ^= (uint8_t) (i >> 1);
+				auto digest = hasher(data);
+				uint64_t h[2];
+				::memcpy(h, digest.begin(), sizeof(h));
+				low.insert(h[0]);
+				high.insert(h[1]);
+			}
+			CPPUNIT_ASSERT(low.size() > 250);
+			CPPUNIT_ASSERT_EQUAL_MESSAGE("len=" + std::to_string(len), low.size(), high.size());
+		}
+	}
+	
+	void testConcurrentInsert() {
+		CPPUNIT_ASSERT_MESSAGE("Serialization failed", m_idxFactory.flush());
+		Static::ItemIndexStore sdb(m_idxFactory.getFlushedData());
+		for(bool verify : {false, true}) {
+			sserialize::ItemIndexFactory idxFactory;
+			idxFactory.setType(T_IDX_TYPE);
+			idxFactory.setIndexFile( UByteArrayAdapter::createCache(T_SET_COUNT*T_MAX_SET_FILL, sserialize::MM_PROGRAM_MEMORY) );
+			idxFactory.setDeduplicationVerification(verify);
+			for(uint32_t round(0); round < 2; ++round) {
+				std::vector<uint32_t> remap = idxFactory.insert(sdb, 4);
+				CPPUNIT_ASSERT_EQUAL(sdb.size(), idxFactory.size());
+				for(uint32_t i = 0, s = (uint32_t) remap.size(); i < s; ++i) {
+					CPPUNIT_ASSERT_EQUAL_MESSAGE(sserialize::toString("idx at ", i), sdb.at(i), idxFactory.indexById(remap.at(i)));
+				}
+			}
+		}
+	}
+	
+	void testSizeEstimation() {
+		std::vector< std::set<uint32_t> > sets(m_sets);
+		sets.push_back(std::set<uint32_t>({0}));
+		sets.push_back(std::set<uint32_t>({0xFFFFFF}));
+		sets.push_back(std::set<uint32_t>({0, 1, 2, 3, 4, 5, 6, 7, 8, 100, 200, 300, 1000000}));
+		for(const std::set<uint32_t> & s : sets) {
+			detail::ItemIndexSizeEstimator estimator(s.cbegin(), s.cend());
+			for(int type : {ItemIndex::T_NATIVE, ItemIndex::T_DE, ItemIndex::T_RLE_DE, ItemIndex::T_ELIAS_FANO}) {
+				UByteArrayAdapter tmp(new std::vector<uint8_t>(), true);
+				CPPUNIT_ASSERT_EQUAL(ItemIndex::Types(type), ItemIndexFactory::create(s, tmp, type));
+				CPPUNIT_ASSERT_EQUAL_MESSAGE(sserialize::toString("type=", type, ", size=", s.size()), tmp.size(), estimator.size(type));
+			}
+		}
+	}
+	
+	void testMultipleSelection() {
+		int types = ItemIndex::T_NATIVE | ItemIndex::T_DE | ItemIndex::T_RLE_DE | ItemIndex::T_ELIAS_FANO | ItemIndex::T_WAH | ItemIndex::T_PFOR;
+		for(const std::set<uint32_t> & s : m_sets) {
+			UByteArrayAdapter::SizeType bestSize = std::numeric_limits<UByteArrayAdapter::SizeType>::max();
+			for(int type = 1; type <= types; type <<= 1) {
+				if (type & types) {
+					UByteArrayAdapter tmp(new std::vector<uint8_t>(), true);
+					ItemIndexFactory::create(s, tmp, type);
+					bestSize = std::min(bestSize, tmp.size());
+				}
+			}
+			UByteArrayAdapter tmp(new std::vector<uint8_t>(), true);
+			ItemIndex::Types type = ItemIndexFactory::create(s, tmp, types | ItemIndex::T_MULTIPLE);
+			CPPUNIT_ASSERT(type & types);
+			CPPUNIT_ASSERT_EQUAL(bestSize, tmp.size());
+			tmp.resetPtrs();
+			CPPUNIT_ASSERT(s == ItemIndex(tmp, type));
+		}
+	}
+	
 	void testIdxSize() {
 		for(uint32_t i = 0; i < m_sets.size(); ++i) {
 			uint32_t idxSize = m_idxFactory.idxSize(m_setIds[i]);
@@ -167,6 +265,47 @@ public:
 		}
 	}
 	
+	void testCache() {
+		CPPUNIT_ASSERT_MESSAGE("Serialization failed", m_idxFactory.flush());
+
+		UByteArrayAdapter dataAdap( m_idxFactory.getFlushedData());
+		UByteArrayAdapter cmpDataAdap(new std::vector<uint8_t>(dataAdap.size(), 0), true);
+		Static::ItemIndexStore sdb(dataAdap);
+		UByteArrayAdapter::OffsetType s = sserialize::ItemIndexFactory::compressWithLZO(sdb, cmpDataAdap);
+		cmpDataAdap.shrinkStorage(cmpDataAdap.size()-s);
+		Static::ItemIndexStore csdb(cmpDataAdap);
+		
+		for(Static::ItemIndexStore * store : {&sdb, &csdb}) {
+			uint32_t minIndexSize = 8;
+			uint32_t cacheable = 0;
+			store->setCacheCapacity(store->size(), std::numeric_limits<std::size_t>::max(), minIndexSize);
+			for(uint32_t round(0); round < 2; ++round) {
+				for(size_t i = 0; i < m_sets.size(); ++i) {
+					ItemIndex idx = store->at(m_setIds[i]);
+					CPPUNIT_ASSERT_MESSAGE(sserialize::toString("Index at ", i, " in round ", round), m_sets[i] == idx);
+					if (!round && m_sets[i].size() >= minIndexSize) {
+						cacheable += 1;
+					}
+				}
+			}
+			auto stats = store->cacheStats();
+			CPPUNIT_ASSERT(stats.size <= cacheable);
+			CPPUNIT_ASSERT(stats.hits >= cacheable);
+			CPPUNIT_ASSERT_EQUAL(uint64_t(stats.size), stats.insertions);
+			
+			//a cache too small for a single index
+			store->setCacheCapacity(store->size(), 4, minIndexSize);
+			CPPUNIT_ASSERT_EQUAL(std::size_t(0), store->cacheStats().size);
+			for(size_t i = 0; i < m_sets.size(); ++i) {
+				CPPUNIT_ASSERT(m_sets[i] == store->at(m_setIds[i]));
+			}
+			CPPUNIT_ASSERT_EQUAL(std::size_t(0), store->cacheStats().size);
+			
+			store->setCacheCapacity(0, 0);
+			CPPUNIT_ASSERT_EQUAL(uint64_t(0), store->cacheStats().hits);
+		}
+	}
+	
 	void testVeryLargeItemIndexFactory() {
 	
 	}
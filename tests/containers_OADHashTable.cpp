@@ -0,0 +1,124 @@
+#include "TestBase.h"
+#include <sserialize/containers/OADHashTable.h>
+#include <unordered_map>
+#include <random>
+
+class TestOADHashTable: public sserialize::tests::TestBase {
+CPPUNIT_TEST_SUITE( TestOADHashTable );
+CPPUNIT_TEST( testDoubleHashing );
+CPPUNIT_TEST( testGrouped );
+CPPUNIT_TEST( testHighLoad );
+CPPUNIT_TEST( testSwitchProbingMode );
+CPPUNIT_TEST( testSort );
+CPPUNIT_TEST_SUITE_END();
+private:
+	using HashTable = sserialize::OADHashTable<uint32_t, uint32_t>;
+	using Ref = std::unordered_map<uint32_t, uint32_t>;
+private:
+	///random keys and runs of consecutive keys
+	std::vector<uint32_t> createKeys(uint32_t count, uint32_t seed) {
+		std::mt19937 gen(seed);
+		std::vector<uint32_t> keys;
+		while (keys.size() < count) {
+			uint32_t k = gen();
+			for(uint32_t i(0), s(gen() % 64); i < s && keys.size() < count; ++i) {
+				keys.push_back(k+i);
+			}
+			keys.push_back(gen() % 1024);
+		}
+		return keys;
+	}
+	void fill(HashTable & ht, Ref & ref, const std::vector<uint32_t> & keys) {
+		for(uint32_t i(0); i < keys.size(); ++i) {
+			ht[keys[i]] = i;
+			ref[keys[i]] = i;
+			CPPUNIT_ASSERT_EQUAL((std::size_t) ht.size(), ref.size());
+		}
+	}
+	void check(HashTable & ht, const Ref & ref) {
+		CPPUNIT_ASSERT_EQUAL(ref.size(), (std::size_t) ht.size());
+		for(const auto & x : ref) {
+			CPPUNIT_ASSERT(ht.count(x.first));
+			CPPUNIT_ASSERT_EQUAL(x.second, ht.at(x.first));
+			auto it = ht.find(x.first);
+			CPPUNIT_ASSERT(it != ht.end());
+			CPPUNIT_ASSERT_EQUAL(x.first, it->first);
+		}
+		std::mt19937 gen(1);
+		for(uint32_t i(0); i < 1000; ++i) {
+			uint32_t k = gen();
+			CPPUNIT_ASSERT_EQUAL(bool(ref.count(k)), ht.count(k));
+		}
+		for(const auto & x : ht) {
+			CPPUNIT_ASSERT_EQUAL(ref.at(x.first), x.second);
+		}
+	}
+	void testMode(HashTable::ProbingMode pm, double maxLoad) {
+		for(uint32_t count : {0, 1, 15, 16, 17, 1000, 100000}) {
+			HashTable ht;
+			ht.probingMode(pm);
+			ht.max_load_factor(maxLoad);
+			CPPUNIT_ASSERT_EQUAL(pm, ht.probingMode());
+			Ref ref;
+			std::vector<uint32_t> keys = createKeys(count, count);
+			fill(ht, ref, keys);
+			check(ht, ref);
+			CPPUNIT_ASSERT(ht.load_factor() <= maxLoad);
+			//iteration order is the insertion order
+			auto it = ht.cbegin();
+			for(uint32_t k : keys) {
+				if (it != ht.cend() && it->first == k) {
+					++it;
+				}
+			}
+			CPPUNIT_ASSERT(it == ht.cend());
+			ht.clear();
+			CPPUNIT_ASSERT_EQUAL(HashTable::SizeType(0), ht.size());
+			CPPUNIT_ASSERT(!ht.count(keys.size() ? keys.front() : 0));
+		}
+	}
+public:
+	void testDoubleHashing() {
+		testMode(HashTable::PM_DOUBLE_HASHING, 0.8);
+	}
+	void testGrouped() {
+		testMode(HashTable::PM_GROUPED, 0.8);
+	}
+	void testHighLoad() {
+		testMode(HashTable::PM_GROUPED, 0.97);
+	}
+	void testSwitchProbingMode() {
+		HashTable ht;
+		Ref ref;
+		std::vector<uint32_t> keys = createKeys(20000, 0);
+		fill(ht, ref, std::vector<uint32_t>(keys.begin(), keys.begin()+10000));
+		ht.probingMode(HashTable::PM_GROUPED);
+		check(ht, ref);
+		fill(ht, ref, std::vector<uint32_t>(keys.begin()+10000, keys.end()));
+		check(ht, ref);
+		HashTable copy(ht);
+		check(copy, ref);
+		ht.probingMode(HashTable::PM_DOUBLE_HASHING);
+		check(ht, ref);
+	}
+	void testSort() {
+		for(auto pm : {HashTable::PM_DOUBLE_HASHING, HashTable::PM_GROUPED}) {
+			HashTable ht;
+			ht.probingMode(pm);
+			Ref ref;
+			fill(ht, ref, createKeys(5000, 3));
+			ht.sort([](const HashTable::value_type & a, const HashTable::value_type & b) { return a.first < b.first; });
+			CPPUNIT_ASSERT(std::is_sorted(ht.cbegin(), ht.cend()));
+			check(ht, ref);
+		}
+	}
+};
+
+int main(int argc, char ** argv) {
+	sserialize::tests::TestBase::init(argc, argv);
+
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(  TestOADHashTable::suite() );
+	bool ok = runner.run();
+	return ok ? 0 : 1;
+}
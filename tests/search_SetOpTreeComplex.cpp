@@ -0,0 +1,208 @@
+#include <sserialize/search/SetOpTree.h>
+#include <sserialize/search/StringCompleterPrivate.h>
+#include <algorithm>
+#include <random>
+#include <atomic>
+#include <set>
+#include "TestBase.h"
+
+class WordCompleter: public sserialize::StringCompleterPrivate {
+public:
+	std::map<std::string, std::vector<uint32_t>> words;
+	mutable std::atomic<uint32_t> calls{0};
+public:
+	virtual sserialize::ItemIndex complete(const std::string & str, sserialize::StringCompleter::QuerryType) const override {
+		calls += 1;
+		auto it = words.find(str);
+		if (it == words.end()) {
+			return sserialize::ItemIndex();
+		}
+		return sserialize::ItemIndex(std::vector<uint32_t>(it->second));
+	}
+	virtual std::map<uint16_t, sserialize::ItemIndex> getNextCharacters(const std::string & str, sserialize::StringCompleter::QuerryType, bool) const override {
+		std::map<uint16_t, std::set<uint32_t>> tmp;
+		for(auto it(words.lower_bound(str)); it != words.end() && it->first.compare(0, str.size(), str) == 0; ++it) {
+			if (it->first.size() > str.size()) {
+				tmp[(unsigned char) it->first[str.size()]].insert(it->second.begin(), it->second.end());
+			}
+		}
+		std::map<uint16_t, sserialize::ItemIndex> result;
+		for(const auto & x : tmp) {
+			result[x.first] = sserialize::ItemIndex(std::vector<uint32_t>(x.second.begin(), x.second.end()));
+		}
+		return result;
+	}
+	virtual sserialize::StringCompleter::SupportedQuerries getSupportedQuerries() const override {
+		return sserialize::StringCompleter::SQ_ALL;
+	}
+};
+
+class CountingFilter: public sserialize::SetOpTree::ExternalFunctoid {
+public:
+	uint32_t * calls;
+	CountingFilter(uint32_t * calls) : calls(calls) {}
+	virtual sserialize::ItemIndex operator()(const std::string &) override {
+		*calls += 1;
+		return sserialize::ItemIndex(std::vector<uint32_t>({1, 2, 3}));
+	}
+	virtual const std::string cmdString() const override { return "Count"; }
+};
+
+class TestSetOpTreeComplex: public sserialize::tests::TestBase {
+CPPUNIT_TEST_SUITE( TestSetOpTreeComplex );
+CPPUNIT_TEST( testRandomQueries );
+CPPUNIT_TEST( testParallelRandomQueries );
+CPPUNIT_TEST( testDeduplication );
+CPPUNIT_TEST( testShortCircuit );
+CPPUNIT_TEST( testCharacterHints );
+CPPUNIT_TEST_SUITE_END();
+private:
+	static constexpr uint32_t WordCount = 16;
+	typedef std::vector<uint32_t> Set;
+private:
+	std::mt19937 m_gen;
+	sserialize::RCPtrWrapper<WordCompleter> m_completer;
+private:
+	///creates a fully braced random query and its result
+	std::string createQuery(uint32_t depth, Set & result) {
+		std::uniform_int_distribution<uint32_t> wordDist(0, WordCount-1);
+		std::uniform_int_distribution<uint32_t> opDist(0, 5);
+		if (!depth || opDist(m_gen) == 0) {
+			std::string word = "w" + std::to_string(wordDist(m_gen));
+			result = m_completer->words.at(word);
+			return word;
+		}
+		Set a, b;
+		std::string aStr = createQuery(depth-1, a);
+		std::string bStr = createQuery(depth-1, b);
+		std::string op;
+		switch (opDist(m_gen)) {
+		case 0:
+		case 1:
+			op = " ";
+			std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+			break;
+		case 2:
+			op = " / ";
+			std::set_intersection(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+			break;
+		case 3:
+			op = " + ";
+			std::set_union(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+			break;
+		case 4:
+			op = " - ";
+			std::set_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+			break;
+		default:
+			op = " ^ ";
+			std::set_symmetric_difference(a.begin(), a.end(), b.begin(), b.end(), std::back_inserter(result));
+			break;
+		}
+		return "(" + aStr + op + bStr + ")";
+	}
+	void check(uint32_t threadCount) {
+		for(uint32_t i(0); i < 500; ++i) {
+			Set expected;
+			std::string query = createQuery(1 + i % 4, expected);
+			sserialize::SetOpTree opTree(sserialize::SetOpTree::SOT_COMPLEX);
+			opTree.registerStringCompleter(sserialize::StringCompleter(m_completer));
+			opTree.setThreadCount(threadCount);
+			opTree.buildTree(query);
+			opTree.doCompletions();
+			sserialize::ItemIndex result = opTree.doSetOperations();
+			CPPUNIT_ASSERT_MESSAGE(query, result == expected);
+		}
+	}
+public:
+	virtual void setUp() override {
+		m_gen.seed(0);
+		m_completer.reset(new WordCompleter());
+		std::uniform_int_distribution<uint32_t> sizeDist(0, 400);
+		for(uint32_t i(0); i < WordCount; ++i) {
+			std::set<uint32_t> tmp;
+			//some selective and some large words
+			uint32_t size = (i % 4 == 0 ? sizeDist(m_gen) % 8 : sizeDist(m_gen));
+			while (tmp.size() < size) {
+				tmp.insert(m_gen() % 1000);
+			}
+			m_completer->words["w" + std::to_string(i)] = Set(tmp.begin(), tmp.end());
+		}
+	}
+	virtual void tearDown() override {
+		m_completer.reset(0);
+	}
+	void testRandomQueries() {
+		check(1);
+	}
+	void testParallelRandomQueries() {
+		check(4);
+	}
+	void testDeduplication() {
+		sserialize::SetOpTree opTree(sserialize::SetOpTree::SOT_COMPLEX);
+		opTree.registerStringCompleter(sserialize::StringCompleter(m_completer));
+		opTree.buildTree("(w1 w2) + (w1 w3) + (w2 - w1)");
+		m_completer->calls = 0;
+		opTree.doCompletions();
+		CPPUNIT_ASSERT_EQUAL(uint32_t(3), m_completer->calls.load());
+	}
+	void testShortCircuit() {
+		uint32_t calls = 0;
+		m_completer->words["empty"] = Set();
+		sserialize::SetOpTree opTree(sserialize::SetOpTree::SOT_COMPLEX);
+		opTree.registerStringCompleter(sserialize::StringCompleter(m_completer));
+		opTree.registerExternalFunction(new CountingFilter(&calls));
+
+		opTree.buildTree("$Count[x] w1 empty");
+		opTree.doCompletions();
+		CPPUNIT_ASSERT_EQUAL(uint32_t(0), opTree.doSetOperations().size());
+		CPPUNIT_ASSERT_EQUAL(uint32_t(0), calls);
+
+		opTree.buildTree("empty - $Count[x]");
+		opTree.doCompletions();
+		CPPUNIT_ASSERT_EQUAL(uint32_t(0), opTree.doSetOperations().size());
+		CPPUNIT_ASSERT_EQUAL(uint32_t(0), calls);
+
+		opTree.buildTree("$Count[x] w5");
+		opTree.doCompletions();
+		opTree.doSetOperations();
+		CPPUNIT_ASSERT_EQUAL(uint32_t(1), calls);
+	}
+	void testCharacterHints() {
+		m_completer->words["x"] = Set({1, 2, 5, 7});
+		m_completer->words["y"] = Set({1, 2, 3, 8});
+		m_completer->words["z"] = Set({2, 9});
+		m_completer->words["ab"] = Set({1, 2, 3, 7, 8});
+		m_completer->words["abc"] = Set({1, 2, 3});
+		m_completer->words["abd"] = Set({7, 8});
+		std::vector< std::pair<std::string, std::set<uint16_t>> > queries = {
+			{"x ab", {'c', 'd'}},
+			{"x y ab", {'c'}},
+			{"x y z ab", {'c'}},
+			{"y z x ab", {'c'}},
+			{"z x ab", {'c'}},
+			{"y ab", {'c', 'd'}},
+		};
+		for(uint32_t threadCount : {1, 4}) {
+			for(const auto & q : queries) {
+				sserialize::SetOpTree opTree(sserialize::SetOpTree::SOT_COMPLEX);
+				opTree.registerStringCompleter(sserialize::StringCompleter(m_completer));
+				opTree.setThreadCount(threadCount);
+				opTree.buildTree(q.first);
+				opTree.doCompletions();
+				opTree.doSetOperations();
+				std::set<uint16_t> hints = opTree.getCharacterHint((uint32_t) q.first.size()-1);
+				CPPUNIT_ASSERT_MESSAGE(q.first, hints == q.second);
+			}
+		}
+	}
+};
+
+int main(int argc, char ** argv) {
+	sserialize::tests::TestBase::init(argc, argv);
+
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(  TestSetOpTreeComplex::suite() );
+	bool ok = runner.run();
+	return ok ? 0 : 1;
+}
@@ -0,0 +1,183 @@
+#include <sserialize/spatial/CellQueryResult.h>
+#include <sserialize/containers/ItemIndexFactory.h>
+#include <sserialize/Static/ItemIndexStore.h>
+#include <algorithm>
+#include <random>
+#include <map>
+#include "TestBase.h"
+
+class CellInfo: public sserialize::interface::CQRCellInfoIface {
+public:
+	std::vector<uint32_t> itemsPtr;
+	std::vector<uint32_t> itemsCount;
+public:
+	virtual SizeType cellSize() const override { return (SizeType) itemsPtr.size(); }
+	virtual sserialize::spatial::GeoRect cellBoundary(CellId) const override { return sserialize::spatial::GeoRect(); }
+	virtual SizeType cellItemsCount(CellId cellId) const override { return itemsCount.at(cellId); }
+	virtual IndexId cellItemsPtr(CellId cellId) const override { return itemsPtr.at(cellId); }
+};
+
+class TestCellQueryResult: public sserialize::tests::TestBase {
+CPPUNIT_TEST_SUITE( TestCellQueryResult );
+CPPUNIT_TEST( testSetOps );
+CPPUNIT_TEST( testParallelSetOps );
+CPPUNIT_TEST_SUITE_END();
+private:
+	typedef std::map<uint32_t, std::vector<uint32_t>> CellItems;
+	static constexpr uint32_t CellCount = 4000;
+	static constexpr uint32_t PartialMatchesPerCell = 2;
+private:
+	std::mt19937 m_gen;
+	std::vector< std::vector<uint32_t> > m_cellItems;
+	sserialize::Static::ItemIndexStore m_idxStore;
+	sserialize::CellQueryResult::CellInfo m_ci;
+	///PartialMatchesPerCell subsets of the items of each cell
+	///Cqrs choose one of them, hence the shortcuts for equal index ids are used as well
+	std::vector< std::vector<uint32_t> > m_pmItems;
+	std::vector<uint32_t> m_pmItemsPtr;
+private:
+	std::vector<uint32_t> randomSubset(const std::vector<uint32_t> & src) {
+		std::vector<uint32_t> result;
+		std::uniform_int_distribution<uint32_t> d(0, 1);
+		for(uint32_t x : src) {
+			if (d(m_gen)) {
+				result.push_back(x);
+			}
+		}
+		if (result.empty()) {
+			result.push_back(src.front());
+		}
+		return result;
+	}
+	///@param fetched create fetched partial matches instead of index ids
+	sserialize::CellQueryResult create(double cellRatio, bool fetched, CellItems & ref) {
+		std::uniform_real_distribution<double> cellDist(0.0, 1.0);
+		std::uniform_int_distribution<uint32_t> typeDist(0, 3);
+		std::uniform_int_distribution<uint32_t> pmDist(0, PartialMatchesPerCell-1);
+		std::vector<uint32_t> fm, pm, pmPtr;
+		std::vector<sserialize::ItemIndex> pmIdx;
+		for(uint32_t cellId(0); cellId < CellCount; ++cellId) {
+			if (cellDist(m_gen) >= cellRatio) {
+				continue;
+			}
+			uint32_t type = typeDist(m_gen);
+			if (type == 0) {
+				fm.push_back(cellId);
+				ref[cellId] = m_cellItems[cellId];
+			}
+			else {
+				uint32_t pmId = cellId*PartialMatchesPerCell + pmDist(m_gen);
+				pm.push_back(cellId);
+				pmPtr.push_back(m_pmItemsPtr[pmId]);
+				pmIdx.emplace_back(std::vector<uint32_t>(m_pmItems[pmId]));
+				ref[cellId] = m_pmItems[pmId];
+			}
+		}
+		if (fetched) {
+			return sserialize::CellQueryResult(sserialize::ItemIndex(std::move(fm)), sserialize::ItemIndex(std::move(pm)), pmIdx.cbegin(), m_ci, m_idxStore, sserialize::CellQueryResult::FF_CELL_GLOBAL_ITEM_IDS);
+		}
+		return sserialize::CellQueryResult(sserialize::ItemIndex(std::move(fm)), sserialize::ItemIndex(std::move(pm)), pmPtr.cbegin(), m_ci, m_idxStore, sserialize::CellQueryResult::FF_CELL_GLOBAL_ITEM_IDS);
+	}
+	template<typename T_STD_FUNC>
+	CellItems apply(const CellItems & a, const CellItems & b, bool unite, bool keepOther, T_STD_FUNC stdFunc) {
+		CellItems result;
+		for(const auto & x : a) {
+			auto it = b.find(x.first);
+			std::vector<uint32_t> tmp;
+			if (it != b.end()) {
+				stdFunc(x.second.begin(), x.second.end(), it->second.begin(), it->second.end(), std::back_inserter(tmp));
+			}
+			else if (unite) {
+				tmp = x.second;
+			}
+			if (tmp.size()) {
+				result[x.first] = std::move(tmp);
+			}
+		}
+		if (keepOther) {
+			for(const auto & x : b) {
+				if (!a.count(x.first)) {
+					result[x.first] = x.second;
+				}
+			}
+		}
+		return result;
+	}
+	void check(const CellItems & expected, const sserialize::CellQueryResult & cqr, const std::string & msg) {
+		CPPUNIT_ASSERT_EQUAL_MESSAGE(msg, (uint32_t) expected.size(), cqr.cellCount());
+		auto it = expected.begin();
+		for(uint32_t i(0), s(cqr.cellCount()); i < s; ++i, ++it) {
+			CPPUNIT_ASSERT_EQUAL_MESSAGE(msg, it->first, cqr.cellId(i));
+			CPPUNIT_ASSERT_MESSAGE(msg, cqr.idx(i) == it->second);
+		}
+	}
+	void check(uint32_t threadCount) {
+		using It = std::vector<uint32_t>::const_iterator;
+		using OutIt = std::back_insert_iterator< std::vector<uint32_t> >;
+		for(double aRatio : {0.05, 0.5, 0.9}) {
+			for(double bRatio : {0.1, 0.6}) {
+				for(uint32_t fetched(0); fetched < 4; ++fetched) {
+					std::string msg = sserialize::toString("aRatio=", aRatio, ", bRatio=", bRatio, ", fetched=", fetched, ", threadCount=", threadCount);
+					CellItems aRef, bRef;
+					sserialize::CellQueryResult a = create(aRatio, fetched & 0x1, aRef);
+					sserialize::CellQueryResult b = create(bRatio, fetched & 0x2, bRef);
+					check(apply(aRef, bRef, false, false, &std::set_intersection<It, It, OutIt>), a.intersect(b, threadCount), "intersect: " + msg);
+					check(apply(aRef, bRef, true, true, &std::set_union<It, It, OutIt>), a.unite(b, threadCount), "unite: " + msg);
+					check(apply(aRef, bRef, true, false, &std::set_difference<It, It, OutIt>), a.diff(b, threadCount), "diff: " + msg);
+					check(apply(aRef, bRef, true, true, &std::set_symmetric_difference<It, It, OutIt>), a.symDiff(b, threadCount), "symDiff: " + msg);
+					check(aRef, a.intersect(a, threadCount), "self intersect: " + msg);
+				}
+			}
+		}
+	}
+public:
+	virtual void setUp() override {
+		m_gen.seed(0);
+		std::uniform_int_distribution<uint32_t> sizeDist(1, 64);
+		sserialize::ItemIndexFactory idxFactory(true);
+		sserialize::RCPtrWrapper<CellInfo> ci(new CellInfo());
+		uint32_t itemId = 0;
+		for(uint32_t cellId(0); cellId < CellCount; ++cellId) {
+			std::vector<uint32_t> items;
+			for(uint32_t i(0), s(sizeDist(m_gen)); i < s; ++i) {
+				items.push_back(itemId);
+				itemId += 1 + m_gen() % 4;
+			}
+			//cells overlap a bit
+			itemId -= std::min<uint32_t>(itemId, 8);
+			ci->itemsPtr.push_back(idxFactory.addIndex(items));
+			ci->itemsCount.push_back((uint32_t) items.size());
+			for(uint32_t i(0); i < PartialMatchesPerCell; ++i) {
+				m_pmItems.push_back(randomSubset(items));
+				m_pmItemsPtr.push_back(idxFactory.addIndex(m_pmItems.back()));
+			}
+			m_cellItems.push_back(std::move(items));
+		}
+		idxFactory.flush();
+		m_idxStore = sserialize::Static::ItemIndexStore(idxFactory.getFlushedData());
+		m_ci = ci;
+	}
+	virtual void tearDown() override {
+		m_cellItems.clear();
+		m_pmItems.clear();
+		m_pmItemsPtr.clear();
+		m_idxStore = sserialize::Static::ItemIndexStore();
+		m_ci = sserialize::CellQueryResult::CellInfo();
+	}
+	void testSetOps() {
+		check(1);
+	}
+	void testParallelSetOps() {
+		check(4);
+		check(0);
+	}
+};
+
+int main(int argc, char ** argv) {
+	sserialize::tests::TestBase::init(argc, argv);
+
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(  TestCellQueryResult::suite() );
+	bool ok = runner.run();
+	return ok ? 0 : 1;
+}
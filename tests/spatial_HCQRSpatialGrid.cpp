@@ -0,0 +1,245 @@
+#include <sserialize/spatial/dgg/HCQRSpatialGrid.h>
+#include <sserialize/spatial/dgg/SpatialGrid.h>
+#include <sserialize/containers/ItemIndexFactory.h>
+#include <sserialize/Static/ItemIndexStore.h>
+#include <random>
+#include <map>
+#include "TestBase.h"
+
+namespace {
+
+///Quadtree with the level in the lower 8 bits and 2 bits per level for the path above
+class QuadGrid: public sserialize::spatial::dgg::interface::SpatialGrid {
+public:
+	static constexpr Level MaxLevel = 3;
+public:
+	QuadGrid() {}
+	~QuadGrid() override {}
+public:
+	std::string name() const override { return "quadgrid"; }
+	Level maxLevel() const override { return MaxLevel; }
+	Level defaultLevel() const override { return MaxLevel; }
+	PixelId rootPixelId() const override { return 0; }
+	Level level(PixelId pixelId) const override { return pixelId & 0xFF; }
+	bool isAncestor(PixelId ancestor, PixelId decendant) const override {
+		Level aLevel = level(ancestor);
+		Level dLevel = level(decendant);
+		return aLevel < dLevel && (path(decendant) >> (2*(dLevel-aLevel))) == path(ancestor);
+	}
+	PixelId index(double, double, Level) const override { return NoPixelId; }
+	PixelId index(double, double) const override { return NoPixelId; }
+	PixelId index(PixelId parent, uint32_t childNumber) const override {
+		return (((path(parent) << 2) | childNumber) << 8) | (level(parent)+1);
+	}
+	PixelId parent(PixelId child) const override {
+		return ((path(child) >> 2) << 8) | (level(child)-1);
+	}
+	Size childrenCount(PixelId pixel) const override { return level(pixel) < MaxLevel ? 4 : 0; }
+	std::unique_ptr<TreeNode> tree(CellIterator, CellIterator) const override { return std::unique_ptr<TreeNode>(); }
+	double area(PixelId) const override { return 0; }
+	sserialize::spatial::GeoRect bbox(PixelId) const override { return sserialize::spatial::GeoRect(); }
+private:
+	static PixelId path(PixelId pixelId) { return pixelId >> 8; }
+};
+
+class QuadGridInfo: public sserialize::spatial::dgg::interface::SpatialGridInfo {
+public:
+	std::map<PixelId, sserialize::ItemIndex> pixelItems;
+public:
+	SizeType itemCount(PixelId pid) const override { return pixelItems.at(pid).size(); }
+	ItemIndex items(PixelId pid) const override { return pixelItems.at(pid); }
+	PixelId pixelId(CompressedPixelId const & cpid) const override { return cpid.value(); }
+};
+
+}//end namespace
+
+class TestHCQRSpatialGrid: public sserialize::tests::TestBase {
+CPPUNIT_TEST_SUITE( TestHCQRSpatialGrid );
+CPPUNIT_TEST( testParallelIntersect );
+CPPUNIT_TEST( testParallelUnite );
+CPPUNIT_TEST( testParallelDiff );
+CPPUNIT_TEST( testParallelFetched );
+CPPUNIT_TEST_SUITE_END();
+private:
+	using HCQRSpatialGrid = sserialize::spatial::dgg::impl::HCQRSpatialGrid;
+	using HCQRPtr = HCQRSpatialGrid::HCQRPtr;
+	using TreeNode = HCQRSpatialGrid::TreeNode;
+	using TreeNodeArena = HCQRSpatialGrid::TreeNodeArena;
+	using PixelId = TreeNode::PixelId;
+	static constexpr uint32_t PartialMatchesPerPixel = 2;
+	static constexpr uint32_t GridCount = 8;
+	static constexpr uint32_t ThreadCount = 4;
+private:
+	std::mt19937 m_gen;
+	sserialize::RCPtrWrapper<QuadGrid> m_sg;
+	sserialize::RCPtrWrapper<QuadGridInfo> m_sgi;
+	sserialize::Static::ItemIndexStore m_idxStore;
+	///PartialMatchesPerPixel index ids of subsets of the items of each leaf pixel
+	std::map<PixelId, std::vector<uint32_t>> m_pmItemsPtr;
+	std::vector<HCQRPtr> m_grids;
+private:
+	sserialize::ItemIndex addPixelItems(PixelId pid, uint32_t & itemId, sserialize::ItemIndexFactory & idxFactory) {
+		sserialize::ItemIndex result;
+		if (m_sg->level(pid) == QuadGrid::MaxLevel) {
+			std::vector<uint32_t> items;
+			for(uint32_t i(0), s(1 + m_gen() % 32); i < s; ++i) {
+				items.push_back(itemId);
+				itemId += 1 + m_gen() % 3;
+			}
+			for(uint32_t i(0); i < PartialMatchesPerPixel; ++i) {
+				std::vector<uint32_t> pm;
+				for(uint32_t x : items) {
+					if (m_gen() % 2) {
+						pm.push_back(x);
+					}
+				}
+				if (pm.empty()) {
+					pm.push_back(items.front());
+				}
+				m_pmItemsPtr[pid].push_back(idxFactory.addIndex(pm));
+			}
+			result = sserialize::ItemIndex(items);
+		}
+		else {
+			std::vector<sserialize::ItemIndex> tmp;
+			for(uint32_t i(0); i < m_sg->childrenCount(pid); ++i) {
+				tmp.emplace_back(addPixelItems(m_sg->index(pid, i), itemId, idxFactory));
+			}
+			result = sserialize::ItemIndex::unite(tmp);
+		}
+		m_sgi->pixelItems[pid] = result;
+		return result;
+	}
+	TreeNode * createNode(TreeNodeArena & arena, PixelId pid, double density) {
+		std::uniform_real_distribution<double> d(0.0, 1.0);
+		if (m_sg->level(pid) == QuadGrid::MaxLevel) {
+			if (d(m_gen) >= density) {
+				return nullptr;
+			}
+			uint32_t type = m_gen() % (PartialMatchesPerPixel+1);
+			if (type == PartialMatchesPerPixel) {
+				return TreeNode::make(arena, pid, TreeNode::IS_FULL_MATCH);
+			}
+			return TreeNode::make(arena, pid, TreeNode::IS_PARTIAL_MATCH, m_pmItemsPtr.at(pid).at(type));
+		}
+		if (m_sg->level(pid) == QuadGrid::MaxLevel-1 && d(m_gen) < 0.1*density) {
+			return TreeNode::make(arena, pid, TreeNode::IS_FULL_MATCH);
+		}
+		TreeNode * node = TreeNode::make(arena, pid, TreeNode::IS_INTERNAL);
+		for(uint32_t i(0); i < m_sg->childrenCount(pid); ++i) {
+			TreeNode * child = createNode(arena, m_sg->index(pid, i), density);
+			if (child) {
+				node->children().push_back(child);
+			}
+		}
+		return node->children().size() ? node : nullptr;
+	}
+	HCQRPtr createGrid(double density) {
+		TreeNodeArena arena;
+		TreeNode * root = createNode(arena, m_sg->rootPixelId(), density);
+		return HCQRPtr(new HCQRSpatialGrid(std::move(arena), root, m_idxStore, m_sg, m_sgi));
+	}
+	static HCQRSpatialGrid & impl(HCQRPtr const & x) {
+		return const_cast<HCQRSpatialGrid&>(dynamic_cast<HCQRSpatialGrid const &>(*x));
+	}
+	void checkEqual(HCQRSpatialGrid const & expected, TreeNode const * expectedNode, HCQRSpatialGrid const & actual, TreeNode const * actualNode) {
+		CPPUNIT_ASSERT_EQUAL(bool(expectedNode), bool(actualNode));
+		if (!expectedNode) {
+			return;
+		}
+		CPPUNIT_ASSERT_EQUAL(expectedNode->pixelId(), actualNode->pixelId());
+		CPPUNIT_ASSERT_EQUAL(expectedNode->flags(), actualNode->flags());
+		CPPUNIT_ASSERT_EQUAL(expectedNode->children().size(), actualNode->children().size());
+		if (expectedNode->isLeaf()) {
+			CPPUNIT_ASSERT_EQUAL(expected.items(*expectedNode), actual.items(*actualNode));
+		}
+		for(std::size_t i(0); i < expectedNode->children().size(); ++i) {
+			checkEqual(expected, expectedNode->children()[i], actual, actualNode->children()[i]);
+		}
+	}
+	///computes op sequentially and with ThreadCount threads and compares the results
+	template<typename TOp>
+	void check(HCQRPtr const & first, HCQRPtr const & second, TOp op, sserialize::ItemIndex const & expectedItems) {
+		impl(first).setThreadCount(1);
+		HCQRPtr sequential = op(*first, *second);
+		impl(first).setThreadCount(ThreadCount);
+		HCQRPtr parallel = op(*first, *second);
+		impl(first).setThreadCount(1);
+		CPPUNIT_ASSERT_EQUAL(ThreadCount, impl(parallel).threadCount());
+		CPPUNIT_ASSERT_EQUAL(expectedItems, sequential->items());
+		CPPUNIT_ASSERT_EQUAL(expectedItems, parallel->items());
+		CPPUNIT_ASSERT_EQUAL(sequential->numberOfItems(), parallel->numberOfItems());
+		CPPUNIT_ASSERT_EQUAL(sequential->numberOfNodes(), parallel->numberOfNodes());
+		CPPUNIT_ASSERT_EQUAL(sequential->depth(), parallel->depth());
+		CPPUNIT_ASSERT_EQUAL(impl(sequential).fetchedItems().size(), impl(parallel).fetchedItems().size());
+		checkEqual(impl(sequential), impl(sequential).root(), impl(parallel), impl(parallel).root());
+	}
+public:
+	virtual void setUp() override {
+		m_gen.seed(0);
+		m_sg.reset(new QuadGrid());
+		m_sgi.reset(new QuadGridInfo());
+		sserialize::ItemIndexFactory idxFactory(true);
+		uint32_t itemId = 0;
+		addPixelItems(m_sg->rootPixelId(), itemId, idxFactory);
+		idxFactory.flush();
+		m_idxStore = sserialize::Static::ItemIndexStore(idxFactory.getFlushedData());
+		for(uint32_t i(0); i < GridCount; ++i) {
+			m_grids.push_back(createGrid(0.2 + 0.1*i));
+		}
+	}
+	virtual void tearDown() override {
+		m_grids.clear();
+		m_pmItemsPtr.clear();
+		m_idxStore = sserialize::Static::ItemIndexStore();
+		m_sgi = sserialize::RCPtrWrapper<QuadGridInfo>();
+		m_sg = sserialize::RCPtrWrapper<QuadGrid>();
+	}
+	void testParallelIntersect() {
+		for(HCQRPtr const & first : m_grids) {
+			for(HCQRPtr const & second : m_grids) {
+				check(first, second, [](auto const & a, auto const & b) { return a / b; }, first->items() / second->items());
+			}
+		}
+	}
+	void testParallelUnite() {
+		for(HCQRPtr const & first : m_grids) {
+			for(HCQRPtr const & second : m_grids) {
+				check(first, second, [](auto const & a, auto const & b) { return a + b; }, first->items() + second->items());
+			}
+		}
+	}
+	void testParallelDiff() {
+		for(HCQRPtr const & first : m_grids) {
+			for(HCQRPtr const & second : m_grids) {
+				check(first, second, [](auto const & a, auto const & b) { return a - b; }, first->items() - second->items());
+			}
+		}
+	}
+	///results of intersections contain fetched nodes
+	void testParallelFetched() {
+		std::vector<HCQRPtr> fetched;
+		for(uint32_t i(0); i+1 < m_grids.size(); ++i) {
+			fetched.push_back(*m_grids[i] / *m_grids[i+1]);
+			CPPUNIT_ASSERT(impl(fetched.back()).fetchedItems().size());
+		}
+		for(HCQRPtr const & first : fetched) {
+			for(HCQRPtr const & second : m_grids) {
+				check(first, second, [](auto const & a, auto const & b) { return a / b; }, first->items() / second->items());
+				check(first, second, [](auto const & a, auto const & b) { return a + b; }, first->items() + second->items());
+				check(first, second, [](auto const & a, auto const & b) { return a - b; }, first->items() - second->items());
+				check(second, first, [](auto const & a, auto const & b) { return a + b; }, second->items() + first->items());
+				check(second, first, [](auto const & a, auto const & b) { return a - b; }, second->items() - first->items());
+			}
+		}
+	}
+};
+
+int main(int argc, char ** argv) {
+	sserialize::tests::TestBase::init(argc, argv);
+
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(  TestHCQRSpatialGrid::suite() );
+	bool ok = runner.run();
+	return ok ? 0 : 1;
+}
@@ -5,6 +5,8 @@
 #include "utilalgos.h"
 #include "TestBase.h"
 #include <sserialize/spatial/GeoGrid.h>
+#include <sserialize/spatial/GeoPolygonEdgeIndex.h>
+#include <sserialize/Static/GeoPolygon.h>
 
 using namespace sserialize;
 
@@ -13,10 +15,51 @@ CPPUNIT_TEST_SUITE( GeoPolygonTest );
 CPPUNIT_TEST( testIntersect );
 CPPUNIT_TEST( testPointIntersect );
 CPPUNIT_TEST( testEnclosing );
+CPPUNIT_TEST( testEdgeIndex );
+CPPUNIT_TEST( testEdgeIndexSerialization );
+CPPUNIT_TEST( testBatchContains );
 CPPUNIT_TEST_SUITE_END();
 private:
 	SamplePolygonTestData m_data;
 private:
+	///star shaped polygon with many vertices around (10, 20)
+	sserialize::spatial::GeoPolygon createStarPolygon(uint32_t pointCount) {
+		std::vector<sserialize::spatial::GeoPoint> points;
+		for(uint32_t i(0); i < pointCount; ++i) {
+			double angle = 2*M_PI*i/pointCount;
+			double r = 1.0 + 4.0*double(rand())/RAND_MAX;
+			points.emplace_back(10.0 + r*std::sin(angle), 20.0 + r*std::cos(angle));
+		}
+		return sserialize::spatial::GeoPolygon(points);
+	}
+	
+	///random points in and around the boundary, the vertices, points on the edges and points sharing a coordinate with a vertex
+	template<typename T_GEO_POLYGON>
+	std::vector<sserialize::spatial::GeoPoint> createTestPoints(const T_GEO_POLYGON & poly, uint32_t randomCount) {
+		std::vector<sserialize::spatial::GeoPoint> result;
+		sserialize::spatial::GeoRect rect = poly.boundary();
+		rect.resize(1.2, 1.2);
+		for(uint32_t i(0); i < randomCount; ++i) {
+			result.emplace_back(rect.minLat() + (rect.maxLat()-rect.minLat())*double(rand())/RAND_MAX,
+								rect.minLon() + (rect.maxLon()-rect.minLon())*double(rand())/RAND_MAX);
+		}
+		for(auto prev(poly.cbegin()), it(poly.cbegin()+1), end(poly.cend()); it != end; ++it, ++prev) {
+			sserialize::spatial::GeoPoint p(*prev), q(*it);
+			result.push_back(q);
+			result.emplace_back((p.lat()+q.lat())/2, (p.lon()+q.lon())/2);
+			result.emplace_back(result.front().lat(), q.lon());
+			result.emplace_back(q.lat(), result.front().lon());
+		}
+		return result;
+	}
+	
+	template<typename T_GEO_POLYGON>
+	void checkEdgeIndex(const T_GEO_POLYGON & poly, const sserialize::spatial::GeoPolygonEdgeIndex & idx, const std::vector<sserialize::spatial::GeoPoint> & points) {
+		for(uint32_t i(0); i < points.size(); ++i) {
+			CPPUNIT_ASSERT_EQUAL_MESSAGE(sserialize::toString("point ", i, "=", points[i]), poly.contains(points[i]), idx.contains(points[i]));
+		}
+	}
+	
 	std::string brokenPolyIntersect(uint32_t i, uint32_t j) {
 		std::stringstream ss;
 		ss << "Broken poly-collide between polygon["  << i << "]=";
@@ -85,6 +128,71 @@ public:
 			}
 		}
 	}
+	
+	void testEdgeIndex() {
+		std::vector<sserialize::spatial::GeoPolygon> polys;
+		for(uint32_t i(0); i < m_data.polys.size(); ++i) {
+			polys.push_back(m_data.poly(i));
+		}
+		polys.push_back(createStarPolygon(10));
+		polys.push_back(createStarPolygon(1000));
+		polys.push_back(sserialize::spatial::GeoPolygon::fromRect(sserialize::spatial::GeoRect(-1, 1, -1, 1)));
+		for(const sserialize::spatial::GeoPolygon & poly : polys) {
+			std::vector<sserialize::spatial::GeoPoint> points(createTestPoints(poly, 10000));
+			for(uint32_t rasterSize : {0, 1, 3, 64}) {
+				for(uint32_t slabCount : {0, 1, 7}) {
+					sserialize::spatial::GeoPolygonEdgeIndex idx(poly, slabCount, rasterSize);
+					CPPUNIT_ASSERT_EQUAL((uint32_t) poly.points().size(), idx.size());
+					checkEdgeIndex(poly, idx, points);
+				}
+			}
+		}
+		//most cells of a large polygon should not need the slabs
+		sserialize::spatial::GeoPolygonEdgeIndex idx(createStarPolygon(1000), 0, 256);
+		CPPUNIT_ASSERT(idx.boundaryCellCount() < idx.latCells()*idx.lonCells()/2);
+		
+		sserialize::spatial::GeoPolygonEdgeIndex emptyIdx;
+		CPPUNIT_ASSERT(!emptyIdx.contains(0.0, 0.0));
+	}
+	
+	void testEdgeIndexSerialization() {
+		sserialize::spatial::GeoPolygon poly(createStarPolygon(500));
+		sserialize::UByteArrayAdapter d(sserialize::UByteArrayAdapter::createCache(0, sserialize::MM_PROGRAM_MEMORY));
+		d << poly;
+		sserialize::UByteArrayAdapter::OffsetType idxBegin = d.tellPutPtr();
+		
+		sserialize::Static::spatial::GeoPolygon spoly(d);
+		sserialize::spatial::GeoPolygonEdgeIndex idx(spoly);
+		d << idx;
+		CPPUNIT_ASSERT_EQUAL(idx.getSizeInBytes(), d.tellPutPtr()-idxBegin);
+		
+		sserialize::spatial::GeoPolygonEdgeIndex sidx(sserialize::UByteArrayAdapter(d, idxBegin));
+		CPPUNIT_ASSERT_EQUAL(idx.size(), sidx.size());
+		CPPUNIT_ASSERT_EQUAL(idx.slabCount(), sidx.slabCount());
+		CPPUNIT_ASSERT_EQUAL(idx.boundaryCellCount(), sidx.boundaryCellCount());
+		checkEdgeIndex(spoly, sidx, createTestPoints(spoly, 10000));
+	}
+	
+	void testBatchContains() {
+		sserialize::spatial::GeoPolygon poly(createStarPolygon(200));
+		std::vector<sserialize::spatial::GeoPoint> points(createTestPoints(poly, 1000));
+		for(uint32_t count : {0, 10, 1000}) {
+			std::vector<bool> result;
+			poly.contains(points.begin(), points.begin()+count, std::back_inserter(result));
+			CPPUNIT_ASSERT_EQUAL((std::size_t) count, result.size());
+			for(uint32_t i(0); i < count; ++i) {
+				CPPUNIT_ASSERT_EQUAL(poly.contains(points[i]), (bool) result[i]);
+			}
+		}
+		sserialize::UByteArrayAdapter d(sserialize::UByteArrayAdapter::createCache(0, sserialize::MM_PROGRAM_MEMORY));
+		d << poly;
+		sserialize::Static::spatial::GeoPolygon spoly(d);
+		std::vector<char> result(points.size());
+		spoly.contains(points.cbegin(), points.cend(), result.begin());
+		for(uint32_t i(0); i < points.size(); ++i) {
+			CPPUNIT_ASSERT_EQUAL(spoly.contains(points[i]), (bool) result[i]);
+		}
+	}
 };
 
 int main(int argc, char ** argv) {
@@ -34,6 +34,7 @@ template<int NumberOfRuns, int TestDataLength>
 class HuffmanCodeTest: public sserialize::tests::TestBase {
 CPPUNIT_TEST_SUITE( HuffmanCodeTest );
 CPPUNIT_TEST( testEquality );
+CPPUNIT_TEST( testSkewedEquality );
 CPPUNIT_TEST_SUITE_END();
 private:
 	std::vector<uint32_t> createTestData() {
@@ -44,6 +45,15 @@ private:
 		return ret;
 	}
 	
+	///mostly short codes, hence the lookup table decodes multiple codes at once
+	std::vector<uint32_t> createSkewedTestData() {
+		std::vector<uint32_t> ret;
+		for(int i = 0; i < TestDataLength; ++i) {
+			ret.push_back( rand() % (1 << (rand() % 14)) );
+		}
+		return ret;
+	}
+	
 	template<typename TInputIterator>
 	void createAlphabet(TInputIterator begin, const TInputIterator & end, std::unordered_map<uint32_t, uint32_t> & dest) {
 		for(; begin != end; ++begin) {
@@ -73,7 +83,18 @@ public:
 	
 	void testEquality() {
 		for(int i = 0; i < NumberOfRuns; ++i) {
-			std::vector< uint32_t > testData = createTestData();
+			check(createTestData());
+		}
+	}
+	
+	void testSkewedEquality() {
+		for(int i = 0; i < NumberOfRuns; ++i) {
+			check(createSkewedTestData());
+		}
+	}
+	
+	void check(const std::vector<uint32_t> & testData) {
+		{
 			std::unordered_map<uint32_t, uint32_t> alphabet;
 			std::vector<uint8_t> bitsPerLevel = createBitsPerLevel(4, 2, 4);
 			createAlphabet(testData.begin(), testData.end(), alphabet);
@@ -104,10 +125,21 @@ public:
 			MultiBitIterator bitIt(dataAdap);
 			UDWIterator udwIt(  new UDWIteratorPrivateHD(bitIt, decoder), true  );
 			
+			UDWIterator copyIt(udwIt);
 			for(uint32_t i = 0; i < testData.size(); ++i) {
 				uint32_t real = testData[i];
 				uint32_t decoded = udwIt.next();
 				CPPUNIT_ASSERT_EQUAL_MESSAGE(printToString("at position ", i), real, decoded);
+				//copies in between pending codes of the lookup table
+				if (i % 7 == 3 && i+1 < testData.size()) {
+					copyIt = udwIt;
+					CPPUNIT_ASSERT_MESSAGE(printToString("copy at position ", i), copyIt.hasNext());
+					CPPUNIT_ASSERT_EQUAL_MESSAGE(printToString("copy at position ", i), testData[i+1], copyIt.next());
+				}
+			}
+			udwIt.reset();
+			for(uint32_t i = 0; i < testData.size(); ++i) {
+				CPPUNIT_ASSERT_EQUAL_MESSAGE(printToString("after reset at position ", i), testData[i], udwIt.next());
 			}
 		}
 	}
@@ -0,0 +1,81 @@
+#include "TestBase.h"
+#include <sserialize/utility/Bitpacking.h>
+#include <sserialize/utility/exceptions.h>
+#include <random>
+
+class TestBitpacking: public sserialize::tests::TestBase {
+CPPUNIT_TEST_SUITE( TestBitpacking );
+CPPUNIT_TEST( testScalar );
+CPPUNIT_TEST( testSse42 );
+CPPUNIT_TEST( testAvx2 );
+CPPUNIT_TEST( testShared );
+CPPUNIT_TEST_SUITE_END();
+private:
+	using InstructionLevel = sserialize::BitpackingInterface::InstructionLevel;
+private:
+	void check(uint32_t bpn, uint32_t count, InstructionLevel il) {
+		std::mt19937 gen(bpn*count);
+		std::vector<uint32_t> src(count);
+		for(uint32_t & x : src) {
+			x = gen() & sserialize::createMask(bpn);
+		}
+		std::vector<uint8_t> packed(std::size_t(count)*bpn/8);
+		{
+			const uint32_t * sit = src.data();
+			uint8_t * dit = packed.data();
+			uint32_t myCount = count;
+			sserialize::BitpackingInterface::instance(bpn, sserialize::detail::bitpacking::IL_SCALAR)->pack_blocks(sit, dit, myCount);
+			CPPUNIT_ASSERT_EQUAL(uint32_t(0), myCount);
+			CPPUNIT_ASSERT(dit == packed.data()+packed.size());
+		}
+		//guard element to detect writes past the end
+		std::vector<uint32_t> dest(count+1, 0xFEFEFEFE);
+		const uint8_t * sit = packed.data();
+		uint32_t * dit = dest.data();
+		uint32_t myCount = count;
+		sserialize::BitpackingInterface::instance(bpn, il)->unpack_blocks(sit, dit, myCount);
+		CPPUNIT_ASSERT_EQUAL(uint32_t(0), myCount);
+		CPPUNIT_ASSERT(sit == packed.data()+packed.size());
+		CPPUNIT_ASSERT(dit == dest.data()+count);
+		CPPUNIT_ASSERT_EQUAL(uint32_t(0xFEFEFEFE), dest.back());
+		for(uint32_t i(0); i < count; ++i) {
+			CPPUNIT_ASSERT_EQUAL_MESSAGE(sserialize::toString("bpn=", bpn, ", count=", count, ", i=", i), src[i], dest[i]);
+		}
+	}
+	void check(InstructionLevel il) {
+		if (il > sserialize::detail::bitpacking::supportedInstructionLevel()) {
+			std::cout << "Skipping test for instruction level " << il << " since it is not supported by this cpu" << std::endl;
+			return;
+		}
+		for(uint32_t bpn(1); bpn <= 32; ++bpn) {
+			for(uint32_t count : {64, 128, 256, 1024, 64*101}) {
+				check(bpn, count, il);
+			}
+		}
+	}
+public:
+	void testScalar() {
+		check(sserialize::detail::bitpacking::IL_SCALAR);
+	}
+	void testSse42() {
+		check(sserialize::detail::bitpacking::IL_SSE42);
+	}
+	void testAvx2() {
+		check(sserialize::detail::bitpacking::IL_AVX2);
+	}
+	void testShared() {
+		for(uint32_t bpn(1); bpn <= 32; ++bpn) {
+			CPPUNIT_ASSERT(&sserialize::BitpackingInterface::shared(bpn) == &sserialize::BitpackingInterface::shared(bpn));
+		}
+		CPPUNIT_ASSERT_THROW(sserialize::BitpackingInterface::shared(60), sserialize::UnsupportedFeatureException);
+	}
+};
+
+int main(int argc, char ** argv) {
+	sserialize::tests::TestBase::init(argc, argv);
+
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(  TestBitpacking::suite() );
+	bool ok = runner.run();
+	return ok ? 0 : 1;
+}
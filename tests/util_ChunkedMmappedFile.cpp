@@ -3,6 +3,9 @@
 #include <cmath>
 #include <limits>
 #include <stdlib.h>
+#include <thread>
+#include <random>
+#include <atomic>
 #include "TestBase.h"
 
 
@@ -15,6 +18,12 @@ CPPUNIT_TEST( testStats );
 CPPUNIT_TEST( testSequentialRead );
 CPPUNIT_TEST( testRandomRead );
 CPPUNIT_TEST( testReadFunction );
+CPPUNIT_TEST( testReadahead );
+CPPUNIT_TEST( testLease );
+CPPUNIT_TEST( testConcurrentRead );
+CPPUNIT_TEST( testLeasedResize );
+CPPUNIT_TEST( testAdapterReferences );
+CPPUNIT_TEST( testAdapterConcurrentReferences );
 CPPUNIT_TEST_SUITE_END();
 private:
 	bool m_deleteOnClose;
@@ -90,6 +99,138 @@ public:
 			offset += len;
 		}
 	}
+	
+	void testReadahead() {
+		m_file.setReadahead(2);
+		m_file.prefetch(0, m_realValues.size());
+		m_file.prefetch(m_realValues.size()/2+1, m_realValues.size());
+		m_file.prefetch(m_realValues.size(), 10);
+		for(std::size_t i = 0; i < m_realValues.size(); ++i) {
+			CPPUNIT_ASSERT_EQUAL_MESSAGE("i=" + std::to_string(i), m_realValues[i], m_file[i]);
+		}
+		testReadFunction();
+		//readahead has to be stopped before the file shrinks
+		m_file.resize(m_realValues.size()/2);
+		m_realValues.resize(m_realValues.size()/2);
+		for(std::size_t i = 0; i < m_realValues.size(); ++i) {
+			CPPUNIT_ASSERT_EQUAL_MESSAGE("i=" + std::to_string(i), m_realValues[i], m_file[i]);
+		}
+		m_file.setReadahead(0);
+		for(std::size_t i = 0; i < m_realValues.size(); i += 4096) {
+			CPPUNIT_ASSERT_EQUAL_MESSAGE("i=" + std::to_string(i), m_realValues[i], m_file[i]);
+		}
+	}
+	
+	void testLease() {
+		m_file.setCacheCount(1);
+		ChunkedMmappedFile::ChunkLease first = m_file.lease(0);
+		CPPUNIT_ASSERT(first.valid());
+		CPPUNIT_ASSERT_EQUAL(SizeType(0), first.offset());
+		CPPUNIT_ASSERT(first.contains(first.size()-1));
+		CPPUNIT_ASSERT(!first.contains(first.size()));
+		//map every other chunk, the pinned first chunk must stay mapped
+		ChunkedMmappedFile::ChunkLease copy = first;
+		for(std::size_t i = first.size(); i < m_realValues.size(); i += 1024) {
+			ChunkedMmappedFile::ChunkLease l = m_file.lease(i);
+			CPPUNIT_ASSERT(l.contains(i));
+			CPPUNIT_ASSERT_EQUAL_MESSAGE("i=" + std::to_string(i), m_realValues[i], *l.at(i));
+		}
+		ChunkedMmappedFile::ChunkLease moved(std::move(first));
+		CPPUNIT_ASSERT(!first.valid());
+		for(std::size_t i = 0; i < moved.size(); ++i) {
+			CPPUNIT_ASSERT_EQUAL_MESSAGE("i=" + std::to_string(i), m_realValues[i], moved.data()[i]);
+			CPPUNIT_ASSERT_EQUAL_MESSAGE("i=" + std::to_string(i), m_realValues[i], copy.data()[i]);
+		}
+	}
+	
+	void testConcurrentRead() {
+		m_file.setCacheCount(2);
+		std::atomic<std::size_t> errors(0);
+		std::vector<std::thread> threads;
+		for(uint32_t t(0); t < 4; ++t) {
+			threads.emplace_back([this, t, &errors]() {
+				std::minstd_rand gen(t);
+				std::vector<uint8_t> buf(4096);
+				for(uint32_t round(0); round < 1000; ++round) {
+					std::size_t offset = gen() % m_realValues.size();
+					SizeType len = buf.size();
+					m_file.read(offset, buf.data(), len);
+					if (!std::equal(buf.begin(), buf.begin()+len, m_realValues.begin()+offset)) {
+						errors += 1;
+					}
+					ChunkedMmappedFile::ChunkLease l = m_file.lease(offset);
+					if (*l.at(offset) != m_realValues[offset]) {
+						errors += 1;
+					}
+				}
+			});
+		}
+		for(std::thread & t : threads) {
+			t.join();
+		}
+		CPPUNIT_ASSERT_EQUAL(std::size_t(0), errors.load());
+	}
+	
+	void testLeasedResize() {
+		{
+			ChunkedMmappedFile::ChunkLease l = m_file.lease(0);
+			CPPUNIT_ASSERT_THROW(m_file.resize(FileSize+1), sserialize::PreconditionViolationException);
+			CPPUNIT_ASSERT_EQUAL(m_realValues[0], *l.at(0));
+		}
+		CPPUNIT_ASSERT(m_file.resize(FileSize));
+		CPPUNIT_ASSERT_EQUAL(m_realValues[0], m_file[0]);
+	}
+	
+	void testAdapterReferences() {
+		m_file.setCacheCount(1);
+		{
+			UByteArrayAdapter d(m_file.dataAdapter());
+			//references returned by operator[] have to survive accesses to other chunks
+			const uint8_t & first = d[0];
+			const uint8_t & last = d[FileSize-1];
+			for(std::size_t i = 0; i < m_realValues.size(); i += 4096) {
+				CPPUNIT_ASSERT_EQUAL_MESSAGE("i=" + std::to_string(i), m_realValues[i], d.getUint8(i));
+			}
+			CPPUNIT_ASSERT_EQUAL(m_realValues.front(), first);
+			CPPUNIT_ASSERT_EQUAL(m_realValues.back(), last);
+		}
+		//the adapter released its leases
+		CPPUNIT_ASSERT(m_file.resize(FileSize));
+	}
+	
+	void testAdapterConcurrentReferences() {
+		//the adapter pins at most 4 chunks for references returned by operator[]
+		const uint32_t maxPinnedChunks = 4;
+		const std::size_t chunkSize = std::size_t(1) << chunkExponent;
+		m_file.setCacheCount(1);
+		{
+			UByteArrayAdapter d(m_file.dataAdapter());
+			std::atomic<std::size_t> errors(0);
+			std::vector<std::thread> threads;
+			for(uint32_t t(0); t < 4; ++t) {
+				threads.emplace_back([&, t]() {
+					for(uint32_t round(0); round < 4; ++round) {
+						for(std::size_t i = t; i < m_realValues.size(); i += chunkSize/16+t) {
+							const uint8_t & v = d[i];
+							if (v != m_realValues[i]) {
+								errors += 1;
+							}
+						}
+					}
+				});
+			}
+			for(std::thread & t : threads) {
+				t.join();
+			}
+			CPPUNIT_ASSERT_EQUAL(std::size_t(0), errors.load());
+			//all chunks but the pinned ones can be evicted
+			m_file.setCacheCount(1);
+			CPPUNIT_ASSERT(m_file.mappedChunkCount() <= maxPinnedChunks+1);
+		}
+		m_file.setCacheCount(0);
+		CPPUNIT_ASSERT_EQUAL(uint32_t(0), m_file.mappedChunkCount());
+		CPPUNIT_ASSERT(m_file.resize(FileSize));
+	}
 };
 
 int main(int argc, char ** argv) {
@@ -0,0 +1,197 @@
+#include <sserialize/utility/Compressor.h>
+#include <sserialize/storage/CompressedMmappedFile.h>
+#include <sserialize/storage/MmappedFile.h>
+#include <sserialize/utility/exceptions.h>
+#include <random>
+#include "TestBase.h"
+
+using namespace sserialize;
+
+class TestCompressor: public sserialize::tests::TestBase {
+CPPUNIT_TEST_SUITE( TestCompressor );
+CPPUNIT_TEST( testRoundTrip );
+CPPUNIT_TEST( testSmallDest );
+CPPUNIT_TEST( testCorrupt );
+CPPUNIT_TEST( testNames );
+CPPUNIT_TEST( testCompressedMmappedFile );
+CPPUNIT_TEST( testSharedCache );
+CPPUNIT_TEST_SUITE_END();
+private:
+	static const std::vector<Compressor::CompressionTypes> & codecs() {
+		static std::vector<Compressor::CompressionTypes> c = {Compressor::CT_NONE, Compressor::CT_LZO, Compressor::CT_LZ4, Compressor::CT_LZ4HC};
+		return c;
+	}
+	///random text-like data with repetitions of varying distance
+	std::vector<uint8_t> create(std::mt19937 & gen, std::size_t size, uint32_t alphabetSize) {
+		std::vector<uint8_t> data;
+		data.reserve(size);
+		std::uniform_int_distribution<uint32_t> symbol(0, alphabetSize-1);
+		std::uniform_int_distribution<uint32_t> coin(0, 3);
+		while (data.size() < size) {
+			if (data.size() > 16 && coin(gen) == 0) {
+				std::uniform_int_distribution<std::size_t> dist(1, std::min<std::size_t>(data.size(), 70000));
+				std::uniform_int_distribution<std::size_t> len(4, 300);
+				std::size_t begin = data.size() - dist(gen);
+				for(std::size_t i(0), s(len(gen)); i < s && data.size() < size; ++i) {
+					data.push_back(data[begin+i]);
+				}
+			}
+			else {
+				data.push_back('a' + symbol(gen));
+			}
+		}
+		return data;
+	}
+	void check(const Compressor & c, const std::vector<uint8_t> & src) {
+		std::string msg = Compressor::name(c.type()) + ": size=" + std::to_string(src.size());
+		std::vector<uint8_t> compressed(c.maxCompressedSize(src.size()));
+		int64_t cLen = c.compress(src.data(), src.size(), compressed.data(), compressed.size());
+		CPPUNIT_ASSERT_MESSAGE(msg, cLen >= 0);
+		//guard element to detect writes past the end
+		std::vector<uint8_t> dest(src.size()+1, 0xFE);
+		int64_t dLen = c.decompress(compressed.data(), cLen, dest.data(), src.size());
+		CPPUNIT_ASSERT_EQUAL_MESSAGE(msg, (int64_t) src.size(), dLen);
+		CPPUNIT_ASSERT_EQUAL_MESSAGE(msg, uint8_t(0xFE), dest.back());
+		dest.pop_back();
+		CPPUNIT_ASSERT_MESSAGE(msg, src == dest);
+	}
+public:
+	void testRoundTrip() {
+		std::mt19937 gen(0);
+		for(Compressor::CompressionTypes ct : codecs()) {
+			Compressor c(ct);
+			CPPUNIT_ASSERT_EQUAL(ct, c.type());
+			for(std::size_t size : {0, 1, 5, 12, 13, 100, 4096, 1 << 16, 300000}) {
+				for(uint32_t alphabetSize : {1, 4, 256}) {
+					check(c, create(gen, size, alphabetSize));
+				}
+			}
+		}
+	}
+	void testSmallDest() {
+		std::mt19937 gen(1);
+		std::vector<uint8_t> src = create(gen, 1 << 16, 256);
+		for(Compressor::CompressionTypes ct : codecs()) {
+			Compressor c(ct);
+			std::vector<uint8_t> compressed(c.maxCompressedSize(src.size()));
+			int64_t cLen = c.compress(src.data(), src.size(), compressed.data(), compressed.size());
+			CPPUNIT_ASSERT(cLen > 0);
+			std::vector<uint8_t> tooSmall(cLen-1);
+			CPPUNIT_ASSERT_EQUAL_MESSAGE(Compressor::name(ct), int64_t(-1), c.compress(src.data(), src.size(), tooSmall.data(), tooSmall.size()));
+			std::vector<uint8_t> dest(src.size()-1);
+			CPPUNIT_ASSERT_EQUAL_MESSAGE(Compressor::name(ct), int64_t(-1), c.decompress(compressed.data(), cLen, dest.data(), dest.size()));
+		}
+	}
+	void testCorrupt() {
+		std::mt19937 gen(2);
+		std::vector<uint8_t> src = create(gen, 1 << 14, 8);
+		for(Compressor::CompressionTypes ct : {Compressor::CT_LZ4, Compressor::CT_LZ4HC}) {
+			Compressor c(ct);
+			std::vector<uint8_t> compressed(c.maxCompressedSize(src.size()));
+			int64_t cLen = c.compress(src.data(), src.size(), compressed.data(), compressed.size());
+			compressed.resize(cLen);
+			std::vector<uint8_t> dest(src.size());
+			//decompression must not crash on corrupt input
+			for(uint32_t round(0); round < 1000; ++round) {
+				std::vector<uint8_t> corrupt(compressed);
+				corrupt[gen() % corrupt.size()] ^= uint8_t(1 + gen() % 255);
+				c.decompress(corrupt.data(), corrupt.size(), dest.data(), dest.size());
+			}
+			CPPUNIT_ASSERT_EQUAL(int64_t(-1), c.decompress(compressed.data(), compressed.size()/2, dest.data(), dest.size()));
+		}
+	}
+	void testNames() {
+		for(Compressor::CompressionTypes ct : codecs()) {
+			CPPUNIT_ASSERT(Compressor::supported(ct));
+			CPPUNIT_ASSERT_EQUAL(ct, Compressor::fromName(Compressor::name(ct)));
+		}
+		CPPUNIT_ASSERT(!Compressor::supported(Compressor::CT__COUNT));
+		CPPUNIT_ASSERT_THROW(Compressor::fromName("foo"), sserialize::TypeMissMatchException);
+		CPPUNIT_ASSERT_THROW(Compressor(Compressor::CT__COUNT), sserialize::TypeMissMatchException);
+	}
+	void testCompressedMmappedFile() {
+		std::mt19937 gen(3);
+		std::vector<uint8_t> src;
+		//compressible, barely compressible and random chunks
+		for(uint32_t alphabetSize : {4, 200, 256, 2}) {
+			std::vector<uint8_t> tmp = create(gen, (1 << 16)+123, alphabetSize);
+			src.insert(src.end(), tmp.begin(), tmp.end());
+		}
+		for(std::size_t i(0); i < (1 << 16); ++i) {
+			src.push_back(gen());
+		}
+		std::string fileName = "compressortest.bin";
+		std::vector<Compressor::CompressionTypes> fileCodecs = {Compressor::CT_LZ4, Compressor::CT_LZ4HC};
+		{
+			UByteArrayAdapter dest = UByteArrayAdapter::createFile(0, fileName);
+			CPPUNIT_ASSERT(CompressedMmappedFile::create(UByteArrayAdapter(&src, false), dest, 16, 1.1, fileCodecs));
+		}
+		CompressedMmappedFile file(fileName);
+		file.setCacheCount(2);
+		CPPUNIT_ASSERT(file.open());
+		CPPUNIT_ASSERT_EQUAL(Compressor::CT_LZ4, file.codec());
+		CPPUNIT_ASSERT_EQUAL((CompressedMmappedFile::SizeType) src.size(), file.size());
+		CPPUNIT_ASSERT_EQUAL(Compressor::CT_NONE, file.codec(src.size()-1));
+		for(std::size_t i(0); i < src.size(); i += 1 << 16) {
+			CPPUNIT_ASSERT(file.codec(i) == Compressor::CT_NONE || file.codec(i) == Compressor::CT_LZ4 || file.codec(i) == Compressor::CT_LZ4HC);
+		}
+		CPPUNIT_ASSERT(file.codec(0) != Compressor::CT_NONE);
+		std::vector<uint8_t> dest(src.size());
+		CompressedMmappedFile::SizeType len = src.size();
+		file.read(0, dest.data(), len);
+		CPPUNIT_ASSERT_EQUAL((CompressedMmappedFile::SizeType) src.size(), len);
+		CPPUNIT_ASSERT(src == dest);
+		for(uint32_t i(0); i < 10000; ++i) {
+			std::size_t pos = gen() % src.size();
+			CPPUNIT_ASSERT_EQUAL_MESSAGE("pos=" + std::to_string(pos), src[pos], file[pos]);
+		}
+		CPPUNIT_ASSERT(file.close());
+		MmappedFile::unlinkFile(fileName);
+	}
+	void testSharedCache() {
+		std::mt19937 gen(4);
+		std::vector<uint8_t> src = create(gen, 40 << 16, 16);
+		std::string fileName = "compressortest_shared.bin";
+		{
+			UByteArrayAdapter dest = UByteArrayAdapter::createFile(0, fileName);
+			CPPUNIT_ASSERT(CompressedMmappedFile::create(UByteArrayAdapter(&src, false), dest, 16, 1.1, {Compressor::CT_LZ4}));
+		}
+		std::size_t prevCacheSize = CompressedMmappedFile::sharedCacheSize();
+		CompressedMmappedFile::setSharedCacheSize(1 << 20);
+		CompressedMmappedFile::setDecompressionThreadCount(2);
+		//two independent instances of the same file
+		std::vector<CompressedMmappedFile> files = {CompressedMmappedFile(fileName), CompressedMmappedFile(fileName)};
+		for(CompressedMmappedFile & file : files) {
+			file.setCacheCount(2);
+			file.setDecodeAhead(4);
+			CPPUNIT_ASSERT(file.open());
+		}
+		for(uint32_t round(0); round < 2; ++round) {
+			for(std::size_t i(0); i < src.size(); i += 1000) {
+				for(CompressedMmappedFile & file : files) {
+					CPPUNIT_ASSERT_EQUAL_MESSAGE("i=" + std::to_string(i), src[i], file[i]);
+				}
+				CPPUNIT_ASSERT(CompressedMmappedFile::sharedCacheUsage() <= CompressedMmappedFile::sharedCacheSize());
+			}
+		}
+		std::vector<uint8_t> dest(src.size());
+		CompressedMmappedFile::SizeType len = src.size();
+		files.front().read(0, dest.data(), len);
+		CPPUNIT_ASSERT(src == dest);
+		for(CompressedMmappedFile & file : files) {
+			CPPUNIT_ASSERT(file.close());
+		}
+		CPPUNIT_ASSERT_EQUAL(std::size_t(0), CompressedMmappedFile::sharedCacheUsage());
+		CompressedMmappedFile::setSharedCacheSize(prevCacheSize);
+		MmappedFile::unlinkFile(fileName);
+	}
+};
+
+int main(int argc, char ** argv) {
+	sserialize::tests::TestBase::init(argc, argv);
+	
+	CppUnit::TextUi::TestRunner runner;
+	runner.addTest(  TestCompressor::suite() );
+	bool ok = runner.run();
+	return ok ? 0 : 1;
+}
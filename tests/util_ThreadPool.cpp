@@ -2,6 +2,9 @@
 #include <sserialize/mt/GuardedVariable.h>
 #include "TestBase.h"
 #include <unistd.h>
+#include <list>
+#include <chrono>
+#include <thread>
 
 template<uint32_t T_NUM_THREADS, uint32_t T_NUM_TASKS>
 class TestThreadPool: public sserialize::tests::TestBase {
@@ -42,6 +45,118 @@ public:
 	}
 };
 
+template<uint32_t T_NUM_THREADS>
+class TestWorkStealingThreadPool: public sserialize::tests::TestBase {
+CPPUNIT_TEST_SUITE( TestWorkStealingThreadPool );
+CPPUNIT_TEST( testNestedSheduling );
+CPPUNIT_TEST( testFlushFromTask );
+CPPUNIT_TEST( testParallelFor );
+CPPUNIT_TEST( testNestedParallelFor );
+CPPUNIT_TEST( testMap );
+CPPUNIT_TEST( testIdleWorkerTakesTask );
+CPPUNIT_TEST_SUITE_END();
+private:
+	static void fork(sserialize::ThreadPool & tp, std::atomic<uint32_t> & calls, uint32_t depth) {
+		calls += 1;
+		if (depth) {
+			for(uint32_t i(0); i < 2; ++i) {
+				tp.sheduleTask([&tp, &calls, depth]() { fork(tp, calls, depth-1); });
+			}
+		}
+	}
+public:
+	void testNestedSheduling() {
+		sserialize::ThreadPool tp(T_NUM_THREADS);
+		std::atomic<uint32_t> calls(0);
+		uint32_t depth = 10;
+		tp.sheduleTask([&tp, &calls, depth]() { fork(tp, calls, depth); });
+		tp.flushQueue();
+		CPPUNIT_ASSERT_EQUAL((uint32_t(1) << (depth+1)) - 1, calls.load());
+		CPPUNIT_ASSERT_EQUAL(std::size_t(0), tp.queueSize());
+	}
+	void testFlushFromTask() {
+		sserialize::ThreadPool tp(T_NUM_THREADS);
+		std::atomic<uint32_t> calls(0);
+		for(uint32_t i(0); i < 4; ++i) {
+			tp.sheduleTask([&tp, &calls]() {
+				for(uint32_t j(0); j < 100; ++j) {
+					tp.sheduleTask([&calls]() { calls += 1; });
+				}
+				tp.flushQueue();
+			});
+		}
+		tp.flushQueue();
+		CPPUNIT_ASSERT_EQUAL(uint32_t(400), calls.load());
+	}
+	void testParallelFor() {
+		sserialize::ThreadPool tp(T_NUM_THREADS);
+		for(std::size_t size : {0, 1, 7, 1000, 10007}) {
+			for(std::size_t grainSize : {0, 1, 3, 64, 20000}) {
+				std::vector< std::atomic<uint32_t> > calls(size+10);
+				tp.parallel_for(5, 5+size, grainSize, [&calls](std::size_t i) { calls.at(i) += 1; });
+				for(std::size_t i(0); i < calls.size(); ++i) {
+					CPPUNIT_ASSERT_EQUAL_MESSAGE(sserialize::toString("size=", size, ", grainSize=", grainSize, ", i=", i), uint32_t(i >= 5 && i < 5+size), calls[i].load());
+				}
+			}
+		}
+	}
+	void testNestedParallelFor() {
+		sserialize::ThreadPool tp(T_NUM_THREADS);
+		std::vector< std::atomic<uint32_t> > calls(100*100);
+		tp.parallel_for(0, 100, 1, [&tp, &calls](std::size_t i) {
+			tp.parallel_for(0, 100, 7, [&calls, i](std::size_t j) { calls.at(i*100+j) += 1; });
+		});
+		for(std::size_t i(0); i < calls.size(); ++i) {
+			CPPUNIT_ASSERT_EQUAL(uint32_t(1), calls[i].load());
+		}
+	}
+	void testMap() {
+		for(std::size_t chunkSize : {0, 1, 5, 1000}) {
+			std::vector< std::atomic<uint32_t> > vcalls(1001);
+			std::vector<uint32_t> v(vcalls.size());
+			std::list<uint32_t> l;
+			for(uint32_t i(0); i < v.size(); ++i) {
+				v[i] = i;
+				l.push_back(i);
+			}
+			sserialize::ThreadPool::map([&vcalls](uint32_t i) { vcalls.at(i) += 1; }, v.begin(), v.end(), T_NUM_THREADS, chunkSize);
+			for(std::size_t i(0); i < vcalls.size(); ++i) {
+				CPPUNIT_ASSERT_EQUAL(uint32_t(1), vcalls[i].load());
+			}
+			sserialize::ThreadPool::map([&vcalls](uint32_t i) { vcalls.at(i) += 1; }, l.begin(), l.end(), T_NUM_THREADS, chunkSize);
+			for(std::size_t i(0); i < vcalls.size(); ++i) {
+				CPPUNIT_ASSERT_EQUAL(uint32_t(2), vcalls[i].load());
+			}
+		}
+	}
+	///a task queued while another worker is busy has to be picked up by a sleeping worker
+	void testIdleWorkerTakesTask() {
+		if (T_NUM_THREADS < 2) {
+			return;
+		}
+		sserialize::ThreadPool tp(T_NUM_THREADS);
+		std::atomic<bool> started(false);
+		std::atomic<bool> secondDone(false);
+		std::atomic<bool> sawSecond(false);
+		tp.sheduleTask([&]() {
+			started = true;
+			auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(5);
+			while (!secondDone.load() && std::chrono::steady_clock::now() < deadline) {
+				std::this_thread::sleep_for(std::chrono::milliseconds(1));
+			}
+			sawSecond = secondDone.load();
+		});
+		while (!started.load()) {
+			std::this_thread::yield();
+		}
+		//let the other workers fall asleep
+		std::this_thread::sleep_for(std::chrono::milliseconds(50));
+		tp.sheduleTask([&]() { secondDone = true; });
+		tp.flushQueue();
+		CPPUNIT_ASSERT(sawSecond.load());
+	}
+};
+
 int main(int argc, char ** argv) {
 	sserialize::tests::TestBase::init(argc, argv);
 	
@@ -55,6 +170,9 @@ int main(int argc, char ** argv) {
 	runner.addTest(  TestThreadPool<8, 1>::suite() );
 	runner.addTest(  TestThreadPool<100, 1000>::suite() );
 	runner.addTest(  TestThreadPool<100, 1>::suite() );
+	runner.addTest(  TestWorkStealingThreadPool<1>::suite() );
+	runner.addTest(  TestWorkStealingThreadPool<2>::suite() );
+	runner.addTest(  TestWorkStealingThreadPool<8>::suite() );
 	bool ok = true;
 	for(uint32_t i(0), s(25); ok && i < s; ++i) {
 		ok = runner.run() && ok;
@@ -1,6 +1,11 @@
 #include <sserialize/storage/UByteArrayAdapter.h>
+#include <sserialize/algorithm/utilmath.h>
+#include <sserialize/storage/BufferPool.h>
 #include "datacreationfuncs.h"
 #include "TestBase.h"
+#include <random>
+#include <numeric>
+#include <deque>
 
 constexpr uint32_t TStringsCount = 1024;
 constexpr uint32_t TIntegerCount = 10240;
@@ -235,6 +240,169 @@ public:
 		d.resetGetPtr();
 	}
 	
+	template<typename T>
+	std::vector<T> createVlPackedValues(std::size_t count, uint32_t seed) {
+		//mostly small numbers to hit the simd paths, with some large ones in between
+		std::mt19937_64 gen(seed);
+		std::vector<T> result;
+		for(std::size_t i(0); i < count; ++i) {
+			uint32_t bits = (gen() % 8 == 0 ? gen() % std::numeric_limits<T>::digits : gen() % 15);
+			T v = T(gen() & sserialize::createMask64(bits));
+			if (std::is_signed<T>::value && (gen() & 0x1)) {
+				v = T(0) - v;
+			}
+			result.push_back(v);
+		}
+		return result;
+	}
+	
+	void testVlPackedArrays() {
+		for(std::size_t count : {0, 1, 7, 16, 17, 1000, 10000}) {
+			std::vector<uint32_t> u32 = createVlPackedValues<uint32_t>(count, (uint32_t) count);
+			std::vector<int32_t> s32 = createVlPackedValues<int32_t>(count, (uint32_t) count+1);
+			std::vector<uint64_t> u64 = createVlPackedValues<uint64_t>(count, (uint32_t) count+2);
+			std::vector<int64_t> s64 = createVlPackedValues<int64_t>(count, (uint32_t) count+3);
+			for(int32_t & x : s32) {
+				if (x == std::numeric_limits<int32_t>::min()) {
+					x += 1;
+				}
+			}
+			for(int64_t & x : s64) {
+				if (x == std::numeric_limits<int64_t>::min()) {
+					x += 1;
+				}
+			}
+			std::vector<uint32_t> u32Delta(count);
+			std::vector<uint64_t> u64Delta(count);
+			sserialize::UByteArrayAdapter d(createUBA());
+			d.putUint8(0xFE);
+			for(uint32_t x : u32) {
+				d.putVlPackedUint32(x);
+			}
+			for(int32_t x : s32) {
+				d.putVlPackedInt32(x);
+			}
+			for(uint64_t x : u64) {
+				d.putVlPackedUint64(x);
+			}
+			for(int64_t x : s64) {
+				d.putVlPackedInt64(x);
+			}
+			std::partial_sum(u32.begin(), u32.end(), u32Delta.begin());
+			std::partial_sum(u64.begin(), u64.end(), u64Delta.begin());
+			for(uint32_t & x : u32Delta) {
+				x += 17;
+			}
+			for(uint64_t & x : u64Delta) {
+				x += 17;
+			}
+			d.putVlPackedUint32(0);
+			
+			std::vector<uint32_t> ru32(count);
+			std::vector<int32_t> rs32(count);
+			std::vector<uint64_t> ru64(count);
+			std::vector<int64_t> rs64(count);
+			d.resetGetPtr();
+			d.incGetPtr(1);
+			d.getVlPackedUint32Array(ru32.data(), count);
+			d.getVlPackedInt32Array(rs32.data(), count);
+			d.getVlPackedUint64Array(ru64.data(), count);
+			d.getVlPackedInt64Array(rs64.data(), count);
+			CPPUNIT_ASSERT(u32 == ru32);
+			CPPUNIT_ASSERT(s32 == rs32);
+			CPPUNIT_ASSERT(u64 == ru64);
+			CPPUNIT_ASSERT(s64 == rs64);
+			CPPUNIT_ASSERT_EQUAL(uint32_t(0), d.getVlPackedUint32());
+			CPPUNIT_ASSERT_EQUAL(d.size(), d.tellGetPtr());
+			
+			//compare with single number decoding
+			d.resetGetPtr();
+			d.incGetPtr(1);
+			for(std::size_t i(0); i < count; ++i) {
+				CPPUNIT_ASSERT_EQUAL(u32[i], d.getVlPackedUint32());
+			}
+			sserialize::UByteArrayAdapter::OffsetType s32Begin = d.tellGetPtr();
+			
+			sserialize::UByteArrayAdapter::OffsetType len = d.getVlPackedDeltaUint32Array(1, ru32.data(), count, 17);
+			CPPUNIT_ASSERT_EQUAL(s32Begin-1, len);
+			CPPUNIT_ASSERT(u32Delta == ru32);
+			
+			for(std::size_t i(0); i < count; ++i) {
+				d.getVlPackedInt32();
+			}
+			d.getVlPackedDeltaUint64Array(ru64.data(), count, 17);
+			CPPUNIT_ASSERT(u64Delta == ru64);
+			
+			//not enough data
+			d.resetGetPtr();
+			sserialize::UByteArrayAdapter::OffsetType size = d.size();
+			d.resize(size-2);
+			if (count) {
+				std::vector<uint64_t> tmp(3*count);
+				CPPUNIT_ASSERT_THROW(d.getVlPackedUint64Array(s32Begin, tmp.data(), tmp.size()), sserialize::OutOfBoundsException);
+			}
+			CPPUNIT_ASSERT_THROW(d.getVlPackedUint32Array(size, ru32.data(), 1), sserialize::OutOfBoundsException);
+			CPPUNIT_ASSERT_EQUAL(sserialize::UByteArrayAdapter::OffsetType(0), d.getVlPackedUint32Array(size, ru32.data(), 0));
+		}
+	}
+	
+	void testBorrowedView() {
+		std::mt19937_64 gen(7);
+		std::vector<uint64_t> values;
+		sserialize::UByteArrayAdapter d(createUBA());
+		d.putUint8(0xFE);
+		for(uint32_t i(0); i < 1000; ++i) {
+			values.push_back(gen() & sserialize::createMask64(gen() % 64));
+			d.putUint8(uint8_t(values.back()));
+			d.putUint16(uint16_t(values.back()));
+			d.putUint24(uint32_t(values.back()) & 0xFFFFFF);
+			d.putUint32(uint32_t(values.back()));
+			d.putUint64(values.back());
+			d.putVlPackedUint32(uint32_t(values.back()));
+			d.putVlPackedUint64(values.back());
+		}
+		sserialize::UByteArrayAdapter sub(d, 1);
+		sserialize::UByteArrayAdapter::BorrowedView v(sub.asBorrowedView());
+		CPPUNIT_ASSERT_EQUAL(sub.size(), v.size());
+		CPPUNIT_ASSERT_EQUAL(sub.isContiguous(), v.isContiguous());
+		CPPUNIT_ASSERT_EQUAL(sub.isContiguous(), v.data() != nullptr);
+		
+		sserialize::UByteArrayAdapter::OffsetType pos = 0;
+		int len = 0;
+		for(uint64_t x : values) {
+			CPPUNIT_ASSERT_EQUAL(uint8_t(x), v.getUint8(pos));
+			CPPUNIT_ASSERT_EQUAL(uint16_t(x), v.getUint16(pos+1));
+			CPPUNIT_ASSERT_EQUAL(uint32_t(x) & 0xFFFFFF, v.getUint24(pos+3));
+			CPPUNIT_ASSERT_EQUAL(uint32_t(x), v.getUint32(pos+6));
+			CPPUNIT_ASSERT_EQUAL(x, v.getUint64(pos+10));
+			pos += 18;
+			CPPUNIT_ASSERT_EQUAL(uint32_t(x), v.getVlPackedUint32(pos, &len));
+			CPPUNIT_ASSERT_EQUAL(sserialize::psize_vu32(uint32_t(x)), len);
+			pos += len;
+			sserialize::UByteArrayAdapter::BorrowedView s(v.slice(pos, sserialize::psize_vu64(x)));
+			CPPUNIT_ASSERT_EQUAL(x, s.getVlPackedUint64(0, &len));
+			CPPUNIT_ASSERT_EQUAL(s.size(), sserialize::UByteArrayAdapter::OffsetType(len));
+			pos += len;
+		}
+		CPPUNIT_ASSERT_EQUAL(v.size(), pos);
+		
+		sserialize::UByteArrayAdapter::BorrowedView s(v.slice(10, 100));
+		std::vector<uint8_t> buffer(200);
+		CPPUNIT_ASSERT_EQUAL(sserialize::UByteArrayAdapter::OffsetType(90), s.getData(10, buffer.data(), buffer.size()));
+		for(uint32_t i(0); i < 90; ++i) {
+			CPPUNIT_ASSERT_EQUAL(sub.getUint8(20+i), buffer.at(i));
+		}
+		CPPUNIT_ASSERT(s.adapter().equalContent(sserialize::UByteArrayAdapter(sub, 10, 100)));
+		CPPUNIT_ASSERT_EQUAL(v.size()-10, v.slice(10).size());
+		
+		CPPUNIT_ASSERT_THROW(s.getUint32(97), sserialize::OutOfBoundsException);
+		CPPUNIT_ASSERT_THROW(s.getUint8(100), sserialize::OutOfBoundsException);
+		CPPUNIT_ASSERT_THROW(s.slice(50, 51), sserialize::OutOfBoundsException);
+		CPPUNIT_ASSERT_THROW(sub.getBorrowedView(sub.size(), 1), sserialize::OutOfBoundsException);
+		CPPUNIT_ASSERT(sub.getBorrowedView(sub.size(), 0).isEmpty());
+		CPPUNIT_ASSERT(sserialize::UByteArrayAdapter::BorrowedView().adapter().isEmpty());
+	}
+	
 	void testPutGetPtrs() {
 		sserialize::UByteArrayAdapter d(createUBA());
 		
@@ -266,6 +434,9 @@ CPPUNIT_TEST_SUITE( UBAVec );
 CPPUNIT_TEST(testStrings);
 CPPUNIT_TEST(testIntegers);
 CPPUNIT_TEST(testPutGetPtrs);
+CPPUNIT_TEST(testVlPackedArrays);
+CPPUNIT_TEST(testBorrowedView);
+CPPUNIT_TEST(testBufferPool);
 CPPUNIT_TEST_SUITE_END();
 protected:
 	virtual sserialize::UByteArrayAdapter createUBA() override {
@@ -279,7 +450,50 @@ protected:
 public:
 	UBAVec() {}
 	virtual ~UBAVec() {}
+	void testBufferPool() {
+		sserialize::RCPtrWrapper<sserialize::BufferPool> pool(new sserialize::BufferPool(1, 1024));
+		std::vector<uint8_t> * buffer = pool->acquire(100);
+		CPPUNIT_ASSERT_EQUAL(std::size_t(100), buffer->size());
+		{
+			sserialize::UByteArrayAdapter d(buffer, pool);
+			CPPUNIT_ASSERT_EQUAL(sserialize::UByteArrayAdapter::OffsetType(100), d.size());
+			d.putUint32(0, 0xFEFEFEFE);
+			sserialize::UByteArrayAdapter d2(d, 4);
+			d2 -= 4;
+			d = sserialize::UByteArrayAdapter();
+			CPPUNIT_ASSERT_EQUAL(std::size_t(0), pool->stats().pooled);
+			CPPUNIT_ASSERT_EQUAL(uint32_t(0xFEFEFEFE), d2.getUint32(0));
+		}
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), pool->stats().pooled);
+		CPPUNIT_ASSERT(buffer == pool->acquire(10));
+		CPPUNIT_ASSERT_EQUAL(std::size_t(10), buffer->size());
+		CPPUNIT_ASSERT_EQUAL(uint64_t(1), pool->stats().reused);
+		//too large buffers and buffers exceeding the pool size are deleted
+		pool->release(pool->acquire(2048));
+		CPPUNIT_ASSERT_EQUAL(std::size_t(0), pool->stats().pooled);
+		pool->release(buffer);
+		pool->release(pool->acquire(10));
+		pool->release(new std::vector<uint8_t>(10));
+		CPPUNIT_ASSERT_EQUAL(std::size_t(1), pool->stats().pooled);
+	}
+};
+
+#ifdef SSERIALIZE_UBA_NON_CONTIGUOUS
+class UBADeque: public UBABaseTest {
+CPPUNIT_TEST_SUITE( UBADeque );
+CPPUNIT_TEST(testIntegers);
+CPPUNIT_TEST(testVlPackedArrays);
+CPPUNIT_TEST(testBorrowedView);
+CPPUNIT_TEST_SUITE_END();
+protected:
+	virtual sserialize::UByteArrayAdapter createUBA() override {
+		return sserialize::UByteArrayAdapter(new std::deque<uint8_t>(), true);
+	}
+public:
+	UBADeque() {}
+	virtual ~UBADeque() {}
 };
+#endif
 
 
 
@@ -293,6 +507,9 @@ int main(int argc, char ** argv) {
 	srand( 0 );
 	CppUnit::TextUi::TestRunner runner;
 	runner.addTest(  UBAVec::suite() );
+#ifdef SSERIALIZE_UBA_NON_CONTIGUOUS
+	runner.addTest(  UBADeque::suite() );
+#endif
 
 	if (sserialize::tests::TestBase::popProtector()) {
 		runner.eventManager().popProtector();
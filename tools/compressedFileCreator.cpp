@@ -2,11 +2,18 @@
 #include <sserialize/storage/MmappedFile.h>
 #include <sserialize/stats/ProgressInfo.h>
 #include <sserialize/strings/stringfunctions.h>
+#include <sserialize/utility/Compressor.h>
 #include <iostream>
 
 
 void help() {
-std::cout << "-i inFile -o outFile -cc minCompressionRatio chunkSizeExponent [-verify]" << std::endl;
+std::cout << "-i inFile -o outFile -cc minCompressionRatio chunkSizeExponent [-c codec[,codec...]] [-verify]" << std::endl;
+std::cout << "codecs: ";
+for(uint32_t i(0); i < sserialize::Compressor::CT__COUNT; ++i) {
+	std::cout << sserialize::Compressor::name(sserialize::Compressor::CompressionTypes(i)) << " ";
+}
+std::cout << std::endl;
+std::cout << "Every chunk is stored with the codec producing the smallest output, default is lzo" << std::endl;
 }
 
 int main(int argc, char ** argv) {
@@ -18,6 +25,7 @@ int main(int argc, char ** argv) {
 	double minCompressionRatio = -1;
 	int chunkSizeExponent = -1;
 	bool verify = false;
+	std::vector<sserialize::Compressor::CompressionTypes> codecs;
 	
 	for(int i = 0; i < argc; ++i) {
 		std::string str(argv[i]);
@@ -34,6 +42,19 @@ int main(int argc, char ** argv) {
 			chunkSizeExponent = atoi(argv[i+2]);
 			i+=2;
 		}
+		else if (str == "-c" && i+1 < argc) {
+			for(const std::string & name : sserialize::split< std::vector<std::string> >(std::string(argv[i+1]), ',', '\\')) {
+				try {
+					codecs.push_back(sserialize::Compressor::fromName(name));
+				}
+				catch (const sserialize::Exception &) {
+					std::cout << "Unknown codec " << name << std::endl;
+					help();
+					return 1;
+				}
+			}
+			++i;
+		}
 		else if (str == "-verify") {
 			verify = true;
 		}
@@ -45,6 +66,15 @@ int main(int argc, char ** argv) {
 	std::cout << "chunkSizeExponent: " << chunkSizeExponent << std::endl;
 	std::cout << "verify: " << (verify ? "true" : "false") << std::endl;
 	
+	if (codecs.empty()) {
+		codecs.push_back(sserialize::Compressor::CT_LZO);
+	}
+	std::cout << "codecs:";
+	for(sserialize::Compressor::CompressionTypes ct : codecs) {
+		std::cout << " " << sserialize::Compressor::name(ct);
+	}
+	std::cout << std::endl;
+	
 	if (inFile.empty() || outFile.empty() || minCompressionRatio < 0 || chunkSizeExponent < 10) {
 		help();
 		return 1;
@@ -81,7 +111,7 @@ int main(int argc, char ** argv) {
 	
 	std::cout << "In-File size:" << inFileData.size() << std::endl;
 	
-	if ( ! sserialize::CompressedMmappedFile::create(inFileData, outFileData, chunkSizeExponent, minCompressionRatio) ) {
+	if ( ! sserialize::CompressedMmappedFile::create(inFileData, outFileData, chunkSizeExponent, minCompressionRatio, codecs) ) {
 		std::cout << "Failed to create compressed file. Deleting remainders" << std::endl;
 		outFileData.setDeleteOnClose(true);
 		return 1;